@@ -5,6 +5,8 @@
 #define I2C_MSG_LENGTH		0x2
 #define E2PROM_2ADDR 0x80000000
 #define E2PROM_ADDR_MASK 0x7fffffff
+/* Largest sequential e2prom read, also the block size of 1-addr chips */
+#define E2PROM_MAX_READ_SIZE 256
 
 /* Defines for register writes and register array processing */
 #define IMX_BYTE_MAX	32
@@ -8,6 +8,7 @@
 #include <linux/i2c.h>
 #include <linux/io.h>
 #include <linux/kernel.h>
+#include <linux/ktime.h>
 #include <linux/mm.h>
 #include <linux/kmod.h>
 #include <linux/module.h>
@@ -24,6 +25,20 @@
 #include "dw9714.h"
 
 static struct dw9714_device dw9714_dev;
+
+/*
+ * Wait until the power-up time requested by the VCM has passed. The
+ * delay starts in dw9714_vcm_power_up() and runs in parallel with the
+ * sensor power-up, so normally nothing is left to wait for here.
+ */
+static void dw9714_wait_ready(void)
+{
+	s64 remain_us = ktime_us_delta(dw9714_dev.ready_time, ktime_get());
+
+	if (remain_us > 0)
+		usleep_range(remain_us, remain_us + 500);
+}
+
 static int dw9714_i2c_write(struct i2c_client *client, u16 data)
 {
 	struct i2c_msg msg;
@@ -31,6 +46,8 @@ static int dw9714_i2c_write(struct i2c_client *client, u16 data)
 	int ret;
 	u16 val;
 
+	dw9714_wait_ready();
+
 	val = cpu_to_be16(data);
 	msg.addr = DW9714_VCM_ADDR;
 	msg.flags = 0;
@@ -48,8 +65,9 @@ int dw9714_vcm_power_up(struct v4l2_subdev *sd)
 
 	/* Enable power */
 	ret = dw9714_dev.platform_data->power_ctrl(sd, 1);
-	/* waiting time requested by DW9714A(vcm) */
-	usleep_range(12000, 12500);
+	/* waiting time requested by DW9714A(vcm), see dw9714_wait_ready() */
+	dw9714_dev.ready_time = ktime_add_us(ktime_get(),
+					     DW9714_POWER_UP_DELAY_US);
 	return ret;
 }
 
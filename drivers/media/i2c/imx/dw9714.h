@@ -2,6 +2,7 @@
 #define __DW9714_H__
 
 #include <linux/atomisp_platform.h>
+#include <linux/ktime.h>
 #include <linux/types.h>
 
 
@@ -34,10 +35,14 @@ struct dw9714_device {
 	bool initialized;		/* true if dw9714 is detected */
 	s32 focus;			/* Current focus value */
 	struct timespec focus_time;	/* Time when focus was last time set */
+	ktime_t ready_time;		/* Earliest i2c access after power up */
 	__u8 buffer[4];			/* Used for i2c transactions */
 	const struct camera_af_platform_data *platform_data;
 };
 
+/* waiting time requested by DW9714A(vcm) after power up */
+#define DW9714_POWER_UP_DELAY_US	12000
+
 #define DW9714_INVALID_CONFIG	0xffffffff
 #define DW9714_MAX_FOCUS_POS	1023
 #define DW9714_DEFAULT_FOCUS_POS	290
@@ -0,0 +1,160 @@
+/*
+ * Support for frame synchronized sensor exposure updates.
+ *
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+#include <linux/errno.h>
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include "exposure_queue.h"
+
+/* true if frame a is at or before frame b, wrap safe */
+#define frame_before_eq(a, b)	((s32)((a) - (b)) <= 0)
+
+static void exposure_queue_work(struct work_struct *work)
+{
+	struct exposure_queue *q = container_of(work, struct exposure_queue,
+						work);
+	struct sensor_exposure_meta *meta;
+	struct sensor_frame_exposure cmd;
+	bool found = false;
+	u32 sof;
+	int ret;
+
+	spin_lock_irq(&q->lock);
+	sof = q->sof;
+	/* Only the newest due command matters, older ones are superseded */
+	while (q->count &&
+	       frame_before_eq(q->cmd[q->head].frame, sof + q->delay)) {
+		cmd = q->cmd[q->head];
+		q->head = (q->head + 1) % EXPOSURE_QUEUE_SIZE;
+		q->count--;
+		found = true;
+	}
+	spin_unlock_irq(&q->lock);
+
+	if (!found)
+		return;
+
+	ret = q->apply(q->sd, &cmd.exposure);
+
+	spin_lock_irq(&q->lock);
+	meta = &q->meta[q->meta_head];
+	q->meta_head = (q->meta_head + 1) % EXPOSURE_META_NUM;
+	if (q->meta_count < EXPOSURE_META_NUM)
+		q->meta_count++;
+	meta->target_frame = cmd.frame;
+	meta->applied_sof = sof;
+	meta->effective_frame = sof + q->delay;
+	meta->error = ret;
+	meta->exposure = cmd.exposure;
+	spin_unlock_irq(&q->lock);
+}
+
+void exposure_queue_init(struct exposure_queue *q, struct v4l2_subdev *sd,
+	int (*apply)(struct v4l2_subdev *sd,
+		     struct atomisp_exposure *exposure),
+	unsigned int delay)
+{
+	memset(q, 0, sizeof(*q));
+	spin_lock_init(&q->lock);
+	INIT_WORK(&q->work, exposure_queue_work);
+	q->sd = sd;
+	q->apply = apply;
+	q->delay = delay;
+}
+
+int exposure_queue_add(struct exposure_queue *q,
+	struct sensor_frame_exposure *req)
+{
+	unsigned int tail;
+	int ret = 0;
+
+	spin_lock_irq(&q->lock);
+	if (q->count == EXPOSURE_QUEUE_SIZE) {
+		ret = -EBUSY;
+		goto out;
+	}
+	/* Commands must be queued in frame order */
+	if (q->count) {
+		tail = (q->head + q->count - 1) % EXPOSURE_QUEUE_SIZE;
+		if (!frame_before_eq(q->cmd[tail].frame, req->frame)) {
+			ret = -EINVAL;
+			goto out;
+		}
+	}
+	tail = (q->head + q->count) % EXPOSURE_QUEUE_SIZE;
+	q->cmd[tail] = *req;
+	q->count++;
+out:
+	spin_unlock_irq(&q->lock);
+	return ret;
+}
+
+/*
+ * Called from the ISP interrupt handler on every start of frame. The
+ * sensor registers are written from a work item, since i2c may sleep.
+ */
+void exposure_queue_sof(struct exposure_queue *q, u32 sof)
+{
+	unsigned long flags;
+	bool due;
+
+	spin_lock_irqsave(&q->lock, flags);
+	q->sof = sof;
+	due = q->count &&
+		frame_before_eq(q->cmd[q->head].frame, sof + q->delay);
+	spin_unlock_irqrestore(&q->lock, flags);
+
+	if (due)
+		schedule_work(&q->work);
+}
+
+/*
+ * Drop the pending commands, e.g. on stream off. Safe to call with the
+ * sensor lock held: a work item already running still completes.
+ */
+void exposure_queue_reset(struct exposure_queue *q)
+{
+	spin_lock_irq(&q->lock);
+	q->head = 0;
+	q->count = 0;
+	spin_unlock_irq(&q->lock);
+}
+
+void exposure_queue_release(struct exposure_queue *q)
+{
+	exposure_queue_reset(q);
+	cancel_work_sync(&q->work);
+}
+
+int exposure_queue_get_meta(struct exposure_queue *q,
+	struct sensor_exposure_meta_list *list)
+{
+	unsigned int i, first;
+
+	spin_lock_irq(&q->lock);
+	first = (q->meta_head + EXPOSURE_META_NUM - q->meta_count) %
+		EXPOSURE_META_NUM;
+	for (i = 0; i < q->meta_count; i++)
+		list->meta[i] = q->meta[(first + i) % EXPOSURE_META_NUM];
+	list->count = q->meta_count;
+	spin_unlock_irq(&q->lock);
+
+	return 0;
+}
@@ -0,0 +1,94 @@
+/*
+ * Support for frame synchronized sensor exposure updates.
+ *
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+#ifndef __EXPOSURE_QUEUE_H__
+#define __EXPOSURE_QUEUE_H__
+
+#include <linux/atomisp.h>
+#include <linux/spinlock.h>
+#include <linux/types.h>
+#include <linux/videodev2.h>
+#include <linux/workqueue.h>
+#include <media/v4l2-subdev.h>
+
+#define EXPOSURE_QUEUE_SIZE	8
+#define EXPOSURE_META_NUM	16
+
+/*
+ * Exposure to be in effect from the given frame on. Frames are numbered
+ * like the frame_sequence of V4L2_EVENT_FRAME_SYNC on the ISP subdev.
+ */
+struct sensor_frame_exposure {
+	struct atomisp_exposure exposure;
+	__u32 frame;
+};
+
+/* Exposure actually written to the sensor, newest last */
+struct sensor_exposure_meta {
+	__u32 target_frame;		/* frame requested by the caller */
+	__u32 applied_sof;		/* SOF after which it was written */
+	__u32 effective_frame;		/* first frame exposed with it */
+	__s32 error;
+	struct atomisp_exposure exposure;
+};
+
+struct sensor_exposure_meta_list {
+	__u32 count;
+	struct sensor_exposure_meta meta[EXPOSURE_META_NUM];
+};
+
+#define SENSOR_IOC_Q_FRAME_EXPOSURE \
+	_IOW('v', BASE_VIDIOC_PRIVATE + 102, struct sensor_frame_exposure)
+#define SENSOR_IOC_G_EXPOSURE_META \
+	_IOR('v', BASE_VIDIOC_PRIVATE + 103, struct sensor_exposure_meta_list)
+
+struct exposure_queue {
+	spinlock_t lock;
+	struct work_struct work;
+	struct v4l2_subdev *sd;
+	/* writes the exposure, may sleep */
+	int (*apply)(struct v4l2_subdev *sd,
+		     struct atomisp_exposure *exposure);
+	/* frames between the write and the first frame exposed with it */
+	unsigned int delay;
+	u32 sof;
+	unsigned int head;
+	unsigned int count;
+	struct sensor_frame_exposure cmd[EXPOSURE_QUEUE_SIZE];
+	unsigned int meta_head;
+	unsigned int meta_count;
+	struct sensor_exposure_meta meta[EXPOSURE_META_NUM];
+};
+
+extern void exposure_queue_init(struct exposure_queue *q,
+	struct v4l2_subdev *sd,
+	int (*apply)(struct v4l2_subdev *sd,
+		     struct atomisp_exposure *exposure),
+	unsigned int delay);
+extern int exposure_queue_add(struct exposure_queue *q,
+	struct sensor_frame_exposure *req);
+extern void exposure_queue_sof(struct exposure_queue *q, u32 sof);
+extern void exposure_queue_reset(struct exposure_queue *q);
+extern void exposure_queue_release(struct exposure_queue *q);
+extern int exposure_queue_get_meta(struct exposure_queue *q,
+	struct sensor_exposure_meta_list *list);
+
+#endif
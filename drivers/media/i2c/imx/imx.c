@@ -504,6 +504,30 @@ static long imx_s_exposure(struct v4l2_subdev *sd,
 				exposure->gain[0], exposure->gain[1]);
 }
 
+static int imx_apply_frame_exposure(struct v4l2_subdev *sd,
+				    struct atomisp_exposure *exposure)
+{
+	/* Queued exposures only make sense while streaming */
+	if (!to_imx_sensor(sd)->streaming)
+		return -EAGAIN;
+
+	return imx_s_exposure(sd, exposure);
+}
+
+static void imx_focus_scan_sof(struct imx_device *dev, u32 sof);
+
+static int imx_interrupt_service_routine(struct v4l2_subdev *sd,
+					 u32 status, bool *handled)
+{
+	/* status is the frame number of the start of frame */
+	exposure_queue_sof(&to_imx_sensor(sd)->expq, status);
+	imx_focus_scan_sof(to_imx_sensor(sd), status);
+	if (handled)
+		*handled = true;
+
+	return 0;
+}
+
 /* FIXME -To be updated with real OTP reading */
 static int imx_g_priv_int_data(struct v4l2_subdev *sd,
 				   struct v4l2_private_int_data *priv)
@@ -587,6 +611,11 @@ static int imx_init(struct v4l2_subdev *sd, u32 val)
 	return ret;
 }
 
+static long imx_s_focus_scan(struct v4l2_subdev *sd,
+			     struct imx_focus_scan *req);
+static long imx_g_focus_scan(struct v4l2_subdev *sd,
+			     struct imx_focus_scan_status *status);
+
 static long imx_ioctl(struct v4l2_subdev *sd, unsigned int cmd, void *arg)
 {
 
@@ -595,6 +624,14 @@ static long imx_ioctl(struct v4l2_subdev *sd, unsigned int cmd, void *arg)
 		return imx_s_exposure(sd, arg);
 	case ATOMISP_IOC_G_SENSOR_PRIV_INT_DATA:
 		return imx_g_priv_int_data(sd, arg);
+	case IMX_IOC_S_FOCUS_SCAN:
+		return imx_s_focus_scan(sd, arg);
+	case IMX_IOC_G_FOCUS_SCAN:
+		return imx_g_focus_scan(sd, arg);
+	case SENSOR_IOC_Q_FRAME_EXPOSURE:
+		return exposure_queue_add(&to_imx_sensor(sd)->expq, arg);
+	case SENSOR_IOC_G_EXPOSURE_META:
+		return exposure_queue_get_meta(&to_imx_sensor(sd)->expq, arg);
 	default:
 		return -EINVAL;
 	}
@@ -659,6 +696,8 @@ static int power_down(struct v4l2_subdev *sd)
 	return ret;
 }
 
+static void imx_focus_scan_stop(struct imx_device *dev);
+
 static int __imx_s_power(struct v4l2_subdev *sd, int on)
 {
 	struct imx_device *dev = to_imx_sensor(sd);
@@ -666,6 +705,8 @@ static int __imx_s_power(struct v4l2_subdev *sd, int on)
 	int r = 0;
 
 	if (on == 0) {
+		imx_focus_scan_stop(dev);
+		exposure_queue_reset(&dev->expq);
 		ret = power_down(sd);
 		if (dev->vcm_driver && dev->vcm_driver->power_down)
 			r = dev->vcm_driver->power_down(sd);
@@ -1138,6 +1179,157 @@ int imx_t_vcm_timing(struct v4l2_subdev *sd, s32 value)
 	return 0;
 }
 
+static void imx_focus_scan_work(struct work_struct *work)
+{
+	struct imx_device *dev = container_of(work, struct imx_device,
+					      focus_scan.work);
+	struct imx_focus_scan_engine *scan = &dev->focus_scan;
+	unsigned int step;
+	u32 sof;
+	s32 pos;
+	int ret;
+
+	spin_lock_irq(&scan->lock);
+	if (!scan->active || scan->next >= scan->req.num_steps) {
+		scan->active = false;
+		scan->busy = false;
+		spin_unlock_irq(&scan->lock);
+		return;
+	}
+	step = scan->next++;
+	pos = scan->req.position[step];
+	sof = scan->step_sof;
+	spin_unlock_irq(&scan->lock);
+
+	ret = imx_t_focus_abs(&dev->sd, pos);
+
+	spin_lock_irq(&scan->lock);
+	scan->status.position[step] = pos;
+	scan->status.timestamp_ns[step] = ktime_to_ns(ktime_get());
+	scan->status.sof[step] = sof;
+	scan->status.num_done = step + 1;
+	if (ret) {
+		scan->status.error = ret;
+		scan->active = false;
+	} else if (scan->next >= scan->req.num_steps) {
+		scan->active = false;
+	}
+	scan->busy = false;
+	spin_unlock_irq(&scan->lock);
+}
+
+/*
+ * Called from the ISP interrupt handler on every start of frame. The
+ * lens is moved from a work item, since the VCM i2c writes may sleep.
+ */
+static void imx_focus_scan_sof(struct imx_device *dev, u32 sof)
+{
+	struct imx_focus_scan_engine *scan = &dev->focus_scan;
+	unsigned long flags;
+	bool due;
+
+	spin_lock_irqsave(&scan->lock, flags);
+	/*
+	 * A move still in flight delays the step to the next SOF rather
+	 * than issuing two moves in one frame.
+	 */
+	due = scan->active && !scan->busy &&
+		(!scan->next || (s32)(sof - scan->next_sof) >= 0);
+	if (due) {
+		scan->busy = true;
+		scan->step_sof = sof;
+		scan->next_sof = sof + scan->frames_per_step;
+	}
+	spin_unlock_irqrestore(&scan->lock, flags);
+
+	if (due)
+		schedule_work(&scan->work);
+}
+
+static void imx_focus_scan_init(struct imx_device *dev)
+{
+	struct imx_focus_scan_engine *scan = &dev->focus_scan;
+
+	spin_lock_init(&scan->lock);
+	INIT_WORK(&scan->work, imx_focus_scan_work);
+}
+
+/*
+ * Stop issuing steps. Safe to call with the sensor lock held: a move
+ * already running still completes.
+ */
+static void imx_focus_scan_cancel(struct imx_device *dev)
+{
+	struct imx_focus_scan_engine *scan = &dev->focus_scan;
+
+	spin_lock_irq(&scan->lock);
+	scan->active = false;
+	spin_unlock_irq(&scan->lock);
+}
+
+static void imx_focus_scan_stop(struct imx_device *dev)
+{
+	struct imx_focus_scan_engine *scan = &dev->focus_scan;
+
+	imx_focus_scan_cancel(dev);
+	cancel_work_sync(&scan->work);
+
+	/* a move cancelled before it ran never clears busy */
+	spin_lock_irq(&scan->lock);
+	scan->busy = false;
+	spin_unlock_irq(&scan->lock);
+}
+
+static long imx_s_focus_scan(struct v4l2_subdev *sd,
+			     struct imx_focus_scan *req)
+{
+	struct imx_device *dev = to_imx_sensor(sd);
+	struct imx_focus_scan_engine *scan = &dev->focus_scan;
+	int ret = 0;
+
+	if (req->num_steps > IMX_FOCUS_SCAN_MAX_STEPS)
+		return -EINVAL;
+	if (!dev->vcm_driver || !dev->vcm_driver->t_focus_abs)
+		return -ENODEV;
+
+	/* Steps are paced by SOF, which only comes while streaming */
+	mutex_lock(&dev->input_lock);
+	if (!dev->streaming) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	/* the VCM moves do not take input_lock */
+	imx_focus_scan_stop(dev);
+	/* A scan without steps only cancels the running one */
+	if (!req->num_steps)
+		goto out;
+
+	spin_lock_irq(&scan->lock);
+	scan->req = *req;
+	memset(&scan->status, 0, sizeof(scan->status));
+	scan->next = 0;
+	scan->frames_per_step = req->frames_per_step ? : 1;
+	scan->active = true;
+	spin_unlock_irq(&scan->lock);
+out:
+	mutex_unlock(&dev->input_lock);
+	return ret;
+}
+
+static long imx_g_focus_scan(struct v4l2_subdev *sd,
+			     struct imx_focus_scan_status *status)
+{
+	struct imx_focus_scan_engine *scan = &to_imx_sensor(sd)->focus_scan;
+
+	spin_lock_irq(&scan->lock);
+	*status = scan->status;
+	status->active = scan->active;
+	spin_unlock_irq(&scan->lock);
+
+	return 0;
+}
+
 static int imx_s_ctrl(struct v4l2_ctrl *ctrl)
 {
 	struct imx_device *dev = container_of(
@@ -1887,6 +2079,8 @@ static int imx_s_stream(struct v4l2_subdev *sd, int enable)
 		}
 		dev->streaming = 0;
 		dev->targetfps = 0;
+		exposure_queue_reset(&dev->expq);
+		imx_focus_scan_cancel(dev);
 	}
 	mutex_unlock(&dev->input_lock);
 
@@ -2084,7 +2278,7 @@ static int imx_s_config(struct v4l2_subdev *sd,
 	if (ret)
 		goto fail_detect;
 	/* Read sensor's OTP data */
-	dev->otp_data = dev->otp_driver->otp_read(sd,
+	dev->otp_data = imx_otp_cached_read(sd, dev->otp_driver->otp_read,
 		dev->otp_driver->dev_addr, dev->otp_driver->start_addr,
 		dev->otp_driver->size);
 
@@ -2399,6 +2593,7 @@ static const struct v4l2_subdev_core_ops imx_core_ops = {
 	.s_power = imx_s_power,
 	.ioctl = imx_ioctl,
 	.init = imx_init,
+	.interrupt_service_routine = imx_interrupt_service_routine,
 };
 
 static const struct v4l2_subdev_pad_ops imx_pad_ops = {
@@ -2424,6 +2619,9 @@ static int imx_remove(struct i2c_client *client)
 	struct v4l2_subdev *sd = i2c_get_clientdata(client);
 	struct imx_device *dev = to_imx_sensor(sd);
 
+	imx_focus_scan_stop(dev);
+	exposure_queue_release(&dev->expq);
+
 	if (dev->platform_data->platform_deinit)
 		dev->platform_data->platform_deinit();
 
@@ -2516,6 +2714,9 @@ static int imx_probe(struct i2c_client *client,
 	}
 
 	mutex_init(&dev->input_lock);
+	imx_focus_scan_init(dev);
+	exposure_queue_init(&dev->expq, &dev->sd, imx_apply_frame_exposure,
+			    IMX_EXPOSURE_APPLY_DELAY);
 
 	dev->i2c_id = id->driver_data;
 	dev->fmt_idx = 0;
@@ -2615,6 +2816,7 @@ static __init int init_imx(void)
 static __exit void exit_imx(void)
 {
 	i2c_del_driver(&imx_driver);
+	imx_otp_cache_release();
 }
 
 module_init(init_imx);
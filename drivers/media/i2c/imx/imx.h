@@ -29,6 +29,7 @@
 #include <linux/spinlock.h>
 #include <linux/types.h>
 #include <linux/videodev2.h>
+#include <linux/workqueue.h>
 #include <linux/v4l2-mediabus.h>
 #include <media/media-entity.h>
 #ifndef CONFIG_GMIN_INTEL_MID /* FIXME! for non-gmin*/
@@ -43,6 +44,7 @@
 #include "imx132.h"
 #include "imx208.h"
 #include "imx219.h"
+#include "exposure_queue.h"
 
 #define IMX_MCLK		192
 
@@ -109,6 +111,8 @@
 #define IMX_MAX_DIGITAL_GAIN_SUPPORTED 0x0fff
 
 #define MAX_FMTS 1
+/* Exposure written after SOF of frame N is latched for frame N + 1 */
+#define IMX_EXPOSURE_APPLY_DELAY	1
 #define IMX_OTP_DATA_SIZE		1280
 
 #define IMX_SUBDEV_PREFIX "imx"
@@ -203,6 +207,48 @@
  */
 #define IMX_F_NUMBER_RANGE 0x160a160a
 
+/*
+ * AF lens scan: a list of VCM positions moved to one after another, one
+ * step every frames_per_step frames. The moves are issued on the start
+ * of frame, so a scan can only be started or cancelled while streaming;
+ * stream off cancels it. The position, time and SOF frame number of
+ * every completed step can be read back as per-frame lens metadata.
+ */
+#define IMX_FOCUS_SCAN_MAX_STEPS	32
+
+struct imx_focus_scan {
+	__u32 num_steps;
+	__u32 frames_per_step;		/* 0: one step per frame */
+	__s32 position[IMX_FOCUS_SCAN_MAX_STEPS];
+};
+
+struct imx_focus_scan_status {
+	__u32 num_done;			/* steps issued so far */
+	__s32 error;			/* first failed move, 0 if none */
+	__u32 active;
+	__s32 position[IMX_FOCUS_SCAN_MAX_STEPS];
+	__u64 timestamp_ns[IMX_FOCUS_SCAN_MAX_STEPS];	/* monotonic */
+	__u32 sof[IMX_FOCUS_SCAN_MAX_STEPS];	/* frame the move began in */
+};
+
+#define IMX_IOC_S_FOCUS_SCAN \
+	_IOW('v', BASE_VIDIOC_PRIVATE + 100, struct imx_focus_scan)
+#define IMX_IOC_G_FOCUS_SCAN \
+	_IOR('v', BASE_VIDIOC_PRIVATE + 101, struct imx_focus_scan_status)
+
+struct imx_focus_scan_engine {
+	spinlock_t lock;
+	struct work_struct work;
+	struct imx_focus_scan req;
+	struct imx_focus_scan_status status;
+	unsigned int next;		/* next step to issue */
+	u32 frames_per_step;
+	u32 next_sof;			/* SOF the next step is due at */
+	u32 step_sof;			/* SOF of the step being issued */
+	bool busy;			/* a move is queued or running */
+	bool active;
+};
+
 struct imx_vcm {
 	int (*power_up)(struct v4l2_subdev *sd);
 	int (*power_down)(struct v4l2_subdev *sd);
@@ -472,6 +518,9 @@ struct imx_device {
 	struct v4l2_ctrl *tp_gr;
 	struct v4l2_ctrl *tp_gb;
 	struct v4l2_ctrl *tp_b;
+
+	struct imx_focus_scan_engine focus_scan;
+	struct exposure_queue expq;
 };
 
 #define to_imx_sensor(x) container_of(x, struct imx_device, sd)
@@ -673,6 +722,11 @@ extern void *e2prom_otp_read(struct v4l2_subdev *sd, u8 dev_addr,
 	u32 start_addr, u32 size);
 extern void *brcc064_otp_read(struct v4l2_subdev *sd, u8 dev_addr,
 	u32 start_addr, u32 size);
+extern void *imx_otp_cached_read(struct v4l2_subdev *sd,
+	void *(*otp_read)(struct v4l2_subdev *sd, u8 dev_addr,
+		u32 start_addr, u32 size),
+	u8 dev_addr, u32 start_addr, u32 size);
+extern void imx_otp_cache_release(void);
 struct imx_otp imx_otps[] = {
 	[IMX175_MERRFLD] = {
 		.otp_read = imx_otp_read,
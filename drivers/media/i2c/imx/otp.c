@@ -16,11 +16,16 @@
  * 02110-1301, USA.
  *
  */
+#include <linux/crc32.h>
 #include <linux/device.h>
 #include <linux/errno.h>
 #include <linux/i2c.h>
 #include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/list.h>
 #include <linux/mm.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
 #include <linux/string.h>
 #include <linux/types.h>
 #ifndef CONFIG_GMIN_INTEL_MID /* FIXME! for non-gmin*/
@@ -40,3 +45,104 @@ void *dummy_otp_read(struct v4l2_subdev *sd, u8 dev_addr,
 
 	return buf;
 }
+
+/*
+ * Module calibration data never changes, so a copy of every OTP/EEPROM
+ * blob read is kept for the lifetime of the module and handed out again
+ * when the same module is probed. Each copy is validated with a CRC
+ * before it is reused; on mismatch the data is read from the chip again.
+ */
+struct imx_otp_cache {
+	struct list_head list;
+	int adapter_nr;
+	u16 client_addr;
+	u8 dev_addr;
+	u32 start_addr;
+	u32 size;
+	u32 crc;
+	u8 data[0];
+};
+
+static LIST_HEAD(imx_otp_cache_list);
+static DEFINE_MUTEX(imx_otp_cache_lock);
+
+static struct imx_otp_cache *imx_otp_cache_find(struct i2c_client *client,
+	u8 dev_addr, u32 start_addr, u32 size)
+{
+	struct imx_otp_cache *entry;
+
+	list_for_each_entry(entry, &imx_otp_cache_list, list)
+		if (entry->adapter_nr == i2c_adapter_id(client->adapter) &&
+		    entry->client_addr == client->addr &&
+		    entry->dev_addr == dev_addr &&
+		    entry->start_addr == start_addr &&
+		    entry->size == size)
+			return entry;
+
+	return NULL;
+}
+
+void *imx_otp_cached_read(struct v4l2_subdev *sd,
+	void *(*otp_read)(struct v4l2_subdev *sd, u8 dev_addr,
+		u32 start_addr, u32 size),
+	u8 dev_addr, u32 start_addr, u32 size)
+{
+	struct i2c_client *client = v4l2_get_subdevdata(sd);
+	struct imx_otp_cache *entry;
+	ktime_t start = ktime_get();
+	void *buf;
+
+	mutex_lock(&imx_otp_cache_lock);
+	entry = imx_otp_cache_find(client, dev_addr, start_addr, size);
+	if (entry) {
+		if (crc32_le(~0, entry->data, size) == entry->crc) {
+			buf = devm_kzalloc(&client->dev, size, GFP_KERNEL);
+			if (buf)
+				memcpy(buf, entry->data, size);
+			mutex_unlock(&imx_otp_cache_lock);
+			if (!buf)
+				return ERR_PTR(-ENOMEM);
+			dev_info(&client->dev, "OTP data loaded from cache in %lld us\n",
+				 ktime_us_delta(ktime_get(), start));
+			return buf;
+		}
+		dev_warn(&client->dev, "OTP cache corrupted, reading again\n");
+		list_del(&entry->list);
+		kfree(entry);
+	}
+
+	buf = otp_read(sd, dev_addr, start_addr, size);
+	if (IS_ERR_OR_NULL(buf)) {
+		mutex_unlock(&imx_otp_cache_lock);
+		return buf;
+	}
+
+	entry = kmalloc(sizeof(*entry) + size, GFP_KERNEL);
+	if (entry) {
+		entry->adapter_nr = i2c_adapter_id(client->adapter);
+		entry->client_addr = client->addr;
+		entry->dev_addr = dev_addr;
+		entry->start_addr = start_addr;
+		entry->size = size;
+		memcpy(entry->data, buf, size);
+		entry->crc = crc32_le(~0, entry->data, size);
+		list_add(&entry->list, &imx_otp_cache_list);
+	}
+	mutex_unlock(&imx_otp_cache_lock);
+
+	dev_info(&client->dev, "OTP data (%u bytes) read in %lld us\n",
+		 size, ktime_us_delta(ktime_get(), start));
+	return buf;
+}
+
+void imx_otp_cache_release(void)
+{
+	struct imx_otp_cache *entry, *tmp;
+
+	mutex_lock(&imx_otp_cache_lock);
+	list_for_each_entry_safe(entry, tmp, &imx_otp_cache_list, list) {
+		list_del(&entry->list);
+		kfree(entry);
+	}
+	mutex_unlock(&imx_otp_cache_lock);
+}
@@ -45,8 +45,9 @@ void *e2prom_otp_read(struct v4l2_subdev *sd, u8 dev_addr,
 {
 	struct i2c_client *client = v4l2_get_subdevdata(sd);
 	unsigned int e2prom_i2c_addr = dev_addr >> 1;
-	static const unsigned int max_read_size = 30;
+	static const unsigned int max_read_size = E2PROM_MAX_READ_SIZE;
 	int addr;
+	u32 len;
 	u32 s_addr = start_addr & E2PROM_ADDR_MASK;
 	bool two_addr = (start_addr & E2PROM_2ADDR) >> 31;
 	char *buffer;
@@ -55,7 +56,7 @@ void *e2prom_otp_read(struct v4l2_subdev *sd, u8 dev_addr,
 	if (!buffer)
 		return NULL;
 
-	for (addr = s_addr; addr < size; addr += max_read_size) {
+	for (addr = s_addr; addr < size; addr += len) {
 		struct i2c_msg msg[2];
 		unsigned int i2c_addr = e2prom_i2c_addr;
 		u16 addr_buf;
@@ -77,12 +78,14 @@ void *e2prom_otp_read(struct v4l2_subdev *sd, u8 dev_addr,
 
 		msg[1].addr = i2c_addr;
 		msg[1].flags = I2C_M_RD;
-		msg[1].len = min(max_read_size, size - addr);
+		/* Sequential read, never crossing a block boundary */
+		len = min(max_read_size - addr % max_read_size, size - addr);
+		msg[1].len = len;
 		msg[1].buf = &buffer[addr];
 
 		r = i2c_transfer(client->adapter, msg, ARRAY_SIZE(msg));
 		if (r != ARRAY_SIZE(msg)) {
-			kfree(buffer);
+			devm_kfree(&client->dev, buffer);
 			dev_err(&client->dev, "read failed at 0x%03x\n", addr);
 			return NULL;
 		}
@@ -44,36 +44,36 @@
 #define IMX_OTP_MODE_REG		0x3B00
 #define IMX_OTP_PAGE_MAX		20
 #define IMX_OTP_READY_REG_DONE		1
-#define IMX_OTP_READ_ONETIME		32
+#define IMX_OTP_READ_ONETIME		IMX_OTP_PAGE_SIZE
 #define IMX_OTP_MODE_READ		1
 
 static int
 imx_read_otp_data(struct i2c_client *client, u16 len, u16 reg, void *val)
 {
 	struct i2c_msg msg[2];
-	u16 data[IMX_SHORT_MAX] = { 0 };
+	u16 addr;
 	int err;
 
-	if (len > IMX_BYTE_MAX) {
+	if (len > IMX_OTP_PAGE_SIZE) {
 		dev_err(&client->dev, "%s error, invalid data length\n",
 			__func__);
 		return -EINVAL;
 	}
 
 	memset(msg, 0 , sizeof(msg));
-	memset(data, 0 , sizeof(data));
 
 	msg[0].addr = client->addr;
 	msg[0].flags = 0;
 	msg[0].len = I2C_MSG_LENGTH;
-	msg[0].buf = (u8 *)data;
+	msg[0].buf = (u8 *)&addr;
 	/* high byte goes first */
-	data[0] = cpu_to_be16(reg);
+	addr = cpu_to_be16(reg);
 
+	/* Read the whole block straight into the caller's buffer */
 	msg[1].addr = client->addr;
 	msg[1].len = len;
 	msg[1].flags = I2C_M_RD;
-	msg[1].buf = (u8 *)data;
+	msg[1].buf = val;
 
 	err = i2c_transfer(client->adapter, msg, 2);
 	if (err != 2) {
@@ -82,7 +82,6 @@ imx_read_otp_data(struct i2c_client *client, u16 len, u16 reg, void *val)
 		goto error;
 	}
 
-	memcpy(val, data, len);
 	return 0;
 
 error:
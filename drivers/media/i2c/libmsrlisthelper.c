@@ -21,7 +21,9 @@
 #include <linux/device.h>
 #include <linux/export.h>
 #include <linux/libmsrlisthelper.h>
+#include <linux/list.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/slab.h>
 
 /* Tagged binary data container structure definitions. */
@@ -50,47 +52,102 @@ struct tbd_data_record_header {
 
 #define TBD_CLASS_DRV_ID 2
 
-static int set_msr_configuration(struct i2c_client *client, uint8_t *bufptr,
-		unsigned int size)
-{
-	/* The configuration data contains any number of sequences where
-	 * the first byte (that is, uint8_t) that marks the number of bytes
-	 * in the sequence to follow, is indeed followed by the indicated
-	 * number of bytes of actual data to be written to sensor.
-	 * By convention, the first two bytes of actual data should be
-	 * understood as an address in the sensor address space (hibyte
-	 * followed by lobyte) where the remaining data in the sequence
-	 * will be written. */
+/*
+ * Largest single write we build when merging adjacent MSR sequences.
+ * The length of a sequence in the container is an uint8_t, so no adapter
+ * on this platform is expected to handle anything longer in one message.
+ */
+#define MSR_MAX_MERGED_LEN	255
+/* Number of messages combined into one i2c_transfer() call */
+#define MSR_MAX_XFER_MSGS	16
 
+/*
+ * Parsed and merged form of one DRVB container. It is built the first
+ * time the firmware is applied and kept until release_msr_list(), so
+ * that the sensor power cycles do not re-walk the container.
+ */
+struct msr_cache {
+	struct list_head list;
+	const struct firmware *fw;
+	unsigned int num_msgs;
+	struct i2c_msg *msgs;
+	uint8_t *data;
+};
+
+static LIST_HEAD(msr_cache_list);
+static DEFINE_MUTEX(msr_cache_lock);
+
+/*
+ * Walk the MSR sequences of one dataset. The configuration data contains
+ * any number of sequences where the first byte (that is, uint8_t) that
+ * marks the number of bytes in the sequence to follow, is indeed followed
+ * by the indicated number of bytes of actual data to be written to sensor.
+ * By convention, the first two bytes of actual data should be understood
+ * as an address in the sensor address space (hibyte followed by lobyte)
+ * where the remaining data in the sequence will be written.
+ *
+ * If cache is NULL, only validate the data and count the messages and
+ * bytes needed. Otherwise append the sequences to cache, merging each one
+ * into the previous message when it continues at the next address.
+ */
+static int msr_build_msgs(struct i2c_client *client, struct msr_cache *cache,
+		uint8_t *bufptr, unsigned int size, unsigned int *num_msgs,
+		unsigned int *num_bytes)
+{
 	uint8_t *ptr = bufptr;
+	uint8_t *dst = cache ? cache->data + *num_bytes : NULL;
+
 	while (ptr < bufptr + size) {
-		struct i2c_msg msg = {
-			.addr = client->addr,
-			.flags = 0,
-		};
-		int ret;
-
-		/* How many bytes */
-		msg.len = *ptr++;
-		/* Where the bytes are located */
-		msg.buf = ptr;
-		ptr += msg.len;
+		struct i2c_msg *prev = NULL;
+		unsigned int len = *ptr++;
+		uint8_t *src = ptr;
 
+		ptr += len;
 		if (ptr > bufptr + size)
 			/* Accessing data beyond bounds is not tolerated */
 			return -EINVAL;
 
-		ret = i2c_transfer(client->adapter, &msg, 1);
-		if (ret < 0) {
-			dev_err(&client->dev, "i2c write error: %d", ret);
-			return ret;
+		if (!cache) {
+			(*num_msgs)++;
+			*num_bytes += len;
+			continue;
+		}
+
+		if (cache->num_msgs)
+			prev = &cache->msgs[cache->num_msgs - 1];
+
+		/* Merge only plain register writes continuing at the next
+		 * address of the previous message. */
+		if (prev && prev->len >= 2 && len > 2 &&
+		    prev->len + len - 2 <= MSR_MAX_MERGED_LEN &&
+		    ((prev->buf[0] << 8) | prev->buf[1]) + prev->len - 2 ==
+		    ((src[0] << 8) | src[1])) {
+			memcpy(dst, src + 2, len - 2);
+			dst += len - 2;
+			*num_bytes += len - 2;
+			prev->len += len - 2;
+			continue;
 		}
+
+		memcpy(dst, src, len);
+		cache->msgs[cache->num_msgs].addr = client->addr;
+		cache->msgs[cache->num_msgs].flags = 0;
+		cache->msgs[cache->num_msgs].len = len;
+		cache->msgs[cache->num_msgs].buf = dst;
+		cache->num_msgs++;
+		dst += len;
+		*num_bytes += len;
 	}
 	return 0;
 }
 
-static int parse_and_apply(struct i2c_client *client, uint8_t *buffer,
-		unsigned int size)
+/*
+ * Iterate over the datasets in the record. Same convention as
+ * msr_build_msgs(): a NULL cache only validates and sizes the data.
+ */
+static int parse_datasets(struct i2c_client *client, struct msr_cache *cache,
+		uint8_t *buffer, unsigned int size, unsigned int *num_msgs,
+		unsigned int *num_bytes)
 {
 	uint8_t *endptr8 = buffer + size;
 	struct tbd_data_record_header *header =
@@ -116,12 +173,13 @@ static int parse_and_apply(struct i2c_client *client, uint8_t *buffer,
 		if (header->data_size && (header->flags & 1)) {
 			int ret;
 
-			dev_info(&client->dev,
-				"New MSR data for sensor driver (dataset %02d) size:%d\n",
-				dataset, header->data_size);
-			ret = set_msr_configuration(client,
-						buffer + header->data_offset,
-						header->data_size);
+			if (!cache)
+				dev_info(&client->dev,
+					"New MSR data for sensor driver (dataset %02d) size:%d\n",
+					dataset, header->data_size);
+			ret = msr_build_msgs(client, cache,
+					buffer + header->data_offset,
+					header->data_size, num_msgs, num_bytes);
 			if (ret)
 				return ret;
 		}
@@ -132,41 +190,135 @@ static int parse_and_apply(struct i2c_client *client, uint8_t *buffer,
 	return 0;
 }
 
-int apply_msr_data(struct i2c_client *client, const struct firmware *fw)
+static void free_msr_cache(struct msr_cache *cache)
+{
+	list_del(&cache->list);
+	kfree(cache->msgs);
+	kfree(cache->data);
+	kfree(cache);
+}
+
+static struct msr_cache *parse_msr_cache(struct i2c_client *client,
+		const struct firmware *fw)
 {
 	struct tbd_header *header;
 	struct tbd_record_header *record;
-
-	if (!fw) {
-		dev_warn(&client->dev, "Drv data is not loaded.\n");
-		return -EINVAL;
-	}
+	struct msr_cache *cache;
+	unsigned int num_msgs = 0, num_bytes = 0;
+	int ret;
 
 	if (sizeof(*header) > fw->size)
-		return -EINVAL;
+		return ERR_PTR(-EINVAL);
 
 	header = (struct tbd_header *)fw->data;
 	/* Check that we have drvb block. */
 	if (memcmp(&header->tag, "DRVB", 4))
-		return -EINVAL;
+		return ERR_PTR(-EINVAL);
 
 	/* Check the size */
 	if (header->size != fw->size)
-		return -EINVAL;
+		return ERR_PTR(-EINVAL);
 
 	if (sizeof(*header) + sizeof(*record) > fw->size)
-		return -EINVAL;
+		return ERR_PTR(-EINVAL);
 
 	record = (struct tbd_record_header *)(header + 1);
 	/* Check that class id mathes tbd's drv id. */
 	if (record->class_id != TBD_CLASS_DRV_ID)
-		return -EINVAL;
+		return ERR_PTR(-EINVAL);
 
 	/* Size 0 shall not be treated as an error */
-	if (!record->size)
-		return 0;
+	if (record->size) {
+		ret = parse_datasets(client, NULL, (uint8_t *)(record + 1),
+				record->size, &num_msgs, &num_bytes);
+		if (ret)
+			return ERR_PTR(ret);
+	}
+
+	cache = kzalloc(sizeof(*cache), GFP_KERNEL);
+	if (!cache)
+		return ERR_PTR(-ENOMEM);
+	cache->fw = fw;
+	INIT_LIST_HEAD(&cache->list);
+
+	if (num_msgs) {
+		cache->msgs = kcalloc(num_msgs, sizeof(*cache->msgs),
+				GFP_KERNEL);
+		cache->data = kmalloc(num_bytes, GFP_KERNEL);
+		if (!cache->msgs || !cache->data) {
+			kfree(cache->msgs);
+			kfree(cache->data);
+			kfree(cache);
+			return ERR_PTR(-ENOMEM);
+		}
+		num_bytes = 0;
+		ret = parse_datasets(client, cache, (uint8_t *)(record + 1),
+				record->size, &num_msgs, &num_bytes);
+		if (ret) {
+			kfree(cache->msgs);
+			kfree(cache->data);
+			kfree(cache);
+			return ERR_PTR(ret);
+		}
+		dev_dbg(&client->dev, "MSR data merged from %u to %u writes\n",
+			num_msgs, cache->num_msgs);
+	}
 
-	return parse_and_apply(client, (uint8_t *)(record + 1), record->size);
+	return cache;
+}
+
+static int set_msr_configuration(struct i2c_client *client,
+		struct msr_cache *cache)
+{
+	/* Several writes may go in one transfer only if the controller
+	 * issues them back to back with repeated start conditions. */
+	unsigned int step = i2c_check_functionality(client->adapter,
+				I2C_FUNC_I2C) ? MSR_MAX_XFER_MSGS : 1;
+	unsigned int i, n;
+	int ret;
+
+	for (i = 0; i < cache->num_msgs; i += n) {
+		n = min(step, cache->num_msgs - i);
+		/* Messages are built for the client that parsed them */
+		ret = i2c_transfer(client->adapter, &cache->msgs[i], n);
+		if (ret < 0) {
+			dev_err(&client->dev, "i2c write error: %d", ret);
+			return ret;
+		}
+		if (ret != n) {
+			dev_err(&client->dev, "i2c short write: %d/%u", ret, n);
+			return -EIO;
+		}
+	}
+	return 0;
+}
+
+int apply_msr_data(struct i2c_client *client, const struct firmware *fw)
+{
+	struct msr_cache *cache;
+	int ret;
+
+	if (!fw) {
+		dev_warn(&client->dev, "Drv data is not loaded.\n");
+		return -EINVAL;
+	}
+
+	mutex_lock(&msr_cache_lock);
+	list_for_each_entry(cache, &msr_cache_list, list)
+		if (cache->fw == fw)
+			goto apply;
+
+	cache = parse_msr_cache(client, fw);
+	if (IS_ERR(cache)) {
+		mutex_unlock(&msr_cache_lock);
+		return PTR_ERR(cache);
+	}
+	list_add(&cache->list, &msr_cache_list);
+
+apply:
+	ret = set_msr_configuration(client, cache);
+	mutex_unlock(&msr_cache_lock);
+	return ret;
 }
 EXPORT_SYMBOL_GPL(apply_msr_data);
 
@@ -189,6 +341,17 @@ EXPORT_SYMBOL_GPL(load_msr_list);
 
 void release_msr_list(struct i2c_client *client, const struct firmware *fw)
 {
+	struct msr_cache *cache;
+
+	mutex_lock(&msr_cache_lock);
+	list_for_each_entry(cache, &msr_cache_list, list) {
+		if (cache->fw == fw) {
+			free_msr_cache(cache);
+			break;
+		}
+	}
+	mutex_unlock(&msr_cache_lock);
+
 	release_firmware(fw);
 }
 EXPORT_SYMBOL_GPL(release_msr_list);
@@ -200,6 +363,12 @@ static int init_msrlisthelper(void)
 
 static void exit_msrlisthelper(void)
 {
+	struct msr_cache *cache, *tmp;
+
+	mutex_lock(&msr_cache_lock);
+	list_for_each_entry_safe(cache, tmp, &msr_cache_list, list)
+		free_msr_cache(cache);
+	mutex_unlock(&msr_cache_lock);
 }
 
 module_init(init_msrlisthelper);
@@ -465,6 +465,27 @@ static int ov8858_s_exposure(struct v4l2_subdev *sd,
 				exposure->gain[0], exposure->gain[1]);
 }
 
+static int ov8858_apply_frame_exposure(struct v4l2_subdev *sd,
+				       struct atomisp_exposure *exposure)
+{
+	/* Queued exposures only make sense while streaming */
+	if (!to_ov8858_sensor(sd)->streaming)
+		return -EAGAIN;
+
+	return ov8858_s_exposure(sd, exposure);
+}
+
+static int ov8858_interrupt_service_routine(struct v4l2_subdev *sd,
+					    u32 status, bool *handled)
+{
+	/* status is the frame number of the start of frame */
+	exposure_queue_sof(&to_ov8858_sensor(sd)->expq, status);
+	if (handled)
+		*handled = true;
+
+	return 0;
+}
+
 static int ov8858_g_priv_int_data(struct v4l2_subdev *sd,
 				  struct v4l2_private_int_data *priv)
 {
@@ -629,6 +650,11 @@ static long ov8858_ioctl(struct v4l2_subdev *sd, unsigned int cmd, void *arg)
 		return ov8858_s_exposure(sd, (struct atomisp_exposure *)arg);
 	case ATOMISP_IOC_G_SENSOR_PRIV_INT_DATA:
 		return ov8858_g_priv_int_data(sd, arg);
+	case SENSOR_IOC_Q_FRAME_EXPOSURE:
+		return exposure_queue_add(&to_ov8858_sensor(sd)->expq, arg);
+	case SENSOR_IOC_G_EXPOSURE_META:
+		return exposure_queue_get_meta(&to_ov8858_sensor(sd)->expq,
+					       arg);
 	default:
 		dev_err(&client->dev, "Unhandled command 0x%X\n", cmd);
 		return -EINVAL;
@@ -702,6 +728,7 @@ static int __ov8858_s_power(struct v4l2_subdev *sd, int on)
 	int ret, r;
 
 	if (on == 0) {
+		exposure_queue_reset(&dev->expq);
 		ov8858_uninit(sd);
 		ret = power_down(sd);
 		if (dev->vcm_driver && dev->vcm_driver->power_down) {
@@ -1372,6 +1399,7 @@ static int ov8858_s_stream(struct v4l2_subdev *sd, int enable)
 		dev->streaming = 0;
 		dev->fps_index = 0;
 		dev->fps = 0;
+		exposure_queue_reset(&dev->expq);
 	}
 out:
 	mutex_unlock(&dev->input_lock);
@@ -1821,6 +1849,7 @@ static const struct v4l2_subdev_core_ops ov8858_core_ops = {
 	.s_power = ov8858_s_power,
 	.ioctl = ov8858_ioctl,
 	.init = ov8858_init,
+	.interrupt_service_routine = ov8858_interrupt_service_routine,
 };
 
 static const struct v4l2_subdev_pad_ops ov8858_pad_ops = {
@@ -1845,6 +1874,8 @@ static int ov8858_remove(struct i2c_client *client)
 {
 	struct v4l2_subdev *sd = i2c_get_clientdata(client);
 	struct ov8858_device *dev = to_ov8858_sensor(sd);
+
+	exposure_queue_release(&dev->expq);
 	if (dev->platform_data->platform_deinit)
 		dev->platform_data->platform_deinit();
 
@@ -1994,6 +2025,8 @@ static int ov8858_probe(struct i2c_client *client,
 	}
 
 	mutex_init(&dev->input_lock);
+	exposure_queue_init(&dev->expq, &dev->sd, ov8858_apply_frame_exposure,
+			    OV8858_EXPOSURE_APPLY_DELAY);
 
 	dev->i2c_id = id->driver_data;
 	dev->fmt_idx = 0;
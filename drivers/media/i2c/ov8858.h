@@ -23,6 +23,7 @@
 #define __OV8858_H__
 #include <linux/atomisp_platform.h>
 #include <media/v4l2-ctrls.h>
+#include "imx/exposure_queue.h"
 
 #define I2C_MSG_LENGTH		0x2
 
@@ -145,6 +146,8 @@
 #define OV8858_READ_MODE_BINNING_OFF		0x00   /* ToDo: Check this */
 #define OV8858_BIN_FACTOR_MAX			2
 #define OV8858_INTEGRATION_TIME_MARGIN		14
+/* Exposure written after SOF of frame N is latched for frame N + 1 */
+#define OV8858_EXPOSURE_APPLY_DELAY		1
 
 #define OV8858_MAX_VTS_VALUE			0xFFFF
 #define OV8858_MAX_EXPOSURE_VALUE \
@@ -258,6 +261,8 @@ struct ov8858_device {
 
 	struct v4l2_ctrl_handler ctrl_handler;
 	struct v4l2_ctrl *run_mode;
+
+	struct exposure_queue expq;
 };
 
 #define to_ov8858_sensor(x) container_of(x, struct ov8858_device, sd)
@@ -32,6 +32,7 @@
 #include "atomisp_compat.h"
 #include "atomisp_cmd.h"
 
+#include "hmm/hmm.h"
 #include "hrt/hive_isp_css_mm_hrt.h"
 #include "memory_access/memory_access.h"
 #include "ia_css.h"
@@ -109,6 +110,20 @@ static int acc_stop_acceleration(struct atomisp_device *isp)
 	return ret;
 }
 
+/* Write back the CPU caches of the buffers mapped for the binaries */
+static void acc_flush_maps(struct atomisp_device *isp)
+{
+	struct atomisp_map *atomisp_map;
+
+	if (isp->flush_wbinvd) {
+		wbinvd();
+		return;
+	}
+
+	list_for_each_entry(atomisp_map, &isp->acc.memory_maps, list)
+		hmm_flush_cache(atomisp_map->ptr);
+}
+
 void atomisp_acc_init(struct atomisp_device *isp)
 {
 	INIT_LIST_HEAD(&isp->acc.fw);
@@ -258,8 +273,7 @@ int atomisp_acc_start(struct atomisp_sub_device *asd, unsigned int *handle)
 	if (isp->acc.pipeline || isp->acc.extension_mode)
 		return -EBUSY;
 
-	/* Invalidate caches. FIXME: should flush only necessary buffers */
-	wbinvd();
+	acc_flush_maps(isp);
 
 	ret = atomisp_css_create_acc_pipe(asd);
 	if (ret)
@@ -454,8 +468,7 @@ int atomisp_acc_load_extensions(struct atomisp_sub_device *asd)
 	if (isp->acc.pipeline || isp->acc.extension_mode)
 		return -EBUSY;
 
-	/* Invalidate caches. FIXME: should flush only necessary buffers */
-	wbinvd();
+	acc_flush_maps(isp);
 
 	list_for_each_entry(acc_fw, &isp->acc.fw, list) {
 		if (acc_fw->type != ATOMISP_ACC_FW_LOAD_TYPE_OUTPUT &&
@@ -0,0 +1,36 @@
+/*
+ * Support for Medifield PNW Camera Imaging ISP subsystem.
+ *
+ * Copyright (c) 2010 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+
+#include "atomisp_buf_batch.h"
+
+int atomisp_buf_batch_result(struct atomisp_buf_batch *batch,
+			     unsigned int prepared, int prep_ret,
+			     unsigned int handled, int ret)
+{
+	batch->done = handled;
+	if (handled < prepared)
+		batch->entry[handled].result = ret;
+	else if (prepared < batch->count)
+		batch->entry[prepared].result = ret = prep_ret;
+
+	return handled ? 0 : ret;
+}
@@ -0,0 +1,69 @@
+/*
+ * Support for Medifield PNW Camera Imaging ISP subsystem.
+ *
+ * Copyright (c) 2010 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+
+#ifndef __ATOMISP_BUF_BATCH_H__
+#define __ATOMISP_BUF_BATCH_H__
+
+#include <linux/videodev2.h>
+
+/*
+ * Batched VIDIOC_QBUF/VIDIOC_DQBUF over the capture pipes of one
+ * sub-device, which are selected by their source pad
+ * (ATOMISP_SUBDEV_PAD_SOURCE_*). Entries are handled in order and the
+ * batch stops at the first failure: done is the number of entries
+ * handled and entry[done].result holds the error. The ioctl only fails
+ * if no entry could be handled. For DQBUF only the first entry honours
+ * blocking mode, the others return what is already done.
+ */
+#define ATOMISP_BUF_BATCH_MAX	8
+
+struct atomisp_buf_batch_entry {
+	__u32 pad;		/* in: source pad of the pipe */
+	__s32 result;		/* out */
+	struct v4l2_buffer buf;
+};
+
+struct atomisp_buf_batch {
+	__u32 count;		/* in */
+	__u32 done;		/* out */
+	struct atomisp_buf_batch_entry entry[ATOMISP_BUF_BATCH_MAX];
+};
+
+#define ATOMISP_IOC_QBUF_BATCH \
+	_IOWR('v', BASE_VIDIOC_PRIVATE + 114, struct atomisp_buf_batch)
+#define ATOMISP_IOC_DQBUF_BATCH \
+	_IOWR('v', BASE_VIDIOC_PRIVATE + 115, struct atomisp_buf_batch)
+
+/*
+ * Record how far a batch got. The first prepared entries passed the
+ * checks under isp->mutex, with prep_ret the error of the entry after
+ * them; the first handled of those were then queued to (or dequeued
+ * from) videobuf, with ret the error of the entry after them. Returns
+ * the ioctl result: 0 once any entry was handled, as results are only
+ * copied back on success. This builds on the host as well, see
+ * buf_batch_check.
+ */
+int atomisp_buf_batch_result(struct atomisp_buf_batch *batch,
+			     unsigned int prepared, int prep_ret,
+			     unsigned int handled, int ret);
+
+#endif /* __ATOMISP_BUF_BATCH_H__ */
@@ -31,6 +31,7 @@
 #include <linux/kfifo.h>
 #include <linux/pm_runtime.h>
 #include <linux/timer.h>
+#include <linux/vmalloc.h>
 #ifndef CONFIG_GMIN_INTEL_MID
 #include <linux/kct.h>
 #endif
@@ -50,6 +51,7 @@
 #include "atomisp_compat.h"
 #include "atomisp_subdev.h"
 #include "atomisp_dfs_tables.h"
+#include "atomisp_pcprof.h"
 
 #include "hrt/hive_isp_css_mm_hrt.h"
 
@@ -260,40 +262,21 @@ static int write_target_freq_to_hw(struct atomisp_device *isp,
 
 	return 0;
 }
-int atomisp_freq_scaling(struct atomisp_device *isp,
-			 enum atomisp_dfs_mode mode,
-			 bool force)
+/*
+ * Look up the DFS table frequency for the current configuration of one
+ * sub-device.
+ */
+static int __atomisp_dfs_rule_freq(struct atomisp_sub_device *asd,
+				   unsigned int *freq)
 {
-	/* FIXME! Only use subdev[0] status yet */
-	struct atomisp_sub_device *asd = &isp->asd[0];
-	unsigned int new_freq;
+	struct atomisp_device *isp = asd->isp;
 	struct atomisp_freq_scaling_rule curr_rules;
-	int i, ret;
-	unsigned short fps = 0;
-
-	if (isp->sw_contex.power_state != ATOM_ISP_POWER_UP) {
-		dev_err(isp->dev, "DFS cannot proceed due to no power.\n");
-		return -EINVAL;
-	}
-
-	if (isp->dfs->lowest_freq == 0 || isp->dfs->max_freq_at_vmin == 0 ||
-	    isp->dfs->highest_freq == 0 || isp->dfs->dfs_table_size == 0 ||
-	    !isp->dfs->dfs_table) {
-		dev_err(isp->dev, "DFS configuration is invalid.\n");
-		return -EINVAL;
-	}
-
-	if (mode == ATOMISP_DFS_MODE_LOW) {
-		new_freq = isp->dfs->lowest_freq;
-		goto done;
-	}
-
-	if (mode == ATOMISP_DFS_MODE_MAX) {
-		new_freq = isp->dfs->highest_freq;
-		goto done;
-	}
+	unsigned short fps;
+	int i;
 
+	/* without fps the governor leaves the sub-device out as well */
 	fps = atomisp_get_sensor_fps(asd);
+	asd->dfs_fps = fps;
 	if (fps == 0)
 		return -EINVAL;
 
@@ -332,11 +315,18 @@ int atomisp_freq_scaling(struct atomisp_device *isp,
 	}
 
 	if (i == isp->dfs->dfs_table_size)
-		new_freq = isp->dfs->max_freq_at_vmin;
+		*freq = isp->dfs->max_freq_at_vmin;
 	else
-		new_freq = isp->dfs->dfs_table[i].isp_freq;
+		*freq = isp->dfs->dfs_table[i].isp_freq;
+
+	return 0;
+}
+
+static int __atomisp_set_freq(struct atomisp_device *isp,
+			      unsigned int new_freq, bool force)
+{
+	int ret;
 
-done:
 	dev_dbg(isp->dev, "DFS target frequency=%d.\n", new_freq);
 
 	if ((new_freq == isp->sw_contex.running_freq) && !force)
@@ -350,6 +340,143 @@ done:
 	return ret;
 }
 
+int atomisp_freq_scaling(struct atomisp_device *isp,
+			 enum atomisp_dfs_mode mode,
+			 bool force)
+{
+	unsigned int new_freq = 0, freq;
+	int i, ret;
+
+	if (isp->sw_contex.power_state != ATOM_ISP_POWER_UP) {
+		dev_err(isp->dev, "DFS cannot proceed due to no power.\n");
+		return -EINVAL;
+	}
+
+	if (isp->dfs->lowest_freq == 0 || isp->dfs->max_freq_at_vmin == 0 ||
+	    isp->dfs->highest_freq == 0 || isp->dfs->dfs_table_size == 0 ||
+	    !isp->dfs->dfs_table) {
+		dev_err(isp->dev, "DFS configuration is invalid.\n");
+		return -EINVAL;
+	}
+
+	isp->dfs_gov.mode = mode;
+	isp->dfs_gov.frames = 0;
+	isp->dfs_gov.below = 0;
+
+	if (mode == ATOMISP_DFS_MODE_LOW)
+		return __atomisp_set_freq(isp, isp->dfs->lowest_freq, force);
+
+	if (mode == ATOMISP_DFS_MODE_MAX)
+		return __atomisp_set_freq(isp, isp->dfs->highest_freq, force);
+
+	/* all streaming sub-devices share the ISP, serve the most demanding */
+	for (i = 0; i < isp->num_of_streams; i++) {
+		struct atomisp_sub_device *asd = &isp->asd[i];
+
+		if (asd->streaming != ATOMISP_DEVICE_STREAMING_ENABLED)
+			continue;
+
+		asd->dfs_busy_us = 0;
+		if (__atomisp_dfs_rule_freq(asd, &freq)) {
+			dev_dbg(isp->dev, "DFS: no fps on stream %d\n", i);
+			continue;
+		}
+		new_freq = max(new_freq, freq);
+	}
+
+	if (new_freq == 0) {
+		ret = __atomisp_dfs_rule_freq(&isp->asd[0], &new_freq);
+		if (ret)
+			return ret;
+	}
+
+	return __atomisp_set_freq(isp, new_freq, force);
+}
+
+static void __atomisp_dfs_gov_run(struct atomisp_device *isp)
+{
+	unsigned int cur_freq = isp->sw_contex.running_freq;
+	unsigned int util_pct = 0;
+	unsigned int new_freq;
+	int i;
+
+	for (i = 0; i < isp->num_of_streams; i++) {
+		struct atomisp_sub_device *asd = &isp->asd[i];
+
+		/* no fps (rule lookup failed) or no sample yet */
+		if (asd->streaming != ATOMISP_DEVICE_STREAMING_ENABLED ||
+		    !asd->dfs_fps || !asd->dfs_busy_us)
+			continue;
+
+		util_pct += atomisp_dfs_gov_util(asd->dfs_busy_us,
+						 asd->dfs_fps);
+	}
+
+	new_freq = atomisp_dfs_gov_eval(&isp->dfs_gov, isp->dfs, cur_freq,
+					util_pct);
+	if (new_freq != cur_freq) {
+		dev_dbg(isp->dev, "DFS governor: load %u%% at %u MHz -> %u MHz\n",
+			util_pct, cur_freq, new_freq);
+		__atomisp_set_freq(isp, new_freq, false);
+	}
+}
+
+/* Called from the ISR with isp->lock held on EOF of a sub-device */
+void atomisp_dfs_gov_eof(struct atomisp_sub_device *asd, uint8_t exp_id)
+{
+	if (asd->isp->dfs_gov.enabled)
+		asd->dfs_eof_ts[exp_id % ATOMISP_DFS_GOV_EXP_IDS] = ktime_get();
+}
+
+/*
+ * Called with isp->mutex held when a main output frame is done. The time
+ * since the EOF of the frame is what the ISP spent on it; the sensor
+ * readout before that does not depend on the ISP clock.
+ */
+void atomisp_dfs_gov_frame_done(struct atomisp_sub_device *asd,
+				uint8_t exp_id)
+{
+	struct atomisp_device *isp = asd->isp;
+	struct atomisp_dfs_gov *gov = &isp->dfs_gov;
+	unsigned long flags;
+	ktime_t eof_ts;
+	s64 busy_us;
+
+	if (!gov->enabled || gov->mode != ATOMISP_DFS_MODE_AUTO ||
+	    !asd->dfs_fps)
+		return;
+
+	/* dfs_eof_ts is written by the ISR under isp->lock */
+	spin_lock_irqsave(&isp->lock, flags);
+	eof_ts = asd->dfs_eof_ts[exp_id % ATOMISP_DFS_GOV_EXP_IDS];
+	asd->dfs_eof_ts[exp_id % ATOMISP_DFS_GOV_EXP_IDS] = ktime_set(0, 0);
+	spin_unlock_irqrestore(&isp->lock, flags);
+
+	/* no ISYS EOF events for this frame */
+	if (!ktime_to_ns(eof_ts))
+		return;
+
+	busy_us = ktime_us_delta(ktime_get(), eof_ts);
+
+	/* an EOF of another frame that ended up with the same slot */
+	if (busy_us <= 0 || busy_us > 2 * USEC_PER_SEC / asd->dfs_fps)
+		return;
+
+	/* the input format of dfs_replay */
+	dev_dbg(isp->dev, "DFS sample: %d %u %u %u\n", asd->index,
+		asd->dfs_fps, (unsigned int)busy_us,
+		isp->sw_contex.running_freq);
+
+	asd->dfs_busy_us = atomisp_dfs_gov_avg(asd->dfs_busy_us,
+					       (unsigned int)busy_us);
+
+	if (++gov->frames < ATOMISP_DFS_GOV_EVAL_FRAMES)
+		return;
+	gov->frames = 0;
+
+	__atomisp_dfs_gov_run(isp);
+}
+
 /*
  * reset and restore ISP
  */
@@ -457,6 +584,14 @@ static void atomisp_sof_event(struct atomisp_sub_device *asd)
 	event.u.frame_sync.frame_sequence = atomic_read(&asd->sof_count);
 
 	v4l2_event_queue(asd->subdev.devnode, &event);
+
+	/*
+	 * Let the sensor apply settings queued for this frame. The handler
+	 * must not sleep, the frame number is passed as the status.
+	 */
+	v4l2_subdev_call(asd->isp->inputs[asd->input_curr].camera, core,
+			 interrupt_service_routine,
+			 event.u.frame_sync.frame_sequence, NULL);
 }
 
 void atomisp_eof_event(struct atomisp_sub_device *asd, uint8_t exp_id)
@@ -469,6 +604,40 @@ void atomisp_eof_event(struct atomisp_sub_device *asd, uint8_t exp_id)
 	v4l2_event_queue(asd->subdev.devnode, &event);
 }
 
+/*
+ * Snapshot what the frame starting now was exposed with, for the frame
+ * metadata ring. Called from the ISR with isp->lock held.
+ */
+static void atomisp_frame_meta_sof(struct atomisp_sub_device *asd)
+{
+	struct atomisp_frame_meta_ring *meta = &asd->frame_meta;
+	unsigned int seq = atomic_read(&asd->sof_count);
+	struct atomisp_frame_meta_sof *sof =
+		&meta->sof[seq % ATOMISP_FRAME_META_SOFS];
+
+	if (!meta->base)
+		return;
+
+	sof->seq = seq;
+	ktime_get_ts(&sof->ts);
+	memcpy(sof->exposure, meta->exposure, sizeof(sof->exposure));
+	sof->focus = meta->focus;
+}
+
+/* Called from the ISR with isp->lock held. */
+static void atomisp_frame_meta_eof(struct atomisp_sub_device *asd,
+				   uint8_t exp_id)
+{
+	struct atomisp_frame_meta_ring *meta = &asd->frame_meta;
+
+	if (!meta->base)
+		return;
+
+	meta->exp[exp_id % ATOMISP_FRAME_META_EXP_IDS].exp_id = exp_id;
+	meta->exp[exp_id % ATOMISP_FRAME_META_EXP_IDS].sof_seq =
+		atomic_read(&asd->sof_count);
+}
+
 static void atomisp_3a_stats_ready_event(struct atomisp_sub_device *asd, uint8_t exp_id)
 {
 	struct v4l2_event event = {0};
@@ -594,6 +763,7 @@ irqreturn_t atomisp_isr(int irq, void *dev)
 		if (irq_infos & CSS_IRQ_INFO_CSS_RECEIVER_SOF) {
 			atomic_inc(&asd->sof_count);
 			atomisp_sof_event(asd);
+			atomisp_frame_meta_sof(asd);
 
 			/* If sequence_temp and sequence are the same
 			 * there where no frames lost so we can increase
@@ -642,6 +812,8 @@ irqreturn_t atomisp_isr(int irq, void *dev)
 			}
 
 			atomisp_eof_event(asd, eof_event.event.exp_id);
+			atomisp_frame_meta_eof(asd, eof_event.event.exp_id);
+			atomisp_dfs_gov_eof(asd, eof_event.event.exp_id);
 			dev_dbg(isp->dev, "%s EOF exp_id %d\n", __func__,
 				eof_event.event.exp_id);
 		}
@@ -904,6 +1076,91 @@ atomisp_get_metadata_type(struct atomisp_sub_device *asd,
 		return ATOMISP_MAIN_METADATA;
 }
 
+/*
+ * A frame came back: the stream is alive, so the recovery tier tried on
+ * it (if any) worked.
+ */
+static void __atomisp_wdt_frame_done(struct atomisp_sub_device *asd)
+{
+	struct atomisp_device *isp = asd->isp;
+	struct atomisp_wdt_tier_stats *stats;
+	s64 latency_us;
+
+	asd->wdt_progress = jiffies;
+
+	/* faked timeouts must not be cleared by frames that keep flowing */
+	if (!asd->wdt_tier || isp->wdt_inject)
+		return;
+
+	stats = &isp->wdt_tier_stats[asd->wdt_tier - 1];
+	latency_us = ktime_us_delta(ktime_get(), asd->wdt_tier_ts);
+	stats->ok++;
+	stats->latency_us += latency_us;
+	if (latency_us > stats->max_latency_us)
+		stats->max_latency_us = latency_us;
+
+	asd->wdt_tier = ATOMISP_WDT_TIER_NONE;
+}
+
+/*
+ * Append the record of a completed frame to the frame metadata ring.
+ * The SOF the frame started on is found through the exp_id seen at its
+ * EOF; without one (no ISYS EOF events, exp_id 0) the sequence of the
+ * buffer is used.
+ */
+static void atomisp_frame_meta_write(struct atomisp_sub_device *asd,
+				     struct videobuf_buffer *vb,
+				     struct atomisp_css_frame *frame,
+				     unsigned int pad, int error)
+{
+	struct atomisp_frame_meta_ring *meta = &asd->frame_meta;
+	struct atomisp_frame_meta_ring_header *hdr = meta->base;
+	struct atomisp_frame_meta *rec;
+	struct atomisp_frame_meta_sof sof;
+	unsigned int frame_seq = atomic_read(&asd->sequence);
+	unsigned int sof_seq = frame_seq;
+	unsigned long flags;
+
+	if (!hdr)
+		return;
+
+	spin_lock_irqsave(&asd->isp->lock, flags);
+	if (frame->exp_id && meta->exp[frame->exp_id %
+		ATOMISP_FRAME_META_EXP_IDS].exp_id == frame->exp_id)
+		sof_seq = meta->exp[frame->exp_id %
+				    ATOMISP_FRAME_META_EXP_IDS].sof_seq;
+	sof = meta->sof[sof_seq % ATOMISP_FRAME_META_SOFS];
+	spin_unlock_irqrestore(&asd->isp->lock, flags);
+
+	/* overwritten by later SOFs: the frame took too long */
+	if (sof.seq != sof_seq)
+		memset(&sof, 0, sizeof(sof));
+
+	rec = meta->base + sizeof(*hdr) +
+	      (meta->head % meta->num_records) * sizeof(*rec);
+
+	rec->seq = meta->head * 2 + 1;
+	smp_wmb();
+	rec->exp_id = frame->exp_id;
+	rec->frame_seq = frame_seq;
+	rec->sof_seq = sof_seq;
+	rec->sof_sec = sof.ts.tv_sec;
+	rec->sof_nsec = sof.ts.tv_nsec;
+	rec->coarse_integration_time = sof.exposure[0];
+	rec->fine_integration_time = sof.exposure[1];
+	rec->analog_gain = sof.exposure[2];
+	rec->digital_gain = sof.exposure[3];
+	rec->focus_position = sof.focus;
+	rec->isp_config_id = frame->isp_config_id;
+	rec->pad = pad;
+	rec->index = vb->i;
+	rec->status = !!error;
+	smp_wmb();
+	rec->seq = meta->head * 2 + 2;
+
+	hdr->head = ++meta->head;
+}
+
 void atomisp_buf_done(struct atomisp_sub_device *asd, int error,
 		      enum atomisp_css_buffer_type buf_type,
 		      enum atomisp_css_pipe_id css_pipe_id,
@@ -967,6 +1224,8 @@ void atomisp_buf_done(struct atomisp_sub_device *asd, int error,
 
 			asd->s3a_bufs_in_css[css_pipe_id]--;
 			atomisp_3a_stats_ready_event(asd, buffer.css_buffer.exp_id);
+			atomisp_completion_post(asd, ATOMISP_COMPLETION_3A_STAT,
+				0, 0, buffer.css_buffer.exp_id, 0);
 			dev_dbg(isp->dev, "%s: s3a stat with exp_id %d is ready\n",
 				__func__, buffer.css_buffer.exp_id);
 			break;
@@ -985,6 +1244,9 @@ void atomisp_buf_done(struct atomisp_sub_device *asd, int error,
 			}
 			asd->metadata_bufs_in_css[stream_id][css_pipe_id]--;
 			atomisp_metadata_ready_event(asd, md_type);
+			atomisp_completion_post(asd, ATOMISP_COMPLETION_METADATA,
+				0, md_type,
+				buffer.css_buffer.data.metadata->exp_id, 0);
 			dev_dbg(isp->dev, "%s: metadata with exp_id %d is ready\n",
 				__func__,
 				buffer.css_buffer.data.metadata->exp_id);
@@ -1003,6 +1265,8 @@ void atomisp_buf_done(struct atomisp_sub_device *asd, int error,
 				}
 			}
 			asd->dis_bufs_in_css--;
+			atomisp_completion_post(asd, ATOMISP_COMPLETION_DIS_STAT,
+				0, 0, buffer.css_buffer.exp_id, 0);
 			dev_dbg(isp->dev, "%s: dis stat with exp_id %d is ready\n",
 				__func__, buffer.css_buffer.exp_id);
 			break;
@@ -1081,6 +1345,8 @@ void atomisp_buf_done(struct atomisp_sub_device *asd, int error,
 			}
 
 			pipe->frame_config_id[vb->i] = frame->isp_config_id;
+			if (!error)
+				atomisp_dfs_gov_frame_done(asd, frame->exp_id);
 			ctrl.id = V4L2_CID_FLASH_MODE;
 			if (asd->params.flash_state ==
 			    ATOMISP_FLASH_ONGOING) {
@@ -1171,6 +1437,8 @@ void atomisp_buf_done(struct atomisp_sub_device *asd, int error,
 	if (vb) {
 		get_buf_timestamp(&vb->ts);
 		vb->field_count = atomic_read(&asd->sequence) << 1;
+		atomisp_frame_meta_write(asd, vb, frame,
+			atomisp_subdev_source_pad(&pipe->vdev), error);
 		/*mark videobuffer done for dequeue*/
 		spin_lock_irqsave(&pipe->irq_lock, irqflags);
 		vb->state = !error ? VIDEOBUF_DONE : VIDEOBUF_ERROR;
@@ -1182,6 +1450,12 @@ void atomisp_buf_done(struct atomisp_sub_device *asd, int error,
 		 * possibly hold by videobuf_dqbuf()
 		 */
 		wake_up(&vb->done);
+
+		__atomisp_wdt_frame_done(asd);
+
+		atomisp_completion_post(asd, ATOMISP_COMPLETION_FRAME,
+			atomisp_subdev_source_pad(&pipe->vdev), vb->i,
+			frame->exp_id, !!error);
 	}
 
 	/*
@@ -1224,7 +1498,13 @@ void atomisp_delayed_init_work(struct work_struct *work)
 	complete(&asd->init_done);
 }
 
-static void __atomisp_css_recover(struct atomisp_device *isp)
+/*
+ * Stop every stream, so that the SP stops, and start them again. The SP
+ * start sets up its queues afresh, which drops the buffers left in CSS;
+ * the driver side of those is returned to videobuf as errors. With
+ * isp_reset, the ISP is power cycled in between.
+ */
+static void __atomisp_css_recover(struct atomisp_device *isp, bool isp_reset)
 {
 	enum atomisp_css_pipe_id css_pipe_id;
 	bool stream_restart[MAX_STREAM_NUM] = {0};
@@ -1269,18 +1549,27 @@ static void __atomisp_css_recover(struct atomisp_device *isp)
 		asd->streaming = ATOMISP_DEVICE_STREAMING_DISABLED;
 	}
 
-	/* clear irq */
-	enable_isp_irq(hrt_isp_css_irq_sp, false);
-	clear_isp_irq(hrt_isp_css_irq_sp);
+	if (isp_reset) {
+		/*
+		 * isp_timeout keeps the power state up while the island is
+		 * power cycled; the sampler must not touch the ISP meanwhile.
+		 */
+		atomisp_pcprof_stop(isp);
+
+		/* clear irq */
+		enable_isp_irq(hrt_isp_css_irq_sp, false);
+		clear_isp_irq(hrt_isp_css_irq_sp);
 
-	/* Set the SRSE to 3 before resetting */
-	pci_write_config_dword(isp->pdev, PCI_I_CONTROL, isp->saved_regs.i_control |
-			MRFLD_PCI_I_CONTROL_SRSE_RESET_MASK);
+		/* Set the SRSE to 3 before resetting */
+		pci_write_config_dword(isp->pdev, PCI_I_CONTROL,
+				isp->saved_regs.i_control |
+				MRFLD_PCI_I_CONTROL_SRSE_RESET_MASK);
 
-	/* reset ISP and restore its state */
-	isp->isp_timeout = true;
-	atomisp_reset(isp);
-	isp->isp_timeout = false;
+		/* reset ISP and restore its state */
+		isp->isp_timeout = true;
+		atomisp_reset(isp);
+		isp->isp_timeout = false;
+	}
 
 	/* The following frame after an ISP timeout
 	 * may be corrupted, so mark it so. */
@@ -1304,6 +1593,7 @@ static void __atomisp_css_recover(struct atomisp_device *isp)
 		atomisp_css_start(asd, css_pipe_id, true);
 
 		asd->streaming = ATOMISP_DEVICE_STREAMING_ENABLED;
+		asd->wdt_progress = jiffies;
 
 		atomisp_csi2_configure(asd);
 	}
@@ -1352,12 +1642,189 @@ static void __atomisp_css_recover(struct atomisp_device *isp)
 		atomisp_flush_bufs_and_wakeup(asd);
 	}
 
+	if (isp_reset && atomisp_streaming_count(isp))
+		atomisp_pcprof_start(isp);
+}
+
+static void __atomisp_wdt_tier_tried(struct atomisp_sub_device *asd,
+				     unsigned int tier)
+{
+	struct atomisp_device *isp = asd->isp;
+
+	if (asd->wdt_tier)
+		isp->wdt_tier_stats[asd->wdt_tier - 1].failed++;
+
+	isp->wdt_tier_stats[tier - 1].tried++;
+	asd->wdt_tier = tier;
+	asd->wdt_tier_ts = ktime_get();
+}
+
+/*
+ * Tier 1: push whatever the stream has waiting back to CSS, in case it
+ * stalled for lack of buffers or parameters.
+ */
+static void __atomisp_wdt_requeue(struct atomisp_sub_device *asd)
+{
+	atomisp_handle_parameter_and_buffer(&asd->video_out_capture);
+	atomisp_handle_parameter_and_buffer(&asd->video_out_preview);
+	atomisp_handle_parameter_and_buffer(&asd->video_out_video_capture);
+	atomisp_qbuffers_to_css(asd);
+}
+
+/*
+ * Tier 2: stop and restart the CSS pipes and the sensor of one
+ * sub-device, as STREAMOFF/STREAMON do, leaving the other streams and
+ * the SP running. Unmapping its queues drops the buffers the stream
+ * still had in CSS; the driver side of those is returned as errors.
+ */
+static int __atomisp_wdt_restart_stream(struct atomisp_sub_device *asd)
+{
+	struct atomisp_device *isp = asd->isp;
+	enum atomisp_css_pipe_id css_pipe_id;
+	int ret;
+
+	asd->streaming = ATOMISP_DEVICE_STREAMING_STOPPING;
+
+	/*
+	 * atomisp_css_start() would reset all streams to grow the shared
+	 * mipi buffer, leave that to the full recovery.
+	 */
+	if (!IS_HWREVISION(isp, ATOMISP_HW_REVISION_ISP2401) &&
+	    __need_realloc_mipi_buffer(isp)) {
+		asd->streaming = ATOMISP_DEVICE_STREAMING_ENABLED;
+		return -EBUSY;
+	}
+
+	if (asd->delayed_init == ATOMISP_DELAYED_INIT_QUEUED)
+		cancel_work_sync(&asd->delayed_init_work);
+
+	complete(&asd->init_done);
+	asd->delayed_init = ATOMISP_DELAYED_INIT_NOT_QUEUED;
+
+	css_pipe_id = atomisp_get_css_pipe_id(asd);
+	atomisp_css_stop(asd, css_pipe_id, true);
+
+	atomisp_acc_unload_extensions(asd);
+
+	ret = v4l2_subdev_call(isp->inputs[asd->input_curr].camera,
+			       video, s_stream, 0);
+	if (ret)
+		dev_warn(isp->dev, "can't stop streaming on sensor!\n");
+
+	atomisp_clear_css_buffer_counters(asd);
+	asd->streaming = ATOMISP_DEVICE_STREAMING_DISABLED;
+
+	if (atomisp_acc_load_extensions(asd) < 0)
+		dev_err(isp->dev, "acc extension failed to reload\n");
+
+	if (isp->inputs[asd->input_curr].type != FILE_INPUT)
+		atomisp_css_input_set_mode(asd, CSS_INPUT_MODE_SENSOR);
+
+	ret = atomisp_css_start(asd, css_pipe_id, true);
+	/*
+	 * Mark the stream enabled even on failure, so that the full
+	 * recovery the caller falls back to restarts it as well.
+	 */
+	asd->streaming = ATOMISP_DEVICE_STREAMING_ENABLED;
+	asd->wdt_progress = jiffies;
+	if (ret)
+		return ret;
+
+	atomisp_csi2_configure(asd);
+
+	ret = v4l2_subdev_call(isp->inputs[asd->input_curr].camera,
+			       video, s_stream, 1);
+	if (ret)
+		dev_warn(isp->dev, "can't start streaming on sensor!\n");
+
+	if (asd->continuous_mode->val &&
+	    asd->delayed_init == ATOMISP_DELAYED_INIT_NOT_QUEUED) {
+#ifndef CONFIG_GMIN_INTEL_MID
+		INIT_COMPLETION(asd->init_done);
+#else
+		reinit_completion(&asd->init_done);
+#endif
+		asd->delayed_init = ATOMISP_DELAYED_INIT_QUEUED;
+		queue_work(asd->delayed_init_workq, &asd->delayed_init_work);
+	}
+
+	atomisp_flush_bufs_and_wakeup(asd);
+
+	return 0;
+}
+
+/*
+ * Try the cheap recovery tiers on the streams that made no progress for
+ * a watchdog period. Returns false if the whole ISP has to be reset;
+ * *injected tells if the timeout was faked through drvfs.
+ */
+static bool __atomisp_wdt_recover_streams(struct atomisp_device *isp,
+					  bool *injected)
+{
+	bool stalled[MAX_STREAM_NUM] = {0};
+	unsigned int tier = ATOMISP_WDT_TIER_NONE;
+	int i;
+
+	*injected = isp->wdt_inject;
+	if (isp->wdt_inject)
+		isp->wdt_inject--;
+
+	for (i = 0; i < isp->num_of_streams; i++) {
+		struct atomisp_sub_device *asd = &isp->asd[i];
+
+		if (asd->streaming != ATOMISP_DEVICE_STREAMING_ENABLED)
+			continue;
+
+		stalled[i] = *injected || (atomisp_buffers_queued(asd) &&
+				time_after_eq(jiffies, asd->wdt_progress +
+					      isp->wdt_duration));
+		if (stalled[i])
+			tier = max(tier, min(asd->wdt_tier + 1,
+					     (unsigned int)ATOMISP_WDT_TIER_RESET));
+	}
+
+	/* the timer is shared, another stream may have moved on since */
+	if (tier == ATOMISP_WDT_TIER_NONE) {
+		atomisp_wdt_refresh(isp, ATOMISP_WDT_KEEP_CURRENT_DELAY);
+		return true;
+	}
+	if (tier == ATOMISP_WDT_TIER_RESET)
+		return false;
+
+	for (i = 0; i < isp->num_of_streams; i++) {
+		struct atomisp_sub_device *asd = &isp->asd[i];
+
+		if (!stalled[i])
+			continue;
+
+		dev_err(isp->dev, "timeout on stream %d, %s it\n", i,
+			tier == ATOMISP_WDT_TIER_REQUEUE ?
+			"requeueing" : "restarting");
+
+		__atomisp_wdt_tier_tried(asd, tier);
+		if (tier == ATOMISP_WDT_TIER_REQUEUE) {
+			__atomisp_wdt_requeue(asd);
+			/* give the stream another period */
+			asd->wdt_progress = jiffies;
+		} else if (__atomisp_wdt_restart_stream(asd)) {
+			dev_err(isp->dev, "stream %d restart failed\n", i);
+			return false;
+		}
+	}
+
+	atomisp_wdt_refresh(isp, ATOMISP_WDT_KEEP_CURRENT_DELAY);
+
+	if (isp->wdt_inject)
+		queue_work(isp->wdt_work_queue, &isp->wdt_work);
+
+	return true;
 }
 
 void atomisp_wdt_work(struct work_struct *work)
 {
 	struct atomisp_device *isp = container_of(work, struct atomisp_device,
 						  wdt_work);
+	bool injected;
 	int i;
 
 	rt_mutex_lock(&isp->mutex);
@@ -1366,11 +1833,20 @@ void atomisp_wdt_work(struct work_struct *work)
 		return;
 	}
 
-	dev_err(isp->dev, "timeout %d of %d\n",
-		atomic_read(&isp->wdt_count) + 1,
-		ATOMISP_ISP_MAX_TIMEOUT_COUNT);
+	if (__atomisp_wdt_recover_streams(isp, &injected)) {
+		rt_mutex_unlock(&isp->mutex);
+		return;
+	}
 
-	if (atomic_inc_return(&isp->wdt_count) <
+	/* a faked timeout walks the tiers but never ends in fatal error */
+	if (injected)
+		dev_err(isp->dev, "injected timeout\n");
+	else
+		dev_err(isp->dev, "timeout %d of %d\n",
+			atomic_read(&isp->wdt_count) + 1,
+			ATOMISP_ISP_MAX_TIMEOUT_COUNT);
+
+	if (injected || atomic_inc_return(&isp->wdt_count) <
 			ATOMISP_ISP_MAX_TIMEOUT_COUNT) {
 		unsigned int old_dbglevel = dbg_level;
 		atomisp_css_debug_dump_sp_sw_debug_info();
@@ -1440,9 +1916,11 @@ void atomisp_wdt_work(struct work_struct *work)
 			if (asd->enable_raw_buffer_lock->val) {
 				unsigned int j;
 
-				for (j = 0; j <= ATOMISP_MAX_EXP_ID/32; j++) {
+				for (j = 0;
+				     j < ARRAY_SIZE(asd->raw_buffer_bitmap);
+				     j++) {
 					dev_err(isp->dev,
-						"%s, raw_buffer_bitmap[%d]: 0x%x\n",
+						"%s, raw_buffer_bitmap[%d]: 0x%lx\n",
 						__func__, j,
 						asd->raw_buffer_bitmap[j]);
 				}
@@ -1456,6 +1934,10 @@ void atomisp_wdt_work(struct work_struct *work)
 			struct atomisp_sub_device *asd = &isp->asd[i];
 			if (asd->streaming ==
 			    ATOMISP_DEVICE_STREAMING_ENABLED) {
+				if (asd->wdt_tier)
+					isp->wdt_tier_stats[asd->wdt_tier - 1].
+						failed++;
+				asd->wdt_tier = ATOMISP_WDT_TIER_NONE;
 				atomisp_clear_css_buffer_counters(asd);
 				atomisp_flush_bufs_and_wakeup(asd);
 				complete(&asd->init_done);
@@ -1474,7 +1956,11 @@ void atomisp_wdt_work(struct work_struct *work)
 	if (dbg_level > 5)
 		kct_log(CT_EV_CRASH, "ATOMISP2", "TIMEOUT", 0, "", "", "", "", "", "", "/logs/aplog");
 #endif
-	__atomisp_css_recover(isp);
+	for (i = 0; i < isp->num_of_streams; i++)
+		if (isp->asd[i].streaming == ATOMISP_DEVICE_STREAMING_ENABLED)
+			__atomisp_wdt_tier_tried(&isp->asd[i],
+						 ATOMISP_WDT_TIER_RESET);
+	__atomisp_css_recover(isp, true);
 	atomisp_set_stop_timeout(ATOMISP_CSS_STOP_TIMEOUT_US);
 	dev_err(isp->dev, "timeout recovery handling done\n");
 
@@ -1490,7 +1976,7 @@ void atomisp_css_flush(struct atomisp_device *isp)
 	atomisp_wdt_stop(isp, true);
 
 	/* Start recover */
-	__atomisp_css_recover(isp);
+	__atomisp_css_recover(isp, true);
 
 	/* Restore wdt */
 	atomisp_wdt_refresh(isp,
@@ -1508,14 +1994,38 @@ void atomisp_wdt(unsigned long isp_addr)
 	queue_work(isp->wdt_work_queue, &isp->wdt_work);
 }
 
+/*
+ * The timer is shared by the streams, so it is armed for the one that
+ * has gone longest without a frame while holding buffers in CSS; a
+ * stream that keeps returning frames does not hide a stalled one.
+ */
 void atomisp_wdt_refresh(struct atomisp_device *isp, unsigned int delay)
 {
 	unsigned long next;
+	bool recovering = false;
+	bool queued = false;
+	int i;
 
 	if (delay != ATOMISP_WDT_KEEP_CURRENT_DELAY)
 		isp->wdt_duration = delay;
 
 	next = jiffies + isp->wdt_duration;
+	for (i = 0; i < isp->num_of_streams; i++) {
+		struct atomisp_sub_device *asd = &isp->asd[i];
+		unsigned long deadline;
+
+		if (asd->streaming != ATOMISP_DEVICE_STREAMING_ENABLED)
+			continue;
+		if (asd->wdt_tier)
+			recovering = true;
+		if (!atomisp_buffers_queued(asd))
+			continue;
+
+		deadline = asd->wdt_progress + isp->wdt_duration;
+		if (!queued || time_before(deadline, next))
+			next = deadline;
+		queued = true;
+	}
 
 	/* Override next if it has been pushed beyon the "next" time */
 	if (atomisp_is_wdt_running(isp) && time_after(isp->wdt_expires, next))
@@ -1531,7 +2041,9 @@ void atomisp_wdt_refresh(struct atomisp_device *isp, unsigned int delay)
 			((int)(next - jiffies) * 1000 / HZ));
 
 	mod_timer(&isp->wdt, next);
-	atomic_set(&isp->wdt_count, 0);
+	/* consecutive resets are only forgiven once frames come back */
+	if (!recovering)
+		atomic_set(&isp->wdt_count, 0);
 }
 
 void atomisp_wdt_stop(struct atomisp_device *isp, bool sync)
@@ -1583,6 +2095,7 @@ irqreturn_t atomisp_isr_thread(int irq, void *isp_ptr)
 	bool frame_done_found[MAX_STREAM_NUM] = {0};
 	bool css_pipe_done[MAX_STREAM_NUM] = {0};
 	bool reset_wdt_timer = false;
+	bool busy;
 	unsigned int i;
 	struct atomisp_sub_device *asd = &isp->asd[0];
 
@@ -1627,6 +2140,7 @@ irqreturn_t atomisp_isr_thread(int irq, void *isp_ptr)
 				   &reset_wdt_timer))
 		goto out;
 
+	busy = false;
 	for (i = 0; i < isp->num_of_streams; i++) {
 		asd = &isp->asd[i];
 		if (asd->streaming != ATOMISP_DEVICE_STREAMING_ENABLED)
@@ -1639,15 +2153,16 @@ irqreturn_t atomisp_isr_thread(int irq, void *isp_ptr)
 		}
 		atomisp_setup_flash(asd);
 
-		/* If there are no buffers queued then
-		 * delete wdt timer. */
-		if (!atomisp_buffers_queued(asd))
-			atomisp_wdt_stop(isp, false);
-		else if (reset_wdt_timer)
-			/* SOF irq should not reset wdt timer. */
-			atomisp_wdt_refresh(isp,
-					    ATOMISP_WDT_KEEP_CURRENT_DELAY);
+		if (atomisp_buffers_queued(asd))
+			busy = true;
 	}
+
+	/* If there are no buffers queued then delete wdt timer. */
+	if (!busy)
+		atomisp_wdt_stop(isp, false);
+	else if (reset_wdt_timer)
+		/* SOF irq should not reset wdt timer. */
+		atomisp_wdt_refresh(isp, ATOMISP_WDT_KEEP_CURRENT_DELAY);
 out:
 	rt_mutex_unlock(&isp->mutex);
 	for (i = 0; i < isp->num_of_streams; i++) {
@@ -2279,6 +2794,117 @@ int atomisp_get_dis_stat(struct atomisp_sub_device *asd,
 	return atomisp_css_get_dis_stat(asd, stats);
 }
 
+/*
+ * Function to set up the mmap-able DIS statistics ring and to fill its
+ * next slot
+ */
+int atomisp_set_dis_stat_ring(struct atomisp_sub_device *asd,
+			      struct atomisp_dis_stat_ring_config *config)
+{
+	return atomisp_css_set_dis_stat_ring(asd, config);
+}
+
+int atomisp_get_dis_stat_slot(struct atomisp_sub_device *asd,
+			      struct atomisp_dis_stat_slot *slot)
+{
+	return atomisp_css_get_dis_stat_slot(asd, slot);
+}
+
+void atomisp_free_frame_meta_ring(struct atomisp_sub_device *asd)
+{
+	struct atomisp_frame_meta_ring *meta = &asd->frame_meta;
+	void *base = meta->base;
+	unsigned long flags;
+
+	if (!base)
+		return;
+
+	spin_lock_irqsave(&asd->isp->lock, flags);
+	meta->base = NULL;
+	spin_unlock_irqrestore(&asd->isp->lock, flags);
+	vfree(base);
+}
+
+/*
+ * Function to set up the mmap-able per-frame metadata ring. The ring is
+ * one page: the header and as many records as fit behind it.
+ */
+int atomisp_set_frame_meta_ring(struct atomisp_sub_device *asd,
+				struct atomisp_frame_meta_ring_config *config)
+{
+	struct atomisp_frame_meta_ring *meta = &asd->frame_meta;
+	struct atomisp_frame_meta_ring_header *hdr;
+	unsigned long flags;
+
+	atomisp_free_frame_meta_ring(asd);
+	if (!config->enable)
+		return 0;
+
+	hdr = vmalloc_user(PAGE_SIZE);
+	if (!hdr)
+		return -ENOMEM;
+
+	hdr->num_records = (PAGE_SIZE - sizeof(*hdr)) /
+			   sizeof(struct atomisp_frame_meta);
+	hdr->record_size = sizeof(struct atomisp_frame_meta);
+
+	spin_lock_irqsave(&asd->isp->lock, flags);
+	memset(meta->sof, 0, sizeof(meta->sof));
+	memset(meta->exp, 0, sizeof(meta->exp));
+	meta->num_records = hdr->num_records;
+	meta->head = 0;
+	meta->base = hdr;
+	spin_unlock_irqrestore(&asd->isp->lock, flags);
+
+	config->num_records = hdr->num_records;
+	config->record_size = hdr->record_size;
+	config->size = PAGE_SIZE;
+	config->mmap_offset = ATOMISP_FRAME_META_RING_MMAP_OFFSET;
+
+	return 0;
+}
+
+int atomisp_mmap_frame_meta_ring(struct atomisp_sub_device *asd,
+				 struct vm_area_struct *vma)
+{
+	if (!asd->frame_meta.base)
+		return -EINVAL;
+
+	if (vma->vm_end - vma->vm_start != PAGE_SIZE ||
+	    (vma->vm_flags & VM_WRITE))
+		return -EINVAL;
+
+	vma->vm_flags &= ~VM_MAYWRITE;
+	return remap_vmalloc_range(vma, asd->frame_meta.base, 0);
+}
+
+/*
+ * Record the exposure and focus user space set, so that the frame
+ * metadata ring can report what each frame was exposed with.
+ */
+void atomisp_frame_meta_set_exposure(struct atomisp_sub_device *asd,
+				     const struct atomisp_exposure *exposure)
+{
+	struct atomisp_frame_meta_ring *meta = &asd->frame_meta;
+	unsigned long flags;
+
+	spin_lock_irqsave(&asd->isp->lock, flags);
+	meta->exposure[0] = exposure->integration_time[0];
+	meta->exposure[1] = exposure->integration_time[1];
+	meta->exposure[2] = exposure->gain[0];
+	meta->exposure[3] = exposure->gain[1];
+	spin_unlock_irqrestore(&asd->isp->lock, flags);
+}
+
+void atomisp_frame_meta_set_focus(struct atomisp_sub_device *asd, int focus)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&asd->isp->lock, flags);
+	asd->frame_meta.focus = focus;
+	spin_unlock_irqrestore(&asd->isp->lock, flags);
+}
+
 /*
  * Function to get current sensor output effective resolution
  */
@@ -2767,8 +3393,11 @@ void atomisp_apply_css_parameters(
 	if (arg->anr_thres)
 		atomisp_css_set_anr_thres(asd, &css_param->anr_thres);
 
-	if (arg->shading_table)
+	if (arg->shading_table) {
 		atomisp_css_set_shading_table(asd, css_param->shading_table);
+		atomisp_css_set_shading_prepared(asd,
+						 css_param->shading_prepared);
+	}
 
 	if (arg->morph_table && asd->params.gdc_cac_en)
 		atomisp_css_set_morph_table(asd, css_param->morph_table);
@@ -2945,10 +3574,13 @@ static int __atomisp_cp_lsc_table(struct atomisp_sub_device *asd,
 			struct atomisp_shading_table *user_st,
 			struct atomisp_css_params *css_param)
 {
+	struct atomisp_device *isp = asd->isp;
 	unsigned int i;
 	unsigned int len_table;
 	struct atomisp_css_shading_table *shading_table;
 	struct atomisp_css_shading_table *old_table;
+	struct atomisp_css_shading_prepared *prepared = NULL;
+	struct atomisp_css_shading_prepared *old_prepared;
 
 	if (!user_st)
 		return 0;
@@ -3022,11 +3654,33 @@ static int __atomisp_cp_lsc_table(struct atomisp_sub_device *asd,
 		}
 	}
 
+	/*
+	 * Convert the table for the binaries of the stream here, with
+	 * isp->mutex released, so that the parameter update only has to
+	 * store the result. Nothing else can see the new table yet. If the
+	 * stream changes meanwhile, CSS converts it again for the binaries
+	 * the prepared table does not match.
+	 */
+	prepared = atomisp_css_shading_table_prepare(asd, shading_table);
+	if (prepared) {
+		rt_mutex_unlock(&isp->mutex);
+		if (atomisp_css_shading_table_convert(prepared)) {
+			atomisp_css_shading_prepared_free(prepared);
+			prepared = NULL;
+		}
+		rt_mutex_lock(&isp->mutex);
+		old_table = css_param->shading_table;
+	}
+
 set_lsc:
 	/* set LSC to CSS */
+	old_prepared = css_param->shading_prepared;
 	css_param->shading_table = shading_table;
+	css_param->shading_prepared = prepared;
 	asd->params.sc_en = shading_table != NULL;
 
+	/* the prepared table refers to its table, free it first */
+	atomisp_css_shading_prepared_free(old_prepared);
 	if (old_table)
 		atomisp_css_shading_table_free(old_table);
 
@@ -3132,6 +3786,18 @@ int atomisp_cp_dvs_6axis_config(struct atomisp_sub_device *asd,
 			return -ENOMEM;
 	}
 
+	/*
+	 * The table is sized by CSS; a user grid of another size would
+	 * overrun it and force a reallocation on every update.
+	 */
+	if (dvs_6axis_config->width_y != user_6axis_config->width_y ||
+	    dvs_6axis_config->height_y != user_6axis_config->height_y ||
+	    dvs_6axis_config->width_uv != user_6axis_config->width_uv ||
+	    dvs_6axis_config->height_uv != user_6axis_config->height_uv) {
+		ret = -EINVAL;
+		goto error;
+	}
+
 	dvs_6axis_config->exp_id = user_6axis_config->exp_id;
 
 	if (copy_from_user(dvs_6axis_config->xcoords_y,
@@ -3163,11 +3829,28 @@ int atomisp_cp_dvs_6axis_config(struct atomisp_sub_device *asd,
 	return 0;
 
 error:
-	if (dvs_6axis_config)
+	/* a config still owned by css_param is left in place */
+	if (dvs_6axis_config && dvs_6axis_config != css_param->dvs_6axis)
 		ia_css_dvs2_6axis_config_free(dvs_6axis_config);
 	return ret;
 }
 
+/*
+ * Function to set up the mmap-able DVS 6-axis config pool and to apply
+ * one of its slots
+ */
+int atomisp_set_dvs_6axis_pool(struct atomisp_sub_device *asd,
+			struct atomisp_dvs_6axis_pool_config *config)
+{
+	return atomisp_css_set_dvs_6axis_pool(asd, config);
+}
+
+int atomisp_set_dvs_6axis_slot(struct atomisp_sub_device *asd,
+			struct atomisp_dvs_6axis_slot *slot)
+{
+	return atomisp_css_set_dvs_6axis_slot(asd, slot);
+}
+
 static int __atomisp_cp_morph_table(struct atomisp_sub_device *asd,
 				struct atomisp_morph_table *user_morph_table,
 				struct atomisp_css_params *css_param)
@@ -3214,6 +3897,10 @@ error:
 }
 
 void atomisp_free_css_parameters(struct atomisp_css_params *css_param) {
+	if (css_param->shading_prepared) {
+		ia_css_shading_prepared_free(css_param->shading_prepared);
+		css_param->shading_prepared = NULL;
+	}
 	if (css_param->dvs_6axis) {
 		ia_css_dvs2_6axis_config_free(css_param->dvs_6axis);
 		css_param->dvs_6axis = NULL;
@@ -5482,58 +6169,35 @@ static int __checking_exp_id(struct atomisp_sub_device *asd, int exp_id)
 
 void atomisp_init_raw_buffer_bitmap(struct atomisp_sub_device *asd)
 {
-	unsigned long flags;
-	spin_lock_irqsave(&asd->raw_buffer_bitmap_lock, flags);
-	memset(asd->raw_buffer_bitmap, 0, sizeof(asd->raw_buffer_bitmap));
-	spin_unlock_irqrestore(&asd->raw_buffer_bitmap_lock, flags);
+	bitmap_zero(asd->raw_buffer_bitmap, ATOMISP_MAX_EXP_ID + 1);
 }
 
 int atomisp_set_raw_buffer_bitmap(struct atomisp_sub_device *asd, int exp_id)
 {
-	int *bitmap, bit;
-	unsigned long flags;
-
 	if (__checking_exp_id(asd, exp_id))
 		return -EINVAL;
 
-	bitmap = asd->raw_buffer_bitmap + exp_id / 32;
-	bit = exp_id % 32;
-	spin_lock_irqsave(&asd->raw_buffer_bitmap_lock, flags);
-	(*bitmap) |= (1 << bit);
-	spin_unlock_irqrestore(&asd->raw_buffer_bitmap_lock, flags);
+	set_bit(exp_id, asd->raw_buffer_bitmap);
 	return 0;
 }
 
 static int __is_raw_buffer_locked(struct atomisp_sub_device *asd, int exp_id)
 {
-	int *bitmap, bit;
-	unsigned long flags;
-	int ret;
-
 	if (__checking_exp_id(asd, exp_id))
 		return -EINVAL;
 
-	bitmap = asd->raw_buffer_bitmap + exp_id / 32;
-	bit = exp_id % 32;
-	spin_lock_irqsave(&asd->raw_buffer_bitmap_lock, flags);
-	ret = ((*bitmap) & (1 << bit));
-	spin_unlock_irqrestore(&asd->raw_buffer_bitmap_lock, flags);
-	return !ret;
+	return !test_bit(exp_id, asd->raw_buffer_bitmap);
 }
 
 static int __clear_raw_buffer_bitmap(struct atomisp_sub_device *asd, int exp_id)
 {
-	int *bitmap, bit;
-	unsigned long flags;
+	if (__checking_exp_id(asd, exp_id))
+		return -EINVAL;
 
-	if (__is_raw_buffer_locked(asd, exp_id))
+	/* check and clear in one go, so two unlocks can't both succeed */
+	if (!test_and_clear_bit(exp_id, asd->raw_buffer_bitmap))
 		return -EINVAL;
 
-	bitmap = asd->raw_buffer_bitmap + exp_id / 32;
-	bit = exp_id % 32;
-	spin_lock_irqsave(&asd->raw_buffer_bitmap_lock, flags);
-	(*bitmap) &= ~(1 << bit);
-	spin_unlock_irqrestore(&asd->raw_buffer_bitmap_lock, flags);
 	return 0;
 }
 
@@ -37,6 +37,11 @@
 
 struct atomisp_device;
 struct atomisp_css_frame;
+struct atomisp_dis_stat_ring_config;
+struct atomisp_dis_stat_slot;
+struct atomisp_dvs_6axis_pool_config;
+struct atomisp_dvs_6axis_slot;
+struct atomisp_frame_meta_ring_config;
 
 #define MSI_ENABLE_BIT		16
 #define INTR_DISABLE_BIT	10
@@ -177,6 +182,31 @@ int atomisp_macc_table(struct atomisp_sub_device *asd, int flag,
 int atomisp_get_dis_stat(struct atomisp_sub_device *asd,
 			 struct atomisp_dis_statistics *stats);
 
+/*
+ * Function to set up the DIS statistics ring and fill its next slot.
+ */
+int atomisp_set_dis_stat_ring(struct atomisp_sub_device *asd,
+			      struct atomisp_dis_stat_ring_config *config);
+
+int atomisp_get_dis_stat_slot(struct atomisp_sub_device *asd,
+			      struct atomisp_dis_stat_slot *slot);
+
+/*
+ * Function to set up, map and free the per-frame metadata ring.
+ */
+int atomisp_set_frame_meta_ring(struct atomisp_sub_device *asd,
+				struct atomisp_frame_meta_ring_config *config);
+
+int atomisp_mmap_frame_meta_ring(struct atomisp_sub_device *asd,
+				 struct vm_area_struct *vma);
+
+void atomisp_free_frame_meta_ring(struct atomisp_sub_device *asd);
+
+void atomisp_frame_meta_set_exposure(struct atomisp_sub_device *asd,
+				     const struct atomisp_exposure *exposure);
+
+void atomisp_frame_meta_set_focus(struct atomisp_sub_device *asd, int focus);
+
 /*
  * Function to get DVS2 BQ resolution settings
  */
@@ -287,6 +317,12 @@ int atomisp_digital_zoom(struct atomisp_sub_device *asd, int flag,
 int atomisp_get_effective_res(struct atomisp_sub_device *asd,
 			struct atomisp_resolution  *config);
 
+int atomisp_set_dvs_6axis_pool(struct atomisp_sub_device *asd,
+			struct atomisp_dvs_6axis_pool_config *config);
+
+int atomisp_set_dvs_6axis_slot(struct atomisp_sub_device *asd,
+			struct atomisp_dvs_6axis_slot *slot);
+
 int atomisp_cp_dvs_6axis_config(struct atomisp_sub_device *asd,
 			struct atomisp_dvs_6axis_config *user_6axis_config,
 			struct atomisp_css_params *css_param);
@@ -330,6 +366,10 @@ int atomisp_freq_scaling(struct atomisp_device *vdev,
 			 enum atomisp_dfs_mode mode,
 			 bool force);
 
+void atomisp_dfs_gov_eof(struct atomisp_sub_device *asd, uint8_t exp_id);
+void atomisp_dfs_gov_frame_done(struct atomisp_sub_device *asd,
+				uint8_t exp_id);
+
 void atomisp_buf_done(struct atomisp_sub_device *asd, int error,
 		      enum atomisp_css_buffer_type buf_type,
 		      enum atomisp_css_pipe_id css_pipe_id,
@@ -123,6 +123,11 @@
 struct atomisp_device;
 struct atomisp_sub_device;
 struct video_device;
+struct vm_area_struct;
+struct atomisp_dis_stat_ring_config;
+struct atomisp_dis_stat_slot;
+struct atomisp_dvs_6axis_pool_config;
+struct atomisp_dvs_6axis_slot;
 enum atomisp_input_stream_id;
 
 struct atomisp_metadata_buf {
@@ -134,6 +139,15 @@ struct atomisp_metadata_buf {
 void atomisp_css_debug_dump_sp_sw_debug_info(void);
 void atomisp_css_debug_dump_debug_info(const char *context);
 void atomisp_css_debug_set_dtrace_level(const unsigned int trace_level);
+void atomisp_css_debug_trace_ring_enable(bool enable);
+bool atomisp_css_debug_trace_ring_enabled(void);
+void atomisp_css_debug_trace_ring_dump(void);
+void atomisp_css_debug_param_prof_enable(bool enable);
+bool atomisp_css_debug_param_prof_enabled(void);
+void atomisp_css_debug_dump_param_prof(void);
+bool atomisp_css_sample_isp_pc(unsigned int *binary_id, unsigned int *pc,
+			       bool *stall);
+const char *atomisp_css_binary_name(unsigned int binary_id);
 
 void atomisp_store_uint32(hrt_address addr, uint32_t data);
 void atomisp_load_uint32(hrt_address addr, uint32_t *data);
@@ -190,6 +204,8 @@ void atomisp_css_mmu_set_page_table_base_index(unsigned long base_index);
 int atomisp_css_start(struct atomisp_sub_device *asd,
 		      enum atomisp_css_pipe_id pipe_id, bool in_reset);
 
+bool __need_realloc_mipi_buffer(struct atomisp_device *isp);
+
 void atomisp_css_update_isp_params(struct atomisp_sub_device *asd);
 void atomisp_css_update_isp_params_on_pipe(struct atomisp_sub_device *asd,
 					struct ia_css_pipe *pipe);
@@ -355,6 +371,8 @@ int atomisp_css_frame_allocate_from_info(struct atomisp_css_frame **frame,
 
 void atomisp_css_frame_free(struct atomisp_css_frame *frame);
 
+void atomisp_css_frame_flush(struct atomisp_css_frame *frame);
+
 int atomisp_css_frame_map(struct atomisp_css_frame **frame,
 				const struct atomisp_css_frame_info *info,
 				const void *data, uint16_t attribute,
@@ -605,6 +623,19 @@ void atomisp_css_set_shading_table(struct atomisp_sub_device *asd,
 
 void atomisp_css_shading_table_free(struct atomisp_css_shading_table *table);
 
+struct atomisp_css_shading_prepared *atomisp_css_shading_table_prepare(
+				struct atomisp_sub_device *asd,
+				struct atomisp_css_shading_table *table);
+
+int atomisp_css_shading_table_convert(
+				struct atomisp_css_shading_prepared *prepared);
+
+void atomisp_css_set_shading_prepared(struct atomisp_sub_device *asd,
+				struct atomisp_css_shading_prepared *prepared);
+
+void atomisp_css_shading_prepared_free(
+				struct atomisp_css_shading_prepared *prepared);
+
 struct atomisp_css_morph_table *atomisp_css_morph_table_allocate(
 				unsigned int width, unsigned int height);
 
@@ -619,6 +650,28 @@ void atomisp_css_morph_table_free(struct atomisp_css_morph_table *table);
 void atomisp_css_set_cont_prev_start_time(struct atomisp_device *isp,
 					unsigned int overlap);
 
+int atomisp_css_set_dis_stat_ring(struct atomisp_sub_device *asd,
+			struct atomisp_dis_stat_ring_config *config);
+
+void atomisp_css_free_dis_stat_ring(struct atomisp_sub_device *asd);
+
+int atomisp_css_get_dis_stat_slot(struct atomisp_sub_device *asd,
+			struct atomisp_dis_stat_slot *slot);
+
+int atomisp_css_mmap_dis_stat_ring(struct atomisp_sub_device *asd,
+			struct vm_area_struct *vma);
+
+int atomisp_css_set_dvs_6axis_pool(struct atomisp_sub_device *asd,
+			struct atomisp_dvs_6axis_pool_config *config);
+
+void atomisp_css_free_dvs_6axis_pool(struct atomisp_sub_device *asd);
+
+int atomisp_css_set_dvs_6axis_slot(struct atomisp_sub_device *asd,
+			struct atomisp_dvs_6axis_slot *slot);
+
+int atomisp_css_mmap_dvs_6axis_pool(struct atomisp_sub_device *asd,
+			struct vm_area_struct *vma);
+
 int atomisp_css_get_dis_stat(struct atomisp_sub_device *asd,
 			 struct atomisp_dis_statistics *stats);
 
@@ -19,6 +19,9 @@
  *
  */
 
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
+
 #include <media/videobuf-vmalloc.h>
 #include <media/v4l2-dev.h>
 #include <media/v4l2-event.h>
@@ -44,6 +47,7 @@
 #include "ia_css_isp_param.h"
 #include "sh_css_hrt.h"
 #include "ia_css_isys.h"
+#include "sh_css_metrics.h"
 
 #include <linux/pm_runtime.h>
 
@@ -93,6 +97,47 @@ unsigned int atomisp_css_debug_get_dtrace_level(void)
 	return ia_css_debug_trace_level;
 }
 
+void atomisp_css_debug_trace_ring_enable(bool enable)
+{
+	ia_css_debug_trace_ring_enable(enable);
+}
+
+bool atomisp_css_debug_trace_ring_enabled(void)
+{
+	return ia_css_debug_trace_ring_enabled;
+}
+
+void atomisp_css_debug_trace_ring_dump(void)
+{
+	ia_css_debug_trace_ring_dump();
+}
+
+void atomisp_css_debug_param_prof_enable(bool enable)
+{
+	ia_css_debug_param_prof_enable(enable);
+}
+
+bool atomisp_css_debug_param_prof_enabled(void)
+{
+	return ia_css_debug_param_prof_enabled;
+}
+
+void atomisp_css_debug_dump_param_prof(void)
+{
+	ia_css_debug_dump_param_prof();
+}
+
+bool atomisp_css_sample_isp_pc(unsigned int *binary_id, unsigned int *pc,
+			       bool *stall)
+{
+	return sh_css_metrics_sample_isp(binary_id, pc, stall);
+}
+
+const char *atomisp_css_binary_name(unsigned int binary_id)
+{
+	return sh_css_metrics_binary_name(binary_id);
+}
+
 static ia_css_ptr atomisp_css2_mm_alloc(size_t bytes, uint32_t attr)
 {
 	if (attr & IA_CSS_MEM_ATTR_ZEROED) {
@@ -156,6 +201,7 @@ void atomisp_css2_hw_store_8(hrt_address addr, uint8_t data)
 {
 	unsigned long flags;
 
+	hmm_flush_dirty();
 	spin_lock_irqsave(&mmio_lock, flags);
 	raw_spin_lock(&pci_config_lock);
 	_hrt_master_port_store_8(addr, data);
@@ -167,6 +213,7 @@ static void atomisp_css2_hw_store_16(hrt_address addr, uint16_t data)
 {
 	unsigned long flags;
 
+	hmm_flush_dirty();
 	spin_lock_irqsave(&mmio_lock, flags);
 	raw_spin_lock(&pci_config_lock);
 	_hrt_master_port_store_16(addr, data);
@@ -178,6 +225,7 @@ static void atomisp_css2_hw_store_32(hrt_address addr, uint32_t data)
 {
 	unsigned long flags;
 
+	hmm_flush_dirty();
 	spin_lock_irqsave(&mmio_lock, flags);
 	raw_spin_lock(&pci_config_lock);
 	_hrt_master_port_store_32(addr, data);
@@ -231,6 +279,7 @@ static void atomisp_css2_hw_store(hrt_address addr,
 	unsigned int _to = (unsigned int)addr;
 	const char *_from = (const char *)from;
 
+	hmm_flush_dirty();
 	spin_lock_irqsave(&mmio_lock, flags);
 	raw_spin_lock(&pci_config_lock);
 	for (i = 0; i < n; i++, _to++, _from++)
@@ -1022,6 +1071,16 @@ void atomisp_css_unload_firmware(struct atomisp_device *isp)
 	ia_css_unload_firmware();
 }
 
+void atomisp_css_unload_firmware_blobs(struct atomisp_device *isp)
+{
+	ia_css_unload_firmware_blobs();
+}
+
+bool atomisp_css_firmware_indexed(struct atomisp_device *isp)
+{
+	return ia_css_firmware_indexed();
+}
+
 void atomisp_css_uninit(struct atomisp_device *isp)
 {
 	struct atomisp_sub_device *asd;
@@ -1569,6 +1628,7 @@ void atomisp_css_free_stat_buffers(struct atomisp_sub_device *asd)
 	if (asd->params.curr_grid_info.dvs_grid.enable) {
 		ia_css_dvs2_coefficients_free(asd->params.css_param.dvs2_coeff);
 		ia_css_dvs2_statistics_free(asd->params.dvs_stat);
+		atomisp_css_free_dis_stat_ring(asd);
 		asd->params.css_param.dvs2_coeff = NULL;
 		asd->params.dvs_stat = NULL;
 		asd->params.dvs_hor_proj_bytes = 0;
@@ -1617,6 +1677,7 @@ void atomisp_css_free_stat_buffers(struct atomisp_sub_device *asd)
 		ia_css_dvs2_6axis_config_free(asd->params.css_param.dvs_6axis);
 		asd->params.css_param.dvs_6axis = NULL;
 	}
+	atomisp_css_free_dvs_6axis_pool(asd);
 
 	for (i = 0; i < ATOMISP_METADATA_TYPE_NUM; i++) {
 		list_for_each_entry_safe(md_buf, _md_buf,
@@ -2299,6 +2360,11 @@ void atomisp_css_frame_free(struct atomisp_css_frame *frame)
 	ia_css_frame_free(frame);
 }
 
+void atomisp_css_frame_flush(struct atomisp_css_frame *frame)
+{
+	hmm_flush_cache(frame->data);
+}
+
 int atomisp_css_frame_map(struct atomisp_css_frame **frame,
 				const struct atomisp_css_frame_info *info,
 				const void *data, uint16_t attribute,
@@ -4126,23 +4192,18 @@ int atomisp_css_get_zoom_factor(struct atomisp_sub_device *asd,
 /*
  * Function to set/get image stablization statistics
  */
-int atomisp_css_get_dis_stat(struct atomisp_sub_device *asd,
-			 struct atomisp_dis_statistics *stats)
+/*
+ * Take the oldest DIS statistics buffer, translate it into host_stats and
+ * return it to the list. The caller has checked the grid.
+ */
+static int __atomisp_css_translate_dis_stat(struct atomisp_sub_device *asd,
+				struct ia_css_dvs2_statistics *host_stats,
+				uint32_t *exp_id)
 {
 	struct atomisp_device *isp = asd->isp;
 	struct atomisp_dis_buf *dis_buf;
 	unsigned long flags;
 
-	if (asd->params.dvs_stat->hor_prod.odd_real == NULL ||
-	    asd->params.dvs_stat->hor_prod.odd_imag == NULL ||
-	    asd->params.dvs_stat->hor_prod.even_real == NULL ||
-	    asd->params.dvs_stat->hor_prod.even_imag == NULL ||
-	    asd->params.dvs_stat->ver_prod.odd_real == NULL ||
-	    asd->params.dvs_stat->ver_prod.odd_imag == NULL ||
-	    asd->params.dvs_stat->ver_prod.even_real == NULL ||
-	    asd->params.dvs_stat->ver_prod.even_imag == NULL)
-		return -EINVAL;
-
 	/* isp needs to be streaming to get DIS statistics */
 	spin_lock_irqsave(&isp->lock, flags);
 	if (asd->streaming != ATOMISP_DEVICE_STREAMING_ENABLED) {
@@ -4151,12 +4212,6 @@ int atomisp_css_get_dis_stat(struct atomisp_sub_device *asd,
 	}
 	spin_unlock_irqrestore(&isp->lock, flags);
 
-	if (atomisp_compare_dvs_grid(asd, &stats->dvs2_stat.grid_info) != 0)
-		/* If the grid info in the argument differs from the current
-		   grid info, we tell the caller to reset the grid size and
-		   try again. */
-		return -EAGAIN;
-
 	spin_lock_irqsave(&asd->dis_stats_lock, flags);
 	if (!asd->params.dis_proj_data_valid || list_empty(&asd->dis_stats)) {
 		spin_unlock_irqrestore(&asd->dis_stats_lock, flags);
@@ -4170,17 +4225,46 @@ int atomisp_css_get_dis_stat(struct atomisp_sub_device *asd,
 	spin_unlock_irqrestore(&asd->dis_stats_lock, flags);
 
 	if (dis_buf->dvs_map)
-		ia_css_translate_dvs2_statistics(
-			asd->params.dvs_stat, dis_buf->dvs_map);
+		ia_css_translate_dvs2_statistics(host_stats, dis_buf->dvs_map);
 	else
-		ia_css_get_dvs2_statistics(asd->params.dvs_stat,
-			dis_buf->dis_data);
-	stats->exp_id = dis_buf->exp_id;
+		ia_css_get_dvs2_statistics(host_stats, dis_buf->dis_data);
+	*exp_id = dis_buf->exp_id;
 
 	spin_lock_irqsave(&asd->dis_stats_lock, flags);
 	list_add_tail(&dis_buf->list, &asd->dis_stats);
 	spin_unlock_irqrestore(&asd->dis_stats_lock, flags);
 
+	return 0;
+}
+
+int atomisp_css_get_dis_stat(struct atomisp_sub_device *asd,
+			 struct atomisp_dis_statistics *stats)
+{
+	uint32_t exp_id;
+	int ret;
+
+	if (asd->params.dvs_stat->hor_prod.odd_real == NULL ||
+	    asd->params.dvs_stat->hor_prod.odd_imag == NULL ||
+	    asd->params.dvs_stat->hor_prod.even_real == NULL ||
+	    asd->params.dvs_stat->hor_prod.even_imag == NULL ||
+	    asd->params.dvs_stat->ver_prod.odd_real == NULL ||
+	    asd->params.dvs_stat->ver_prod.odd_imag == NULL ||
+	    asd->params.dvs_stat->ver_prod.even_real == NULL ||
+	    asd->params.dvs_stat->ver_prod.even_imag == NULL)
+		return -EINVAL;
+
+	if (atomisp_compare_dvs_grid(asd, &stats->dvs2_stat.grid_info) != 0)
+		/* If the grid info in the argument differs from the current
+		   grid info, we tell the caller to reset the grid size and
+		   try again. */
+		return -EAGAIN;
+
+	ret = __atomisp_css_translate_dis_stat(asd, asd->params.dvs_stat,
+					       &exp_id);
+	if (ret)
+		return ret;
+	stats->exp_id = exp_id;
+
 	if (copy_to_user(stats->dvs2_stat.ver_prod.odd_real,
 			 asd->params.dvs_stat->ver_prod.odd_real,
 			 asd->params.dvs_ver_proj_bytes))
@@ -4217,6 +4301,209 @@ int atomisp_css_get_dis_stat(struct atomisp_sub_device *asd,
 	return 0;
 }
 
+void atomisp_css_free_dis_stat_ring(struct atomisp_sub_device *asd)
+{
+	struct atomisp_dis_stat_ring *ring = &asd->params.dis_ring;
+
+	/* pages still mapped by userspace stay alive until munmap */
+	vfree(ring->base);
+	memset(ring, 0, sizeof(*ring));
+}
+
+int atomisp_css_set_dis_stat_ring(struct atomisp_sub_device *asd,
+			struct atomisp_dis_stat_ring_config *config)
+{
+	struct atomisp_dis_stat_ring *ring = &asd->params.dis_ring;
+	unsigned int ver = asd->params.dvs_ver_proj_bytes;
+	unsigned int hor = asd->params.dvs_hor_proj_bytes;
+	unsigned int i;
+
+	atomisp_css_free_dis_stat_ring(asd);
+	if (!config->enable)
+		return 0;
+
+	if (!asd->params.dvs_stat || !ver || !hor)
+		return -EINVAL;
+
+	ring->num_slots = ATOMISP_DIS_STAT_RING_SLOTS;
+	ring->slot_size = PAGE_ALIGN(4 * ver + 4 * hor);
+	ring->base = vmalloc_user(ring->num_slots * ring->slot_size);
+	if (!ring->base) {
+		memset(ring, 0, sizeof(*ring));
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < ring->num_slots; i++) {
+		struct ia_css_dvs2_statistics *st = &ring->slot[i];
+		char *p = ring->base + i * ring->slot_size;
+
+		st->grid = asd->params.dvs_stat->grid;
+		st->ver_prod.odd_real = (int32_t *)p;
+		st->ver_prod.odd_imag = (int32_t *)(p + ver);
+		st->ver_prod.even_real = (int32_t *)(p + 2 * ver);
+		st->ver_prod.even_imag = (int32_t *)(p + 3 * ver);
+		p += 4 * ver;
+		st->hor_prod.odd_real = (int32_t *)p;
+		st->hor_prod.odd_imag = (int32_t *)(p + hor);
+		st->hor_prod.even_real = (int32_t *)(p + 2 * hor);
+		st->hor_prod.even_imag = (int32_t *)(p + 3 * hor);
+	}
+
+	config->num_slots = ring->num_slots;
+	config->slot_size = ring->slot_size;
+	config->ver_proj_bytes = ver;
+	config->hor_proj_bytes = hor;
+	config->mmap_offset = ATOMISP_DIS_STAT_RING_MMAP_OFFSET;
+
+	return 0;
+}
+
+int atomisp_css_get_dis_stat_slot(struct atomisp_sub_device *asd,
+			struct atomisp_dis_stat_slot *slot)
+{
+	struct atomisp_dis_stat_ring *ring = &asd->params.dis_ring;
+	uint32_t exp_id;
+	int ret;
+
+	/* the ring is dropped when the grid changes, see
+	 * atomisp_css_free_stat_buffers() */
+	if (!ring->base)
+		return -EAGAIN;
+
+	ret = __atomisp_css_translate_dis_stat(asd, &ring->slot[ring->next],
+					       &exp_id);
+	if (ret)
+		return ret;
+
+	slot->index = ring->next;
+	slot->exp_id = exp_id;
+	ring->next = (ring->next + 1) % ring->num_slots;
+
+	return 0;
+}
+
+int atomisp_css_mmap_dis_stat_ring(struct atomisp_sub_device *asd,
+			struct vm_area_struct *vma)
+{
+	struct atomisp_dis_stat_ring *ring = &asd->params.dis_ring;
+
+	if (!ring->base)
+		return -EINVAL;
+
+	if (vma->vm_end - vma->vm_start != ring->num_slots * ring->slot_size)
+		return -EINVAL;
+
+	return remap_vmalloc_range(vma, ring->base, 0);
+}
+
+void atomisp_css_free_dvs_6axis_pool(struct atomisp_sub_device *asd)
+{
+	struct atomisp_dvs_6axis_pool *pool = &asd->params.dvs_6axis_pool;
+
+	/*
+	 * CSS copies the grid in ia_css_stream_set_isp_config(), so no
+	 * pending config can point into the pool here.
+	 */
+	vfree(pool->base);
+	memset(pool, 0, sizeof(*pool));
+}
+
+int atomisp_css_set_dvs_6axis_pool(struct atomisp_sub_device *asd,
+			struct atomisp_dvs_6axis_pool_config *config)
+{
+	struct atomisp_dvs_6axis_pool *pool = &asd->params.dvs_6axis_pool;
+	struct ia_css_stream *stream =
+			asd->stream_env[ATOMISP_INPUT_STREAM_GENERAL].stream;
+	struct ia_css_dvs_6axis_config *geometry;
+	unsigned int y_bytes, uv_bytes;
+	unsigned int i;
+
+	atomisp_css_free_dvs_6axis_pool(asd);
+	if (!config->enable)
+		return 0;
+
+	if (!stream || !asd->params.curr_grid_info.dvs_grid.enable)
+		return -EINVAL;
+
+	/* the table geometry is owned by CSS, borrow it once */
+	geometry = ia_css_dvs2_6axis_config_allocate(stream);
+	if (!geometry)
+		return -ENOMEM;
+
+	y_bytes = geometry->width_y * geometry->height_y * sizeof(uint32_t);
+	uv_bytes = geometry->width_uv * geometry->height_uv *
+		   sizeof(uint32_t);
+
+	pool->num_slots = ATOMISP_DVS_6AXIS_POOL_SLOTS;
+	pool->slot_size = PAGE_ALIGN(2 * y_bytes + 2 * uv_bytes);
+	pool->base = vmalloc_user(pool->num_slots * pool->slot_size);
+	if (!pool->base) {
+		ia_css_dvs2_6axis_config_free(geometry);
+		memset(pool, 0, sizeof(*pool));
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < pool->num_slots; i++) {
+		struct ia_css_dvs_6axis_config *cfg = &pool->slot[i];
+		char *p = pool->base + i * pool->slot_size;
+
+		cfg->width_y = geometry->width_y;
+		cfg->height_y = geometry->height_y;
+		cfg->width_uv = geometry->width_uv;
+		cfg->height_uv = geometry->height_uv;
+		cfg->xcoords_y = (uint32_t *)p;
+		cfg->ycoords_y = (uint32_t *)(p + y_bytes);
+		cfg->xcoords_uv = (uint32_t *)(p + 2 * y_bytes);
+		cfg->ycoords_uv = (uint32_t *)(p + 2 * y_bytes + uv_bytes);
+	}
+
+	config->num_slots = pool->num_slots;
+	config->slot_size = pool->slot_size;
+	config->width_y = geometry->width_y;
+	config->height_y = geometry->height_y;
+	config->width_uv = geometry->width_uv;
+	config->height_uv = geometry->height_uv;
+	config->mmap_offset = ATOMISP_DVS_6AXIS_POOL_MMAP_OFFSET;
+
+	ia_css_dvs2_6axis_config_free(geometry);
+	return 0;
+}
+
+int atomisp_css_set_dvs_6axis_slot(struct atomisp_sub_device *asd,
+			struct atomisp_dvs_6axis_slot *slot)
+{
+	struct atomisp_dvs_6axis_pool *pool = &asd->params.dvs_6axis_pool;
+	struct ia_css_dvs_6axis_config *cfg;
+
+	/* the pool is dropped when the stream is torn down, see
+	 * atomisp_css_free_stat_buffers() */
+	if (!pool->base)
+		return -EAGAIN;
+
+	if (slot->index >= pool->num_slots)
+		return -EINVAL;
+
+	cfg = &pool->slot[slot->index];
+	cfg->exp_id = slot->exp_id;
+	atomisp_css_set_dvs_6axis(asd, cfg);
+
+	return 0;
+}
+
+int atomisp_css_mmap_dvs_6axis_pool(struct atomisp_sub_device *asd,
+			struct vm_area_struct *vma)
+{
+	struct atomisp_dvs_6axis_pool *pool = &asd->params.dvs_6axis_pool;
+
+	if (!pool->base)
+		return -EINVAL;
+
+	if (vma->vm_end - vma->vm_start != pool->num_slots * pool->slot_size)
+		return -EINVAL;
+
+	return remap_vmalloc_range(vma, pool->base, 0);
+}
+
 struct atomisp_css_shading_table *atomisp_css_shading_table_alloc(
 				unsigned int width, unsigned int height)
 {
@@ -4234,6 +4521,36 @@ void atomisp_css_shading_table_free(struct atomisp_css_shading_table *table)
 	ia_css_shading_table_free(table);
 }
 
+struct atomisp_css_shading_prepared *atomisp_css_shading_table_prepare(
+				struct atomisp_sub_device *asd,
+				struct atomisp_css_shading_table *table)
+{
+	return ia_css_shading_prepare(
+			asd->stream_env[ATOMISP_INPUT_STREAM_GENERAL].stream,
+			table);
+}
+
+int atomisp_css_shading_table_convert(
+				struct atomisp_css_shading_prepared *prepared)
+{
+	if (ia_css_shading_prepared_convert(prepared) != IA_CSS_SUCCESS)
+		return -ENOMEM;
+
+	return 0;
+}
+
+void atomisp_css_set_shading_prepared(struct atomisp_sub_device *asd,
+			struct atomisp_css_shading_prepared *prepared)
+{
+	asd->params.config.shading_prepared = prepared;
+}
+
+void atomisp_css_shading_prepared_free(
+				struct atomisp_css_shading_prepared *prepared)
+{
+	ia_css_shading_prepared_free(prepared);
+}
+
 struct atomisp_css_morph_table *atomisp_css_morph_table_allocate(
 				unsigned int width, unsigned int height)
 {
@@ -80,6 +80,7 @@
 #define atomisp_css_3a_grid_info	ia_css_3a_grid_info
 #define atomisp_css_dvs_grid_info	ia_css_dvs_grid_info
 #define atomisp_css_shading_table	ia_css_shading_table
+#define atomisp_css_shading_prepared	ia_css_shading_prepared
 #define atomisp_css_morph_table	ia_css_morph_table
 #define atomisp_css_dvs_6axis_config	ia_css_dvs_6axis_config
 #define atomisp_css_fw_info	ia_css_fw_info
@@ -259,6 +260,11 @@ int atomisp_css_load_firmware(struct atomisp_device *isp);
 
 void atomisp_css_unload_firmware(struct atomisp_device *isp);
 
+/* Free the binaries, keeping the parsed firmware index for a reload */
+void atomisp_css_unload_firmware_blobs(struct atomisp_device *isp);
+
+bool atomisp_css_firmware_indexed(struct atomisp_device *isp);
+
 void atomisp_css_set_dvs_6axis(struct atomisp_sub_device *asd,
 			struct atomisp_css_dvs_6axis *dvs_6axis);
 
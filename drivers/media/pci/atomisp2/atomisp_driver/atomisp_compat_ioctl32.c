@@ -26,6 +26,7 @@
 #include "atomisp_internal.h"
 #include "atomisp_compat.h"
 #include "atomisp_compat_ioctl32.h"
+#include "atomisp_ioctl.h"
 
 static int get_atomisp_histogram32(struct atomisp_histogram *kp,
 					struct atomisp_histogram32 __user *up)
@@ -1160,6 +1161,12 @@ long atomisp_compat_ioctl32(struct file *file,
 	case ATOMISP_IOC_G_SENSOR_AE_BRACKETING_MODE:
 	case ATOMISP_IOC_G_INVALID_FRAME_NUM:
 	case ATOMISP_IOC_G_EFFECTIVE_RESOLUTION:
+	case ATOMISP_IOC_S_DIS_STAT_RING:
+	case ATOMISP_IOC_G_DIS_STAT_SLOT:
+	case ATOMISP_IOC_S_DIS_VECTOR_POOL:
+	case ATOMISP_IOC_S_DIS_VECTOR_SLOT:
+	case ATOMISP_IOC_G_COMPLETION_FD:
+	case ATOMISP_IOC_S_FRAME_META_RING:
 		ret = native_ioctl(file, cmd, arg);
 		break;
 
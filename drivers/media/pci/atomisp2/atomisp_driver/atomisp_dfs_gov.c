@@ -0,0 +1,86 @@
+/*
+ * Support for Medifield PNW Camera Imaging ISP subsystem.
+ *
+ * Copyright (c) 2010 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+#include <linux/atomisp.h>
+#include <linux/kernel.h>
+
+#include "atomisp-regs.h"
+#include "atomisp_dfs_gov.h"
+#include "atomisp_dfs_tables.h"
+
+unsigned int atomisp_dfs_gov_pick(const struct atomisp_dfs_config *dfs,
+				  unsigned int cur_freq,
+				  unsigned int util_pct,
+				  unsigned int target_pct)
+{
+	unsigned int need = DIV_ROUND_UP(cur_freq * util_pct, target_pct);
+	unsigned int best = dfs->highest_freq;
+	unsigned int freq;
+	int i;
+
+	if (dfs->lowest_freq >= need)
+		return dfs->lowest_freq;
+	if (dfs->max_freq_at_vmin >= need && dfs->max_freq_at_vmin < best)
+		best = dfs->max_freq_at_vmin;
+
+	for (i = 0; i < dfs->dfs_table_size; i++) {
+		freq = dfs->dfs_table[i].isp_freq;
+		if (freq >= need && freq < best)
+			best = freq;
+	}
+
+	return best;
+}
+
+unsigned int atomisp_dfs_gov_avg(unsigned int avg, unsigned int busy_us)
+{
+	return avg ? (avg * 7 + busy_us) / 8 : busy_us;
+}
+
+unsigned int atomisp_dfs_gov_util(unsigned int busy_us, unsigned short fps)
+{
+	return DIV_ROUND_UP(busy_us * fps, USEC_PER_SEC / 100);
+}
+
+unsigned int atomisp_dfs_gov_eval(struct atomisp_dfs_gov *gov,
+				  const struct atomisp_dfs_config *dfs,
+				  unsigned int cur_freq,
+				  unsigned int util_pct)
+{
+	unsigned int new_freq;
+
+	gov->util_pct = util_pct;
+	if (!util_pct || !cur_freq)
+		return cur_freq;
+
+	new_freq = atomisp_dfs_gov_pick(dfs, cur_freq, util_pct,
+					gov->target_pct);
+	if (new_freq < cur_freq) {
+		if (++gov->below < gov->down_evals)
+			return cur_freq;
+		gov->downs++;
+	} else if (new_freq > cur_freq) {
+		gov->ups++;
+	}
+	gov->below = 0;
+
+	return new_freq;
+}
@@ -0,0 +1,88 @@
+/*
+ * Support for Medifield PNW Camera Imaging ISP subsystem.
+ *
+ * Copyright (c) 2010 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+
+#ifndef __ATOMISP_DFS_GOV_H__
+#define __ATOMISP_DFS_GOV_H__
+
+#include <linux/kernel.h>
+
+struct atomisp_dfs_config;
+
+enum atomisp_dfs_mode {
+	ATOMISP_DFS_MODE_AUTO = 0,
+	ATOMISP_DFS_MODE_LOW,
+	ATOMISP_DFS_MODE_MAX,
+};
+
+/*
+ * Utilization governor on top of the DFS table: every
+ * ATOMISP_DFS_GOV_EVAL_FRAMES output frames the EOF to frame done time of
+ * all streaming sub-devices is summed as a share of their frame period,
+ * and the lowest DFS frequency keeping that share below target_pct is
+ * chosen. Frequency goes up at once, but down only after down_evals
+ * evaluations in a row asked for less.
+ *
+ * The functions below only compute; atomisp_cmd.c feeds them the
+ * samples and sets the frequency. They build on the host as well, see
+ * dfs_replay.
+ */
+#define ATOMISP_DFS_GOV_EVAL_FRAMES	16
+#define ATOMISP_DFS_GOV_TARGET_PCT	80
+#define ATOMISP_DFS_GOV_DOWN_EVALS	4
+
+struct atomisp_dfs_gov {
+	bool enabled;
+	enum atomisp_dfs_mode mode;	/* last mode asked for */
+	unsigned int target_pct;
+	unsigned int down_evals;
+	unsigned int frames;
+	unsigned int below;
+	unsigned int util_pct;		/* last measured, at running_freq */
+	unsigned int ups;
+	unsigned int downs;
+};
+
+/*
+ * Lowest DFS frequency at which a load of util_pct percent measured at
+ * cur_freq stays within target_pct percent.
+ */
+unsigned int atomisp_dfs_gov_pick(const struct atomisp_dfs_config *dfs,
+				  unsigned int cur_freq,
+				  unsigned int util_pct,
+				  unsigned int target_pct);
+
+/* Running average of the busy time, a new sample weighs 1/8 */
+unsigned int atomisp_dfs_gov_avg(unsigned int avg, unsigned int busy_us);
+
+/* Busy time as a share of the frame period */
+unsigned int atomisp_dfs_gov_util(unsigned int busy_us, unsigned short fps);
+
+/*
+ * One evaluation of the governor for a load of util_pct percent measured
+ * at cur_freq. Returns the frequency to run at from now on.
+ */
+unsigned int atomisp_dfs_gov_eval(struct atomisp_dfs_gov *gov,
+				  const struct atomisp_dfs_config *dfs,
+				  unsigned int cur_freq,
+				  unsigned int util_pct);
+
+#endif /* __ATOMISP_DFS_GOV_H__ */
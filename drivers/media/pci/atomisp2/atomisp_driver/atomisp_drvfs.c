@@ -24,13 +24,38 @@
 #include <linux/pci.h>
 
 #include "atomisp_compat.h"
+#include "atomisp_fops.h"
 #include "atomisp_internal.h"
 #include "atomisp_ioctl.h"
+#include "atomisp_pcprof.h"
+#include "atomisp_uptr_cache.h"
 #include "hmm/hmm.h"
 
 /*
  * _iunit_debug:
  * dbglvl: iunit css driver trace level
+ * trace_ring: css binary trace ring, 0: off, 1: on, 2: dump to log
+ * param_prof: css parameter encoder profile, 0: off, 1: on, 2: dump to log
+ * dfs_gov: dfs utilization governor, 0: off (table only), 1: on;
+ *          reading shows the last measured load
+ * wdt_recovery: watchdog recovery tier statistics; writing n (1-3) fakes
+ *          n timeouts in a row on all streams, walking the tiers
+ * uptr_cache: pinned page budget of the USERPTR mapping cache, 0: off;
+ *          reading also shows the cache statistics
+ * cache_flush: cpu cache flush before the ISP reads a buffer, 0: buffer
+ *          pages only, 1: wbinvd; 2: compare both over buffer sizes
+ *          (not while streaming), shown on read
+ * open_linger: ms to keep the ISP powered up and CSS initialized after
+ *          the last close, 0: off; reading also shows cold and warm
+ *          (within the linger period) open latencies
+ * fw_load: deferred firmware load times, full parse vs kept index
+ * pc_prof: ISP pc sample rate in Hz while streaming, 0: off; writing
+ *          clears the profile. reading shows per firmware binary the
+ *          share of busy samples, stalls, estimated ISP cycles and a
+ *          histogram over 16 equal ISP program memory ranges
+ * hmm_vmap: page budget of the persistent hmm vmaps of small buffers,
+ *          0: off (vmap and flush per access); reading also shows the
+ *          vmap and deferred flush statistics
  * dbgopt: iunit debug option:
  *        bit 0: binary list
  *        bit 1: running binary
@@ -168,6 +193,415 @@ static ssize_t iunit_dbgopt_store(struct device_driver *drv, const char *buf,
 	return size;
 }
 
+static ssize_t iunit_probe_time_show(struct device_driver *drv, char *buf)
+{
+	struct atomisp_device *isp = iunit_debug.isp;
+	ssize_t len = 0;
+	unsigned int i;
+
+	for (i = 0; i < isp->subdev_timing_cnt; i++) {
+		struct atomisp_subdev_timing *t = &isp->subdev_timing[i];
+
+		len += scnprintf(buf + len, PAGE_SIZE - len,
+				 "%s: start %lld us, duration %lld us%s\n",
+				 t->name, t->start_us, t->duration_us,
+				 t->detected ? "" : " (not detected)");
+	}
+
+	return len;
+}
+
+static ssize_t iunit_trace_ring_show(struct device_driver *drv, char *buf)
+{
+	return sprintf(buf, "trace ring:%u\n",
+		       atomisp_css_debug_trace_ring_enabled());
+}
+
+static ssize_t iunit_trace_ring_store(struct device_driver *drv,
+				      const char *buf, size_t size)
+{
+	unsigned int opt;
+
+	if (kstrtouint(buf, 10, &opt) || opt > 2) {
+		dev_err(atomisp_dev, "%s setting %d value invalid\n",
+			__func__, opt);
+		return -EINVAL;
+	}
+
+	if (opt == 2)
+		atomisp_css_debug_trace_ring_dump();
+	else
+		atomisp_css_debug_trace_ring_enable(opt);
+
+	return size;
+}
+
+static ssize_t iunit_param_prof_show(struct device_driver *drv, char *buf)
+{
+	return sprintf(buf, "param prof:%u\n",
+		       atomisp_css_debug_param_prof_enabled());
+}
+
+static ssize_t iunit_param_prof_store(struct device_driver *drv,
+				      const char *buf, size_t size)
+{
+	unsigned int opt;
+
+	if (kstrtouint(buf, 10, &opt) || opt > 2) {
+		dev_err(atomisp_dev, "%s setting %d value invalid\n",
+			__func__, opt);
+		return -EINVAL;
+	}
+
+	if (opt == 2)
+		atomisp_css_debug_dump_param_prof();
+	else
+		atomisp_css_debug_param_prof_enable(opt);
+
+	return size;
+}
+
+static ssize_t iunit_dfs_gov_show(struct device_driver *drv, char *buf)
+{
+	struct atomisp_dfs_gov *gov = &iunit_debug.isp->dfs_gov;
+
+	return sprintf(buf, "dfs gov:%u load:%u%% target:%u%% freq:%d up:%u down:%u\n",
+		       gov->enabled, gov->util_pct, gov->target_pct,
+		       iunit_debug.isp->sw_contex.running_freq,
+		       gov->ups, gov->downs);
+}
+
+static ssize_t iunit_dfs_gov_store(struct device_driver *drv,
+				   const char *buf, size_t size)
+{
+	struct atomisp_device *isp = iunit_debug.isp;
+	unsigned int opt;
+
+	if (kstrtouint(buf, 10, &opt) || opt > 1) {
+		dev_err(atomisp_dev, "%s setting %d value invalid\n",
+			__func__, opt);
+		return -EINVAL;
+	}
+
+	rt_mutex_lock(&isp->mutex);
+	isp->dfs_gov.enabled = opt;
+	isp->dfs_gov.frames = 0;
+	isp->dfs_gov.below = 0;
+	rt_mutex_unlock(&isp->mutex);
+
+	return size;
+}
+
+static ssize_t iunit_wdt_recovery_show(struct device_driver *drv, char *buf)
+{
+	static const char * const tier_name[ATOMISP_WDT_TIERS] = {
+		"requeue", "restart", "reset"
+	};
+	struct atomisp_device *isp = iunit_debug.isp;
+	ssize_t len = 0;
+	unsigned int i;
+
+	for (i = 0; i < ATOMISP_WDT_TIERS; i++) {
+		struct atomisp_wdt_tier_stats *stats = &isp->wdt_tier_stats[i];
+
+		len += scnprintf(buf + len, PAGE_SIZE - len,
+				 "%s: tried %u ok %u failed %u avg %llu us max %u us\n",
+				 tier_name[i], stats->tried, stats->ok,
+				 stats->failed,
+				 stats->ok ? div_u64(stats->latency_us,
+						     stats->ok) : 0,
+				 stats->max_latency_us);
+	}
+
+	return len;
+}
+
+static ssize_t iunit_wdt_recovery_store(struct device_driver *drv,
+					const char *buf, size_t size)
+{
+	struct atomisp_device *isp = iunit_debug.isp;
+	unsigned int opt;
+
+	if (kstrtouint(buf, 10, &opt) || opt < 1 || opt > ATOMISP_WDT_TIERS) {
+		dev_err(atomisp_dev, "%s setting %d value invalid\n",
+			__func__, opt);
+		return -EINVAL;
+	}
+
+	rt_mutex_lock(&isp->mutex);
+	if (!atomisp_streaming_count(isp)) {
+		rt_mutex_unlock(&isp->mutex);
+		return -EPERM;
+	}
+	isp->wdt_inject = opt;
+	queue_work(isp->wdt_work_queue, &isp->wdt_work);
+	rt_mutex_unlock(&isp->mutex);
+
+	return size;
+}
+
+static ssize_t iunit_uptr_cache_show(struct device_driver *drv, char *buf)
+{
+	struct atomisp_device *isp = iunit_debug.isp;
+
+	return sprintf(buf, "budget %u pages, idle %u pages\n"
+		       "hits %u misses %u evictions %u invalidations %u\n",
+		       isp->uptr_cache.max_pages, isp->uptr_cache.idle_pages,
+		       isp->uptr_cache.hits, isp->uptr_cache.misses,
+		       isp->uptr_cache.evictions,
+		       isp->uptr_cache.invalidations);
+}
+
+static ssize_t iunit_uptr_cache_store(struct device_driver *drv,
+				      const char *buf, size_t size)
+{
+	struct atomisp_device *isp = iunit_debug.isp;
+	unsigned int opt;
+
+	if (kstrtouint(buf, 10, &opt)) {
+		dev_err(atomisp_dev, "%s setting %d value invalid\n",
+			__func__, opt);
+		return -EINVAL;
+	}
+
+	isp->uptr_cache.max_pages = opt;
+	atomisp_uptr_cache_trim(isp);
+
+	return size;
+}
+
+static const unsigned int cache_bench_kb[] = { 64, 256, 1024, 4096, 16384 };
+#define CACHE_BENCH_LOOPS	8
+
+static struct {
+	u64 range_ns;
+	u64 wbinvd_ns;
+} cache_bench[ARRAY_SIZE(cache_bench_kb)];
+
+/*
+ * Dirty a cached private buffer and time writing it back, by its pages
+ * and with wbinvd. Zeroes are left for sizes that can't be allocated.
+ */
+static void iunit_cache_bench(void)
+{
+	unsigned int i, j;
+
+	for (i = 0; i < ARRAY_SIZE(cache_bench_kb); i++) {
+		size_t bytes = cache_bench_kb[i] * 1024;
+		ia_css_ptr ptr;
+		void *vaddr;
+		ktime_t start;
+
+		cache_bench[i].range_ns = 0;
+		cache_bench[i].wbinvd_ns = 0;
+
+		ptr = hmm_alloc(bytes, HMM_BO_PRIVATE, 0, NULL, true);
+		if (!ptr)
+			continue;
+		vaddr = hmm_vmap(ptr, true);
+		if (!vaddr) {
+			hmm_free(ptr);
+			continue;
+		}
+
+		for (j = 0; j < CACHE_BENCH_LOOPS; j++) {
+			memset(vaddr, j, bytes);
+			start = ktime_get();
+			hmm_flush_cache(ptr);
+			cache_bench[i].range_ns +=
+				ktime_to_ns(ktime_sub(ktime_get(), start));
+
+			memset(vaddr, j, bytes);
+			start = ktime_get();
+			wbinvd();
+			cache_bench[i].wbinvd_ns +=
+				ktime_to_ns(ktime_sub(ktime_get(), start));
+		}
+		do_div(cache_bench[i].range_ns, CACHE_BENCH_LOOPS);
+		do_div(cache_bench[i].wbinvd_ns, CACHE_BENCH_LOOPS);
+
+		hmm_vunmap(ptr);
+		hmm_free(ptr);
+	}
+}
+
+static ssize_t iunit_cache_flush_show(struct device_driver *drv, char *buf)
+{
+	struct atomisp_device *isp = iunit_debug.isp;
+	ssize_t len;
+	unsigned int i;
+
+	len = scnprintf(buf, PAGE_SIZE, "%s\n",
+			isp->flush_wbinvd ? "wbinvd" : "range");
+	for (i = 0; i < ARRAY_SIZE(cache_bench_kb); i++)
+		len += scnprintf(buf + len, PAGE_SIZE - len,
+				 "%6u KB: range %llu ns wbinvd %llu ns\n",
+				 cache_bench_kb[i], cache_bench[i].range_ns,
+				 cache_bench[i].wbinvd_ns);
+
+	return len;
+}
+
+static ssize_t iunit_cache_flush_store(struct device_driver *drv,
+				       const char *buf, size_t size)
+{
+	struct atomisp_device *isp = iunit_debug.isp;
+	unsigned int opt;
+
+	if (kstrtouint(buf, 10, &opt) || opt > 2) {
+		dev_err(atomisp_dev, "%s setting %d value invalid\n",
+			__func__, opt);
+		return -EINVAL;
+	}
+
+	if (opt < 2) {
+		isp->flush_wbinvd = opt;
+		return size;
+	}
+
+	rt_mutex_lock(&isp->mutex);
+	if (atomisp_streaming_count(isp)) {
+		rt_mutex_unlock(&isp->mutex);
+		return -EBUSY;
+	}
+	iunit_cache_bench();
+	rt_mutex_unlock(&isp->mutex);
+
+	return size;
+}
+
+static ssize_t iunit_open_linger_show(struct device_driver *drv, char *buf)
+{
+	struct atomisp_device *isp = iunit_debug.isp;
+
+	return sprintf(buf, "linger %u ms\n"
+		       "cold: %u opens avg %llu us max %u us\n"
+		       "warm: %u opens avg %llu us max %u us\n",
+		       isp->open_linger_ms,
+		       isp->open_stats.cold,
+		       isp->open_stats.cold ?
+		       div_u64(isp->open_stats.cold_us, isp->open_stats.cold) : 0,
+		       isp->open_stats.cold_max_us,
+		       isp->open_stats.warm,
+		       isp->open_stats.warm ?
+		       div_u64(isp->open_stats.warm_us, isp->open_stats.warm) : 0,
+		       isp->open_stats.warm_max_us);
+}
+
+static ssize_t iunit_open_linger_store(struct device_driver *drv,
+				       const char *buf, size_t size)
+{
+	struct atomisp_device *isp = iunit_debug.isp;
+	unsigned int opt;
+
+	if (kstrtouint(buf, 10, &opt)) {
+		dev_err(atomisp_dev, "%s setting %d value invalid\n",
+			__func__, opt);
+		return -EINVAL;
+	}
+
+	isp->open_linger_ms = opt;
+	/* a lingering device follows the new setting right away */
+	if (!opt)
+		atomisp_linger_cancel(isp);
+
+	return size;
+}
+
+static ssize_t iunit_fw_load_show(struct device_driver *drv, char *buf)
+{
+	struct atomisp_device *isp = iunit_debug.isp;
+
+	return sprintf(buf, "cold: %u loads avg %llu us\n"
+		       "indexed: %u loads avg %llu us\n",
+		       isp->fw_load_stats.cold,
+		       isp->fw_load_stats.cold ?
+		       div_u64(isp->fw_load_stats.cold_us,
+			       isp->fw_load_stats.cold) : 0,
+		       isp->fw_load_stats.indexed,
+		       isp->fw_load_stats.indexed ?
+		       div_u64(isp->fw_load_stats.indexed_us,
+			       isp->fw_load_stats.indexed) : 0);
+}
+
+static ssize_t iunit_pc_prof_show(struct device_driver *drv, char *buf)
+{
+	struct atomisp_pcprof *prof = &iunit_debug.isp->pcprof;
+	unsigned int busy = prof->samples - prof->idle;
+	ssize_t len;
+	unsigned int i, j;
+
+	len = scnprintf(buf, PAGE_SIZE,
+			"%u Hz, %u samples, %u idle, %u dropped\n",
+			prof->rate_hz, prof->samples, prof->idle,
+			prof->dropped);
+
+	for (i = 0; i < ATOMISP_PCPROF_BINARIES; i++) {
+		struct atomisp_pcprof_binary *bin = &prof->bin[i];
+
+		if (!bin->samples)
+			break;
+
+		len += scnprintf(buf + len, PAGE_SIZE - len,
+				 "%3u %-24s %3u%% busy %3u%% stall %llu Mcycles\n",
+				 bin->id, bin->name,
+				 busy ? bin->samples * 100 / busy : 0,
+				 bin->stalls * 100 / bin->samples,
+				 div_u64(bin->cycles, 1000000));
+		for (j = 0; j < ATOMISP_PCPROF_BUCKETS; j++)
+			len += scnprintf(buf + len, PAGE_SIZE - len, " %u",
+					 bin->hist[j]);
+		len += scnprintf(buf + len, PAGE_SIZE - len, "\n");
+	}
+
+	return len;
+}
+
+static ssize_t iunit_pc_prof_store(struct device_driver *drv,
+				   const char *buf, size_t size)
+{
+	struct atomisp_device *isp = iunit_debug.isp;
+	unsigned int opt;
+
+	if (kstrtouint(buf, 10, &opt) || opt > ATOMISP_PCPROF_MAX_HZ) {
+		dev_err(atomisp_dev, "%s setting %d value invalid\n",
+			__func__, opt);
+		return -EINVAL;
+	}
+
+	rt_mutex_lock(&isp->mutex);
+	atomisp_pcprof_set_rate(isp, opt);
+	rt_mutex_unlock(&isp->mutex);
+
+	return size;
+}
+
+static ssize_t iunit_hmm_vmap_show(struct device_driver *drv, char *buf)
+{
+	return sprintf(buf, "%u/%u pages, %u maps, %u evictions\n"
+		       "%llu deferred, %llu handoffs, %llu bytes flushed\n",
+		       hmm_vmap_stat.pages, hmm_vmap_stat.max_pages,
+		       hmm_vmap_stat.maps, hmm_vmap_stat.evictions,
+		       hmm_vmap_stat.deferred, hmm_vmap_stat.handoffs,
+		       hmm_vmap_stat.flushed);
+}
+
+static ssize_t iunit_hmm_vmap_store(struct device_driver *drv,
+				    const char *buf, size_t size)
+{
+	unsigned int opt;
+
+	if (kstrtouint(buf, 10, &opt)) {
+		dev_err(atomisp_dev, "%s setting %d value invalid\n",
+			__func__, opt);
+		return -EINVAL;
+	}
+
+	hmm_vmap_cache_set_budget(opt);
+
+	return size;
+}
+
 static struct driver_attribute iunit_drvfs_attrs[] = {
 	__ATTR(dbglvl, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH, iunit_dbglvl_show,
 		iunit_dbglvl_store),
@@ -175,6 +609,27 @@ static struct driver_attribute iunit_drvfs_attrs[] = {
 		iunit_dbgfun_store),
 	__ATTR(dbgopt, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH, iunit_dbgopt_show,
 		iunit_dbgopt_store),
+	__ATTR(probe_time, S_IRUSR|S_IRGRP|S_IROTH, iunit_probe_time_show,
+		NULL),
+	__ATTR(trace_ring, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH,
+		iunit_trace_ring_show, iunit_trace_ring_store),
+	__ATTR(param_prof, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH,
+		iunit_param_prof_show, iunit_param_prof_store),
+	__ATTR(dfs_gov, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH,
+		iunit_dfs_gov_show, iunit_dfs_gov_store),
+	__ATTR(wdt_recovery, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH,
+		iunit_wdt_recovery_show, iunit_wdt_recovery_store),
+	__ATTR(uptr_cache, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH,
+		iunit_uptr_cache_show, iunit_uptr_cache_store),
+	__ATTR(cache_flush, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH,
+		iunit_cache_flush_show, iunit_cache_flush_store),
+	__ATTR(open_linger, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH,
+		iunit_open_linger_show, iunit_open_linger_store),
+	__ATTR(fw_load, S_IRUSR|S_IRGRP|S_IROTH, iunit_fw_load_show, NULL),
+	__ATTR(pc_prof, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH,
+		iunit_pc_prof_show, iunit_pc_prof_store),
+	__ATTR(hmm_vmap, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH,
+		iunit_hmm_vmap_show, iunit_hmm_vmap_store),
 };
 
 static int iunit_drvfs_create_files(struct pci_driver *drv)
@@ -21,6 +21,7 @@
  *
  */
 
+#include <linux/anon_inodes.h>
 #include <linux/module.h>
 #include <linux/pm_runtime.h>
 
@@ -45,6 +46,7 @@
 #include "memory_access/memory_access.h"
 
 #include "atomisp_acc.h"
+#include "atomisp_uptr_cache.h"
 
 #define ISP_LEFT_PAD			128	/* equal to 2*NWAY */
 
@@ -145,6 +147,9 @@ int atomisp_q_video_buffers_to_css(struct atomisp_sub_device *asd,
 					__func__, err);
 			return -EINVAL;
 		}
+		/* the stall clock of an idle stream starts now */
+		if (!atomisp_buffers_queued(asd))
+			asd->wdt_progress = jiffies;
 		pipe->buffers_in_css++;
 	}
 	return 0;
@@ -593,8 +598,10 @@ static void atomisp_buf_queue(struct videobuf_queue *vq,
 static void atomisp_buf_release(struct videobuf_queue *vq,
 				struct videobuf_buffer *vb)
 {
+	struct atomisp_video_pipe *pipe = vq->priv_data;
+
 	vb->state = VIDEOBUF_NEEDS_INIT;
-	atomisp_videobuf_free_buf(vb);
+	atomisp_videobuf_free_buf(pipe->isp, vb);
 }
 
 static int atomisp_buf_setup_output(struct videobuf_queue *vq,
@@ -755,12 +762,92 @@ unsigned int atomisp_dev_users(struct atomisp_device *isp)
 	return sum;
 }
 
+/*
+ * Undo the power up and CSS init done by the first open. Called with
+ * isp->mutex held, once the last user is gone.
+ */
+static void __atomisp_power_off(struct atomisp_device *isp)
+{
+	atomisp_css_uninit(isp);
+
+	if (defer_fw_load) {
+		atomisp_css_unload_firmware_blobs(isp);
+		isp->css_env.isp_css_fw.data = NULL;
+		isp->css_env.isp_css_fw.bytes = 0;
+	}
+
+	hmm_cleanup_mmu_l2();
+	hmm_pool_unregister(HMM_POOL_TYPE_DYNAMIC);
+
+	if (pm_runtime_put_sync(isp->dev) < 0)
+		dev_err(isp->dev, "Failed to power off device\n");
+}
+
+void atomisp_linger_work(struct work_struct *work)
+{
+	struct atomisp_device *isp = container_of(work, struct atomisp_device,
+						  linger_work.work);
+
+	rt_mutex_lock(&isp->mutex);
+	/* a reopen may have raced with us for the mutex */
+	if (isp->css_lingering && !atomisp_dev_users(isp)) {
+		isp->css_lingering = false;
+		__atomisp_power_off(isp);
+	}
+	rt_mutex_unlock(&isp->mutex);
+}
+
+void atomisp_linger_cancel(struct atomisp_device *isp)
+{
+	cancel_delayed_work_sync(&isp->linger_work);
+
+	rt_mutex_lock(&isp->mutex);
+	if (isp->css_lingering) {
+		isp->css_lingering = false;
+		__atomisp_power_off(isp);
+	}
+	rt_mutex_unlock(&isp->mutex);
+}
+
+static void atomisp_fw_load_stat(struct atomisp_device *isp, ktime_t start)
+{
+	unsigned int us = ktime_us_delta(ktime_get(), start);
+
+	if (atomisp_css_firmware_indexed(isp)) {
+		isp->fw_load_stats.indexed++;
+		isp->fw_load_stats.indexed_us += us;
+	} else {
+		isp->fw_load_stats.cold++;
+		isp->fw_load_stats.cold_us += us;
+	}
+}
+
+static void atomisp_open_stat(struct atomisp_device *isp, bool warm,
+			      ktime_t start)
+{
+	unsigned int us = ktime_us_delta(ktime_get(), start);
+
+	if (warm) {
+		isp->open_stats.warm++;
+		isp->open_stats.warm_us += us;
+		isp->open_stats.warm_max_us =
+			max(isp->open_stats.warm_max_us, us);
+	} else {
+		isp->open_stats.cold++;
+		isp->open_stats.cold_us += us;
+		isp->open_stats.cold_max_us =
+			max(isp->open_stats.cold_max_us, us);
+	}
+}
+
 static int atomisp_open(struct file *file)
 {
 	struct video_device *vdev = video_devdata(file);
 	struct atomisp_device *isp = video_get_drvdata(vdev);
 	struct atomisp_video_pipe *pipe = atomisp_to_video_pipe(vdev);
 	struct atomisp_sub_device *asd = pipe->asd;
+	ktime_t start = ktime_get();
+	bool first, warm = false;
 	int ret;
 
 	dev_dbg(isp->dev, "open device %s\n", vdev->name);
@@ -780,6 +867,7 @@ static int atomisp_open(struct file *file)
 			dev_err(isp->dev, "Failed to init css.\n");
 			goto error;
 		}
+		atomisp_fw_load_stat(isp, start);
 		/* No need to keep FW in memory anymore. */
 		release_firmware(isp->firmware);
 		isp->firmware = NULL;
@@ -806,11 +894,22 @@ static int atomisp_open(struct file *file)
 		goto error;
 
 
-	if (atomisp_dev_users(isp)) {
+	first = !atomisp_dev_users(isp);
+	if (!first) {
 		dev_dbg(isp->dev, "skip init isp in open\n");
 		goto init_subdev;
 	}
 
+	/* still powered up and initialized since the last close */
+	if (isp->css_lingering) {
+		dev_dbg(isp->dev, "warm open, skip init isp\n");
+		isp->css_lingering = false;
+		/* if already running, the work sees css_lingering cleared */
+		cancel_delayed_work(&isp->linger_work);
+		warm = true;
+		goto init_struct;
+	}
+
 	/* runtime power management, turn on ISP */
 	ret = pm_runtime_get_sync(vdev->v4l2_dev->dev);
 	if (ret < 0) {
@@ -831,6 +930,7 @@ static int atomisp_open(struct file *file)
 		goto css_error;
 	}
 
+init_struct:
 	atomisp_dev_init_struct(isp);
 
 	ret = v4l2_subdev_call(isp->flash, core, s_power, 1);
@@ -847,12 +947,19 @@ init_subdev:
 
 done:
 	pipe->users++;
+	if (first)
+		atomisp_open_stat(isp, warm, start);
 	rt_mutex_unlock(&isp->mutex);
 	return 0;
 
 css_error:
 	atomisp_css_uninit(isp);
 error:
+	/* the power up still belongs to the linger period */
+	if (isp->css_lingering) {
+		rt_mutex_unlock(&isp->mutex);
+		return ret;
+	}
 	hmm_pool_unregister(HMM_POOL_TYPE_DYNAMIC);
 	pm_runtime_put(vdev->v4l2_dev->dev);
 	rt_mutex_unlock(&isp->mutex);
@@ -936,6 +1043,7 @@ static int atomisp_release(struct file *file)
 	}
 
 	atomisp_css_free_stat_buffers(asd);
+	atomisp_free_frame_meta_ring(asd);
 	atomisp_free_internal_buffers(asd);
 	ret = v4l2_subdev_call(isp->inputs[asd->input_curr].camera,
 				       core, s_power, 0);
@@ -949,25 +1057,22 @@ static int atomisp_release(struct file *file)
 	if (atomisp_dev_users(isp))
 		goto done;
 
+	atomisp_uptr_cache_release(isp);
 	atomisp_acc_release(isp);
 	atomisp_destroy_pipes_stream_force(asd);
-	atomisp_css_uninit(isp);
-
-	if (defer_fw_load) {
-		atomisp_css_unload_firmware(isp);
-		isp->css_env.isp_css_fw.data = NULL;
-		isp->css_env.isp_css_fw.bytes = 0;
-	}
-
-	hmm_cleanup_mmu_l2();
-	hmm_pool_unregister(HMM_POOL_TYPE_DYNAMIC);
 
 	ret = v4l2_subdev_call(isp->flash, core, s_power, 0);
 	if (ret < 0 && ret != -ENODEV && ret != -ENOIOCTLCMD)
 		dev_warn(isp->dev, "Failed to power-off flash\n");
 
-	if (pm_runtime_put_sync(vdev->v4l2_dev->dev) < 0)
-		dev_err(isp->dev, "Failed to power off device\n");
+	if (isp->open_linger_ms) {
+		isp->css_lingering = true;
+		schedule_delayed_work(&isp->linger_work,
+				      msecs_to_jiffies(isp->open_linger_ms));
+		goto done;
+	}
+
+	__atomisp_power_off(isp);
 
 done:
 	rt_mutex_unlock(&isp->mutex);
@@ -1144,6 +1249,30 @@ static int atomisp_mmap(struct file *file, struct vm_area_struct *vma)
 		return ret;
 	}
 
+	/* mmap for the DIS statistics ring */
+	if (vma->vm_pgoff ==
+	    (ATOMISP_DIS_STAT_RING_MMAP_OFFSET >> PAGE_SHIFT)) {
+		ret = atomisp_css_mmap_dis_stat_ring(asd, vma);
+		rt_mutex_unlock(&isp->mutex);
+		return ret;
+	}
+
+	/* mmap for the per-frame metadata ring */
+	if (vma->vm_pgoff ==
+	    (ATOMISP_FRAME_META_RING_MMAP_OFFSET >> PAGE_SHIFT)) {
+		ret = atomisp_mmap_frame_meta_ring(asd, vma);
+		rt_mutex_unlock(&isp->mutex);
+		return ret;
+	}
+
+	/* mmap for the DVS 6-axis config pool */
+	if (vma->vm_pgoff ==
+	    (ATOMISP_DVS_6AXIS_POOL_MMAP_OFFSET >> PAGE_SHIFT)) {
+		ret = atomisp_css_mmap_dvs_6axis_pool(asd, vma);
+		rt_mutex_unlock(&isp->mutex);
+		return ret;
+	}
+
 	/* mmap for ISP offline raw data */
 	if (atomisp_subdev_source_pad(vdev)
 	    == ATOMISP_SUBDEV_PAD_SOURCE_CAPTURE &&
@@ -1235,6 +1364,168 @@ static unsigned int atomisp_poll(struct file *file,
 	return videobuf_poll_stream(file, &pipe->capq, pt);
 }
 
+/*
+ * Completion channel: a read/poll-able file descriptor carrying one record
+ * per completed buffer of a sub-device, fed from atomisp_buf_done().
+ */
+void atomisp_completion_post(struct atomisp_sub_device *asd,
+			     unsigned int type, unsigned int pad,
+			     unsigned int index, unsigned int exp_id,
+			     unsigned int status)
+{
+	struct atomisp_completion_chan *chan = &asd->completion;
+	struct atomisp_completion_event *ev;
+	unsigned long flags;
+
+	spin_lock_irqsave(&chan->lock, flags);
+	if (!chan->open) {
+		spin_unlock_irqrestore(&chan->lock, flags);
+		return;
+	}
+
+	/* keep the oldest records, the reader learns about the gap */
+	if (chan->head - chan->tail == ATOMISP_COMPLETION_SLOTS) {
+		chan->lost++;
+		spin_unlock_irqrestore(&chan->lock, flags);
+		return;
+	}
+
+	ev = &chan->ev[chan->head % ATOMISP_COMPLETION_SLOTS];
+	ev->type = type;
+	ev->pad = pad;
+	ev->index = index;
+	ev->exp_id = exp_id;
+	ev->status = status;
+	ev->lost = chan->lost;
+	chan->lost = 0;
+	chan->head++;
+	spin_unlock_irqrestore(&chan->lock, flags);
+
+	wake_up_interruptible(&chan->wait);
+}
+
+static bool atomisp_completion_pending(struct atomisp_completion_chan *chan)
+{
+	unsigned long flags;
+	bool pending;
+
+	spin_lock_irqsave(&chan->lock, flags);
+	pending = chan->head != chan->tail;
+	spin_unlock_irqrestore(&chan->lock, flags);
+
+	return pending;
+}
+
+static ssize_t atomisp_completion_read(struct file *file, char __user *buf,
+				       size_t count, loff_t *ppos)
+{
+	struct atomisp_sub_device *asd = file->private_data;
+	struct atomisp_completion_chan *chan = &asd->completion;
+	struct atomisp_completion_event ev;
+	unsigned long flags;
+	size_t done = 0;
+	int ret;
+
+	if (count < sizeof(ev))
+		return -EINVAL;
+
+	if (!(file->f_flags & O_NONBLOCK)) {
+		ret = wait_event_interruptible(chan->wait,
+				atomisp_completion_pending(chan));
+		if (ret)
+			return ret;
+	}
+
+	while (done + sizeof(ev) <= count) {
+		spin_lock_irqsave(&chan->lock, flags);
+		if (chan->head == chan->tail) {
+			spin_unlock_irqrestore(&chan->lock, flags);
+			break;
+		}
+		ev = chan->ev[chan->tail % ATOMISP_COMPLETION_SLOTS];
+		chan->tail++;
+		spin_unlock_irqrestore(&chan->lock, flags);
+
+		if (copy_to_user(buf + done, &ev, sizeof(ev)))
+			return done ? done : -EFAULT;
+		done += sizeof(ev);
+	}
+
+	return done ? done : -EAGAIN;
+}
+
+static unsigned int atomisp_completion_poll(struct file *file,
+					    struct poll_table_struct *pt)
+{
+	struct atomisp_sub_device *asd = file->private_data;
+
+	poll_wait(file, &asd->completion.wait, pt);
+
+	return atomisp_completion_pending(&asd->completion) ?
+	       POLLIN | POLLRDNORM : 0;
+}
+
+static int atomisp_completion_release(struct inode *inode, struct file *file)
+{
+	struct atomisp_sub_device *asd = file->private_data;
+	struct atomisp_completion_event *ev;
+	unsigned long flags;
+
+	spin_lock_irqsave(&asd->completion.lock, flags);
+	asd->completion.open = false;
+	ev = asd->completion.ev;
+	asd->completion.ev = NULL;
+	spin_unlock_irqrestore(&asd->completion.lock, flags);
+
+	kfree(ev);
+	return 0;
+}
+
+static const struct file_operations atomisp_completion_fops = {
+	.owner = THIS_MODULE,
+	.read = atomisp_completion_read,
+	.poll = atomisp_completion_poll,
+	.release = atomisp_completion_release,
+	.llseek = noop_llseek,
+};
+
+int atomisp_completion_get_fd(struct atomisp_sub_device *asd, int *fd)
+{
+	struct atomisp_completion_chan *chan = &asd->completion;
+	struct atomisp_completion_event *ev;
+	unsigned long flags;
+	int ret;
+
+	ev = kcalloc(ATOMISP_COMPLETION_SLOTS, sizeof(*ev), GFP_KERNEL);
+	if (!ev)
+		return -ENOMEM;
+
+	spin_lock_irqsave(&chan->lock, flags);
+	if (chan->open) {
+		spin_unlock_irqrestore(&chan->lock, flags);
+		kfree(ev);
+		return -EBUSY;
+	}
+	chan->open = true;
+	chan->ev = ev;
+	chan->head = chan->tail = chan->lost = 0;
+	spin_unlock_irqrestore(&chan->lock, flags);
+
+	ret = anon_inode_getfd("atomisp-completion", &atomisp_completion_fops,
+			       asd, O_RDONLY | O_CLOEXEC);
+	if (ret < 0) {
+		spin_lock_irqsave(&chan->lock, flags);
+		chan->open = false;
+		chan->ev = NULL;
+		spin_unlock_irqrestore(&chan->lock, flags);
+		kfree(ev);
+		return ret;
+	}
+
+	*fd = ret;
+	return 0;
+}
+
 const struct v4l2_file_operations atomisp_fops = {
 	.owner = THIS_MODULE,
 	.open = atomisp_open,
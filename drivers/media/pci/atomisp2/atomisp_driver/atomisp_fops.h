@@ -55,6 +55,22 @@ int atomisp_qbuf_to_css(struct atomisp_device *isp,
 
 int atomisp_qbuffers_to_css(struct atomisp_sub_device *asd);
 
+/*
+ * Completion channel
+ */
+
+int atomisp_completion_get_fd(struct atomisp_sub_device *asd, int *fd);
+
+void atomisp_completion_post(struct atomisp_sub_device *asd,
+			     unsigned int type, unsigned int pad,
+			     unsigned int index, unsigned int exp_id,
+			     unsigned int status);
+
+void atomisp_linger_work(struct work_struct *work);
+
+/* Power down now if the device was left on after the last close */
+void atomisp_linger_cancel(struct atomisp_device *isp);
+
 extern const struct v4l2_file_operations atomisp_fops;
 
 extern bool defer_fw_load;
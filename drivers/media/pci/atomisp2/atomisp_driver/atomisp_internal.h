@@ -25,6 +25,8 @@
 
 #include <linux/atomisp_platform.h>
 #include <linux/firmware.h>
+#include <linux/hrtimer.h>
+#include <linux/i2c.h>
 #include <linux/kernel.h>
 #include <linux/pm_qos.h>
 #include <linux/idr.h>
@@ -42,6 +44,7 @@
 #include "atomisp_subdev.h"
 #include "atomisp_tpg.h"
 #include "atomisp_compat.h"
+#include "atomisp_dfs_gov.h"
 
 #include "gp_device.h"
 #include "irq.h"
@@ -117,6 +120,8 @@
 #define ATOM_ISP_POWER_UP	1
 
 #define ATOM_ISP_MAX_INPUTS	4
+/* sensors, motor and flash probed from the platform subdev table */
+#define ATOMISP_MAX_SUBDEV_TIMINGS	8
 
 #define ATOMISP_SC_TYPE_SIZE	2
 
@@ -175,6 +180,17 @@
 #define DIV_NEAREST_STEP(n, d, step) \
 	round_down((2 * (n) + (d) * (step))/(2 * (d)), (step))
 
+/*
+ * Power-up/probe timeline of one platform subdev, relative to the start
+ * of atomisp_subdev_probe(). Exported through drvfs.
+ */
+struct atomisp_subdev_timing {
+	char name[I2C_NAME_SIZE];
+	s64 start_us;
+	s64 duration_us;
+	bool detected;
+};
+
 struct atomisp_input_subdev {
 	unsigned int type;
 	enum atomisp_camera_port port;
@@ -192,10 +208,34 @@ struct atomisp_input_subdev {
 	int sensor_index;
 };
 
-enum atomisp_dfs_mode {
-	ATOMISP_DFS_MODE_AUTO = 0,
-	ATOMISP_DFS_MODE_LOW,
-	ATOMISP_DFS_MODE_MAX,
+/*
+ * ISP pc profiler, see atomisp_pcprof.h. Samples are kept per firmware
+ * binary, with a coarse histogram over the ISP program memory.
+ */
+#define ATOMISP_PCPROF_BINARIES		32
+#define ATOMISP_PCPROF_BUCKETS		16
+#define ATOMISP_PCPROF_PMEM_DEPTH	2048	/* ISP_PMEM_DEPTH */
+#define ATOMISP_PCPROF_NAME_LEN		32
+#define ATOMISP_PCPROF_MAX_HZ		20000
+
+struct atomisp_pcprof_binary {
+	unsigned int id;
+	char name[ATOMISP_PCPROF_NAME_LEN];
+	unsigned int samples;
+	unsigned int stalls;
+	u64 cycles;			/* estimated, at the running freq */
+	unsigned int hist[ATOMISP_PCPROF_BUCKETS];
+};
+
+struct atomisp_pcprof {
+	unsigned int rate_hz;		/* 0: off */
+	bool running;
+	struct hrtimer timer;
+	ktime_t period;
+	unsigned int samples;
+	unsigned int idle;
+	unsigned int dropped;		/* binaries beyond the table */
+	struct atomisp_pcprof_binary bin[ATOMISP_PCPROF_BINARIES];
 };
 
 struct atomisp_regs {
@@ -261,6 +301,30 @@ struct atomisp_map {
 /*
  * ci device struct
  */
+/*
+ * Watchdog recovery tiers, tried in this order for a stream that stopped
+ * returning frames: requeue its buffers, restart only that stream, reset
+ * the whole ISP. See atomisp_wdt_work().
+ */
+enum atomisp_wdt_tier {
+	ATOMISP_WDT_TIER_NONE = 0,
+	ATOMISP_WDT_TIER_REQUEUE,
+	ATOMISP_WDT_TIER_RESTART,
+	ATOMISP_WDT_TIER_RESET,
+};
+#define ATOMISP_WDT_TIERS	ATOMISP_WDT_TIER_RESET
+
+struct atomisp_wdt_tier_stats {
+	unsigned int tried;
+	unsigned int ok;		/* a frame came back afterwards */
+	unsigned int failed;		/* escalated to the next tier */
+	u64 latency_us;			/* summed over the ok ones */
+	unsigned int max_latency_us;
+};
+
+/* pinned page budget for idle USERPTR mappings, 64MB */
+#define ATOMISP_UPTR_CACHE_PAGES	16384
+
 struct atomisp_device {
 	struct pci_dev *pdev;
 	struct device *dev;
@@ -284,6 +348,22 @@ struct atomisp_device {
 		void *acc_stages;
 	} acc;
 
+	/* see atomisp_uptr_cache.h */
+	struct {
+		struct mutex lock;
+		struct list_head entries;	/* all cached mappings */
+		struct list_head lru;		/* idle ones, oldest first */
+		struct list_head dead;		/* invalidated, to be freed */
+		struct list_head mms;		/* watched address spaces */
+		unsigned int idle_pages;
+		unsigned int max_pages;		/* budget for idle_pages */
+		unsigned int inval_seq;
+		unsigned int hits;
+		unsigned int misses;
+		unsigned int evictions;
+		unsigned int invalidations;
+	} uptr_cache;
+
 
 	/*
 	 * ISP modules
@@ -316,6 +396,9 @@ struct atomisp_device {
 	struct v4l2_subdev *flash;
 	struct v4l2_subdev *motor;
 
+	unsigned int subdev_timing_cnt;
+	struct atomisp_subdev_timing subdev_timing[ATOMISP_MAX_SUBDEV_TIMINGS];
+
 	struct atomisp_regs saved_regs;
 	struct atomisp_sw_contex sw_contex;
 	struct atomisp_css_env css_env;
@@ -329,6 +412,8 @@ struct atomisp_device {
 	atomic_t wdt_count;
 	unsigned int wdt_duration;	/* in jiffies */
 	unsigned long wdt_expires;
+	struct atomisp_wdt_tier_stats wdt_tier_stats[ATOMISP_WDT_TIERS];
+	unsigned int wdt_inject;	/* timeouts to fake, from drvfs */
 
 	spinlock_t lock; /* Just for streaming below */
 
@@ -336,8 +421,37 @@ struct atomisp_device {
 
 	unsigned int mipi_frame_size;
 	const struct atomisp_dfs_config *dfs;
+	struct atomisp_dfs_gov dfs_gov;
+	struct atomisp_pcprof pcprof;
 
 	bool css_initialized;
+
+	/* flush whole CPU caches instead of buffer pages, from drvfs */
+	bool flush_wbinvd;
+
+	/*
+	 * After the last close, CSS, firmware, dynamic pool and power are
+	 * kept for open_linger_ms so that a quick reopen is cheap.
+	 */
+	unsigned int open_linger_ms;
+	bool css_lingering;
+	struct delayed_work linger_work;
+	struct {
+		unsigned int cold;
+		unsigned int warm;
+		u64 cold_us;
+		u64 warm_us;
+		unsigned int cold_max_us;
+		unsigned int warm_max_us;
+	} open_stats;		/* first opens only */
+
+	/* deferred firmware loads, see ia_css_unload_firmware_blobs() */
+	struct {
+		unsigned int cold;
+		unsigned int indexed;
+		u64 cold_us;
+		u64 indexed_us;
+	} fw_load_stats;
 };
 
 #define v4l2_dev_to_atomisp_device(dev) \
@@ -39,6 +39,8 @@
 #include "atomisp_ioctl.h"
 #include "atomisp-regs.h"
 #include "atomisp_compat.h"
+#include "atomisp_pcprof.h"
+#include "atomisp_uptr_cache.h"
 
 #include "sh_css_hrt.h"
 
@@ -945,7 +947,8 @@ static int atomisp_enum_frameintervals(struct file *file, void *fh,
 /*
  * Free videobuffer buffer priv data
  */
-void atomisp_videobuf_free_buf(struct videobuf_buffer *vb)
+void atomisp_videobuf_free_buf(struct atomisp_device *isp,
+			       struct videobuf_buffer *vb)
 {
 	struct videobuf_vmalloc_memory *vm_mem;
 
@@ -954,7 +957,7 @@ void atomisp_videobuf_free_buf(struct videobuf_buffer *vb)
 
 	vm_mem = vb->priv;
 	if (vm_mem && vm_mem->vaddr) {
-		atomisp_css_frame_free(vm_mem->vaddr);
+		atomisp_uptr_cache_put(isp, vm_mem->vaddr);
 		vm_mem->vaddr = NULL;
 	}
 }
@@ -964,10 +967,11 @@ void atomisp_videobuf_free_buf(struct videobuf_buffer *vb)
  */
 static void atomisp_videobuf_free_queue(struct videobuf_queue *q)
 {
+	struct atomisp_video_pipe *pipe = q->priv_data;
 	int i;
 
 	for (i = 0; i < VIDEO_MAX_FRAME; i++) {
-		atomisp_videobuf_free_buf(q->bufs[i]);
+		atomisp_videobuf_free_buf(pipe->isp, q->bufs[i]);
 		kfree(q->bufs[i]);
 		q->bufs[i] = NULL;
 	}
@@ -1201,16 +1205,16 @@ static int atomisp_querybuf_file(struct file *file, void *fh,
 }
 
 /*
- * Applications call the VIDIOC_QBUF ioctl to enqueue an empty (capturing) or
- * filled (output) buffer in the drivers incoming queue.
+ * Validate a capture buffer and map its user pages before it is handed to
+ * videobuf. Called with isp->mutex held.
  */
-static int atomisp_qbuf(struct file *file, void *fh, struct v4l2_buffer *buf)
+static int __atomisp_qbuf_prepare(struct atomisp_video_pipe *pipe,
+				  struct v4l2_buffer *buf)
 {
 	static const int NOFLUSH_FLAGS = V4L2_BUF_FLAG_NO_CACHE_INVALIDATE |
 					 V4L2_BUF_FLAG_NO_CACHE_CLEAN;
-	struct video_device *vdev = video_devdata(file);
-	struct atomisp_device *isp = video_get_drvdata(vdev);
-	struct atomisp_video_pipe *pipe = atomisp_to_video_pipe(vdev);
+	struct video_device *vdev = &pipe->vdev;
+	struct atomisp_device *isp = pipe->isp;
 	struct atomisp_sub_device *asd = pipe->asd;
 	struct videobuf_buffer *vb;
 	struct videobuf_vmalloc_memory *vm_mem;
@@ -1220,24 +1224,19 @@ static int atomisp_qbuf(struct file *file, void *fh, struct v4l2_buffer *buf)
 	u32 pgnr;
 	int ret = 0;
 
-	rt_mutex_lock(&isp->mutex);
-	if (isp->isp_fatal_error) {
-		ret = -EIO;
-		goto error;
-	}
+	if (isp->isp_fatal_error)
+		return -EIO;
 
 	if (asd->streaming == ATOMISP_DEVICE_STREAMING_STOPPING) {
 		dev_err(isp->dev, "%s: reject, as ISP at stopping.\n",
 				__func__);
-		ret = -EIO;
-		goto error;
+		return -EIO;
 	}
 
 	if (!buf || buf->index >= VIDEO_MAX_FRAME ||
 		!pipe->capq.bufs[buf->index]) {
 		dev_err(isp->dev, "Invalid index for qbuf.\n");
-		ret = -EINVAL;
-		goto error;
+		return -EINVAL;
 	}
 
 	/*
@@ -1248,22 +1247,19 @@ static int atomisp_qbuf(struct file *file, void *fh, struct v4l2_buffer *buf)
 		struct hrt_userbuffer_attr attributes;
 		vb = pipe->capq.bufs[buf->index];
 		vm_mem = vb->priv;
-		if (!vm_mem) {
-			ret = -EINVAL;
-			goto error;
-		}
+		if (!vm_mem)
+			return -EINVAL;
 
 		length = vb->bsize;
 		pgnr = (length + (PAGE_SIZE - 1)) >> PAGE_SHIFT;
 
-		if (vb->baddr == buf->m.userptr && vm_mem->vaddr)
+		if (vb->baddr == buf->m.userptr && vm_mem->vaddr &&
+		    atomisp_uptr_cache_valid(isp, vm_mem->vaddr))
 			goto done;
 
 		if (atomisp_get_css_frame_info(asd,
-				atomisp_subdev_source_pad(vdev), &frame_info)) {
-			ret = -EIO;
-			goto error;
-		}
+				atomisp_subdev_source_pad(vdev), &frame_info))
+			return -EIO;
 
 		attributes.pgnr = pgnr;
 #ifdef CONFIG_ION
@@ -1272,17 +1268,16 @@ static int atomisp_qbuf(struct file *file, void *fh, struct v4l2_buffer *buf)
 #else
 		attributes.type = HRT_USR_PTR;
 #endif
-		ret = atomisp_css_frame_map(&handle, &frame_info,
-				       (void *)buf->m.userptr,
-				       0, &attributes);
+		ret = atomisp_uptr_cache_map(isp, &handle, &frame_info,
+					     buf->m.userptr, &attributes);
 		if (ret) {
 			dev_err(isp->dev, "Failed to map user buffer\n");
-			goto error;
+			return ret;
 		}
 
 		if (vm_mem->vaddr) {
 			mutex_lock(&pipe->capq.vb_lock);
-			atomisp_css_frame_free(vm_mem->vaddr);
+			atomisp_uptr_cache_put(isp, vm_mem->vaddr);
 			vm_mem->vaddr = NULL;
 			vb->state = VIDEOBUF_NEEDS_INIT;
 			mutex_unlock(&pipe->capq.vb_lock);
@@ -1300,8 +1295,13 @@ static int atomisp_qbuf(struct file *file, void *fh, struct v4l2_buffer *buf)
 	}
 
 done:
-	if (!((buf->flags & NOFLUSH_FLAGS) == NOFLUSH_FLAGS))
-		wbinvd();
+	if (!((buf->flags & NOFLUSH_FLAGS) == NOFLUSH_FLAGS)) {
+		vm_mem = pipe->capq.bufs[buf->index]->priv;
+		if (isp->flush_wbinvd || !vm_mem || !vm_mem->vaddr)
+			wbinvd();
+		else
+			atomisp_css_frame_flush(vm_mem->vaddr);
+	}
 
 	if (!atomisp_is_vf_pipe(pipe) &&
 	    (buf->reserved2 & ATOMISP_BUFFER_HAS_PER_FRAME_SETTING))
@@ -1313,23 +1313,26 @@ done:
 
 	pipe->frame_params[buf->index] = NULL;
 
-	rt_mutex_unlock(&isp->mutex);
+	return 0;
+}
 
-	ret = videobuf_qbuf(&pipe->capq, buf);
-	rt_mutex_lock(&isp->mutex);
-	if (ret)
-		goto error;
+/*
+ * Bookkeeping after a buffer was queued to videobuf. Returns true if the
+ * caller needs to pass the queued buffers on to CSS, which is done once
+ * for all pipes by __atomisp_qbuf_to_css(). Called with isp->mutex held.
+ */
+static bool __atomisp_qbuf_queued(struct atomisp_video_pipe *pipe)
+{
+	struct atomisp_device *isp = pipe->isp;
+	struct atomisp_sub_device *asd = pipe->asd;
+	bool to_css = false;
 
 	/* TODO: do this better, not best way to queue to css */
 	if (asd->streaming == ATOMISP_DEVICE_STREAMING_ENABLED) {
-		if (!list_empty(&pipe->buffers_waiting_for_param)) {
+		if (!list_empty(&pipe->buffers_waiting_for_param))
 			atomisp_handle_parameter_and_buffer(pipe);
-		} else {
-			atomisp_qbuffers_to_css(asd);
-
-			if (!atomisp_is_wdt_running(isp) && atomisp_buffers_queued(asd))
-				atomisp_wdt_start(isp);
-		}
+		else
+			to_css = true;
 	}
 
 	/* Workaround: Due to the design of HALv3,
@@ -1341,7 +1344,7 @@ done:
 	 * CSS to do capture when new buffer is queued. */
 	if (asd->continuous_mode->val &&
 	    asd->run_mode->val == ATOMISP_RUN_MODE_PREVIEW &&
-	    atomisp_subdev_source_pad(vdev)
+	    atomisp_subdev_source_pad(&pipe->vdev)
 	    == ATOMISP_SUBDEV_PAD_SOURCE_CAPTURE &&
 	    pipe->capq.streaming &&
 	    !asd->enable_raw_buffer_lock->val &&
@@ -1349,15 +1352,50 @@ done:
 		asd->pending_capture_request++;
 		dev_dbg(isp->dev, "Add one pending capture request.\n");
 	}
-	rt_mutex_unlock(&isp->mutex);
 
-	dev_dbg(isp->dev, "qbuf buffer %d (%s)\n", buf->index, vdev->name);
+	return to_css;
+}
 
-	return ret;
+static void __atomisp_qbuf_to_css(struct atomisp_sub_device *asd)
+{
+	struct atomisp_device *isp = asd->isp;
 
-error:
+	atomisp_qbuffers_to_css(asd);
+
+	if (!atomisp_is_wdt_running(isp) && atomisp_buffers_queued(asd))
+		atomisp_wdt_start(isp);
+}
+
+/*
+ * Applications call the VIDIOC_QBUF ioctl to enqueue an empty (capturing) or
+ * filled (output) buffer in the drivers incoming queue.
+ */
+static int atomisp_qbuf(struct file *file, void *fh, struct v4l2_buffer *buf)
+{
+	struct video_device *vdev = video_devdata(file);
+	struct atomisp_device *isp = video_get_drvdata(vdev);
+	struct atomisp_video_pipe *pipe = atomisp_to_video_pipe(vdev);
+	struct atomisp_sub_device *asd = pipe->asd;
+	int ret;
+
+	rt_mutex_lock(&isp->mutex);
+	ret = __atomisp_qbuf_prepare(pipe, buf);
 	rt_mutex_unlock(&isp->mutex);
-	return ret;
+	if (ret)
+		return ret;
+
+	ret = videobuf_qbuf(&pipe->capq, buf);
+	if (ret)
+		return ret;
+
+	rt_mutex_lock(&isp->mutex);
+	if (__atomisp_qbuf_queued(pipe))
+		__atomisp_qbuf_to_css(asd);
+	rt_mutex_unlock(&isp->mutex);
+
+	dev_dbg(isp->dev, "qbuf buffer %d (%s)\n", buf->index, vdev->name);
+
+	return 0;
 }
 
 static int atomisp_qbuf_file(struct file *file, void *fh,
@@ -1418,40 +1456,32 @@ static int __get_frame_exp_id(struct atomisp_video_pipe *pipe,
 	return -EINVAL;
 }
 
-/*
- * Applications call the VIDIOC_DQBUF ioctl to dequeue a filled (capturing) or
- * displayed (output buffer)from the driver's outgoing queue
- */
-static int atomisp_dqbuf(struct file *file, void *fh, struct v4l2_buffer *buf)
+/* Called with isp->mutex held. */
+static int __atomisp_dqbuf_check(struct atomisp_sub_device *asd)
 {
-	struct video_device *vdev = video_devdata(file);
-	struct atomisp_video_pipe *pipe = atomisp_to_video_pipe(vdev);
-	struct atomisp_sub_device *asd = pipe->asd;
-	struct atomisp_device *isp = video_get_drvdata(vdev);
-	int ret = 0;
-
-	rt_mutex_lock(&isp->mutex);
+	struct atomisp_device *isp = asd->isp;
 
-	if (isp->isp_fatal_error) {
-		rt_mutex_unlock(&isp->mutex);
+	if (isp->isp_fatal_error)
 		return -EIO;
-	}
 
 	if (asd->streaming == ATOMISP_DEVICE_STREAMING_STOPPING) {
-		rt_mutex_unlock(&isp->mutex);
 		dev_err(isp->dev, "%s: reject, as ISP at stopping.\n",
 				__func__);
 		return -EIO;
 	}
 
-	rt_mutex_unlock(&isp->mutex);
+	return 0;
+}
+
+/*
+ * Fill in the driver specific fields of a dequeued buffer. Called with
+ * isp->mutex held.
+ */
+static void __atomisp_dqbuf_done(struct atomisp_video_pipe *pipe,
+				 struct v4l2_buffer *buf)
+{
+	struct atomisp_sub_device *asd = pipe->asd;
 
-	ret = videobuf_dqbuf(&pipe->capq, buf, file->f_flags & O_NONBLOCK);
-	if (ret) {
-		dev_dbg(isp->dev, "<%s: %d\n", __func__, ret);
-		return ret;
-	}
-	rt_mutex_lock(&isp->mutex);
 	buf->bytesused = pipe->pix.sizeimage;
 	buf->reserved = asd->frame_status[buf->index];
 	/*
@@ -1463,6 +1493,33 @@ static int atomisp_dqbuf(struct file *file, void *fh, struct v4l2_buffer *buf)
 	buf->reserved &= 0x0000ffff;
 	buf->reserved |= __get_frame_exp_id(pipe, buf) << 16;
 	buf->reserved2 = pipe->frame_config_id[buf->index];
+}
+
+/*
+ * Applications call the VIDIOC_DQBUF ioctl to dequeue a filled (capturing) or
+ * displayed (output buffer)from the driver's outgoing queue
+ */
+static int atomisp_dqbuf(struct file *file, void *fh, struct v4l2_buffer *buf)
+{
+	struct video_device *vdev = video_devdata(file);
+	struct atomisp_video_pipe *pipe = atomisp_to_video_pipe(vdev);
+	struct atomisp_sub_device *asd = pipe->asd;
+	struct atomisp_device *isp = video_get_drvdata(vdev);
+	int ret = 0;
+
+	rt_mutex_lock(&isp->mutex);
+	ret = __atomisp_dqbuf_check(asd);
+	rt_mutex_unlock(&isp->mutex);
+	if (ret)
+		return ret;
+
+	ret = videobuf_dqbuf(&pipe->capq, buf, file->f_flags & O_NONBLOCK);
+	if (ret) {
+		dev_dbg(isp->dev, "<%s: %d\n", __func__, ret);
+		return ret;
+	}
+	rt_mutex_lock(&isp->mutex);
+	__atomisp_dqbuf_done(pipe, buf);
 	rt_mutex_unlock(&isp->mutex);
 
 	dev_dbg(isp->dev, "dqbuf buffer %d (%s) with exp_id %d\n",
@@ -1470,6 +1527,131 @@ static int atomisp_dqbuf(struct file *file, void *fh, struct v4l2_buffer *buf)
 	return 0;
 }
 
+static struct atomisp_video_pipe *__atomisp_batch_pipe(
+		struct atomisp_sub_device *asd, unsigned int pad)
+{
+	switch (pad) {
+	case ATOMISP_SUBDEV_PAD_SOURCE_CAPTURE:
+		return &asd->video_out_capture;
+	case ATOMISP_SUBDEV_PAD_SOURCE_VF:
+		return &asd->video_out_vf;
+	case ATOMISP_SUBDEV_PAD_SOURCE_PREVIEW:
+		return &asd->video_out_preview;
+	case ATOMISP_SUBDEV_PAD_SOURCE_VIDEO:
+		return &asd->video_out_video_capture;
+	default:
+		return NULL;
+	}
+}
+
+/*
+ * Queue buffers to several pipes of one sub-device. isp->mutex has to be
+ * dropped around videobuf_qbuf() (it takes mmap_sem, which nests outside
+ * isp->mutex in atomisp_mmap()), so all entries are prepared under one
+ * lock, queued to videobuf and then passed on to CSS under a second one.
+ */
+static int atomisp_qbuf_batch(struct atomisp_sub_device *asd,
+			      struct atomisp_buf_batch *batch)
+{
+	struct atomisp_device *isp = asd->isp;
+	struct atomisp_video_pipe *pipe[ATOMISP_BUF_BATCH_MAX];
+	unsigned int i, prepared;
+	bool to_css = false;
+	int prep_ret = 0;
+	int ret = 0;
+
+	batch->done = 0;
+	if (batch->count == 0 || batch->count > ATOMISP_BUF_BATCH_MAX)
+		return -EINVAL;
+
+	for (i = 0; i < batch->count; i++)
+		batch->entry[i].result = 0;
+
+	rt_mutex_lock(&isp->mutex);
+	for (i = 0; i < batch->count; i++) {
+		pipe[i] = __atomisp_batch_pipe(asd, batch->entry[i].pad);
+		prep_ret = pipe[i] ?
+			   __atomisp_qbuf_prepare(pipe[i],
+						  &batch->entry[i].buf) :
+			   -EINVAL;
+		if (prep_ret)
+			break;
+	}
+	rt_mutex_unlock(&isp->mutex);
+	prepared = i;
+
+	for (i = 0; i < prepared; i++) {
+		ret = videobuf_qbuf(&pipe[i]->capq, &batch->entry[i].buf);
+		if (ret)
+			break;
+	}
+	ret = atomisp_buf_batch_result(batch, prepared, prep_ret, i, ret);
+
+	if (batch->done) {
+		rt_mutex_lock(&isp->mutex);
+		for (i = 0; i < batch->done; i++)
+			to_css |= __atomisp_qbuf_queued(pipe[i]);
+		if (to_css)
+			__atomisp_qbuf_to_css(asd);
+		rt_mutex_unlock(&isp->mutex);
+	}
+
+	dev_dbg(isp->dev, "qbuf batch %u/%u\n", batch->done, batch->count);
+
+	return ret;
+}
+
+/*
+ * Dequeue buffers from several pipes of one sub-device. Only the first
+ * entry may block; the others take what is already done, so a caller can
+ * wait for one pipe and collect the rest of the frame in the same call.
+ */
+static int atomisp_dqbuf_batch(struct file *file,
+			       struct atomisp_sub_device *asd,
+			       struct atomisp_buf_batch *batch)
+{
+	struct atomisp_device *isp = asd->isp;
+	struct atomisp_video_pipe *pipe[ATOMISP_BUF_BATCH_MAX];
+	unsigned int i;
+	int ret;
+
+	batch->done = 0;
+	if (batch->count == 0 || batch->count > ATOMISP_BUF_BATCH_MAX)
+		return -EINVAL;
+
+	for (i = 0; i < batch->count; i++) {
+		batch->entry[i].result = 0;
+		pipe[i] = __atomisp_batch_pipe(asd, batch->entry[i].pad);
+		if (!pipe[i])
+			return -EINVAL;
+	}
+
+	rt_mutex_lock(&isp->mutex);
+	ret = __atomisp_dqbuf_check(asd);
+	rt_mutex_unlock(&isp->mutex);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < batch->count; i++) {
+		ret = videobuf_dqbuf(&pipe[i]->capq, &batch->entry[i].buf,
+				     i ? 1 : file->f_flags & O_NONBLOCK);
+		if (ret)
+			break;
+	}
+	ret = atomisp_buf_batch_result(batch, batch->count, 0, i, ret);
+
+	if (batch->done) {
+		rt_mutex_lock(&isp->mutex);
+		for (i = 0; i < batch->done; i++)
+			__atomisp_dqbuf_done(pipe[i], &batch->entry[i].buf);
+		rt_mutex_unlock(&isp->mutex);
+	}
+
+	dev_dbg(isp->dev, "dqbuf batch %u/%u\n", batch->done, batch->count);
+
+	return ret;
+}
+
 enum atomisp_css_pipe_id atomisp_get_css_pipe_id(struct atomisp_sub_device *asd)
 {
 	if (ATOMISP_USE_YUVPP(asd))
@@ -1709,6 +1891,8 @@ static int atomisp_streamon(struct file *file, void *fh,
 	atomic_set(&asd->sof_count, -1);
 	atomic_set(&asd->sequence, -1);
 	atomic_set(&asd->sequence_temp, -1);
+	asd->wdt_tier = ATOMISP_WDT_TIER_NONE;
+	asd->wdt_progress = jiffies;
 	if (isp->sw_contex.file_input)
 		wdt_duration = ATOMISP_ISP_FILE_TIMEOUT_DURATION;
 
@@ -1721,6 +1905,8 @@ static int atomisp_streamon(struct file *file, void *fh,
 
 	atomisp_qbuffers_to_css(asd);
 
+	atomisp_pcprof_start(isp);
+
 	/* Only start sensor when the last streaming instance started */
 	if (atomisp_subdev_streaming_count(asd) < sensor_start_stream)
 		goto out;
@@ -1884,11 +2070,14 @@ int __atomisp_streamoff(struct file *file, void *fh, enum v4l2_buf_type type)
 	spin_unlock_irqrestore(&isp->lock, flags);
 
 	if (first_streamoff) {
+		/* profiler state is serialized by isp->mutex, like its start */
+		if (!atomisp_streaming_count(isp))
+			atomisp_pcprof_stop(isp);
+
 		/* if other streams are running, should not disable watch dog */
 		rt_mutex_unlock(&isp->mutex);
-		if (!atomisp_streaming_count(isp)) {
+		if (!atomisp_streaming_count(isp))
 			atomisp_wdt_stop(isp, true);
-		}
 
 		/*
 		 * must stop sending pixels into GP_FIFO before stop
@@ -2374,6 +2563,8 @@ static int atomisp_camera_s_ext_ctrls(struct file *file, void *fh,
 				ret = v4l2_subdev_call(
 					isp->inputs[asd->input_curr].camera,
 					core, s_ctrl, &ctrl);
+			if (!ret && ctrl.id == V4L2_CID_FOCUS_ABSOLUTE)
+				atomisp_frame_meta_set_focus(asd, ctrl.value);
 			break;
 		case V4L2_CID_FLASH_STATUS:
 		case V4L2_CID_FLASH_INTENSITY:
@@ -2569,6 +2760,8 @@ static long atomisp_vidioc_default(struct file *file, void *fh,
 	case ATOMISP_IOC_S_SENSOR_AE_BRACKETING_MODE:
 	case ATOMISP_IOC_G_SENSOR_AE_BRACKETING_MODE:
 	case ATOMISP_IOC_S_SENSOR_AE_BRACKETING_LUT:
+	case ATOMISP_IOC_QBUF_BATCH:
+	case ATOMISP_IOC_DQBUF_BATCH:
 		/* we do not need take isp->mutex for these IOCTLs */
 		break;
 	default:
@@ -2620,6 +2813,18 @@ static long atomisp_vidioc_default(struct file *file, void *fh,
 		err = atomisp_get_dis_stat(asd, arg);
 		break;
 
+	case ATOMISP_IOC_S_DIS_STAT_RING:
+		err = atomisp_set_dis_stat_ring(asd, arg);
+		break;
+
+	case ATOMISP_IOC_G_DIS_STAT_SLOT:
+		err = atomisp_get_dis_stat_slot(asd, arg);
+		break;
+
+	case ATOMISP_IOC_S_FRAME_META_RING:
+		err = atomisp_set_frame_meta_ring(asd, arg);
+		break;
+
 	case ATOMISP_IOC_G_DVS2_BQ_RESOLUTIONS:
 		err = atomisp_get_dvs2_bq_resolutions(asd, arg);
 		break;
@@ -2640,6 +2845,18 @@ static long atomisp_vidioc_default(struct file *file, void *fh,
 		}
 		break;
 
+	case ATOMISP_IOC_S_DIS_VECTOR_POOL:
+		err = atomisp_set_dvs_6axis_pool(asd, arg);
+		break;
+
+	case ATOMISP_IOC_S_DIS_VECTOR_SLOT:
+		err = atomisp_set_dvs_6axis_slot(asd, arg);
+		if (!err) {
+			atomisp_css_update_isp_params(asd);
+			asd->params.css_update_params_needed = false;
+		}
+		break;
+
 	case ATOMISP_IOC_G_ISP_PARM:
 		err = atomisp_param(asd, 0, arg);
 		break;
@@ -2739,6 +2956,12 @@ static long atomisp_vidioc_default(struct file *file, void *fh,
 					core, ioctl, cmd, arg);
 
 	case ATOMISP_IOC_S_EXPOSURE:
+		err = v4l2_subdev_call(isp->inputs[asd->input_curr].camera,
+				       core, ioctl, cmd, arg);
+		if (!err)
+			atomisp_frame_meta_set_exposure(asd, arg);
+		return err;
+
 	case ATOMISP_IOC_G_SENSOR_CALIBRATION_GROUP:
 	case ATOMISP_IOC_G_SENSOR_PRIV_INT_DATA:
 	case ATOMISP_IOC_G_SENSOR_AE_BRACKETING_INFO:
@@ -2842,6 +3065,15 @@ static long atomisp_vidioc_default(struct file *file, void *fh,
 	case ATOMISP_IOC_G_EFFECTIVE_RESOLUTION:
 		err = atomisp_get_effective_res(asd, arg);
 		break;
+	case ATOMISP_IOC_QBUF_BATCH:
+		err = atomisp_qbuf_batch(asd, arg);
+		break;
+	case ATOMISP_IOC_G_COMPLETION_FD:
+		err = atomisp_completion_get_fd(asd, arg);
+		break;
+	case ATOMISP_IOC_DQBUF_BATCH:
+		err = atomisp_dqbuf_batch(file, asd, arg);
+		break;
 	default:
 		rt_mutex_unlock(&isp->mutex);
 		return -EINVAL;
@@ -2857,6 +3089,8 @@ static long atomisp_vidioc_default(struct file *file, void *fh,
 	case ATOMISP_IOC_S_SENSOR_AE_BRACKETING_MODE:
 	case ATOMISP_IOC_G_SENSOR_AE_BRACKETING_MODE:
 	case ATOMISP_IOC_S_SENSOR_AE_BRACKETING_LUT:
+	case ATOMISP_IOC_QBUF_BATCH:
+	case ATOMISP_IOC_DQBUF_BATCH:
 		break;
 	default:
 		rt_mutex_unlock(&isp->mutex);
@@ -25,10 +25,153 @@
 #define	__ATOMISP_IOCTL_H__
 
 #include "ia_css.h"
+#include "atomisp_buf_batch.h"
 
 struct atomisp_device;
 struct atomisp_video_pipe;
 
+/*
+ * DIS statistics ring. Once configured, the ring is mapped with
+ * mmap(MAP_SHARED) at mmap_offset on the video node. Each slot holds the
+ * vertical odd_real, odd_imag, even_real, even_imag projections followed
+ * by the horizontal ones in the same order. ATOMISP_IOC_G_DIS_STAT_SLOT
+ * translates the next DIS statistics straight into a slot and returns
+ * its index; a slot is reused after num_slots further calls.
+ */
+#define ATOMISP_DIS_STAT_RING_MMAP_OFFSET	0xffffe000
+
+struct atomisp_dis_stat_ring_config {
+	__u32 enable;		/* in: 1 to (re)create the ring, 0 to free */
+	__u32 num_slots;	/* out */
+	__u32 slot_size;	/* out: bytes per slot, page aligned */
+	__u32 ver_proj_bytes;	/* out: bytes per vertical projection */
+	__u32 hor_proj_bytes;	/* out: bytes per horizontal projection */
+	__u32 mmap_offset;	/* out */
+};
+
+struct atomisp_dis_stat_slot {
+	__u32 index;		/* out: slot holding the statistics */
+	__u32 exp_id;		/* out: exposure id of the statistics */
+};
+
+#define ATOMISP_IOC_S_DIS_STAT_RING \
+	_IOWR('v', BASE_VIDIOC_PRIVATE + 110, \
+	      struct atomisp_dis_stat_ring_config)
+#define ATOMISP_IOC_G_DIS_STAT_SLOT \
+	_IOR('v', BASE_VIDIOC_PRIVATE + 111, struct atomisp_dis_stat_slot)
+
+/*
+ * DVS 6-axis config pool. Once configured, the pool is mapped with
+ * mmap(MAP_SHARED) at mmap_offset on the video node. Each slot holds
+ * xcoords_y, ycoords_y (width_y * height_y each) followed by xcoords_uv,
+ * ycoords_uv (width_uv * height_uv each), all 32 bit. User space fills
+ * a slot and submits it with ATOMISP_IOC_S_DIS_VECTOR_SLOT; the slot
+ * contents are consumed before the ioctl returns, so alternating
+ * between the slots lets the next grid be written while the previous
+ * one is being submitted.
+ */
+#define ATOMISP_DVS_6AXIS_POOL_MMAP_OFFSET	0xffffd000
+
+struct atomisp_dvs_6axis_pool_config {
+	__u32 enable;		/* in: 1 to (re)create the pool, 0 to free */
+	__u32 num_slots;	/* out */
+	__u32 slot_size;	/* out: bytes per slot, page aligned */
+	__u32 width_y;		/* out */
+	__u32 height_y;		/* out */
+	__u32 width_uv;		/* out */
+	__u32 height_uv;	/* out */
+	__u32 mmap_offset;	/* out */
+};
+
+struct atomisp_dvs_6axis_slot {
+	__u32 index;		/* in: slot to apply */
+	__u32 exp_id;		/* in: exposure id the grid belongs to */
+};
+
+#define ATOMISP_IOC_S_DIS_VECTOR_POOL \
+	_IOWR('v', BASE_VIDIOC_PRIVATE + 112, \
+	      struct atomisp_dvs_6axis_pool_config)
+#define ATOMISP_IOC_S_DIS_VECTOR_SLOT \
+	_IOW('v', BASE_VIDIOC_PRIVATE + 113, struct atomisp_dvs_6axis_slot)
+
+/*
+ * Completion channel. ATOMISP_IOC_G_COMPLETION_FD returns a file
+ * descriptor that becomes readable (poll/epoll) whenever a frame,
+ * statistics or metadata buffer of the sub-device completes. read()
+ * returns whole struct atomisp_completion_event records; it blocks
+ * unless the descriptor is non-blocking. One channel per sub-device.
+ */
+#define ATOMISP_COMPLETION_FRAME	1
+#define ATOMISP_COMPLETION_3A_STAT	2
+#define ATOMISP_COMPLETION_DIS_STAT	3
+#define ATOMISP_COMPLETION_METADATA	4
+
+struct atomisp_completion_event {
+	__u32 type;		/* ATOMISP_COMPLETION_* */
+	__u32 pad;		/* frame: source pad of the pipe */
+	__u32 index;		/* frame: buffer index, metadata: type */
+	__u32 exp_id;
+	__u32 status;		/* frame: 0 done, 1 error */
+	__u32 lost;		/* records dropped before this one */
+};
+
+#define ATOMISP_IOC_G_COMPLETION_FD \
+	_IOR('v', BASE_VIDIOC_PRIVATE + 116, int)
+
+/*
+ * Per-frame metadata ring. Once enabled, the ring is mapped read-only
+ * with mmap(MAP_SHARED) at mmap_offset on the video node. It starts
+ * with struct atomisp_frame_meta_ring_header, followed by num_records
+ * records of record_size bytes. A record is written when its frame
+ * buffer completes; record n lives in slot n % num_records and header
+ * head is the number of records written so far. A record is stable when
+ * its seq is even and unchanged across the read: seq is 2n+1 while
+ * record n is being written and 2n+2 once it is complete.
+ *
+ * Exposure, gain and focus are the values last set through
+ * ATOMISP_IOC_S_EXPOSURE and V4L2_CID_FOCUS_ABSOLUTE before the SOF of
+ * the frame; sensors that latch them with a delay apply them later.
+ */
+#define ATOMISP_FRAME_META_RING_MMAP_OFFSET	0xffffc000
+
+struct atomisp_frame_meta {
+	__u32 seq;
+	__u32 exp_id;
+	__u32 frame_seq;	/* v4l2_buffer sequence */
+	__u32 sof_seq;		/* SOF count of the frame, 0 based */
+	__u32 sof_sec;		/* SOF timestamp, CLOCK_MONOTONIC */
+	__u32 sof_nsec;
+	__u32 coarse_integration_time;
+	__u32 fine_integration_time;
+	__u32 analog_gain;
+	__u32 digital_gain;
+	__s32 focus_position;
+	__u32 isp_config_id;
+	__u32 pad;		/* source pad of the pipe */
+	__u32 index;		/* buffer index */
+	__u32 status;		/* 0 done, 1 error */
+	__u32 reserved;
+};
+
+struct atomisp_frame_meta_ring_header {
+	__u32 head;
+	__u32 num_records;
+	__u32 record_size;
+	__u32 reserved[13];
+};
+
+struct atomisp_frame_meta_ring_config {
+	__u32 enable;		/* in: 1 to (re)create the ring, 0 to free */
+	__u32 num_records;	/* out */
+	__u32 record_size;	/* out */
+	__u32 size;		/* out: bytes to map */
+	__u32 mmap_offset;	/* out */
+};
+
+#define ATOMISP_IOC_S_FRAME_META_RING \
+	_IOWR('v', BASE_VIDIOC_PRIVATE + 117, \
+	      struct atomisp_frame_meta_ring_config)
+
 extern const struct atomisp_format_bridge atomisp_output_fmts[];
 
 const struct atomisp_format_bridge *atomisp_get_format_bridge(
@@ -49,7 +192,8 @@ int atomisp_reqbufs(struct file *file, void *fh,
 enum atomisp_css_pipe_id atomisp_get_css_pipe_id(struct atomisp_sub_device
 						 *asd);
 
-void atomisp_videobuf_free_buf(struct videobuf_buffer *vb);
+void atomisp_videobuf_free_buf(struct atomisp_device *isp,
+			       struct videobuf_buffer *vb);
 
 extern const struct v4l2_file_operations atomisp_file_fops;
 
@@ -0,0 +1,149 @@
+/*
+ * Support for Medifield PNW Camera Imaging ISP subsystem.
+ *
+ * Copyright (c) 2010 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+
+/*
+ * The profile is only written by the timer callback, in hard irq
+ * context, and only cleared while the timer is stopped. Readers take
+ * it as it is; a sample more or less does not matter.
+ */
+
+#include <linux/hrtimer.h>
+#include <linux/string.h>
+
+#include "atomisp_compat.h"
+#include "atomisp_internal.h"
+#include "atomisp_ioctl.h"
+#include "atomisp_pcprof.h"
+
+static struct atomisp_pcprof_binary *
+__atomisp_pcprof_binary(struct atomisp_pcprof *prof, unsigned int id)
+{
+	struct atomisp_pcprof_binary *bin;
+	const char *name;
+	unsigned int i;
+
+	for (i = 0; i < ATOMISP_PCPROF_BINARIES; i++) {
+		bin = &prof->bin[i];
+		if (bin->samples && bin->id == id)
+			return bin;
+		if (!bin->samples)
+			break;
+	}
+	if (i == ATOMISP_PCPROF_BINARIES)
+		return NULL;
+
+	/*
+	 * The name is copied: the firmware blob it points into may be
+	 * unloaded long before the profile is read.
+	 */
+	bin->id = id;
+	name = atomisp_css_binary_name(id);
+	strlcpy(bin->name, name ? name : "unknown", sizeof(bin->name));
+
+	return bin;
+}
+
+static enum hrtimer_restart atomisp_pcprof_sample(struct hrtimer *timer)
+{
+	struct atomisp_pcprof *prof =
+		container_of(timer, struct atomisp_pcprof, timer);
+	struct atomisp_device *isp =
+		container_of(prof, struct atomisp_device, pcprof);
+	struct atomisp_pcprof_binary *bin;
+	unsigned int id, pc;
+	bool stall;
+
+	hrtimer_forward_now(timer, prof->period);
+
+	prof->samples++;
+	if (isp->sw_contex.power_state != ATOM_ISP_POWER_UP ||
+	    !atomisp_css_sample_isp_pc(&id, &pc, &stall)) {
+		prof->idle++;
+		return HRTIMER_RESTART;
+	}
+
+	bin = __atomisp_pcprof_binary(prof, id);
+	if (!bin) {
+		prof->dropped++;
+		return HRTIMER_RESTART;
+	}
+
+	bin->samples++;
+	if (stall)
+		bin->stalls++;
+	/* running_freq is in MHz, i.e. cycles per us */
+	bin->cycles += div_u64((u64)ktime_to_ns(prof->period) *
+			       isp->sw_contex.running_freq, NSEC_PER_USEC);
+	bin->hist[(pc % ATOMISP_PCPROF_PMEM_DEPTH) * ATOMISP_PCPROF_BUCKETS /
+		  ATOMISP_PCPROF_PMEM_DEPTH]++;
+
+	return HRTIMER_RESTART;
+}
+
+void atomisp_pcprof_init(struct atomisp_device *isp)
+{
+	hrtimer_init(&isp->pcprof.timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	isp->pcprof.timer.function = atomisp_pcprof_sample;
+}
+
+void atomisp_pcprof_start(struct atomisp_device *isp)
+{
+	struct atomisp_pcprof *prof = &isp->pcprof;
+
+	if (!prof->rate_hz || prof->running)
+		return;
+
+	prof->running = true;
+	hrtimer_start(&prof->timer, prof->period, HRTIMER_MODE_REL);
+}
+
+void atomisp_pcprof_stop(struct atomisp_device *isp)
+{
+	struct atomisp_pcprof *prof = &isp->pcprof;
+
+	if (!prof->running)
+		return;
+
+	hrtimer_cancel(&prof->timer);
+	prof->running = false;
+}
+
+void atomisp_pcprof_set_rate(struct atomisp_device *isp, unsigned int hz)
+{
+	struct atomisp_pcprof *prof = &isp->pcprof;
+	bool running = prof->running;
+
+	atomisp_pcprof_stop(isp);
+
+	prof->samples = 0;
+	prof->idle = 0;
+	prof->dropped = 0;
+	memset(prof->bin, 0, sizeof(prof->bin));
+
+	prof->rate_hz = hz;
+	if (!hz)
+		return;
+	prof->period = ns_to_ktime(div_u64(NSEC_PER_SEC, hz));
+
+	if (running || atomisp_streaming_count(isp))
+		atomisp_pcprof_start(isp);
+}
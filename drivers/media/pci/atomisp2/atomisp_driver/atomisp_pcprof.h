@@ -0,0 +1,50 @@
+/*
+ * Support for Medifield PNW Camera Imaging ISP subsystem.
+ *
+ * Copyright (c) 2010 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+
+#ifndef __ATOMISP_PCPROF_H__
+#define __ATOMISP_PCPROF_H__
+
+/*
+ * Sampling profiler of the ISP program counter.
+ *
+ * While streaming, an hrtimer reads the ISP pc, its stall state and the
+ * binary the SP runs on the ISP at pcprof.rate_hz. Each sample counts
+ * towards its binary, together with the ISP cycles one sample period
+ * stands for at the current ISP frequency. This shows which firmware
+ * binary dominates the frame time, without profiling hardware.
+ */
+
+struct atomisp_device;
+
+void atomisp_pcprof_init(struct atomisp_device *isp);
+
+/* Set the sample rate, clearing the profile; 0 stops sampling */
+void atomisp_pcprof_set_rate(struct atomisp_device *isp, unsigned int hz);
+
+/*
+ * Called on streamon, and when the last stream is turned off. These and
+ * atomisp_pcprof_set_rate() are called with isp->mutex held.
+ */
+void atomisp_pcprof_start(struct atomisp_device *isp);
+void atomisp_pcprof_stop(struct atomisp_device *isp);
+
+#endif /* __ATOMISP_PCPROF_H__ */
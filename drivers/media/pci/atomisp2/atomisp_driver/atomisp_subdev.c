@@ -718,6 +718,8 @@ static void isp_subdev_init_params(struct atomisp_sub_device *asd)
 	INIT_LIST_HEAD(&asd->dis_stats);
 	INIT_LIST_HEAD(&asd->dis_stats_in_css);
 	spin_lock_init(&asd->dis_stats_lock);
+	spin_lock_init(&asd->completion.lock);
+	init_waitqueue_head(&asd->completion.wait);
 	for (i = 0; i < ATOMISP_METADATA_TYPE_NUM; i++) {
 		INIT_LIST_HEAD(&asd->metadata[i]);
 		INIT_LIST_HEAD(&asd->metadata_in_css[i]);
@@ -1200,7 +1202,6 @@ static int isp_subdev_init_entities(struct atomisp_sub_device *asd)
 
 	/* Make controls visible on subdev as well. */
 	asd->subdev.ctrl_handler = &asd->ctrl_handler;
-	spin_lock_init(&asd->raw_buffer_bitmap_lock);
 	return asd->ctrl_handler.error;
 }
 
@@ -171,6 +171,8 @@ struct atomisp_css_params {
 	struct ia_css_dvs_6axis_config *dvs_6axis;
 	struct ia_css_dvs2_coefficients *dvs2_coeff;
 	struct ia_css_shading_table *shading_table;
+	/* shading_table converted for the stream outside isp->mutex */
+	struct ia_css_shading_prepared *shading_prepared;
 	struct ia_css_morph_table   *morph_table;
 
 	/*
@@ -181,6 +183,74 @@ struct atomisp_css_params {
 	uint32_t	isp_config_id;
 };
 
+/* User mappable DIS statistics ring, see ATOMISP_IOC_S_DIS_STAT_RING */
+#define ATOMISP_DIS_STAT_RING_SLOTS	4
+
+struct atomisp_dis_stat_ring {
+	void *base;		/* vmalloc_user() memory */
+	unsigned int num_slots;
+	unsigned int slot_size;
+	unsigned int next;
+	/* host statistics pointing into the slots */
+	struct ia_css_dvs2_statistics slot[ATOMISP_DIS_STAT_RING_SLOTS];
+};
+
+/* User mappable DVS 6-axis config pool, see ATOMISP_IOC_S_DIS_VECTOR_POOL */
+#define ATOMISP_DVS_6AXIS_POOL_SLOTS	2
+
+struct atomisp_dvs_6axis_pool {
+	void *base;		/* vmalloc_user() memory */
+	unsigned int num_slots;
+	unsigned int slot_size;
+	/* 6-axis configs pointing into the slots */
+	struct ia_css_dvs_6axis_config slot[ATOMISP_DVS_6AXIS_POOL_SLOTS];
+};
+
+/* Completion channel, see ATOMISP_IOC_G_COMPLETION_FD */
+#define ATOMISP_COMPLETION_SLOTS	64
+
+struct atomisp_completion_chan {
+	spinlock_t lock;
+	wait_queue_head_t wait;
+	bool open;
+	/* free running, slot is index % ATOMISP_COMPLETION_SLOTS */
+	unsigned int head;
+	unsigned int tail;
+	unsigned int lost;
+	/* ATOMISP_COMPLETION_SLOTS records while the channel is open */
+	struct atomisp_completion_event *ev;
+};
+
+/* SOF snapshots and EOF exp_id map kept for the frame metadata ring */
+#define ATOMISP_FRAME_META_SOFS		8
+#define ATOMISP_FRAME_META_EXP_IDS	16
+
+/* EOF timestamps the DFS governor keeps per stream, by exp_id */
+#define ATOMISP_DFS_GOV_EXP_IDS		8
+
+struct atomisp_frame_meta_sof {
+	unsigned int seq;
+	struct timespec ts;
+	unsigned int exposure[4];
+	int focus;
+};
+
+struct atomisp_frame_meta_ring {
+	/* header and records, see struct atomisp_frame_meta_ring_header */
+	void *base;
+	unsigned int num_records;
+	unsigned int head;
+	/* last values set from user space, isp->lock protected */
+	unsigned int exposure[4];
+	int focus;
+	/* written by the ISR, slot is sof_count % ATOMISP_FRAME_META_SOFS */
+	struct atomisp_frame_meta_sof sof[ATOMISP_FRAME_META_SOFS];
+	struct {
+		unsigned int exp_id;
+		unsigned int sof_seq;
+	} exp[ATOMISP_FRAME_META_EXP_IDS];
+};
+
 struct atomisp_subdev_params {
 	/* FIXME: Determines whether raw capture buffer are being passed to
 	 * user space. Unimplemented for now. */
@@ -229,6 +299,8 @@ struct atomisp_subdev_params {
 	int  dvs_ver_coef_bytes;
 	int  dvs_ver_proj_bytes;
 	int  dvs_hor_proj_bytes;
+	struct atomisp_dis_stat_ring dis_ring;
+	struct atomisp_dvs_6axis_pool dvs_6axis_pool;
 
 	/* Flash */
 	int num_flash_frames;
@@ -305,6 +377,9 @@ struct atomisp_sub_device {
 	struct list_head dis_stats_in_css;
 	spinlock_t dis_stats_lock;
 
+	struct atomisp_completion_chan completion;
+	struct atomisp_frame_meta_ring frame_meta;
+
 	struct atomisp_css_frame *vf_frame; /* TODO: needed? */
 	struct atomisp_css_frame *raw_output_frame;
 	enum atomisp_frame_status frame_status[VIDEO_MAX_FRAME];
@@ -335,14 +410,28 @@ struct atomisp_sub_device {
 
 	unsigned int latest_preview_exp_id; /* CSS ZSL/SDV raw buffer id */
 
+	/* watchdog recovery, see enum atomisp_wdt_tier */
+	unsigned long wdt_progress;	/* jiffies of the last frame, or since
+					 * buffers are queued to CSS */
+	unsigned int wdt_tier;		/* last tier tried, until a frame */
+	ktime_t wdt_tier_ts;
+
+	/* DFS governor input, see struct atomisp_dfs_gov */
+	unsigned short dfs_fps;
+	ktime_t dfs_eof_ts[ATOMISP_DFS_GOV_EXP_IDS];	/* by exp_id */
+	unsigned int dfs_busy_us;	/* running average */
+
 	unsigned int mipi_frame_size;
 
 	bool copy_mode; /* CSI2+ use copy mode */
 	bool copy_mode_format_conv; /* CSI2+ copy with format conversion */
 	bool yuvpp_mode;	/* CSI2+ yuvpp pipe */
 
-	int raw_buffer_bitmap[ATOMISP_MAX_EXP_ID/32 + 1]; /* Record each Raw Buffer lock status */
-	spinlock_t raw_buffer_bitmap_lock;
+	/*
+	 * Lock status of each raw buffer, indexed by exp_id. Updated with
+	 * atomic bitops only, from the ISR thread and the ioctls.
+	 */
+	unsigned long raw_buffer_bitmap[BITS_TO_LONGS(ATOMISP_MAX_EXP_ID + 1)];
 
 	bool high_speed_mode; /* Indicate whether now is a high speed mode */
 	int pending_capture_request; /* Indicates the number of pending capture requests. */
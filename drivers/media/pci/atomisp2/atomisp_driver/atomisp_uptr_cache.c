@@ -0,0 +1,350 @@
+/*
+ * Support for Medifield PNW Camera Imaging ISP subsystem.
+ *
+ * Copyright (c) 2010 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+/*
+ * The cache lock is taken from MMU notifier callbacks, which may run
+ * with mmap_sem held or from page reclaim. So nothing under it may
+ * sleep on mmap_sem or allocate memory: frames are mapped and freed,
+ * and notifiers registered, with the lock dropped.
+ */
+
+#include <linux/mmu_notifier.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+
+#include "atomisp_internal.h"
+#include "atomisp_uptr_cache.h"
+
+#include "hrt/hive_isp_css_mm_hrt.h"
+
+struct atomisp_uptr_mm {
+	struct mmu_notifier mn;
+	struct mm_struct *mm;
+	struct atomisp_device *isp;
+	struct list_head list;
+};
+
+struct atomisp_uptr_entry {
+	struct list_head list;		/* uptr_cache.entries */
+	struct list_head lru;		/* uptr_cache.lru or .dead */
+	struct mm_struct *mm;
+	unsigned long start;
+	unsigned int pgnr;
+	struct atomisp_css_frame_info info;
+	struct atomisp_css_frame *frame;
+	bool idle;			/* not held by any video buffer */
+	bool stale;			/* user memory changed, never reuse */
+};
+
+static struct atomisp_uptr_entry *
+__atomisp_uptr_find(struct atomisp_device *isp,
+		    struct atomisp_css_frame *frame)
+{
+	struct atomisp_uptr_entry *e;
+
+	list_for_each_entry(e, &isp->uptr_cache.entries, list)
+		if (e->frame == frame)
+			return e;
+
+	return NULL;
+}
+
+static void __atomisp_uptr_free(struct list_head *head)
+{
+	struct atomisp_uptr_entry *e, *tmp;
+
+	list_for_each_entry_safe(e, tmp, head, lru) {
+		list_del(&e->lru);
+		atomisp_css_frame_free(e->frame);
+		kfree(e);
+	}
+}
+
+static void atomisp_uptr_invalidate(struct atomisp_uptr_mm *um,
+				    unsigned long start, unsigned long end)
+{
+	struct atomisp_device *isp = um->isp;
+	struct atomisp_uptr_entry *e, *tmp;
+
+	mutex_lock(&isp->uptr_cache.lock);
+	isp->uptr_cache.inval_seq++;
+	list_for_each_entry_safe(e, tmp, &isp->uptr_cache.entries, list) {
+		unsigned long e_start = e->start & PAGE_MASK;
+		unsigned long e_end = e_start + (e->pgnr << PAGE_SHIFT);
+
+		if (e->mm != um->mm || e->stale ||
+		    e_start >= end || e_end <= start)
+			continue;
+
+		e->stale = true;
+		isp->uptr_cache.invalidations++;
+		if (!e->idle)
+			continue;
+
+		/* freed later from process context, see the top */
+		list_del(&e->list);
+		list_move_tail(&e->lru, &isp->uptr_cache.dead);
+		isp->uptr_cache.idle_pages -= e->pgnr;
+	}
+	mutex_unlock(&isp->uptr_cache.lock);
+}
+
+static void atomisp_uptr_mn_release(struct mmu_notifier *mn,
+				    struct mm_struct *mm)
+{
+	atomisp_uptr_invalidate(container_of(mn, struct atomisp_uptr_mm, mn),
+				0, ULONG_MAX);
+}
+
+static void atomisp_uptr_mn_invalidate_page(struct mmu_notifier *mn,
+					    struct mm_struct *mm,
+					    unsigned long address)
+{
+	atomisp_uptr_invalidate(container_of(mn, struct atomisp_uptr_mm, mn),
+				address, address + PAGE_SIZE);
+}
+
+static void atomisp_uptr_mn_invalidate_range_start(struct mmu_notifier *mn,
+						   struct mm_struct *mm,
+						   unsigned long start,
+						   unsigned long end)
+{
+	atomisp_uptr_invalidate(container_of(mn, struct atomisp_uptr_mm, mn),
+				start, end);
+}
+
+static const struct mmu_notifier_ops atomisp_uptr_mn_ops = {
+	.release = atomisp_uptr_mn_release,
+	.invalidate_page = atomisp_uptr_mn_invalidate_page,
+	.invalidate_range_start = atomisp_uptr_mn_invalidate_range_start,
+};
+
+/* Start watching current->mm, if not done yet. Called without the lock. */
+static int atomisp_uptr_watch_mm(struct atomisp_device *isp)
+{
+	struct mm_struct *mm = current->mm;
+	struct atomisp_uptr_mm *um;
+	int ret;
+
+	mutex_lock(&isp->uptr_cache.lock);
+	list_for_each_entry(um, &isp->uptr_cache.mms, list) {
+		if (um->mm == mm) {
+			mutex_unlock(&isp->uptr_cache.lock);
+			return 0;
+		}
+	}
+	mutex_unlock(&isp->uptr_cache.lock);
+
+	um = kzalloc(sizeof(*um), GFP_KERNEL);
+	if (!um)
+		return -ENOMEM;
+
+	um->mn.ops = &atomisp_uptr_mn_ops;
+	um->mm = mm;
+	um->isp = isp;
+	ret = mmu_notifier_register(&um->mn, mm);
+	if (ret) {
+		kfree(um);
+		return ret;
+	}
+	/* keep the mm_struct around until the notifier is unregistered */
+	atomic_inc(&mm->mm_count);
+
+	/* callers are serialised by isp->mutex, so no one raced us here */
+	mutex_lock(&isp->uptr_cache.lock);
+	list_add(&um->list, &isp->uptr_cache.mms);
+	mutex_unlock(&isp->uptr_cache.lock);
+
+	return 0;
+}
+
+void atomisp_uptr_cache_init(struct atomisp_device *isp)
+{
+	mutex_init(&isp->uptr_cache.lock);
+	INIT_LIST_HEAD(&isp->uptr_cache.entries);
+	INIT_LIST_HEAD(&isp->uptr_cache.lru);
+	INIT_LIST_HEAD(&isp->uptr_cache.dead);
+	INIT_LIST_HEAD(&isp->uptr_cache.mms);
+	isp->uptr_cache.max_pages = ATOMISP_UPTR_CACHE_PAGES;
+}
+
+void atomisp_uptr_cache_release(struct atomisp_device *isp)
+{
+	struct atomisp_uptr_entry *e, *tmp;
+	struct atomisp_uptr_mm *um, *tum;
+	LIST_HEAD(free);
+	LIST_HEAD(mms);
+
+	mutex_lock(&isp->uptr_cache.lock);
+	list_for_each_entry_safe(e, tmp, &isp->uptr_cache.entries, list) {
+		/* still held: no longer watched, freed by the last put */
+		e->stale = true;
+		if (!e->idle)
+			continue;
+		list_del(&e->list);
+		list_move_tail(&e->lru, &free);
+	}
+	list_splice_init(&isp->uptr_cache.dead, &free);
+	list_splice_init(&isp->uptr_cache.mms, &mms);
+	isp->uptr_cache.idle_pages = 0;
+	mutex_unlock(&isp->uptr_cache.lock);
+
+	__atomisp_uptr_free(&free);
+
+	list_for_each_entry_safe(um, tum, &mms, list) {
+		list_del(&um->list);
+		mmu_notifier_unregister(&um->mn, um->mm);
+		mmdrop(um->mm);
+		kfree(um);
+	}
+}
+
+int atomisp_uptr_cache_map(struct atomisp_device *isp,
+			   struct atomisp_css_frame **frame,
+			   const struct atomisp_css_frame_info *info,
+			   unsigned long userptr,
+			   struct hrt_userbuffer_attr *attr)
+{
+	struct atomisp_uptr_entry *e;
+	unsigned int seq;
+	int ret;
+
+	/* ION buffers are passed by fd, there is no address to key on */
+	if (attr->type != HRT_USR_PTR || !isp->uptr_cache.max_pages)
+		return atomisp_css_frame_map(frame, info, (void *)userptr,
+					     0, attr);
+
+	atomisp_uptr_cache_trim(isp);
+
+	mutex_lock(&isp->uptr_cache.lock);
+	list_for_each_entry(e, &isp->uptr_cache.lru, lru) {
+		if (e->mm != current->mm || e->start != userptr ||
+		    e->pgnr != attr->pgnr ||
+		    memcmp(&e->info, info, sizeof(*info)))
+			continue;
+
+		list_del_init(&e->lru);
+		e->idle = false;
+		isp->uptr_cache.idle_pages -= e->pgnr;
+		isp->uptr_cache.hits++;
+		mutex_unlock(&isp->uptr_cache.lock);
+
+		*frame = e->frame;
+		return 0;
+	}
+	isp->uptr_cache.misses++;
+	seq = isp->uptr_cache.inval_seq;
+	mutex_unlock(&isp->uptr_cache.lock);
+
+	if (atomisp_uptr_watch_mm(isp))
+		/* can't see invalidations, so don't cache */
+		return atomisp_css_frame_map(frame, info, (void *)userptr,
+					     0, attr);
+
+	e = kzalloc(sizeof(*e), GFP_KERNEL);
+	if (!e)
+		return -ENOMEM;
+
+	ret = atomisp_css_frame_map(&e->frame, info, (void *)userptr,
+				    0, attr);
+	if (ret) {
+		kfree(e);
+		return ret;
+	}
+
+	e->mm = current->mm;
+	e->start = userptr;
+	e->pgnr = attr->pgnr;
+	e->info = *info;
+	INIT_LIST_HEAD(&e->lru);
+
+	mutex_lock(&isp->uptr_cache.lock);
+	/* the pages may have been pinned before an unmap we didn't match */
+	e->stale = seq != isp->uptr_cache.inval_seq;
+	list_add(&e->list, &isp->uptr_cache.entries);
+	mutex_unlock(&isp->uptr_cache.lock);
+
+	*frame = e->frame;
+	return 0;
+}
+
+bool atomisp_uptr_cache_valid(struct atomisp_device *isp,
+			      struct atomisp_css_frame *frame)
+{
+	struct atomisp_uptr_entry *e;
+	bool valid;
+
+	mutex_lock(&isp->uptr_cache.lock);
+	e = __atomisp_uptr_find(isp, frame);
+	valid = !e || !e->stale;
+	mutex_unlock(&isp->uptr_cache.lock);
+
+	return valid;
+}
+
+void atomisp_uptr_cache_put(struct atomisp_device *isp,
+			    struct atomisp_css_frame *frame)
+{
+	struct atomisp_uptr_entry *e;
+
+	mutex_lock(&isp->uptr_cache.lock);
+	e = __atomisp_uptr_find(isp, frame);
+	if (!e) {
+		mutex_unlock(&isp->uptr_cache.lock);
+		atomisp_css_frame_free(frame);
+		return;
+	}
+
+	if (e->stale || !isp->uptr_cache.max_pages) {
+		list_del(&e->list);
+		mutex_unlock(&isp->uptr_cache.lock);
+		atomisp_css_frame_free(frame);
+		kfree(e);
+		return;
+	}
+
+	e->idle = true;
+	list_add_tail(&e->lru, &isp->uptr_cache.lru);
+	isp->uptr_cache.idle_pages += e->pgnr;
+	mutex_unlock(&isp->uptr_cache.lock);
+
+	atomisp_uptr_cache_trim(isp);
+}
+
+void atomisp_uptr_cache_trim(struct atomisp_device *isp)
+{
+	struct atomisp_uptr_entry *e;
+	LIST_HEAD(free);
+
+	mutex_lock(&isp->uptr_cache.lock);
+	list_splice_init(&isp->uptr_cache.dead, &free);
+	while (isp->uptr_cache.idle_pages > isp->uptr_cache.max_pages) {
+		e = list_first_entry(&isp->uptr_cache.lru,
+				     struct atomisp_uptr_entry, lru);
+		list_del(&e->list);
+		list_move_tail(&e->lru, &free);
+		isp->uptr_cache.idle_pages -= e->pgnr;
+		isp->uptr_cache.evictions++;
+	}
+	mutex_unlock(&isp->uptr_cache.lock);
+
+	__atomisp_uptr_free(&free);
+}
@@ -0,0 +1,70 @@
+/*
+ * Support for Medifield PNW Camera Imaging ISP subsystem.
+ *
+ * Copyright (c) 2010 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+#ifndef __ATOMISP_UPTR_CACHE_H__
+#define __ATOMISP_UPTR_CACHE_H__
+
+#include "atomisp_compat.h"
+
+/*
+ * Cache of USERPTR frame mappings.
+ *
+ * A user buffer mapped for one video buffer slot keeps its pinned pages
+ * and ISP virtual address when the slot is given another user buffer, so
+ * that queueing it again later, on any slot, needs no new pinning and
+ * page table setup. Idle mappings are dropped in LRU order past the
+ * pinned page budget, and as soon as the user unmaps or changes the
+ * memory behind them.
+ */
+
+struct atomisp_device;
+struct hrt_userbuffer_attr;
+
+void atomisp_uptr_cache_init(struct atomisp_device *isp);
+
+/*
+ * Free all idle mappings and stop watching the user address spaces.
+ * Called when the last device node is closed.
+ */
+void atomisp_uptr_cache_release(struct atomisp_device *isp);
+
+/* Map a user buffer into a frame, reusing a cached mapping if possible */
+int atomisp_uptr_cache_map(struct atomisp_device *isp,
+			   struct atomisp_css_frame **frame,
+			   const struct atomisp_css_frame_info *info,
+			   unsigned long userptr,
+			   struct hrt_userbuffer_attr *attr);
+
+/* False if the user memory behind a cached mapping went away */
+bool atomisp_uptr_cache_valid(struct atomisp_device *isp,
+			      struct atomisp_css_frame *frame);
+
+/*
+ * Give a frame back. Frames that did not come from the cache are freed,
+ * so this can be used for any video buffer frame.
+ */
+void atomisp_uptr_cache_put(struct atomisp_device *isp,
+			    struct atomisp_css_frame *frame);
+
+/* Drop idle mappings until the pinned page budget is met */
+void atomisp_uptr_cache_trim(struct atomisp_device *isp);
+
+#endif /* __ATOMISP_UPTR_CACHE_H__ */
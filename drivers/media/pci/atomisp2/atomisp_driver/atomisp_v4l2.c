@@ -20,6 +20,7 @@
  * 02110-1301, USA.
  *
  */
+#include <linux/async.h>
 #include <linux/module.h>
 #include <linux/pci.h>
 #include <linux/pm_runtime.h>
@@ -43,6 +44,8 @@
 #include "atomisp_ioctl.h"
 #include "atomisp_internal.h"
 #include "atomisp_acc.h"
+#include "atomisp_pcprof.h"
+#include "atomisp_uptr_cache.h"
 #include "atomisp-regs.h"
 #include "atomisp_dfs_tables.h"
 #include "atomisp_drvfs.h"
@@ -498,6 +501,12 @@ static int atomisp_suspend(struct device *dev)
 	if (atomisp_dev_users(isp))
 		return -EBUSY;
 
+	/*
+	 * CSS left initialized after the last close would not survive the
+	 * power down; uninit it now, so the next open starts cold.
+	 */
+	atomisp_linger_cancel(isp);
+
 	spin_lock_irqsave(&isp->lock, flags);
 	if (asd->streaming != ATOMISP_DEVICE_STREAMING_DISABLED) {
 		spin_unlock_irqrestore(&isp->lock, flags);
@@ -678,15 +687,56 @@ static int atomisp_csi_lane_config(struct atomisp_device *isp)
 	return 0;
 }
 
+/*
+ * One entry of the platform subdev table. The i2c devices are created
+ * from async context so that the sensor, VCM and flash drivers run their
+ * power-up sequences and detection in parallel instead of one by one.
+ */
+struct atomisp_subdev_probe_ctx {
+	struct atomisp_device *isp;
+	struct intel_v4l2_subdev_table *subdevs;
+	struct i2c_adapter *adapter;
+	struct v4l2_subdev *subdev;
+	struct atomisp_subdev_timing *timing;
+	ktime_t base;
+};
+
+static ASYNC_DOMAIN_EXCLUSIVE(atomisp_subdev_probe_domain);
+
+static void atomisp_subdev_probe_async(void *data, async_cookie_t cookie)
+{
+	struct atomisp_subdev_probe_ctx *ctx = data;
+	struct i2c_board_info *board_info =
+		&ctx->subdevs->v4l2_subdev.board_info;
+	ktime_t start = ktime_get();
+
+#ifdef CONFIG_GMIN_INTEL_MID
+	/* In G-Min, the sensor devices will already be probed
+	 * (via ACPI) and registered, do not create new
+	 * ones */
+	ctx->subdev = atomisp_gmin_find_subdev(ctx->adapter, board_info);
+	if (v4l2_device_register_subdev(&ctx->isp->v4l2_dev, ctx->subdev))
+		ctx->subdev = NULL;
+#else
+	ctx->subdev = v4l2_i2c_new_subdev_board(&ctx->isp->v4l2_dev,
+			ctx->adapter, board_info, NULL);
+#endif
+
+	if (ctx->timing) {
+		ctx->timing->start_us = ktime_us_delta(start, ctx->base);
+		ctx->timing->duration_us = ktime_us_delta(ktime_get(), start);
+		ctx->timing->detected = ctx->subdev != NULL;
+	}
+}
+
 static int atomisp_subdev_probe(struct atomisp_device *isp)
 {
 	const struct atomisp_platform_data *pdata;
 	struct intel_v4l2_subdev_table *subdevs;
-#ifdef CONFIG_GMIN_INTEL_MID
-	int ret, raw_index = -1;
-#else
+	struct atomisp_subdev_probe_ctx *ctx;
+	unsigned int n = 0, cnt;
+	ktime_t base = ktime_get();
 	int raw_index = -1;
-#endif
 
 	pdata = atomisp_get_platform_data();
 	if (pdata == NULL) {
@@ -694,14 +744,19 @@ static int atomisp_subdev_probe(struct atomisp_device *isp)
 		return 0;
 	}
 
-	for (subdevs = pdata->subdevs; subdevs->type; ++subdevs) {
-		struct v4l2_subdev *subdev;
+	for (subdevs = pdata->subdevs; subdevs->type; ++subdevs)
+		n++;
+
+	ctx = kcalloc(n, sizeof(*ctx), GFP_KERNEL);
+	if (n && !ctx)
+		return -ENOMEM;
+
+	isp->subdev_timing_cnt = 0;
+	for (cnt = 0, subdevs = pdata->subdevs; cnt < n; cnt++, subdevs++) {
 		struct i2c_board_info *board_info =
 			&subdevs->v4l2_subdev.board_info;
 		struct i2c_adapter *adapter =
 			i2c_get_adapter(subdevs->v4l2_subdev.i2c_adapter_id);
-		struct camera_sensor_platform_data *sensor_pdata;
-		int sensor_num, i;
 
 		if (adapter == NULL) {
 			dev_err(isp->dev,
@@ -710,22 +765,31 @@ static int atomisp_subdev_probe(struct atomisp_device *isp)
 			break;
 		}
 
-#ifdef CONFIG_GMIN_INTEL_MID
-		/* In G-Min, the sensor devices will already be probed
-		 * (via ACPI) and registered, do not create new
-		 * ones */
-		subdev = atomisp_gmin_find_subdev(adapter, board_info);
-		ret = v4l2_device_register_subdev(&isp->v4l2_dev, subdev);
-		if (ret) {
-			dev_warn(isp->dev, "Subdev %s detection fail\n",
-				 board_info->type);
-			continue;
+		ctx[cnt].isp = isp;
+		ctx[cnt].subdevs = subdevs;
+		ctx[cnt].adapter = adapter;
+		ctx[cnt].base = base;
+		if (isp->subdev_timing_cnt < ATOMISP_MAX_SUBDEV_TIMINGS) {
+			ctx[cnt].timing =
+				&isp->subdev_timing[isp->subdev_timing_cnt++];
+			strlcpy(ctx[cnt].timing->name, board_info->type,
+				sizeof(ctx[cnt].timing->name));
 		}
-#else
-		subdev = v4l2_i2c_new_subdev_board(&isp->v4l2_dev, adapter,
-				board_info, NULL);
-#endif
 
+		async_schedule_domain(atomisp_subdev_probe_async, &ctx[cnt],
+				      &atomisp_subdev_probe_domain);
+	}
+	async_synchronize_full_domain(&atomisp_subdev_probe_domain);
+
+	/* Assign inputs in platform table order, as before */
+	for (n = 0; n < cnt; n++) {
+		struct v4l2_subdev *subdev = ctx[n].subdev;
+		struct i2c_board_info *board_info =
+			&ctx[n].subdevs->v4l2_subdev.board_info;
+		struct camera_sensor_platform_data *sensor_pdata;
+		int sensor_num, i;
+
+		subdevs = ctx[n].subdevs;
 		if (subdev == NULL) {
 			dev_warn(isp->dev, "Subdev %s detection fail\n",
 				 board_info->type);
@@ -791,8 +855,11 @@ static int atomisp_subdev_probe(struct atomisp_device *isp)
 			dev_dbg(isp->dev, "unknown subdev probed\n");
 			break;
 		}
-
 	}
+	kfree(ctx);
+
+	dev_dbg(isp->dev, "subdev probe took %lld us\n",
+		ktime_us_delta(ktime_get(), base));
 
 	/*
 	 * HACK: Currently VCM belongs to primary sensor only, but correct
@@ -1274,6 +1341,10 @@ static int atomisp_pci_probe(struct pci_dev *dev,
 		return -ENODEV;
 	}
 
+	isp->dfs_gov.target_pct = ATOMISP_DFS_GOV_TARGET_PCT;
+	isp->dfs_gov.down_evals = ATOMISP_DFS_GOV_DOWN_EVALS;
+	atomisp_pcprof_init(isp);
+
 	isp->max_isr_latency = ATOMISP_MAX_ISR_LATENCY;
 #ifndef CONFIG_GMIN_INTEL_MID /* No spid in gmin, nor CLVT support */
 	if (pdata &&
@@ -1307,6 +1378,7 @@ static int atomisp_pci_probe(struct pci_dev *dev,
 		goto wdt_work_queue_fail;
 	}
 	INIT_WORK(&isp->wdt_work, atomisp_wdt_work);
+	INIT_DELAYED_WORK(&isp->linger_work, atomisp_linger_work);
 
 	pci_set_master(dev);
 	pci_set_drvdata(dev, isp);
@@ -1372,6 +1444,7 @@ static int atomisp_pci_probe(struct pci_dev *dev,
 		goto register_entities_fail;
 	}
 	atomisp_acc_init(isp);
+	atomisp_uptr_cache_init(isp);
 
 	/* save the iunit context only once after all the values are init'ed. */
 	atomisp_save_iunit_reg(isp);
@@ -1449,6 +1522,10 @@ static void atomisp_pci_remove(struct pci_dev *dev)
 
 	atomisp_drvfs_exit();
 
+	atomisp_linger_cancel(isp);
+	rt_mutex_lock(&isp->mutex);
+	atomisp_pcprof_stop(isp);
+	rt_mutex_unlock(&isp->mutex);
 	atomisp_acc_cleanup(isp);
 
 	atomisp_css_unload_firmware(isp);
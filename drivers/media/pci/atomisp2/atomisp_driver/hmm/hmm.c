@@ -28,6 +28,7 @@
 #include <linux/mm.h>
 #include <linux/highmem.h>	/* for kmap */
 #include <linux/io.h>		/* for page_to_phys */
+#include <linux/spinlock.h>
 
 #include "hmm/hmm.h"
 #include "hmm/hmm_pool.h"
@@ -49,6 +50,178 @@ struct hmm_pool	reserved_pool;
 static ia_css_ptr dummy_ptr;
 struct _hmm_mem_stat hmm_mem_stat;
 
+/*
+ * Persistent vmaps for parameter-sized buffer objects.
+ *
+ * The CSS host library reaches small buffers through hmm_load/store/set
+ * thousands of times a second, and a vmap/vunmap pair per access costs
+ * far more than the copy itself. Buffer objects of up to
+ * HMM_VMAP_CACHE_MAX_PGNR pages therefore keep a cached vmap once they
+ * are touched, on an LRU bounded by hmm_vmap_stat.max_pages.
+ *
+ * Stores through a cached vmap only widen the buffer object's dirty
+ * range; hmm_flush_dirty() writes all of them back at once. The host
+ * can only hand work to the ISP by writing its registers or DMEM, and
+ * every such write calls hmm_flush_dirty() first, so the ISP never
+ * reads stale data.
+ *
+ * Like the vmaps made through hmm_vmap(), these assume that the host
+ * accesses to one buffer are serialized by the caller (isp->mutex).
+ * hmm_vmap() pins a buffer object: it leaves the LRU and keeps its
+ * mapping until hmm_vunmap().
+ */
+#define HMM_VMAP_CACHE_MAX_PGNR		16
+#define HMM_VMAP_CACHE_PAGES		1024
+
+static DEFINE_SPINLOCK(vmap_cache_lock);
+static LIST_HEAD(vmap_cache_lru);
+static LIST_HEAD(vmap_cache_dirty);
+struct _hmm_vmap_stat hmm_vmap_stat = {
+	.max_pages = HMM_VMAP_CACHE_PAGES,
+};
+
+/* write back the dirty range of bo, vmap_cache_lock held */
+static void __hmm_vmap_cache_clean(struct hmm_buffer_object *bo)
+{
+	if (list_empty(&bo->dirty_list))
+		return;
+
+	clflush_cache_range(bo->vmap_addr + bo->dirty_start,
+			    bo->dirty_end - bo->dirty_start);
+	hmm_vmap_stat.flushed += bo->dirty_end - bo->dirty_start;
+	list_del_init(&bo->dirty_list);
+}
+
+void hmm_flush_dirty(void)
+{
+	struct hmm_buffer_object *bo, *tmp;
+	unsigned long flags;
+
+	if (list_empty(&vmap_cache_dirty))
+		return;
+
+	spin_lock_irqsave(&vmap_cache_lock, flags);
+	list_for_each_entry_safe(bo, tmp, &vmap_cache_dirty, dirty_list)
+		__hmm_vmap_cache_clean(bo);
+	hmm_vmap_stat.handoffs++;
+	spin_unlock_irqrestore(&vmap_cache_lock, flags);
+}
+
+/* unmap the least recently used buffers until at most limit pages stay */
+static void hmm_vmap_cache_trim(unsigned int limit)
+{
+	struct hmm_buffer_object *bo;
+	unsigned long flags;
+
+	spin_lock_irqsave(&vmap_cache_lock, flags);
+	while (hmm_vmap_stat.pages > limit) {
+		bo = list_first_entry(&vmap_cache_lru,
+				      struct hmm_buffer_object, vmap_list);
+		__hmm_vmap_cache_clean(bo);
+		list_del_init(&bo->vmap_list);
+		hmm_vmap_stat.pages -= bo->pgnr;
+		hmm_vmap_stat.evictions++;
+		/* hmm_free() may drop its reference while we unmap */
+		hmm_bo_ref(bo);
+		spin_unlock_irqrestore(&vmap_cache_lock, flags);
+
+		hmm_bo_vunmap(bo);
+		hmm_bo_unref(bo);
+
+		spin_lock_irqsave(&vmap_cache_lock, flags);
+	}
+	spin_unlock_irqrestore(&vmap_cache_lock, flags);
+}
+
+void hmm_vmap_cache_set_budget(unsigned int pages)
+{
+	hmm_vmap_stat.max_pages = pages;
+	hmm_vmap_cache_trim(pages);
+	/* with the budget off, stores flush right away again */
+	if (!pages)
+		hmm_flush_dirty();
+}
+
+/* keep a small buffer object vmapped for the accesses that follow */
+static void hmm_vmap_cache_map(struct hmm_buffer_object *bo)
+{
+	unsigned int max_pages = hmm_vmap_stat.max_pages;
+	unsigned long flags;
+
+	if (bo->pgnr > HMM_VMAP_CACHE_MAX_PGNR || bo->pgnr > max_pages ||
+	    in_atomic())
+		return;
+
+	hmm_vmap_cache_trim(max_pages - bo->pgnr);
+
+	if (!hmm_bo_vmap(bo, true))
+		return;
+
+	spin_lock_irqsave(&vmap_cache_lock, flags);
+	if (list_empty(&bo->vmap_list)) {
+		list_add_tail(&bo->vmap_list, &vmap_cache_lru);
+		hmm_vmap_stat.pages += bo->pgnr;
+		hmm_vmap_stat.maps++;
+	}
+	spin_unlock_irqrestore(&vmap_cache_lock, flags);
+}
+
+static void hmm_vmap_cache_touch(struct hmm_buffer_object *bo)
+{
+	unsigned long flags;
+
+	if (list_empty(&bo->vmap_list))
+		return;
+
+	spin_lock_irqsave(&vmap_cache_lock, flags);
+	if (!list_empty(&bo->vmap_list))
+		list_move_tail(&bo->vmap_list, &vmap_cache_lru);
+	spin_unlock_irqrestore(&vmap_cache_lock, flags);
+}
+
+/*
+ * bytes at offset of bo were written through its cached vmap at dst:
+ * flush them now, or leave that to the next hmm_flush_dirty().
+ */
+static void hmm_vmap_cache_dirty(struct hmm_buffer_object *bo, void *dst,
+				 unsigned int offset, unsigned int bytes)
+{
+	unsigned long flags;
+
+	if (!hmm_vmap_stat.max_pages) {
+		clflush_cache_range(dst, bytes);
+		return;
+	}
+
+	spin_lock_irqsave(&vmap_cache_lock, flags);
+	if (list_empty(&bo->dirty_list)) {
+		bo->dirty_start = offset;
+		bo->dirty_end = offset + bytes;
+		list_add_tail(&bo->dirty_list, &vmap_cache_dirty);
+	} else {
+		bo->dirty_start = min(bo->dirty_start, offset);
+		bo->dirty_end = max(bo->dirty_end, offset + bytes);
+	}
+	if (!list_empty(&bo->vmap_list))
+		list_move_tail(&bo->vmap_list, &vmap_cache_lru);
+	hmm_vmap_stat.deferred++;
+	spin_unlock_irqrestore(&vmap_cache_lock, flags);
+}
+
+/* forget bo before its vmap goes away, writing back what is still dirty */
+static void hmm_vmap_cache_drop(struct hmm_buffer_object *bo)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&vmap_cache_lock, flags);
+	__hmm_vmap_cache_clean(bo);
+	if (!list_empty(&bo->vmap_list)) {
+		list_del_init(&bo->vmap_list);
+		hmm_vmap_stat.pages -= bo->pgnr;
+	}
+	spin_unlock_irqrestore(&vmap_cache_lock, flags);
+}
+
 int hmm_init(void)
 {
 	int ret;
@@ -78,6 +251,8 @@ void hmm_cleanup(void)
 	hmm_free(dummy_ptr);
 	dummy_ptr = 0;
 
+	hmm_vmap_cache_trim(0);
+
 	hmm_bo_device_exit(&bo_device);
 }
 
@@ -155,6 +330,8 @@ void hmm_free(ia_css_ptr virt)
 
 	hmm_mem_stat.tol_cnt -= bo->pgnr;
 
+	hmm_vmap_cache_drop(bo);
+
 	hmm_bo_unbind(bo);
 
 	hmm_bo_free_pages(bo);
@@ -262,17 +439,22 @@ static int load_and_flush(ia_css_ptr virt, void *data, unsigned int bytes)
 	if (ret)
 		return ret;
 
+	if (!(bo->status & (HMM_BO_VMAPED | HMM_BO_VMAPED_CACHED)))
+		hmm_vmap_cache_map(bo);
+
 	if (bo->status & HMM_BO_VMAPED || bo->status & HMM_BO_VMAPED_CACHED) {
 		void *src = bo->vmap_addr;
 
 		src += (virt - bo->vm_node->start);
+		if (data)
 #ifdef USE_SSSE3
-		_ssse3_memcpy(data, src, bytes);
+			_ssse3_memcpy(data, src, bytes);
 #else
-		memcpy(data, src, bytes);
+			memcpy(data, src, bytes);
 #endif
 		if (bo->status & HMM_BO_VMAPED_CACHED)
 			clflush_cache_range(src, bytes);
+		hmm_vmap_cache_touch(bo);
 	} else {
 		void *vptr;
 
@@ -280,10 +462,11 @@ static int load_and_flush(ia_css_ptr virt, void *data, unsigned int bytes)
 		if (!vptr)
 			return load_and_flush_by_kmap(virt, data, bytes);
 
+		if (data)
 #ifdef USE_SSSE3
-		_ssse3_memcpy(data, vptr, bytes);
+			_ssse3_memcpy(data, vptr, bytes);
 #else
-		memcpy(data, vptr, bytes);
+			memcpy(data, vptr, bytes);
 #endif
 		clflush_cache_range(vptr, bytes);
 		hmm_vunmap(virt);
@@ -325,6 +508,9 @@ int hmm_store(ia_css_ptr virt, const void *data, unsigned int bytes)
 	if (ret)
 		return ret;
 
+	if (!(bo->status & (HMM_BO_VMAPED | HMM_BO_VMAPED_CACHED)))
+		hmm_vmap_cache_map(bo);
+
 	if (bo->status & HMM_BO_VMAPED || bo->status & HMM_BO_VMAPED_CACHED) {
 		void *dst = bo->vmap_addr;
 
@@ -335,7 +521,9 @@ int hmm_store(ia_css_ptr virt, const void *data, unsigned int bytes)
 		memcpy(dst, data, bytes);
 #endif
 		if (bo->status & HMM_BO_VMAPED_CACHED)
-			clflush_cache_range(dst, bytes);
+			hmm_vmap_cache_dirty(bo, dst,
+					     virt - bo->vm_node->start, bytes);
+		return 0;
 	} else {
 		void *vptr;
 
@@ -416,6 +604,9 @@ int hmm_set(ia_css_ptr virt, int c, unsigned int bytes)
 	if (ret)
 		return ret;
 
+	if (!(bo->status & (HMM_BO_VMAPED | HMM_BO_VMAPED_CACHED)))
+		hmm_vmap_cache_map(bo);
+
 	if (bo->status & HMM_BO_VMAPED || bo->status & HMM_BO_VMAPED_CACHED) {
 		void *dst = bo->vmap_addr;
 
@@ -423,7 +614,9 @@ int hmm_set(ia_css_ptr virt, int c, unsigned int bytes)
 		memset(dst, c, bytes);
 
 		if (bo->status & HMM_BO_VMAPED_CACHED)
-			clflush_cache_range(dst, bytes);
+			hmm_vmap_cache_dirty(bo, dst,
+					     virt - bo->vm_node->start, bytes);
+		return 0;
 	} else {
 		void *vptr;
 
@@ -519,6 +712,14 @@ void *hmm_vmap(ia_css_ptr virt, bool cached)
 		return NULL;
 	}
 
+	/*
+	 * The caller keeps the mapping until hmm_vunmap(), so take bo off
+	 * the LRU whatever the mapping type: a trim must not unmap it under
+	 * the caller. Stores through the accessors still widen its dirty
+	 * range, and load/store do not put a mapped bo back on the LRU.
+	 */
+	hmm_vmap_cache_drop(bo);
+
 	ptr = hmm_bo_vmap(bo, cached);
 	if (ptr)
 		return ptr + (virt - bo->vm_node->start);
@@ -542,6 +743,21 @@ void hmm_flush_vmap(ia_css_ptr virt)
 	hmm_bo_flush_vmap(bo);
 }
 
+void hmm_flush_cache(ia_css_ptr virt)
+{
+	struct hmm_buffer_object *bo;
+
+	bo = hmm_bo_device_search_in_range(&bo_device, virt);
+	if (!bo) {
+		dev_warn(atomisp_dev,
+			    "can not find buffer object contains address 0x%x\n",
+			    virt);
+		return;
+	}
+
+	hmm_bo_flush_cache(bo);
+}
+
 void hmm_vunmap(ia_css_ptr virt)
 {
 	struct hmm_buffer_object *bo;
@@ -554,6 +770,8 @@ void hmm_vunmap(ia_css_ptr virt)
 		return;
 	}
 
+	hmm_vmap_cache_drop(bo);
+
 	return hmm_bo_vunmap(bo);
 }
 
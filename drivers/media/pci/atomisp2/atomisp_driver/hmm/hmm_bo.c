@@ -133,6 +133,8 @@ int hmm_bo_init(struct hmm_bo_device *bdev,
 	mutex_init(&bo->mutex);
 
 	INIT_LIST_HEAD(&bo->list);
+	INIT_LIST_HEAD(&bo->vmap_list);
+	INIT_LIST_HEAD(&bo->dirty_list);
 
 	bo->pgnr = pgnr;
 	bo->bdev = bdev;
@@ -844,6 +846,9 @@ int hmm_bo_alloc_pages(struct hmm_buffer_object *bo,
 	if (ret)
 		goto alloc_err;
 
+	/* user and ION pages come with whatever caching their owner set */
+	bo->cached = type != HMM_BO_PRIVATE || cached;
+
 	bo->type = type;
 
 	bo->status |= HMM_BO_PAGE_ALLOCED;
@@ -1132,6 +1137,27 @@ void hmm_bo_flush_vmap(struct hmm_buffer_object *bo)
 	mutex_unlock(&bo->mutex);
 }
 
+void hmm_bo_flush_cache(struct hmm_buffer_object *bo)
+{
+	void *vaddr;
+	int i;
+
+	check_bo_null_return_void(bo);
+
+	mutex_lock(&bo->mutex);
+	if (!bo->cached || !(bo->status & HMM_BO_PAGE_ALLOCED)) {
+		mutex_unlock(&bo->mutex);
+		return;
+	}
+
+	for (i = 0; i < bo->pgnr; i++) {
+		vaddr = kmap_atomic(bo->page_obj[i].page);
+		clflush_cache_range(vaddr, PAGE_SIZE);
+		kunmap_atomic(vaddr);
+	}
+	mutex_unlock(&bo->mutex);
+}
+
 void hmm_bo_vunmap(struct hmm_buffer_object *bo)
 {
 	check_bo_null_return_void(bo);
@@ -72,6 +72,26 @@ void hmm_vunmap(ia_css_ptr virt);
  */
 void hmm_flush_vmap(ia_css_ptr virt);
 
+/*
+ * flush the CPU cache for the pages of the buffer containing virt,
+ * before handing it to the ISP. a cheaper alternative to wbinvd().
+ */
+void hmm_flush_cache(ia_css_ptr virt);
+
+/*
+ * write back the CPU cache lines of all deferred hmm_store/hmm_set
+ * ranges. must run before the ISP is told to look at them, i.e.
+ * before any host write to ISP registers or DMEM. cheap when
+ * nothing is pending, and callable from any context.
+ */
+void hmm_flush_dirty(void);
+
+/*
+ * set the page budget of the persistent vmaps, unmapping the least
+ * recently used buffers beyond it. 0 turns them off.
+ */
+void hmm_vmap_cache_set_budget(unsigned int pages);
+
 /*
  * Address translation from ISP shared memory address to kernel virtual address
  * if the memory is not vmmaped,  then do it.
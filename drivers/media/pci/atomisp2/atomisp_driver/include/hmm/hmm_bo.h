@@ -122,7 +122,13 @@ struct hmm_buffer_object {
 #endif
 	int			status;
 	int         mem_type;
+	bool			cached;	/* CPU may hold lines of its pages */
 	void		*vmap_addr; /* kernel virtual address by vmap */
+	/* persistent vmap and deferred flush state, see hmm.c */
+	struct list_head	vmap_list;
+	struct list_head	dirty_list;
+	unsigned int		dirty_start;
+	unsigned int		dirty_end;
 	/*
 	 * release callback for releasing buffer object.
 	 *
@@ -300,6 +306,12 @@ void *hmm_bo_vmap(struct hmm_buffer_object *bo, bool cached);
  */
 void hmm_bo_flush_vmap(struct hmm_buffer_object *bo);
 
+/*
+ * flush the CPU cache lines of the buffer object's pages, one page at
+ * a time. does nothing for uncached private buffers.
+ */
+void hmm_bo_flush_cache(struct hmm_buffer_object *bo);
+
 /*
  * vunmap buffer object's kernel virtual address.
  */
@@ -97,4 +97,28 @@ struct _hmm_mem_stat {
 
 extern struct _hmm_mem_stat hmm_mem_stat;
 
+/*
+ * persistent vmap statistic:
+ *
+ * pages:     pages currently kept vmapped by hmm_load/store/set.
+ * max_pages: budget for pages, 0 disables the persistent vmaps and
+ *	      the deferred flush.
+ * maps:      buffer objects vmapped for good.
+ * evictions: buffer objects unmapped to stay within max_pages.
+ * deferred:  stores and sets whose cache flush was deferred.
+ * handoffs:  flushes of the deferred ranges, one per ISP handoff.
+ * flushed:   bytes written back by those flushes.
+ */
+struct _hmm_vmap_stat {
+	unsigned int pages;
+	unsigned int max_pages;
+	unsigned int maps;
+	unsigned int evictions;
+	unsigned long long deferred;
+	unsigned long long handoffs;
+	unsigned long long flushed;
+};
+
+extern struct _hmm_vmap_stat hmm_vmap_stat;
+
 #endif
@@ -0,0 +1,109 @@
+/*
+ * Host check of the atomisp batched QBUF/DQBUF bookkeeping.
+ *
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+/*
+ * Runs atomisp_buf_batch_result() over the partial failures the batch
+ * ioctls have to report: an entry failing the checks under isp->mutex,
+ * failing in videobuf, or both, at the start, in the middle and at the
+ * end of a batch. For each case done, the result of entry[done] and the
+ * ioctl result must be the expected ones, and no other entry may carry
+ * a result.
+ *
+ * Usage: buf_batch_check
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "atomisp_buf_batch.h"
+
+#define BB_ARRAY_SIZE(a)	(sizeof(a) / sizeof((a)[0]))
+
+static const struct {
+	unsigned int count, prepared;
+	int prep_ret;
+	unsigned int handled;
+	int ret;
+	/* expected */
+	unsigned int done;
+	int result;		/* of entry[done], if done < count */
+	int ioctl_ret;
+} bb_cases[] = {
+	{ 4, 4, 0,       4, 0,       4, 0,       0 },
+	{ 4, 0, -EINVAL, 0, 0,       0, -EINVAL, -EINVAL },
+	{ 4, 2, -EBUSY,  2, 0,       2, -EBUSY,  0 },
+	{ 4, 3, -EINVAL, 3, 0,       3, -EINVAL, 0 },
+	{ 4, 4, 0,       0, -ENOMEM, 0, -ENOMEM, -ENOMEM },
+	{ 4, 4, 0,       2, -EIO,    2, -EIO,    0 },
+	{ 4, 3, -EINVAL, 1, -EIO,    1, -EIO,    0 },
+	{ 4, 2, -EBUSY,  0, -EIO,    0, -EIO,    -EIO },
+	{ 1, 0, -EINVAL, 0, 0,       0, -EINVAL, -EINVAL },
+};
+
+int main(void)
+{
+	static struct atomisp_buf_batch batch;
+	unsigned int errors = 0, i, j;
+	int ret;
+
+	printf("  %-4s %5s %8s %7s %7s %5s %7s\n", "case", "count",
+	       "prepared", "handled", "ret", "done", "result");
+
+	for (i = 0; i < BB_ARRAY_SIZE(bb_cases); i++) {
+		int result;
+
+		memset(&batch, 0, sizeof(batch));
+		batch.count = bb_cases[i].count;
+
+		ret = atomisp_buf_batch_result(&batch, bb_cases[i].prepared,
+					       bb_cases[i].prep_ret,
+					       bb_cases[i].handled,
+					       bb_cases[i].ret);
+		result = batch.done < batch.count ?
+			 batch.entry[batch.done].result : 0;
+		printf("  %-4u %5u %8u %7u %7d %5u %7d\n", i, batch.count,
+		       bb_cases[i].prepared, bb_cases[i].handled, ret,
+		       batch.done, result);
+
+		if (ret != bb_cases[i].ioctl_ret ||
+		    batch.done != bb_cases[i].done ||
+		    (batch.done < batch.count &&
+		     result != bb_cases[i].result)) {
+			fprintf(stderr, "case %u: ret %d done %u result %d, expected ret %d done %u result %d\n",
+				i, ret, batch.done, result,
+				bb_cases[i].ioctl_ret, bb_cases[i].done,
+				bb_cases[i].result);
+			errors++;
+			continue;
+		}
+		for (j = 0; j < batch.count; j++)
+			if (j != batch.done && batch.entry[j].result) {
+				fprintf(stderr, "case %u: entry %u result %d\n",
+					i, j, batch.entry[j].result);
+				errors++;
+				break;
+			}
+	}
+
+	printf("%u errors\n%s\n", errors, errors ? "FAILED" : "PASSED");
+	return errors ? 1 : 0;
+}
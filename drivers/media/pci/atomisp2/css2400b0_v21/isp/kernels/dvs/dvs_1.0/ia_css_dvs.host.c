@@ -27,6 +27,7 @@
 #include "ia_css_host_data.h"
 #include "sh_css_param_dvs.h"
 #include "sh_css_params.h"
+#include "sh_css_internal.h"
 #include "ia_css_binary.h"
 #include "ia_css_debug.h"
 #include "memory_access.h"
@@ -225,16 +226,40 @@ convert_coords_to_ispparams(
 	}
 }
 
+/* Grids with fewer Y blocks are converted on the caller, the workqueue
+ * round trip costs more than it saves.
+ */
+#define DVS_PARALLEL_MIN_BLOCKS	1024
+
+struct dvs_convert_ctx {
+	struct ia_css_host_data *me;
+	const struct ia_css_dvs_6axis_config *config;
+	unsigned int i_stride;
+	unsigned int o_width;
+	unsigned int o_height;
+};
+
+/* uv_flag 0: Y plane, 1: UV plane; they fill disjoint table entries */
+static void
+dvs_convert_plane(void *data, unsigned int uv_flag)
+{
+	struct dvs_convert_ctx *ctx = data;
+
+	convert_coords_to_ispparams(ctx->me, ctx->config,
+				    ctx->i_stride >> uv_flag,
+				    ctx->o_width >> uv_flag,
+				    ctx->o_height >> uv_flag, uv_flag);
+}
+
 struct ia_css_host_data *
 convert_allocate_dvs_6axis_config(
 	struct ia_css_isp_parameters *params,
 	const struct ia_css_binary *binary)
 {
-	unsigned int i_stride;
-	unsigned int o_width;
-	unsigned int o_height;
+	struct dvs_convert_ctx ctx;
 	struct ia_css_host_data *me;
 	struct gdc_warp_param_mem_s *isp_data_ptr;
+	const struct ia_css_dvs_6axis_config *config;
 
 	assert(params != NULL);
 	assert(binary != NULL);
@@ -246,18 +271,22 @@ convert_allocate_dvs_6axis_config(
 		return NULL;
 
 	isp_data_ptr = (struct gdc_warp_param_mem_s *)me->address;
+	config = params->dvs_6axis_config;
+	ctx.me = me;
+	ctx.config = config;
 	/* bgz115: replaced binary->in_frame_info.res.width for
 	   'padded_width=stride' */
-	i_stride  = binary->internal_frame_info.padded_width;
-	o_width  = binary->out_frame_info[0].res.width;
-	o_height = binary->out_frame_info[0].res.height;
-
-	/* Y plane */
-	convert_coords_to_ispparams(me, params->dvs_6axis_config,
-				    i_stride, o_width, o_height, 0);
-	/* UV plane (packed inside the y plane) */
-	convert_coords_to_ispparams(me, params->dvs_6axis_config,
-				    i_stride/2, o_width/2, o_height/2, 1);
+	ctx.i_stride = binary->internal_frame_info.padded_width;
+	ctx.o_width = binary->out_frame_info[0].res.width;
+	ctx.o_height = binary->out_frame_info[0].res.height;
+
+	/* Y plane, then the UV plane (packed inside the y plane) */
+	if (config->width_y * config->height_y >= DVS_PARALLEL_MIN_BLOCKS) {
+		sh_css_parallel_for(2, dvs_convert_plane, &ctx);
+	} else {
+		dvs_convert_plane(&ctx, 0);
+		dvs_convert_plane(&ctx, 1);
+	}
 
 	return me;
 }
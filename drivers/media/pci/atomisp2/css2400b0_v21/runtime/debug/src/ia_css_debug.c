@@ -116,6 +116,54 @@
 /* Global variable to store the dtrace verbosity level */
 unsigned int ia_css_debug_trace_level = IA_CSS_DEBUG_WARNING;
 
+#if defined(__KERNEL__)
+#include <linux/atomic.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+
+struct static_key ia_css_debug_trace_key = STATIC_KEY_INIT_FALSE;
+static bool ia_css_debug_trace_key_on;
+#endif
+
+bool ia_css_debug_trace_ring_enabled;
+
+bool ia_css_debug_param_prof_enabled;
+
+/* Parameter encoder cost per kernel parameter id */
+struct param_prof_stats {
+	uint32_t calls;
+	uint64_t total_ns;
+	uint64_t max_ns;
+};
+
+static struct param_prof_stats param_prof[IA_CSS_NUM_PARAMETER_IDS];
+static uint32_t param_prof_frames;
+
+/* Record flags */
+#define TRACE_RING_ARGS_DROPPED	(1 << 0)	/* args could not be captured */
+
+/* One binary trace record. seq is written last and is 0 for an empty
+ * slot; a reader only trusts a record whose seq is unchanged across the
+ * copy.
+ */
+struct ia_css_debug_trace_rec {
+	uint32_t seq;
+	uint8_t level;
+	uint8_t flags;
+	uint8_t str_mask;	/* bit n: arg n is an offset into str[] */
+	const char *fmt;
+	unsigned long arg[IA_CSS_DEBUG_TRACE_RING_ARGS];
+	char str[IA_CSS_DEBUG_TRACE_RING_STR];
+};
+
+static struct ia_css_debug_trace_rec
+	trace_ring[IA_CSS_DEBUG_TRACE_RING_SIZE];
+#if defined(__KERNEL__)
+static atomic_t trace_ring_head = ATOMIC_INIT(0);
+#else
+static uint32_t trace_ring_head;
+#endif
+
 /* Assumes that IA_CSS_STREAM_FORMAT_BINARY_8 is last */
 #define N_IA_CSS_STREAM_FORMAT (IA_CSS_STREAM_FORMAT_BINARY_8+1)
 
@@ -246,9 +294,259 @@ void ia_css_debug_dump_sp_stack_info(void)
 void ia_css_debug_set_dtrace_level(const unsigned int trace_level)
 {
 	ia_css_debug_trace_level = trace_level;
+#if defined(__KERNEL__)
+	if (trace_level > IA_CSS_DEBUG_WARNING && !ia_css_debug_trace_key_on) {
+		ia_css_debug_trace_key_on = true;
+		static_key_slow_inc(&ia_css_debug_trace_key);
+	} else if (trace_level <= IA_CSS_DEBUG_WARNING &&
+		   ia_css_debug_trace_key_on) {
+		ia_css_debug_trace_key_on = false;
+		static_key_slow_dec(&ia_css_debug_trace_key);
+	}
+#endif
 	return;
 }
 
+/* Capture the arguments of fmt into rec. Only the conversions used by the
+ * CSS traces are understood; anything else drops the arguments and the
+ * record is later printed as the bare format string.
+ */
+static void trace_ring_capture_args(struct ia_css_debug_trace_rec *rec,
+				    const char *fmt, va_list args)
+{
+	unsigned int n = 0, str_len = 0;
+	const char *p = fmt;
+
+	while (*p) {
+		unsigned int lng = 0;
+
+		if (*p++ != '%')
+			continue;
+		if (*p == '%') {
+			p++;
+			continue;
+		}
+		while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' ||
+		       *p == '0')
+			p++;
+		/* '*' width and precision consume an int argument */
+		for (;;) {
+			if (*p == '*') {
+				if (n == IA_CSS_DEBUG_TRACE_RING_ARGS)
+					goto dropped;
+				rec->arg[n++] = (unsigned long)va_arg(args, int);
+				p++;
+			}
+			while (*p >= '0' && *p <= '9')
+				p++;
+			if (*p != '.')
+				break;
+			p++;
+		}
+		while (*p == 'h')
+			p++;
+		while (*p == 'l') {
+			lng++;
+			p++;
+		}
+		if (*p == 'z' || *p == 't') {
+			lng = 1;
+			p++;
+		}
+		if (n == IA_CSS_DEBUG_TRACE_RING_ARGS)
+			goto dropped;
+
+		switch (*p++) {
+		case 'd':
+		case 'i':
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'o':
+		case 'c':
+			if (lng > 1 &&
+			    sizeof(long long) > sizeof(unsigned long))
+				goto dropped;
+			if (lng > 1)
+				rec->arg[n++] = (unsigned long)
+						va_arg(args, long long);
+			else if (lng)
+				rec->arg[n++] = va_arg(args, unsigned long);
+			else
+				rec->arg[n++] = va_arg(args, unsigned int);
+			break;
+		case 'p':
+			rec->arg[n++] = (unsigned long)va_arg(args, void *);
+			break;
+		case 's': {
+			const char *str = va_arg(args, const char *);
+			unsigned int len;
+
+			if (!str)
+				str = "(null)";
+			len = strnlen(str, IA_CSS_DEBUG_TRACE_RING_STR - 1 -
+					   str_len);
+			memcpy(&rec->str[str_len], str, len);
+			rec->str[str_len + len] = '\0';
+			rec->str_mask |= 1 << n;
+			rec->arg[n++] = str_len;
+			str_len += len;
+			/* keep room for the terminator of the next string */
+			if (str_len < IA_CSS_DEBUG_TRACE_RING_STR - 1)
+				str_len++;
+			break;
+		}
+		default:
+			goto dropped;
+		}
+	}
+	return;
+
+dropped:
+	rec->flags |= TRACE_RING_ARGS_DROPPED;
+}
+
+void
+ia_css_debug_trace_ring_record(unsigned int level, const char *fmt,
+			       va_list args)
+{
+	struct ia_css_debug_trace_rec *rec;
+	uint32_t seq;
+
+#if defined(__KERNEL__)
+	seq = (uint32_t)atomic_inc_return(&trace_ring_head);
+#else
+	seq = ++trace_ring_head;
+#endif
+	rec = &trace_ring[(seq - 1) & (IA_CSS_DEBUG_TRACE_RING_SIZE - 1)];
+
+	rec->seq = 0;
+#if defined(__KERNEL__)
+	smp_wmb();
+#endif
+	rec->level = (uint8_t)level;
+	rec->flags = 0;
+	rec->str_mask = 0;
+	rec->fmt = fmt;
+	trace_ring_capture_args(rec, fmt, args);
+#if defined(__KERNEL__)
+	smp_wmb();
+#endif
+	rec->seq = seq;
+}
+
+void ia_css_debug_trace_ring_enable(bool enable)
+{
+	ia_css_debug_trace_ring_enabled = enable;
+}
+
+void ia_css_debug_param_prof_enable(bool enable)
+{
+	if (enable && !ia_css_debug_param_prof_enabled) {
+		memset(param_prof, 0, sizeof(param_prof));
+		param_prof_frames = 0;
+	}
+	ia_css_debug_param_prof_enabled = enable;
+}
+
+uint64_t ia_css_debug_param_prof_clock(void)
+{
+#if defined(__KERNEL__)
+	return (uint64_t)ktime_to_ns(ktime_get());
+#else
+	return 0;
+#endif
+}
+
+void ia_css_debug_param_prof_record(unsigned int param_id, uint64_t ns)
+{
+	struct param_prof_stats *st;
+
+	if (param_id >= IA_CSS_NUM_PARAMETER_IDS)
+		return;
+
+	st = &param_prof[param_id];
+	st->calls++;
+	st->total_ns += ns;
+	if (ns > st->max_ns)
+		st->max_ns = ns;
+}
+
+void ia_css_debug_param_prof_frame(void)
+{
+	param_prof_frames++;
+}
+
+void ia_css_debug_dump_param_prof(void)
+{
+	unsigned int i;
+	uint32_t frames = param_prof_frames ? param_prof_frames : 1;
+
+	ia_css_debug_dtrace(2, "Parameter encoder profile, %u frames:\n",
+			    param_prof_frames);
+	ia_css_debug_dtrace(2, "\t%-8s %10s %14s %14s\n",
+			    "param_id", "calls", "ns/frame", "max ns");
+	for (i = 0; i < IA_CSS_NUM_PARAMETER_IDS; i++) {
+		const struct param_prof_stats *st = &param_prof[i];
+		uint64_t per_frame;
+
+		if (st->calls == 0)
+			continue;
+#if defined(__KERNEL__)
+		per_frame = div_u64(st->total_ns, frames);
+#else
+		per_frame = st->total_ns / frames;
+#endif
+		ia_css_debug_dtrace(2, "\t%-8u %10u %14lu %14lu\n", i,
+				    st->calls, (unsigned long)per_frame,
+				    (unsigned long)st->max_ns);
+	}
+}
+
+void ia_css_debug_trace_ring_dump(void)
+{
+	struct ia_css_debug_trace_rec rec;
+	unsigned long *a = rec.arg;
+	uint32_t head, seq, i;
+
+#if defined(__KERNEL__)
+	head = (uint32_t)atomic_read(&trace_ring_head);
+#else
+	head = trace_ring_head;
+#endif
+	seq = head > IA_CSS_DEBUG_TRACE_RING_SIZE ?
+		head - IA_CSS_DEBUG_TRACE_RING_SIZE + 1 : 1;
+
+	sh_css_print("trace ring: %u records, showing from %u\n", head, seq);
+	for (; seq && seq <= head; seq++) {
+		const struct ia_css_debug_trace_rec *slot =
+			&trace_ring[(seq - 1) & (IA_CSS_DEBUG_TRACE_RING_SIZE - 1)];
+
+		if (slot->seq != seq)
+			continue;
+#if defined(__KERNEL__)
+		smp_rmb();
+#endif
+		rec = *slot;
+#if defined(__KERNEL__)
+		smp_rmb();
+#endif
+		/* overwritten while copying */
+		if (slot->seq != seq)
+			continue;
+
+		sh_css_print("[%u:%u] ", seq, rec.level);
+		if (rec.flags & TRACE_RING_ARGS_DROPPED) {
+			sh_css_print("(args dropped) %s", rec.fmt);
+			continue;
+		}
+		for (i = 0; i < IA_CSS_DEBUG_TRACE_RING_ARGS; i++)
+			if (rec.str_mask & (1 << i))
+				a[i] = (unsigned long)&rec.str[a[i]];
+		sh_css_print(rec.fmt, a[0], a[1], a[2], a[3], a[4], a[5]);
+	}
+}
+
 unsigned int ia_css_debug_get_dtrace_level(void)
 {
 	return ia_css_debug_trace_level;
@@ -39,26 +39,44 @@ static ibuf_handle_t *getHandle(uint16_t index)
 	return handle;
 }
 
-void ia_css_isys_ibuf_rmgr_init(void)
+/* Reset to a single free segment spanning the whole input buffer */
+static void ibuf_rmgr_reset(void)
 {
 	memset(&ibuf_rsrc, 0, sizeof(ibuf_rsrc));
+	ibuf_rsrc.handles[0].start_addr = 0;
+	ibuf_rsrc.handles[0].size = MAX_INPUT_BUFFER_SIZE;
+	ibuf_rsrc.handles[0].active = false;
+	ibuf_rsrc.num_allocated = 1;
 	ibuf_rsrc.free_size = MAX_INPUT_BUFFER_SIZE;
 }
 
+/* Remove the segment at index, the caller accounts for its space */
+static void ibuf_rmgr_remove_handle(uint16_t index)
+{
+	uint16_t i;
+
+	for (i = index; i + 1 < ibuf_rsrc.num_allocated; i++)
+		ibuf_rsrc.handles[i] = ibuf_rsrc.handles[i + 1];
+	ibuf_rsrc.num_allocated--;
+}
+
+void ia_css_isys_ibuf_rmgr_init(void)
+{
+	ibuf_rmgr_reset();
+}
+
 void ia_css_isys_ibuf_rmgr_uninit(void)
 {
-	memset(&ibuf_rsrc, 0, sizeof(ibuf_rsrc));
-	ibuf_rsrc.free_size = MAX_INPUT_BUFFER_SIZE;
+	ibuf_rmgr_reset();
 }
 
 bool ia_css_isys_ibuf_rmgr_acquire(
 	uint32_t	size,
 	uint32_t	*start_addr)
 {
-	bool retval = false;
-	bool input_buffer_found = false;
 	uint32_t aligned_size;
 	ibuf_handle_t *handle = NULL;
+	uint16_t best = MAX_IBUF_HANDLES;
 	uint16_t i;
 
 	assert(start_addr != NULL);
@@ -66,49 +84,49 @@ bool ia_css_isys_ibuf_rmgr_acquire(
 
 	aligned_size = (size + (IBUF_ALIGN - 1)) & ~(IBUF_ALIGN - 1);
 
-	/* Check if there is an available un-used handle with the size
-	 * that will fulfill the request.
+	if (ibuf_rsrc.free_size < aligned_size)
+		return false;
+
+	/* Best fit: the smallest free segment that holds the request, so
+	 * large segments stay available for large line buffers.
 	 */
-	if (ibuf_rsrc.num_active < ibuf_rsrc.num_allocated) {
-		for (i = 0; i < ibuf_rsrc.num_allocated; i++) {
-			handle = getHandle(i);
-			if (!handle->active) {
-				if (handle->size >= aligned_size) {
-					handle->active = true;
-					input_buffer_found = true;
-					ibuf_rsrc.num_active++;
-					break;
-				}
-			}
-		}
+	for (i = 0; i < ibuf_rsrc.num_allocated; i++) {
+		handle = getHandle(i);
+		if (handle->active || handle->size < aligned_size)
+			continue;
+		if (best == MAX_IBUF_HANDLES ||
+		    handle->size < ibuf_rsrc.handles[best].size)
+			best = i;
+		if (handle->size == aligned_size)
+			break;
 	}
 
-	if (!input_buffer_found) {
-		/* There were no available handles that fulfilled the
-		 * request. Allocate a new handle with the requested size.
-		 */
-		if ((ibuf_rsrc.num_allocated < MAX_IBUF_HANDLES) &&
-		    (ibuf_rsrc.free_size >= aligned_size)) {
-			handle = getHandle(ibuf_rsrc.num_allocated);
-			handle->start_addr	= ibuf_rsrc.free_start_addr;
-			handle->size		= aligned_size;
-			handle->active		= true;
-
-			ibuf_rsrc.free_start_addr += aligned_size;
-			ibuf_rsrc.free_size -= aligned_size;
-			ibuf_rsrc.num_active++;
-			ibuf_rsrc.num_allocated++;
-
-			input_buffer_found = true;
-		}
-	}
+	if (best == MAX_IBUF_HANDLES)
+		return false;
+
+	handle = getHandle(best);
 
-	if (input_buffer_found && handle) {
-		*start_addr = handle->start_addr;
-		retval = true;
+	/* Split off the remainder as a new free segment. Without a spare
+	 * handle the whole segment is handed out instead.
+	 */
+	if (handle->size > aligned_size &&
+	    ibuf_rsrc.num_allocated < MAX_IBUF_HANDLES) {
+		for (i = ibuf_rsrc.num_allocated; i > best + 1; i--)
+			ibuf_rsrc.handles[i] = ibuf_rsrc.handles[i - 1];
+		ibuf_rsrc.handles[best + 1].start_addr =
+			handle->start_addr + aligned_size;
+		ibuf_rsrc.handles[best + 1].size = handle->size - aligned_size;
+		ibuf_rsrc.handles[best + 1].active = false;
+		ibuf_rsrc.num_allocated++;
+		handle->size = aligned_size;
 	}
 
-	return retval;
+	handle->active = true;
+	ibuf_rsrc.free_size -= handle->size;
+	ibuf_rsrc.num_active++;
+
+	*start_addr = handle->start_addr;
+	return true;
 }
 
 void ia_css_isys_ibuf_rmgr_release(
@@ -122,11 +140,34 @@ void ia_css_isys_ibuf_rmgr_release(
 	for (i = 0; i < ibuf_rsrc.num_allocated; i++) {
 		handle = getHandle(i);
 		if ((handle->start_addr == *start_addr)
-		    && ( true == handle->active)) {
-			handle->active = false;
-			ibuf_rsrc.num_active--;
+		    && ( true == handle->active))
 			break;
-		}
+	}
+
+	if (i == ibuf_rsrc.num_allocated)
+		return;
+
+	handle->active = false;
+	ibuf_rsrc.free_size += handle->size;
+	ibuf_rsrc.num_active--;
+
+	/* Defragment on idle: with no buffer in use the whole input
+	 * buffer is one free segment again.
+	 */
+	if (ibuf_rsrc.num_active == 0) {
+		ibuf_rmgr_reset();
+		return;
+	}
+
+	/* Coalesce with the free neighbours */
+	if (i + 1 < ibuf_rsrc.num_allocated &&
+	    !ibuf_rsrc.handles[i + 1].active) {
+		handle->size += ibuf_rsrc.handles[i + 1].size;
+		ibuf_rmgr_remove_handle(i + 1);
+	}
+	if (i > 0 && !ibuf_rsrc.handles[i - 1].active) {
+		ibuf_rsrc.handles[i - 1].size += handle->size;
+		ibuf_rmgr_remove_handle(i);
 	}
 }
 #endif
@@ -38,6 +38,9 @@
 #include "ia_css_isp_configs.h"
 #include "ia_css_isp_states.h"
 
+/* Most bytes an Adler-32 run can take before its sums need reducing */
+#define FW_HEADER_SUM_RUN	5552U
+
 #define _STR(x) #x
 #define STR(x) _STR(x)
 
@@ -71,6 +74,18 @@ unsigned		  sh_css_num_binaries; /* This includes 1 SP binary */
 
 static struct fw_param *fw_minibuffer;
 
+/*
+ * Identifies the firmware package the binary descriptors above were
+ * parsed from, so that they can be reused for it without parsing again.
+ */
+static struct {
+	bool valid;
+	unsigned int fw_size;
+	char version[64];
+	int binary_nr;
+	uint32_t header_sum;
+} fw_index;
+
 
 char *sh_css_get_fw_version(void)
 {
@@ -192,6 +207,66 @@ sh_css_load_blob_info(const char *fw, const struct ia_css_fw_info *bi, struct ia
 	return IA_CSS_SUCCESS;
 }
 
+/* Sum of the package header and all binary headers, not the binaries */
+static uint32_t
+fw_header_sum(const char *fw_data, int binary_nr)
+{
+	const unsigned char *p = (const unsigned char *)fw_data;
+	unsigned int size = sizeof(struct sh_css_fw_bi_file_h) +
+			    binary_nr * sizeof(struct ia_css_fw_info);
+	uint32_t a = 1, b = 0;
+
+	/* b cannot overflow in FW_HEADER_SUM_RUN bytes, reduce once per run */
+	while (size) {
+		unsigned int run = min(size, FW_HEADER_SUM_RUN);
+
+		size -= run;
+		while (run--) {
+			a += *p++;
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+	}
+	return (b << 16) | a;
+}
+
+bool
+sh_css_firmware_index_match(const char *fw_data, unsigned int fw_size)
+{
+	const struct sh_css_fw_bi_file_h *file_header =
+		(const struct sh_css_fw_bi_file_h *)fw_data;
+
+	if (!fw_index.valid || fw_data == NULL ||
+	    fw_size != fw_index.fw_size ||
+	    fw_size < sizeof(struct sh_css_fw_bi_file_h))
+		return false;
+
+	if (file_header->binary_nr != fw_index.binary_nr ||
+	    strncmp(file_header->version, fw_index.version,
+		    sizeof(fw_index.version)) != 0)
+		return false;
+
+	return fw_header_sum(fw_data, fw_index.binary_nr) ==
+		fw_index.header_sum;
+}
+
+/* Point the kept binary descriptors at a new copy of the same package */
+void
+sh_css_firmware_index_rebase(const char *fw_data)
+{
+	unsigned int i;
+
+	firmware_header = (struct firmware_header *)fw_data;
+
+	for (i = NUM_OF_SPS; i < sh_css_num_binaries; i++) {
+		struct ia_css_blob_descr *bd = &sh_css_blob_info[i-NUM_OF_SPS];
+
+		bd->blob = (const unsigned char *)fw_data +
+			   bd->header.blob.offset;
+	}
+}
+
 bool
 sh_css_check_firmware_version(const char *fw_data)
 {
@@ -299,11 +374,19 @@ sh_css_load_firmware(const char *fw_data,
 		}
 	}
 
+	fw_index.fw_size = fw_size;
+	memcpy(fw_index.version, file_header->version,
+	       sizeof(fw_index.version));
+	fw_index.binary_nr = file_header->binary_nr;
+	fw_index.header_sum = fw_header_sum(fw_data, file_header->binary_nr);
+	fw_index.valid = true;
+
 	return IA_CSS_SUCCESS;
 }
 
 void sh_css_unload_firmware(void)
 {
+	fw_index.valid = false;
 
 	/* release firmware minibuffer */
 	if (fw_minibuffer) {
@@ -26,6 +26,9 @@
 #include "isp.h"
 
 #include "sh_css_internal.h"
+#include "sh_css_firmware.h"
+#include "sh_css_sp.h"
+#include "ia_css_binary.h"
 
 #define MULTIPLE_PCS 0
 #define SUSPEND      0
@@ -183,3 +186,52 @@ sh_css_metrics_sample_pcs(void)
 			sp_histogram->run[pc]++;
 	}
 }
+
+bool
+sh_css_metrics_sample_isp(unsigned int *binary_id, unsigned int *pc,
+			  bool *stall)
+{
+	const struct ia_css_fw_info *fw = &sh_css_sp_fw;
+	unsigned int HIVE_ADDR_pipeline_sp_curr_binary_id;
+	uint32_t curr_binary_id;
+
+	assert(binary_id != NULL);
+	assert(pc != NULL);
+	assert(stall != NULL);
+
+	/* if the SP is not running we should not access its dmem */
+	if (!sh_css_sp_is_running() ||
+	    isp_ctrl_getbit(ISP0_ID, ISP_SC_REG, ISP_IDLE_BIT))
+		return false;
+
+	HIVE_ADDR_pipeline_sp_curr_binary_id = fw->info.sp.curr_binary_id;
+	(void)HIVE_ADDR_pipeline_sp_curr_binary_id;
+
+	sp_dmem_load(SP0_ID,
+		     (unsigned int)sp_address_of(pipeline_sp_curr_binary_id),
+		     &curr_binary_id, sizeof(curr_binary_id));
+
+	/* the SP reports pipe id << 16 | binary id */
+	*binary_id = curr_binary_id & 0xffff;
+	*pc = isp_ctrl_load(ISP0_ID, ISP_PC_REG);
+	*stall = isp_ctrl_load(ISP0_ID, ISP_CTRL_SINK_REG) != 0x7FF;
+
+	return true;
+}
+
+const char *
+sh_css_metrics_binary_name(unsigned int binary_id)
+{
+	struct ia_css_binary_xinfo *binaries;
+	uint32_t num_binaries;
+	uint32_t i;
+
+	ia_css_binary_get_isp_binaries(&binaries, &num_binaries);
+
+	for (i = 0; i < num_binaries; i++) {
+		if (binaries[i].sp.id == binary_id && binaries[i].blob)
+			return binaries[i].blob->name;
+	}
+
+	return NULL;
+}
@@ -25,6 +25,19 @@
 #include <ia_css_types.h>
 #include <ia_css_binary.h>
 
+/* The geometry prepare_shading_table() converts a table to: the binary's
+ * input resolution and padding, scaled by the sensor binning, and the
+ * size of its shading table.
+ */
+struct sh_css_shading_geometry {
+	unsigned int input_width;
+	unsigned int input_height;
+	unsigned int left_padding;
+	unsigned int right_padding;
+	unsigned int table_width;
+	unsigned int table_height;
+};
+
 void
 sh_css_params_shading_id_table_generate(
 	struct ia_css_shading_table **target_table,
@@ -36,5 +49,15 @@ prepare_shading_table(const struct ia_css_shading_table *in_table,
 		      struct ia_css_shading_table **target_table,
 		      const struct ia_css_binary *binary);
 
+/* The table prepared converted in_table to for binary, or NULL when it
+ * was prepared for another table or geometry.
+ */
+const struct ia_css_shading_table *
+sh_css_shading_prepared_lookup(
+	const struct ia_css_shading_prepared *prepared,
+	const struct ia_css_shading_table *in_table,
+	unsigned int sensor_binning,
+	const struct ia_css_binary *binary);
+
 #endif /* __SH_CSS_PARAMS_SHADING_H */
 
@@ -68,6 +68,25 @@ ia_css_load_firmware(const struct ia_css_env *env,
 void
 ia_css_unload_firmware(void);
 
+/** @brief Unloads the firmware binaries but keeps the firmware index
+ * @return	None
+ *
+ * This function frees the ISP memory copies of the binaries loaded by
+ * ia_css_load_firmware, but keeps the binary descriptors parsed from the
+ * firmware package. A following ia_css_load_firmware with the same
+ * firmware package only copies the binaries again and skips parsing and
+ * validating it. ia_css_unload_firmware frees the index as well.
+ */
+void
+ia_css_unload_firmware_blobs(void);
+
+/** @brief Tells how the last firmware load went
+ * @return	Returns true when the last ia_css_load_firmware reused the
+ *		index kept by ia_css_unload_firmware_blobs.
+ */
+bool
+ia_css_firmware_indexed(void);
+
 /** @brief Checks firmware version
  * @param[in]	fw	Firmware package containing the firmware for all
  *			predefined ISP binaries.
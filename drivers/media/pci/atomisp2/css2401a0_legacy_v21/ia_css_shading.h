@@ -27,6 +27,7 @@
  */
 
 #include <ia_css_types.h>
+#include "ia_css_err.h"
 
 /** @brief Shading table
  * @param[in]	width Width of the shading table.
@@ -44,4 +45,38 @@ ia_css_shading_table_alloc(unsigned int width,
 void
 ia_css_shading_table_free(struct ia_css_shading_table *table);
 
+struct ia_css_stream;
+
+/** @brief Record what a shading table is converted to for a stream
+ * @param[in]	stream The stream the table is for.
+ * @param[in]	table Pointer to the shading table.
+ * @return		Pointer to the prepared table, NULL when the stream
+ *			does not convert shading tables or has no stages yet.
+ *
+ * This takes the geometry of the shading correction binaries of the
+ * stream; call it like the other stream calls. The conversion itself is
+ * done by ia_css_shading_prepared_convert(), which only reads table and
+ * can run concurrently with any other call. Pass the result in
+ * ia_css_isp_config.shading_prepared together with table; a binary the
+ * stream no longer has converts table when the parameters are written.
+ * The table must stay valid until the prepared table is freed.
+*/
+struct ia_css_shading_prepared *
+ia_css_shading_prepare(const struct ia_css_stream *stream,
+		       const struct ia_css_shading_table *table);
+
+/** @brief Convert a prepared shading table
+ * @param[in]	prepared Pointer to the prepared table.
+ * @return		IA_CSS_SUCCESS or IA_CSS_ERR_CANNOT_ALLOCATE_MEMORY.
+*/
+enum ia_css_err
+ia_css_shading_prepared_convert(struct ia_css_shading_prepared *prepared);
+
+/** @brief Free a prepared shading table
+ * @param[in]	prepared Pointer to the prepared table.
+ * @return		None
+*/
+void
+ia_css_shading_prepared_free(struct ia_css_shading_prepared *prepared);
+
 #endif /* __IA_CSS_SHADING_H */
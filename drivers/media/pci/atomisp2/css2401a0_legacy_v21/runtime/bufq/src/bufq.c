@@ -203,6 +203,22 @@ static void unmap_buffer_type_to_queue_id(
 	assert(buffer_type_to_queue_id_map[thread_id][buf_type] != SH_CSS_INVALID_QUEUE_ID);
 
 	queue_id = buffer_type_to_queue_id_map[thread_id][buf_type];
+
+	/* The queue is unmapped once the thread has stopped; drop the buffers
+	 * it did not pick up, so that the next pipe on this thread does not
+	 * get them. Parameter sets are refcounted and stay until uninit.
+	 */
+	if (buf_type != IA_CSS_BUFFER_TYPE_PARAMETER_SET &&
+	    buf_type != IA_CSS_BUFFER_TYPE_PER_FRAME_PARAMETER_SET) {
+		ia_css_queue_t *q;
+		uint32_t item;
+
+		q = bufq_get_qhandle(sh_css_host2sp_buffer_queue,
+				     queue_id, thread_id);
+		while (q && ia_css_queue_dequeue(q, &item) == 0)
+			;
+	}
+
 	buffer_type_to_queue_id_map[thread_id][buf_type] = SH_CSS_INVALID_QUEUE_ID;
 	queue_availability[thread_id][queue_id] = true;
 }
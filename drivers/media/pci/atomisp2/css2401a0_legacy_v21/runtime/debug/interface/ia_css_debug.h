@@ -52,6 +52,45 @@
 /* Global variable which controls the verbosity levels of the debug tracing */
 extern unsigned int ia_css_debug_trace_level;
 
+/*! Compile-time ceiling for dtrace; messages above it are compiled out */
+#ifndef IA_CSS_DEBUG_TRACE_LEVEL_MAX
+#define IA_CSS_DEBUG_TRACE_LEVEL_MAX IA_CSS_DEBUG_INFO
+#endif
+
+/* Messages above WARNING are additionally gated by a static key, which
+ * is only switched on while the runtime level is above WARNING. With the
+ * default level those call sites reduce to a patched-out jump.
+ */
+#if defined(__KERNEL__)
+#include <linux/jump_label.h>
+extern struct static_key ia_css_debug_trace_key;
+#define ia_css_debug_trace_key_enabled() \
+	static_key_false(&ia_css_debug_trace_key)
+#else
+#define ia_css_debug_trace_key_enabled() true
+#endif
+
+/*! Evaluates to true when a message of the given level is traced.
+ * Level is expected to be a constant or a side-effect free expression.
+ */
+#define ia_css_debug_dtrace_enabled(level) \
+	((level) <= IA_CSS_DEBUG_TRACE_LEVEL_MAX && \
+	 ((level) <= IA_CSS_DEBUG_WARNING || \
+	  ia_css_debug_trace_key_enabled()) && \
+	 ia_css_debug_trace_level >= (level))
+
+/*! Number of records in the binary trace ring, must be a power of two */
+#define IA_CSS_DEBUG_TRACE_RING_SIZE	512
+/*! Maximum number of format arguments captured per record */
+#define IA_CSS_DEBUG_TRACE_RING_ARGS	6
+/*! Bytes reserved per record for copies of %s arguments */
+#define IA_CSS_DEBUG_TRACE_RING_STR	48
+
+/* When set, traced messages are stored in the trace ring instead of
+ * being printed.
+ */
+extern bool ia_css_debug_trace_ring_enabled;
+
 /*! @brief Enum defining the different isp parameters to dump.
  *  Values can be combined to dump a combination of sets.
  */
@@ -132,16 +171,24 @@ enum ia_css_debug_enable_param_dump {
  * @param[in]	fmt		printf like format string
  * @param[in]	args		arguments for the format string
  */
+void
+ia_css_debug_trace_ring_record(unsigned int level, const char *fmt,
+			       va_list args);
+
 STORAGE_CLASS_INLINE void
 ia_css_debug_vdtrace(unsigned int level, const char *fmt, va_list args)
 {
-	if (ia_css_debug_trace_level >= level)
-		sh_css_vprint(fmt, args);
+	if (ia_css_debug_trace_level >= level) {
+		if (ia_css_debug_trace_ring_enabled)
+			ia_css_debug_trace_ring_record(level, fmt, args);
+		else
+			sh_css_vprint(fmt, args);
+	}
 }
 
 #ifndef __SP
 STORAGE_CLASS_INLINE void
-ia_css_debug_dtrace(unsigned int level, const char *fmt, ...)
+ia_css_debug_dtrace_print(unsigned int level, const char *fmt, ...)
 {
 	va_list ap;
 
@@ -149,8 +196,63 @@ ia_css_debug_dtrace(unsigned int level, const char *fmt, ...)
 	ia_css_debug_vdtrace(level, fmt, ap);
 	va_end(ap);
 }
+
+/*! @brief Trace a message at the given level.
+ * The level is checked before the arguments are evaluated, so disabled
+ * messages cost a compare (or nothing, above the compile-time ceiling).
+ */
+#define ia_css_debug_dtrace(level, fmt, ...) \
+do { \
+	if (ia_css_debug_dtrace_enabled(level)) \
+		ia_css_debug_dtrace_print(level, fmt, ##__VA_ARGS__); \
+} while (0)
 #endif
 
+/*! @brief Enable or disable the binary trace ring.
+ * While enabled, traced messages are recorded as format pointer plus
+ * arguments and only formatted when the ring is dumped.
+ * @param[in]	enable		true to record into the ring.
+ * @return	None
+ */
+void ia_css_debug_trace_ring_enable(bool enable);
+
+/*! @brief Print the trace ring contents, oldest record first.
+ * @return	None
+ */
+void ia_css_debug_trace_ring_dump(void);
+
+/* Set while the cost of the per-kernel parameter encoders is profiled */
+extern bool ia_css_debug_param_prof_enabled;
+
+/*! @brief Enable or disable parameter encoder profiling.
+ * Enabling clears the statistics collected so far.
+ * @param[in]	enable		true to start profiling.
+ * @return	None
+ */
+void ia_css_debug_param_prof_enable(bool enable);
+
+/*! @brief Current host time used for parameter encoder profiling.
+ * @return	time in ns, 0 when the platform offers no clock
+ */
+uint64_t ia_css_debug_param_prof_clock(void);
+
+/*! @brief Account one run of a kernel parameter encoder.
+ * @param[in]	param_id	Kernel parameter id.
+ * @param[in]	ns		Time spent in the encoder.
+ * @return	None
+ */
+void ia_css_debug_param_prof_record(unsigned int param_id, uint64_t ns);
+
+/*! @brief Account one committed parameter set.
+ * @return	None
+ */
+void ia_css_debug_param_prof_frame(void);
+
+/*! @brief Dump the encoder cost per kernel, as ns per committed set.
+ * @return	None
+ */
+void ia_css_debug_dump_param_prof(void);
+
 /*! @brief Dump sp thread's stack contents
  * SP thread's stack contents are set to 0xcafecafe. This function dumps the
  * stack to inspect if the stack's boundaries are compromised.
@@ -53,6 +53,12 @@ sh_css_load_firmware(const char *fw_data,
 
 void sh_css_unload_firmware(void);
 
+bool
+sh_css_firmware_index_match(const char *fw_data, unsigned int fw_size);
+
+void
+sh_css_firmware_index_rebase(const char *fw_data);
+
 hrt_vaddress sh_css_load_blob(const unsigned char *blob, unsigned size);
 
 enum ia_css_err
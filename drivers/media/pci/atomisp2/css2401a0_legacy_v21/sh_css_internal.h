@@ -1039,6 +1039,15 @@ sh_css_calloc(size_t N, size_t size);
 void
 sh_css_free(void *ptr);
 
+/* Run fn(ctx, i) for i in [0, n). In the kernel the calls are spread over
+ * the unbound workqueue; fn must be safe to run concurrently for different
+ * i and must not take locks held by the caller.
+ */
+void
+sh_css_parallel_for(unsigned int n,
+		    void (*fn)(void *ctx, unsigned int i),
+		    void *ctx);
+
 /* For Acceleration API: Flush FW (shared buffer pointer) arguments */
 void
 sh_css_flush(struct ia_css_acc_fw *fw);
@@ -1085,6 +1094,19 @@ sh_css_store_sp_stage_to_ddr(unsigned pipe, unsigned stage);
 hrt_vaddress
 sh_css_store_isp_stage_to_ddr(unsigned pipe, unsigned stage);
 
+/* Traffic of the sp group/stage descriptor stores above. A frame ends
+ * with the store of the sp group.
+ */
+struct sh_css_sp_desc_store_stats {
+	uint32_t frame_bytes;		/* bytes written in the current frame */
+	uint32_t last_frame_bytes;	/* bytes written in the last frame */
+	uint64_t total_bytes;		/* bytes written since init */
+	uint64_t skipped_bytes;		/* unchanged bytes not rewritten */
+};
+
+void
+sh_css_get_sp_desc_store_stats(struct sh_css_sp_desc_store_stats *stats);
+
 
 void
 sh_css_update_uds_and_crop_info(
@@ -25,6 +25,9 @@
 #include "assert_support.h"
 #include "sh_css_defs.h"
 #include "sh_css_internal.h"
+#include "sh_css_params.h"
+#include "ia_css_stream.h"
+#include "ia_css_pipeline.h"
 #include "ia_css_debug.h"
 
 #include "sh_css_hrt.h"
@@ -224,75 +227,252 @@ sh_css_params_shading_id_table_generate(
 	*target_table = result;
 }
 
-void
-prepare_shading_table(const struct ia_css_shading_table *in_table,
-		      unsigned int sensor_binning,
-		      struct ia_css_shading_table **target_table,
-		      const struct ia_css_binary *binary)
-{
-	unsigned int input_width,
-		     input_height,
-		     table_width,
-		     table_height,
-		     left_padding,
-		     right_padding,
-		     i;
+/* Tables with fewer cells per color are interpolated on the caller, the
+ * workqueue round trip costs more than it saves.
+ */
+#define SHADING_PARALLEL_MIN_CELLS	1024
+
+struct shading_interp_ctx {
+	unsigned int input_width;
+	unsigned int input_height;
+	unsigned int left_padding;
+	unsigned int right_padding;
+	const struct ia_css_shading_table *in_table;
 	struct ia_css_shading_table *result;
+};
 
-	assert(target_table != NULL);
-	assert(binary != NULL);
+static void
+shading_interp_color(void *data, unsigned int color)
+{
+	struct shading_interp_ctx *ctx = data;
 
-	if (!in_table) {
-		sh_css_params_shading_id_table_generate(target_table, binary);
-		return;
-	}
+	crop_and_interpolate(ctx->input_width, ctx->input_height,
+			     ctx->left_padding, ctx->right_padding,
+			     ctx->in_table, ctx->result, color);
+}
 
+/* What the conversion of a shading table takes from the binary it is for */
+static void
+shading_geometry_get(const struct ia_css_binary *binary,
+		     unsigned int sensor_binning,
+		     struct sh_css_shading_geometry *geo)
+{
 	/* We use the ISP input resolution for the shading table because
 	   shading correction is performed in the bayer domain (before bayer
 	   down scaling). */
-	input_height  = binary->in_frame_info.res.height;
-	input_width   = binary->in_frame_info.res.width;
-	left_padding  = binary->left_padding;
-	right_padding = binary->in_frame_info.padded_width -
-			(input_width + left_padding);
+	geo->input_height  = binary->in_frame_info.res.height;
+	geo->input_width   = binary->in_frame_info.res.width;
+	geo->left_padding  = binary->left_padding;
+	geo->right_padding = binary->in_frame_info.padded_width -
+			     (geo->input_width + geo->left_padding);
 
 	/* We take into account the binning done by the sensor. We do this
 	   by cropping the non-binned part of the shading table and then
 	   increasing the size of a grid cell with this same binning factor. */
-	input_width  <<= sensor_binning;
-	input_height <<= sensor_binning;
+	geo->input_width  <<= sensor_binning;
+	geo->input_height <<= sensor_binning;
 	/* We also scale the padding by the same binning factor. This will
 	   make it much easier later on to calculate the padding of the
 	   shading table. */
-	left_padding  <<= sensor_binning;
-	right_padding <<= sensor_binning;
+	geo->left_padding  <<= sensor_binning;
+	geo->right_padding <<= sensor_binning;
+
+	geo->table_width  = binary->sctbl_width_per_color;
+	geo->table_height = binary->sctbl_height;
+}
+
+static struct ia_css_shading_table *
+shading_table_convert(const struct ia_css_shading_table *in_table,
+		      const struct sh_css_shading_geometry *geo)
+{
+	unsigned int input_width,
+		     input_height,
+		     i;
+	struct ia_css_shading_table *result;
 
 	/* during simulation, the used resolution can exceed the sensor
 	   resolution, so we clip it. */
-	input_width  = min(input_width,  in_table->sensor_width);
-	input_height = min(input_height, in_table->sensor_height);
-
-	table_width  = binary->sctbl_width_per_color;
-	table_height = binary->sctbl_height;
+	input_width  = min(geo->input_width,  in_table->sensor_width);
+	input_height = min(geo->input_height, in_table->sensor_height);
 
-	result = ia_css_shading_table_alloc(table_width, table_height);
-	if (result == NULL) {
-		*target_table = NULL;
-		return;
-	}
+	result = ia_css_shading_table_alloc(geo->table_width,
+					    geo->table_height);
+	if (result == NULL)
+		return NULL;
 	result->sensor_width  = in_table->sensor_width;
 	result->sensor_height = in_table->sensor_height;
 	result->fraction_bits = in_table->fraction_bits;
 
 	/* now we crop the original shading table and then interpolate to the
-	   requested resolution and decimation factor. */
-	for (i = 0; i < IA_CSS_SC_NUM_COLORS; i++) {
-		crop_and_interpolate(input_width, input_height,
-				     left_padding, right_padding,
-				     in_table,
-				     result, i);
+	   requested resolution and decimation factor. The color planes are
+	   independent and are done in parallel for large tables. */
+	if (geo->table_width * geo->table_height >=
+	    SHADING_PARALLEL_MIN_CELLS) {
+		struct shading_interp_ctx ctx = {
+			input_width, input_height,
+			geo->left_padding, geo->right_padding,
+			in_table, result
+		};
+
+		sh_css_parallel_for(IA_CSS_SC_NUM_COLORS,
+				    shading_interp_color, &ctx);
+	} else {
+		for (i = 0; i < IA_CSS_SC_NUM_COLORS; i++) {
+			crop_and_interpolate(input_width, input_height,
+					     geo->left_padding,
+					     geo->right_padding,
+					     in_table,
+					     result, i);
+		}
 	}
-	*target_table = result;
+	return result;
+}
+
+void
+prepare_shading_table(const struct ia_css_shading_table *in_table,
+		      unsigned int sensor_binning,
+		      struct ia_css_shading_table **target_table,
+		      const struct ia_css_binary *binary)
+{
+	struct sh_css_shading_geometry geo;
+
+	assert(target_table != NULL);
+	assert(binary != NULL);
+
+	if (!in_table) {
+		sh_css_params_shading_id_table_generate(target_table, binary);
+		return;
+	}
+
+	shading_geometry_get(binary, sensor_binning, &geo);
+	*target_table = shading_table_convert(in_table, &geo);
+}
+
+/* Binaries with shading correction a stream can convert a table for
+ * ahead of time; any further ones convert it when the parameters are
+ * written, as without a prepared table.
+ */
+#define SH_CSS_SC_MAX_PREPARED	IA_CSS_PIPE_ID_NUM
+
+struct ia_css_shading_prepared {
+	const struct ia_css_shading_table *table;
+	unsigned int num_tables;
+	struct sh_css_shading_geometry geometry[SH_CSS_SC_MAX_PREPARED];
+	struct ia_css_shading_table *converted[SH_CSS_SC_MAX_PREPARED];
+};
+
+struct ia_css_shading_prepared *
+ia_css_shading_prepare(const struct ia_css_stream *stream,
+		       const struct ia_css_shading_table *table)
+{
+	const struct ia_css_isp_parameters *params;
+	struct ia_css_shading_prepared *me;
+	int i;
+
+	if (stream == NULL || table == NULL || !table->enable)
+		return NULL;
+	params = stream->isp_params_configs;
+	/* without conversion the table is stored as it is */
+	if (params == NULL ||
+	    params->shading_settings.enable_shading_table_conversion == 0)
+		return NULL;
+
+	IA_CSS_ENTER("stream=%p, table=%p", stream, table);
+
+	me = sh_css_malloc(sizeof(*me));
+	if (me == NULL) {
+		IA_CSS_ERROR("out of memory");
+		return NULL;
+	}
+	memset(me, 0, sizeof(*me));
+	me->table = table;
+
+	for (i = 0; i < stream->num_pipes; i++) {
+		const struct ia_css_pipeline *pipeline =
+			ia_css_pipe_get_pipeline(stream->pipes[i]);
+		const struct ia_css_pipeline_stage *stage;
+
+		for (stage = pipeline->stages; stage; stage = stage->next) {
+			struct sh_css_shading_geometry geo;
+			unsigned int j;
+
+			if (!stage->binary ||
+			    !stage->binary->info->sp.enable.sc)
+				continue;
+
+			shading_geometry_get(stage->binary,
+					     params->sensor_binning, &geo);
+			for (j = 0; j < me->num_tables; j++) {
+				if (!memcmp(&me->geometry[j], &geo, sizeof(geo)))
+					break;
+			}
+			if (j == me->num_tables &&
+			    me->num_tables < SH_CSS_SC_MAX_PREPARED)
+				me->geometry[me->num_tables++] = geo;
+		}
+	}
+
+	/* the stream has no stages yet, they convert at its start */
+	if (me->num_tables == 0) {
+		sh_css_free(me);
+		me = NULL;
+	}
+
+	IA_CSS_LEAVE("prepared=%p", me);
+	return me;
+}
+
+enum ia_css_err
+ia_css_shading_prepared_convert(struct ia_css_shading_prepared *prepared)
+{
+	unsigned int i;
+
+	assert(prepared != NULL);
+
+	for (i = 0; i < prepared->num_tables; i++) {
+		if (prepared->converted[i])
+			continue;
+		prepared->converted[i] = shading_table_convert(
+			prepared->table, &prepared->geometry[i]);
+		if (prepared->converted[i] == NULL)
+			return IA_CSS_ERR_CANNOT_ALLOCATE_MEMORY;
+	}
+	return IA_CSS_SUCCESS;
+}
+
+void
+ia_css_shading_prepared_free(struct ia_css_shading_prepared *prepared)
+{
+	unsigned int i;
+
+	if (prepared == NULL)
+		return;
+
+	for (i = 0; i < prepared->num_tables; i++)
+		ia_css_shading_table_free(prepared->converted[i]);
+	sh_css_free(prepared);
+}
+
+const struct ia_css_shading_table *
+sh_css_shading_prepared_lookup(
+	const struct ia_css_shading_prepared *prepared,
+	const struct ia_css_shading_table *in_table,
+	unsigned int sensor_binning,
+	const struct ia_css_binary *binary)
+{
+	struct sh_css_shading_geometry geo;
+	unsigned int i;
+
+	if (prepared == NULL || in_table == NULL ||
+	    prepared->table != in_table)
+		return NULL;
+
+	shading_geometry_get(binary, sensor_binning, &geo);
+	for (i = 0; i < prepared->num_tables; i++) {
+		if (!memcmp(&prepared->geometry[i], &geo, sizeof(geo)))
+			return prepared->converted[i];
+	}
+	return NULL;
 }
 
 struct ia_css_shading_table *
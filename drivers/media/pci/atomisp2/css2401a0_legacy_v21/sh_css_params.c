@@ -157,6 +157,19 @@ static hrt_vaddress xmem_sp_stage_ptrs[IA_CSS_PIPE_ID_NUM]
 static hrt_vaddress xmem_isp_stage_ptrs[IA_CSS_PIPE_ID_NUM]
 						[SH_CSS_MAX_STAGES];
 
+/* Host copies of what was last stored to the sp group/stage buffers
+ * above. Descriptors are compared against these in chunks and only the
+ * chunks that changed are written to DDR.
+ */
+#define SP_DESC_CHUNK_BYTES	(2 * HIVE_ISP_DDR_WORD_BYTES)
+
+static struct sh_css_sp_group *sp_group_shadow;
+static struct sh_css_sp_stage *sp_stage_shadow[IA_CSS_PIPE_ID_NUM]
+						[SH_CSS_MAX_STAGES];
+static struct sh_css_isp_stage *isp_stage_shadow[IA_CSS_PIPE_ID_NUM]
+						[SH_CSS_MAX_STAGES];
+static struct sh_css_sp_desc_store_stats sp_desc_store_stats;
+
 /* END DO NOT MOVE INTO VIMALS_WORLD */
 
 /* Digital Zoom lookup table. See documentation for more details about the
@@ -2722,6 +2735,7 @@ sh_css_init_isp_params_from_config(struct ia_css_pipe *pipe,
 	sh_css_set_dz_config(params, config->dz_config);
 	sh_css_set_motion_vector(params, config->motion_vector);
 	sh_css_set_shading_table(pipe->stream, params, config->shading_table);
+	params->sc_prepared = config->shading_prepared;
 	sh_css_set_morph_table(params, config->morph_table);
 	sh_css_set_macc_table(params, config->macc_table);
 	sh_css_set_gamma_table(params, config->gamma_table);
@@ -3417,8 +3431,16 @@ sh_css_params_init(void)
 					    mmgr_calloc(1,
 					    sizeof(struct sh_css_isp_stage)));
 
+			/* zeroed like the DDR buffers they mirror */
+			sp_stage_shadow[p][i] = sh_css_calloc(1,
+					    sizeof(struct sh_css_sp_stage));
+			isp_stage_shadow[p][i] = sh_css_calloc(1,
+					    sizeof(struct sh_css_isp_stage));
+
 			if ((xmem_sp_stage_ptrs[p][i] == mmgr_NULL) ||
-			    (xmem_isp_stage_ptrs[p][i] == mmgr_NULL)) {
+			    (xmem_isp_stage_ptrs[p][i] == mmgr_NULL) ||
+			    (sp_stage_shadow[p][i] == NULL) ||
+			    (isp_stage_shadow[p][i] == NULL)) {
 				sh_css_params_uninit();
 				IA_CSS_LEAVE_ERR_PRIVATE(IA_CSS_ERR_CANNOT_ALLOCATE_MEMORY);
 				return IA_CSS_ERR_CANNOT_ALLOCATE_MEMORY;
@@ -3438,9 +3460,12 @@ sh_css_params_init(void)
 			 HIVE_ISP_DDR_WORD_BYTES)));
 	xmem_sp_group_ptrs = ia_css_refcount_increment(-1, mmgr_calloc(1,
 		sizeof(struct sh_css_sp_group)));
+	sp_group_shadow = sh_css_calloc(1, sizeof(struct sh_css_sp_group));
+	memset(&sp_desc_store_stats, 0, sizeof(sp_desc_store_stats));
 
 	if ((sp_ddr_ptrs == mmgr_NULL) ||
-	    (xmem_sp_group_ptrs == mmgr_NULL)) {
+	    (xmem_sp_group_ptrs == mmgr_NULL) ||
+	    (sp_group_shadow == NULL)) {
 		ia_css_uninit();
 		IA_CSS_LEAVE_ERR_PRIVATE(IA_CSS_ERR_CANNOT_ALLOCATE_MEMORY);
 		return IA_CSS_ERR_CANNOT_ALLOCATE_MEMORY;
@@ -3592,6 +3617,10 @@ sh_css_params_uninit(void)
 	sp_ddr_ptrs = mmgr_NULL;
 	ia_css_refcount_decrement(-1, xmem_sp_group_ptrs);
 	xmem_sp_group_ptrs = mmgr_NULL;
+	if (sp_group_shadow) {
+		sh_css_free(sp_group_shadow);
+		sp_group_shadow = NULL;
+	}
 
 	for (p = 0; p < IA_CSS_PIPE_ID_NUM; p++)
 		for (i = 0; i < SH_CSS_MAX_STAGES; i++) {
@@ -3599,6 +3628,14 @@ sh_css_params_uninit(void)
 			xmem_sp_stage_ptrs[p][i] = mmgr_NULL;
 			ia_css_refcount_decrement(-1, xmem_isp_stage_ptrs[p][i]);
 			xmem_isp_stage_ptrs[p][i] = mmgr_NULL;
+			if (sp_stage_shadow[p][i]) {
+				sh_css_free(sp_stage_shadow[p][i]);
+				sp_stage_shadow[p][i] = NULL;
+			}
+			if (isp_stage_shadow[p][i]) {
+				sh_css_free(isp_stage_shadow[p][i]);
+				isp_stage_shadow[p][i] = NULL;
+			}
 		}
 
 	/* go through the pools to clear references */
@@ -3658,27 +3695,71 @@ convert_allocate_morph_plane(
 	return me;
 }
 
+/* Tables with fewer cells per plane are converted on the caller, the
+ * workqueue round trip costs more than it saves.
+ */
+#define MORPH_PARALLEL_MIN_CELLS	1024
+
+#define MORPH_NUM_COORD_PLANES	(2 * IA_CSS_MORPH_TABLE_NUM_PLANES)
+
+struct morph_convert_ctx {
+	const struct ia_css_morph_table *table;
+	unsigned int aligned_width;
+	struct ia_css_host_data *isp_data[MORPH_NUM_COORD_PLANES];
+};
+
+/* even i: x coordinates of plane i / 2, odd i: its y coordinates */
+static void
+morph_convert_plane(void *data, unsigned int i)
+{
+	struct morph_convert_ctx *ctx = data;
+	const struct ia_css_morph_table *table = ctx->table;
+
+	ctx->isp_data[i] = convert_allocate_morph_plane(
+		(i & 1) ? table->coordinates_y[i / 2] :
+			  table->coordinates_x[i / 2],
+		table->width, table->height, ctx->aligned_width);
+}
+
+/* The planes are independent and are converted in parallel for large
+ * tables; the stores to DDR stay in order on the caller.
+ */
 static enum ia_css_err
-store_morph_plane(
-	unsigned short *data,
-	unsigned int width,
-	unsigned int height,
-	hrt_vaddress dest,
+store_morph_table(
+	const struct ia_css_morph_table *table,
+	hrt_vaddress *virt_addr_tetra_x[],
+	hrt_vaddress *virt_addr_tetra_y[],
 	unsigned int aligned_width)
 {
-	struct ia_css_host_data *isp_data;
+	struct morph_convert_ctx ctx;
+	enum ia_css_err err = IA_CSS_SUCCESS;
+	unsigned int i;
 
-	assert(dest != mmgr_NULL);
+	ctx.table = table;
+	ctx.aligned_width = aligned_width;
 
-	isp_data = convert_allocate_morph_plane(data, width, height, aligned_width);
-	if (!isp_data) {
-		IA_CSS_LEAVE_ERR_PRIVATE(IA_CSS_ERR_CANNOT_ALLOCATE_MEMORY);
-		return IA_CSS_ERR_CANNOT_ALLOCATE_MEMORY;
+	if (table->width * table->height >= MORPH_PARALLEL_MIN_CELLS) {
+		sh_css_parallel_for(MORPH_NUM_COORD_PLANES,
+				    morph_convert_plane, &ctx);
+	} else {
+		for (i = 0; i < MORPH_NUM_COORD_PLANES; i++)
+			morph_convert_plane(&ctx, i);
 	}
-	ia_css_params_store_ia_css_host_data(dest, isp_data);
 
-	ia_css_host_data_free(isp_data);
-	return IA_CSS_SUCCESS;
+	for (i = 0; i < MORPH_NUM_COORD_PLANES; i++) {
+		hrt_vaddress dest = (i & 1) ? *virt_addr_tetra_y[i / 2] :
+					      *virt_addr_tetra_x[i / 2];
+
+		if (!ctx.isp_data[i]) {
+			err = IA_CSS_ERR_CANNOT_ALLOCATE_MEMORY;
+			continue;
+		}
+		assert(dest != mmgr_NULL);
+		ia_css_params_store_ia_css_host_data(dest, ctx.isp_data[i]);
+		ia_css_host_data_free(ctx.isp_data[i]);
+	}
+
+	return err;
 }
 
 #endif
@@ -3793,6 +3874,25 @@ void ia_css_dequeue_param_buffers(/*unsigned int pipe_num*/)
 	IA_CSS_LEAVE_PRIVATE("void");
 }
 
+/* Run the parameter encoder of one kernel, timed while profiling */
+static void
+process_kernel_param(unsigned param_id, unsigned int pipe_id,
+		     struct ia_css_pipeline_stage *stage,
+		     struct ia_css_isp_parameters *params)
+{
+	uint64_t start;
+
+	if (!ia_css_debug_param_prof_enabled) {
+		ia_css_kernel_process_param[param_id](pipe_id, stage, params);
+		return;
+	}
+
+	start = ia_css_debug_param_prof_clock();
+	ia_css_kernel_process_param[param_id](pipe_id, stage, params);
+	ia_css_debug_param_prof_record(param_id,
+			ia_css_debug_param_prof_clock() - start);
+}
+
 static void
 process_kernel_parameters(unsigned int pipe_id,
 			  struct ia_css_pipeline_stage *stage,
@@ -3829,7 +3929,7 @@ process_kernel_parameters(unsigned int pipe_id,
 		if (param_id == IA_CSS_SC_ID) continue;
 #endif
 		if (params->config_changed[param_id])
-			ia_css_kernel_process_param[param_id](pipe_id, stage, params);
+			process_kernel_param(param_id, pipe_id, stage, params);
 	}
 }
 
@@ -3865,9 +3965,12 @@ sh_css_param_update_isp_params(struct ia_css_pipe *curr_pipe,
 
 	/* now make the map available to the sp */
 	if (!commit) {
+		params->sc_prepared = NULL;
 		IA_CSS_LEAVE_ERR_PRIVATE(err);
 		return err;
 	}
+	if (ia_css_debug_param_prof_enabled)
+		ia_css_debug_param_prof_frame();
 	/* enqueue a copies of the mem_map to
 	   the designated pipelines */
 	for (i = 0; i < curr_pipe->stream->num_pipes; i++) {
@@ -4068,6 +4171,7 @@ sh_css_param_update_isp_params(struct ia_css_pipe *curr_pipe,
 	for all pipelines have been updated */
 	params->isp_params_changed = false;
 	params->sc_table_changed = false;
+	params->sc_prepared = NULL;
 	params->dis_coef_table_changed = false;
 	params->dvs2_coef_table_changed = false;
 	params->morph_table_changed = false;
@@ -4234,7 +4338,7 @@ sh_css_params_write_to_ddr_internal(
 					}
 					/* set sc_config to isp */
 					params->sc_config = (struct ia_css_shading_table *)params->sc_table;
-					ia_css_kernel_process_param[IA_CSS_SC_ID](pipe_id, stage, params);
+					process_kernel_param(IA_CSS_SC_ID, pipe_id, stage, params);
 					params->sc_config = NULL;
 				} else {
 					/* generate the identical shading table */
@@ -4256,7 +4360,7 @@ sh_css_params_write_to_ddr_internal(
 					}
 
 					/* set sc_config to isp */
-					ia_css_kernel_process_param[IA_CSS_SC_ID](pipe_id, stage, params);
+					process_kernel_param(IA_CSS_SC_ID, pipe_id, stage, params);
 
 					/* free the shading table */
 					ia_css_shading_table_free(params->sc_config);
@@ -4264,34 +4368,55 @@ sh_css_params_write_to_ddr_internal(
 				}
 			} else { /* legacy */
 /* ------ deprecated(bz675) : from ------ */
+				const struct ia_css_shading_table *prepared;
+
 				/* shading table is full resolution, reduce */
 				if (params->sc_config) {
 					ia_css_shading_table_free(params->sc_config);
 					params->sc_config = NULL;
 				}
-				prepare_shading_table(
-					(const struct ia_css_shading_table *)params->sc_table,
+				/* converted by the caller, outside its lock */
+				prepared = sh_css_shading_prepared_lookup(
+					params->sc_prepared,
+					params->sc_table,
 					params->sensor_binning,
-					&params->sc_config,
 					binary);
-				if (params->sc_config == NULL) {
-					IA_CSS_LEAVE_ERR_PRIVATE(IA_CSS_ERR_CANNOT_ALLOCATE_MEMORY);
-					return IA_CSS_ERR_CANNOT_ALLOCATE_MEMORY;
-				}
+				if (prepared) {
+					/* store the shading table to ddr */
+					err = ia_css_params_store_sctbl(stage, ddr_map->sc_tbl, prepared);
+					if (err != IA_CSS_SUCCESS) {
+						IA_CSS_LEAVE_ERR_PRIVATE(err);
+						return err;
+					}
+					/* set sc_config to isp */
+					params->sc_config = (struct ia_css_shading_table *)prepared;
+					process_kernel_param(IA_CSS_SC_ID, pipe_id, stage, params);
+					params->sc_config = NULL;
+				} else {
+					prepare_shading_table(
+						(const struct ia_css_shading_table *)params->sc_table,
+						params->sensor_binning,
+						&params->sc_config,
+						binary);
+					if (params->sc_config == NULL) {
+						IA_CSS_LEAVE_ERR_PRIVATE(IA_CSS_ERR_CANNOT_ALLOCATE_MEMORY);
+						return IA_CSS_ERR_CANNOT_ALLOCATE_MEMORY;
+					}
 
-				/* store the shading table to ddr */
-				err = ia_css_params_store_sctbl(stage, ddr_map->sc_tbl, params->sc_config);
-				if (err != IA_CSS_SUCCESS) {
-					IA_CSS_LEAVE_ERR_PRIVATE(err);
-					return err;
-				}
+					/* store the shading table to ddr */
+					err = ia_css_params_store_sctbl(stage, ddr_map->sc_tbl, params->sc_config);
+					if (err != IA_CSS_SUCCESS) {
+						IA_CSS_LEAVE_ERR_PRIVATE(err);
+						return err;
+					}
 
-				/* set sc_config to isp */
-				ia_css_kernel_process_param[IA_CSS_SC_ID](pipe_id, stage, params);
+					/* set sc_config to isp */
+					process_kernel_param(IA_CSS_SC_ID, pipe_id, stage, params);
 
-				/* free the shading table */
-				ia_css_shading_table_free(params->sc_config);
-				params->sc_config = NULL;
+					/* free the shading table */
+					ia_css_shading_table_free(params->sc_config);
+					params->sc_config = NULL;
+				}
 /* ------ deprecated(bz675) : to ------ */
 			}
 		}
@@ -4464,20 +4589,16 @@ sh_css_params_write_to_ddr_internal(
 				table = id_table;
 			}
 
-			for (i = 0; i < IA_CSS_MORPH_TABLE_NUM_PLANES; i++) {
-				store_morph_plane(table->coordinates_x[i],
-					table->width,
-					table->height,
-					*virt_addr_tetra_x[i],
-					binary->morph_tbl_aligned_width);
-				store_morph_plane(table->coordinates_y[i],
-					table->width,
-					table->height,
-					*virt_addr_tetra_y[i],
+			err = store_morph_table(table,
+					virt_addr_tetra_x,
+					virt_addr_tetra_y,
 					binary->morph_tbl_aligned_width);
-			}
 			if (id_table != NULL)
 				ia_css_morph_table_free(id_table);
+			if (err != IA_CSS_SUCCESS) {
+				IA_CSS_LEAVE_ERR_PRIVATE(err);
+				return err;
+			}
 		}
 	}
 #endif /* !defined(IS_ISP_2500_SYSTEM) */
@@ -4635,12 +4756,59 @@ struct ia_css_shading_table *ia_css_get_shading_table(struct ia_css_stream *stre
 }
 
 
+/* Write the chunks of desc that differ from shadow to DDR and update
+ * shadow. Without a shadow the whole descriptor is written.
+ */
+static void
+store_sp_desc_changes(hrt_vaddress ddr, void *shadow, const void *desc,
+		      size_t size)
+{
+	const char *src = desc;
+	char *dst = shadow;
+	size_t offset = 0, written = 0;
+
+	if (dst == NULL) {
+		mmgr_store(ddr, desc, size);
+		written = size;
+		goto out;
+	}
+
+	while (offset < size) {
+		size_t start, len;
+
+		len = min(SP_DESC_CHUNK_BYTES, size - offset);
+		if (memcmp(src + offset, dst + offset, len) == 0) {
+			offset += len;
+			continue;
+		}
+		/* extend over consecutive dirty chunks */
+		start = offset;
+		do {
+			offset += len;
+			len = min(SP_DESC_CHUNK_BYTES, size - offset);
+		} while (offset < size &&
+			 memcmp(src + offset, dst + offset, len) != 0);
+
+		mmgr_store(ddr + start, src + start, offset - start);
+		memcpy(dst + start, src + start, offset - start);
+		written += offset - start;
+	}
+
+out:
+	sp_desc_store_stats.frame_bytes += written;
+	sp_desc_store_stats.total_bytes += written;
+	sp_desc_store_stats.skipped_bytes += size - written;
+}
+
 hrt_vaddress sh_css_store_sp_group_to_ddr(void)
 {
 	IA_CSS_ENTER_LEAVE_PRIVATE("void");
-	mmgr_store(xmem_sp_group_ptrs,
-			     &sh_css_sp_group,
-			     sizeof(struct sh_css_sp_group));
+	store_sp_desc_changes(xmem_sp_group_ptrs, sp_group_shadow,
+			      &sh_css_sp_group,
+			      sizeof(struct sh_css_sp_group));
+	/* The group is stored last, close the accounting for this frame */
+	sp_desc_store_stats.last_frame_bytes = sp_desc_store_stats.frame_bytes;
+	sp_desc_store_stats.frame_bytes = 0;
 	return xmem_sp_group_ptrs;
 }
 
@@ -4649,9 +4817,10 @@ hrt_vaddress sh_css_store_sp_stage_to_ddr(
 	unsigned stage)
 {
 	IA_CSS_ENTER_LEAVE_PRIVATE("void");
-	mmgr_store(xmem_sp_stage_ptrs[pipe][stage],
-			     &sh_css_sp_stage,
-			     sizeof(struct sh_css_sp_stage));
+	store_sp_desc_changes(xmem_sp_stage_ptrs[pipe][stage],
+			      sp_stage_shadow[pipe][stage],
+			      &sh_css_sp_stage,
+			      sizeof(struct sh_css_sp_stage));
 	return xmem_sp_stage_ptrs[pipe][stage];
 }
 
@@ -4660,12 +4829,20 @@ hrt_vaddress sh_css_store_isp_stage_to_ddr(
 	unsigned stage)
 {
 	IA_CSS_ENTER_LEAVE_PRIVATE("void");
-	mmgr_store(xmem_isp_stage_ptrs[pipe][stage],
-			     &sh_css_isp_stage,
-			     sizeof(struct sh_css_isp_stage));
+	store_sp_desc_changes(xmem_isp_stage_ptrs[pipe][stage],
+			      isp_stage_shadow[pipe][stage],
+			      &sh_css_isp_stage,
+			      sizeof(struct sh_css_isp_stage));
 	return xmem_isp_stage_ptrs[pipe][stage];
 }
 
+void
+sh_css_get_sp_desc_store_stats(struct sh_css_sp_desc_store_stats *stats)
+{
+	assert(stats != NULL);
+	*stats = sp_desc_store_stats;
+}
+
 static enum ia_css_err ref_sh_css_ddr_address_map(
 	struct sh_css_ddr_address_map *map,
 	struct sh_css_ddr_address_map *out)
@@ -69,6 +69,9 @@ struct ia_css_isp_parameters {
 	struct ia_css_vector	    motion_config;
 	const struct ia_css_morph_table   *morph_table;
 	const struct ia_css_shading_table *sc_table;
+	/* sc_table converted outside the caller's lock, only valid until
+	 * the parameters it came with are written */
+	const struct ia_css_shading_prepared *sc_prepared;
 	struct ia_css_shading_table *sc_config;
 	struct ia_css_macc_table    macc_table;
 	struct ia_css_gamma_table   gc_table;
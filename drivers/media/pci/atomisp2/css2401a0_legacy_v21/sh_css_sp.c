@@ -74,6 +74,10 @@ struct sh_css_sp_stage		sh_css_sp_stage;
 struct sh_css_isp_stage		sh_css_isp_stage;
 struct sh_css_sp_output		sh_css_sp_output;
 static struct sh_css_sp_per_frame_data per_frame_data;
+/* Copy of per_frame_data as last stored in SP dmem */
+static struct sh_css_sp_per_frame_data per_frame_data_stored;
+static unsigned int per_frame_data_stored_addr;
+static bool per_frame_data_stored_valid;
 
 /* true if SP supports frame loop and host2sp_commands */
 /* For the moment there is only code that sets this bool to true */
@@ -166,10 +170,19 @@ store_sp_per_frame_data(const struct ia_css_fw_info *fw)
 		return;
 	}
 
+	if (per_frame_data_stored_valid &&
+	    HIVE_ADDR_sp_per_frame_data == per_frame_data_stored_addr &&
+	    memcmp(&per_frame_data, &per_frame_data_stored,
+		   sizeof(per_frame_data)) == 0)
+		return;
+
 	sp_dmem_store(SP0_ID,
 		(unsigned int)sp_address_of(sp_per_frame_data),
 		&per_frame_data,
 			sizeof(per_frame_data));
+	per_frame_data_stored = per_frame_data;
+	per_frame_data_stored_addr = HIVE_ADDR_sp_per_frame_data;
+	per_frame_data_stored_valid = true;
 }
 
 static void
@@ -1716,6 +1729,9 @@ sh_css_sp_start_isp(void)
 	/* no longer here, sp started immediately */
 	/*ia_css_debug_pipe_graph_dump_epilogue();*/
 
+	/* dmem was reloaded with the sp firmware */
+	per_frame_data_stored_valid = false;
+
 	store_sp_group_data();
 	store_sp_per_frame_data(fw);
 
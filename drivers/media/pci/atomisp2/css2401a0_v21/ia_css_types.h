@@ -431,6 +431,9 @@ struct ia_css_isp_config {
 							[GC2, 2only] */
 	struct ia_css_vector      *motion_vector; /**< For 2-axis DVS */
 	struct ia_css_shading_table *shading_table;
+	struct ia_css_shading_prepared *shading_prepared; /**< shading_table
+							converted ahead of
+							time (optional) */
 	struct ia_css_morph_table   *morph_table;
 	struct ia_css_dvs_coefficients *dvs_coefs; /**< DVS 1.0 coefficients */
 	struct ia_css_dvs2_coefficients *dvs2_coefs; /**< DVS 2.0 coefficients */
@@ -26,6 +26,10 @@
 #define MAX_INPUT_BUFFER_SIZE	(64 * 1024)
 #define IBUF_ALIGN		8
 
+/* A handle describes one segment of the input buffer; inactive handles
+ * are free segments. The handles[] table is kept sorted by start_addr
+ * and together the segments cover the whole input buffer.
+ */
 typedef struct ibuf_handle_s ibuf_handle_t;
 struct ibuf_handle_s {
 	uint32_t	start_addr;
@@ -35,10 +39,9 @@ struct ibuf_handle_s {
 
 typedef struct ibuf_rsrc_s ibuf_rsrc_t;
 struct ibuf_rsrc_s {
-	uint32_t	free_start_addr;
-	uint32_t	free_size;
+	uint32_t	free_size;	/* sum of all free segments */
 	uint16_t	num_active;
-	uint16_t	num_allocated;
+	uint16_t	num_allocated;	/* number of segments in handles[] */
 	ibuf_handle_t	handles[MAX_IBUF_HANDLES];
 };
 
@@ -183,6 +183,9 @@ static struct ia_css_rmgr_vbuf_handle *hmm_buffer_record_h[MAX_HMM_BUFFER_NUM];
 #define GPIO_FLASH_PIN_MASK (1 << HIVE_GPIO_STROBE_TRIGGER_PIN)
 
 static bool fw_explicitly_loaded = false;
+/* binaries freed, firmware index kept by ia_css_unload_firmware_blobs */
+static bool fw_index_only = false;
+static bool fw_index_hit = false;
 
 /**
  * Local prototypes
@@ -272,6 +275,13 @@ static enum ia_css_err
 alloc_continuous_frames(
 	struct ia_css_pipe *pipe, bool init_time);
 
+static void
+cont_frame_pool_put_multiple(unsigned int num_frames,
+			     struct ia_css_frame **frames_array);
+
+static void
+cont_frame_pool_flush(void);
+
 static void
 pipe_global_init(void);
 
@@ -1543,12 +1553,30 @@ ia_css_unload_firmware(void)
 	if (sh_css_num_binaries)
 	{
 		/* we have already loaded before so get rid of the old stuff */
-		ia_css_binary_uninit();
+		if (!fw_index_only)
+			ia_css_binary_uninit();
 		sh_css_unload_firmware();
 	}
+	fw_index_only = false;
+	fw_explicitly_loaded = false;
+}
+
+void
+ia_css_unload_firmware_blobs(void)
+{
+	if (sh_css_num_binaries && !fw_index_only) {
+		ia_css_binary_uninit();
+		fw_index_only = true;
+	}
 	fw_explicitly_loaded = false;
 }
 
+bool
+ia_css_firmware_indexed(void)
+{
+	return fw_index_hit;
+}
+
 static void
 ia_css_reset_defaults(struct sh_css* css)
 {
@@ -1610,12 +1638,26 @@ ia_css_load_firmware(const struct ia_css_env *env,
 		my_css.flush = env->cpu_mem_env.flush;
 	}
 
-	ia_css_unload_firmware(); /* in case we are called twice */
-	err = sh_css_load_firmware(fw->data, fw->bytes);
-	if (err == IA_CSS_SUCCESS) {
+	fw_index_hit = fw_index_only &&
+		       sh_css_firmware_index_match(fw->data, fw->bytes);
+	if (fw_index_hit) {
+		/* same package as before, only the binaries need copying */
+		sh_css_firmware_index_rebase(fw->data);
 		err = ia_css_binary_init_infos();
-		if (err == IA_CSS_SUCCESS)
+		if (err == IA_CSS_SUCCESS) {
+			fw_index_only = false;
 			fw_explicitly_loaded = true;
+		} else {
+			ia_css_binary_uninit();
+		}
+	} else {
+		ia_css_unload_firmware(); /* in case we are called twice */
+		err = sh_css_load_firmware(fw->data, fw->bytes);
+		if (err == IA_CSS_SUCCESS) {
+			err = ia_css_binary_init_infos();
+			if (err == IA_CSS_SUCCESS)
+				fw_explicitly_loaded = true;
+		}
 	}
 
 	ia_css_debug_dtrace(IA_CSS_DEBUG_TRACE, "ia_css_load_firmware() leave \n");
@@ -1953,6 +1995,68 @@ sh_css_free(void *ptr)
 	IA_CSS_LEAVE_PRIVATE("void");
 }
 
+#if defined(__KERNEL__)
+#include <linux/workqueue.h>
+
+/* Upper bound on the work items queued by one sh_css_parallel_for() */
+#define SH_CSS_PARALLEL_MAX_WORKERS	8
+
+struct sh_css_parallel_work {
+	struct work_struct work;
+	void (*fn)(void *ctx, unsigned int i);
+	void *ctx;
+	unsigned int i;
+};
+
+static void sh_css_parallel_work_fn(struct work_struct *work)
+{
+	struct sh_css_parallel_work *pw =
+		container_of(work, struct sh_css_parallel_work, work);
+
+	pw->fn(pw->ctx, pw->i);
+}
+
+void
+sh_css_parallel_for(unsigned int n,
+		    void (*fn)(void *ctx, unsigned int i),
+		    void *ctx)
+{
+	struct sh_css_parallel_work pw[SH_CSS_PARALLEL_MAX_WORKERS];
+	unsigned int i, queued;
+
+	/* index 0 and anything above the worker limit run on the caller */
+	queued = min(n, (unsigned int)SH_CSS_PARALLEL_MAX_WORKERS + 1);
+	for (i = 1; i < queued; i++) {
+		INIT_WORK_ONSTACK(&pw[i - 1].work, sh_css_parallel_work_fn);
+		pw[i - 1].fn = fn;
+		pw[i - 1].ctx = ctx;
+		pw[i - 1].i = i;
+		queue_work(system_unbound_wq, &pw[i - 1].work);
+	}
+
+	if (n > 0)
+		fn(ctx, 0);
+	for (i = queued; i < n; i++)
+		fn(ctx, i);
+
+	for (i = 1; i < queued; i++) {
+		flush_work(&pw[i - 1].work);
+		destroy_work_on_stack(&pw[i - 1].work);
+	}
+}
+#else
+void
+sh_css_parallel_for(unsigned int n,
+		    void (*fn)(void *ctx, unsigned int i),
+		    void *ctx)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+		fn(ctx, i);
+}
+#endif
+
 /* For Acceleration API: Flush FW (shared buffer pointer) arguments */
 void
 sh_css_flush(struct ia_css_acc_fw *fw)
@@ -2464,7 +2568,7 @@ ia_css_pipe_destroy(struct ia_css_pipe *pipe)
 		/* need to take into account that this function is also called
 		   on the internal copy pipe */
 		if (pipe->mode == IA_CSS_PIPE_ID_PREVIEW) {
-			ia_css_frame_free_multiple(NUM_CONTINUOUS_FRAMES,
+			cont_frame_pool_put_multiple(NUM_CONTINUOUS_FRAMES,
 					pipe->continuous_frames);
 			ia_css_metadata_free_multiple(NUM_CONTINUOUS_FRAMES,
 					pipe->cont_md_buffers);
@@ -2477,7 +2581,7 @@ ia_css_pipe_destroy(struct ia_css_pipe *pipe)
 		break;
 	case IA_CSS_PIPE_MODE_VIDEO:
 		if (pipe->mode == IA_CSS_PIPE_ID_VIDEO) {
-			ia_css_frame_free_multiple(NUM_CONTINUOUS_FRAMES,
+			cont_frame_pool_put_multiple(NUM_CONTINUOUS_FRAMES,
 				pipe->continuous_frames);
 			ia_css_metadata_free_multiple(NUM_CONTINUOUS_FRAMES,
 					pipe->cont_md_buffers);
@@ -2532,6 +2636,7 @@ ia_css_uninit(void)
 
 	/* TODO: JB: implement decent check and handling of freeing mipi frames */
 	//assert(ref_count_mipi_allocation == 0); //mipi frames are not freed
+	cont_frame_pool_flush();
 	/* cleanup generic data */
 	sh_css_params_uninit();
 	ia_css_refcount_uninit();
@@ -2758,6 +2863,71 @@ static enum ia_css_err load_copy_binary(
 	return IA_CSS_SUCCESS;
 }
 
+/*
+ * Continuous raw frames given back by a destroyed or reconfigured pipe.
+ * A later pipe asking for frames of the same info takes them from here
+ * instead of allocating, so restarting a continuous stream at the same
+ * input resolution does not reallocate its raw frames. A request for
+ * another info empties the pool, as does ia_css_uninit(), so frames of
+ * an old resolution are not kept around.
+ */
+static struct ia_css_frame *cont_frame_pool[NUM_CONTINUOUS_FRAMES];
+
+static struct ia_css_frame *
+cont_frame_pool_get(const struct ia_css_frame_info *info)
+{
+	unsigned int i;
+
+	for (i = 0; i < NUM_CONTINUOUS_FRAMES; i++) {
+		struct ia_css_frame *frame = cont_frame_pool[i];
+
+		if (frame != NULL &&
+		    memcmp(&frame->info, info, sizeof(*info)) == 0) {
+			cont_frame_pool[i] = NULL;
+			return frame;
+		}
+	}
+	/* nothing parked matches, so nothing parked is of the current size */
+	cont_frame_pool_flush();
+	return NULL;
+}
+
+static void
+cont_frame_pool_put(struct ia_css_frame *frame)
+{
+	unsigned int i;
+
+	if (frame == NULL)
+		return;
+
+	for (i = 0; i < NUM_CONTINUOUS_FRAMES; i++) {
+		if (cont_frame_pool[i] == NULL) {
+			cont_frame_pool[i] = frame;
+			return;
+		}
+	}
+	/* pool full, the frame is not needed */
+	ia_css_frame_free(frame);
+}
+
+static void
+cont_frame_pool_put_multiple(unsigned int num_frames,
+			     struct ia_css_frame **frames_array)
+{
+	unsigned int i;
+
+	for (i = 0; i < num_frames; i++) {
+		cont_frame_pool_put(frames_array[i]);
+		frames_array[i] = NULL;
+	}
+}
+
+static void
+cont_frame_pool_flush(void)
+{
+	ia_css_frame_free_multiple(NUM_CONTINUOUS_FRAMES, cont_frame_pool);
+}
+
 static enum ia_css_err
 alloc_continuous_frames(
 	struct ia_css_pipe *pipe, bool init_time)
@@ -2846,23 +3016,25 @@ alloc_continuous_frames(
 		idx = pipe->stream->config.init_num_cont_raw_buf;
 
 	for (i = idx; i < NUM_CONTINUOUS_FRAMES; i++) {
-		/* free previous frame */
-		if (pipe->continuous_frames[i]) {
-			ia_css_frame_free(pipe->continuous_frames[i]);
-			pipe->continuous_frames[i] = NULL;
-		}
+		/* park previous frame, it may fit the new info */
+		cont_frame_pool_put(pipe->continuous_frames[i]);
+		pipe->continuous_frames[i] = NULL;
 		/* free previous metadata buffer */
 		ia_css_metadata_free(pipe->cont_md_buffers[i]);
 		pipe->cont_md_buffers[i] = NULL;
 
 		/* check if new frame needed */
 		if (i < num_frames) {
-			/* allocate new frame */
-			err = ia_css_frame_allocate_from_info(
-				&pipe->continuous_frames[i],
-				&ref_info);
-			if (err != IA_CSS_SUCCESS)
-				return err;
+			/* reuse a parked frame or allocate new frame */
+			pipe->continuous_frames[i] =
+				cont_frame_pool_get(&ref_info);
+			if (pipe->continuous_frames[i] == NULL) {
+				err = ia_css_frame_allocate_from_info(
+					&pipe->continuous_frames[i],
+					&ref_info);
+				if (err != IA_CSS_SUCCESS)
+					return err;
+			}
 			/* allocate metadata buffer */
 			pipe->cont_md_buffers[i] = ia_css_metadata_allocate(
 					&pipe->stream->info.metadata_info);
@@ -80,4 +80,15 @@ void sh_css_metrics_start_frame(void);
 void sh_css_metrics_start_binary(struct sh_css_binary_metrics *metrics);
 void sh_css_metrics_sample_pcs(void);
 
+/* Sample the binary the SP runs on the ISP and the ISP pc, for host side
+ * profiling independent of the histograms above. Returns false when the
+ * SP is not running or the ISP is idle, in which case nothing is written.
+ * Safe in irq context.
+ */
+bool sh_css_metrics_sample_isp(unsigned int *binary_id, unsigned int *pc,
+			       bool *stall);
+
+/* Name of the firmware ISP binary with this id, NULL if unknown */
+const char *sh_css_metrics_binary_name(unsigned int binary_id);
+
 #endif /* _SH_CSS_METRICS_H_ */
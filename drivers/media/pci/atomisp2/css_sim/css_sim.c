@@ -0,0 +1,661 @@
+/*
+ * Host simulation of the CSS buffer and event flow.
+ *
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+/*
+ * Runs the host side of the CSS buffer flow against the simulated SP
+ * (sim_sp.c) on top of the simulated environment (sim_env.c). The
+ * buffer queue, event queue and resource manager code is the CSS code
+ * itself; the enqueue, event and dequeue steps below do what
+ * ia_css_pipe_enqueue_buffer(), ia_css_dequeue_psys_event() and
+ * ia_css_pipe_dequeue_buffer() in sh_css.c do, without needing a
+ * stream, and so without firmware.
+ *
+ * Every pipe streams output, viewfinder, 3A and metadata buffers. The
+ * host keeps its buffers queued like the driver does, holding some of
+ * them back at random like a user space client, and checks every
+ * buffer that comes back: right pipe and type, exposure ids in order
+ * and the data equal to the reference. At the end it checks that every
+ * buffer is accounted for, and reports the throughput and the traffic
+ * through the environment.
+ *
+ * Usage: css_sim [-p pipes] [-b buffers] [-n frames] [-W width]
+ *                [-H height] [-r fps] [-s seed] [-v]
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ia_css_types.h"
+#include "ia_css_bufq.h"
+#include "ia_css_rmgr.h"
+#include "ia_css_debug.h"
+#include "sw_event_global.h"
+#include "memory_access.h"
+#include "sh_css_internal.h"
+#include "sim_env.h"
+#include "sim_sp.h"
+
+#ifndef ARRAY_SIZE
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+#endif
+
+#define SIM_MAX_BUFS		16
+#define SIM_STATS_BYTES		4096
+#define SIM_METADATA_BYTES	1024
+#define SIM_TIMEOUT_NS		5000000000ULL
+
+struct sim_queue;
+
+struct sim_buf {
+	struct sim_queue *q;
+	hrt_vaddress data;
+	struct ia_css_rmgr_vbuf_handle *h_vbuf;
+	bool queued;
+	uint64_t enq_ns;
+};
+
+struct sim_queue {
+	unsigned int pipe;
+	enum ia_css_buffer_type buf_type;
+	enum sh_css_queue_id queue_id;
+	uint32_t size;
+	uint8_t *ref;		/* host copy of the reference data */
+	hrt_vaddress ref_isp;
+	struct sim_buf bufs[SIM_MAX_BUFS];
+	unsigned int num_bufs;
+	unsigned int queued;
+	uint32_t last_exp_id;
+	uint64_t done;
+};
+
+static const enum ia_css_buffer_type sim_buf_types[] = {
+	IA_CSS_BUFFER_TYPE_OUTPUT_FRAME,
+	IA_CSS_BUFFER_TYPE_VF_OUTPUT_FRAME,
+	IA_CSS_BUFFER_TYPE_3A_STATISTICS,
+	IA_CSS_BUFFER_TYPE_METADATA,
+};
+#define SIM_NUM_TYPES	ARRAY_SIZE(sim_buf_types)
+
+static const char * const sim_type_names[SIM_NUM_TYPES] = {
+	"out", "vf", "3a", "md",
+};
+
+struct sim_pipe {
+	struct sim_queue queues[SIM_NUM_TYPES];
+	uint64_t latency_ns;
+	uint64_t max_latency_ns;
+};
+
+static struct sim_pipe sim_pipes[SH_CSS_MAX_SP_THREADS];
+static unsigned int sim_num_pipes = 2;
+static unsigned int sim_num_bufs = 4;
+static unsigned int sim_frames = 1000;
+static unsigned int sim_width = 640;
+static unsigned int sim_height = 480;
+static unsigned int sim_fps;
+static unsigned int sim_seed = 1;
+static int sim_verbose;
+static uint8_t *sim_scratch;
+
+static uint64_t sim_errors;
+static uint64_t sim_host_full;
+
+#define sim_error(fmt, ...) \
+do { \
+	sim_errors++; \
+	fprintf(stderr, "css_sim: " fmt "\n", ##__VA_ARGS__); \
+} while (0)
+
+static uint64_t sim_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint32_t sim_buf_size(enum ia_css_buffer_type buf_type)
+{
+	switch (buf_type) {
+	case IA_CSS_BUFFER_TYPE_OUTPUT_FRAME:
+		return sim_width * sim_height * 3 / 2;
+	case IA_CSS_BUFFER_TYPE_VF_OUTPUT_FRAME:
+		return (sim_width / 2) * (sim_height / 2) * 3 / 2;
+	case IA_CSS_BUFFER_TYPE_3A_STATISTICS:
+		return SIM_STATS_BYTES;
+	default:
+		return SIM_METADATA_BYTES;
+	}
+}
+
+static struct sim_queue *sim_find_queue(unsigned int pipe,
+					enum ia_css_buffer_type buf_type)
+{
+	unsigned int i;
+
+	if (pipe >= sim_num_pipes)
+		return NULL;
+	for (i = 0; i < SIM_NUM_TYPES; i++)
+		if (sim_pipes[pipe].queues[i].buf_type == buf_type)
+			return &sim_pipes[pipe].queues[i];
+	return NULL;
+}
+
+static int sim_setup(void)
+{
+	unsigned int p, i, b, j;
+
+	for (p = 0; p < sim_num_pipes; p++) {
+		for (i = 0; i < SIM_NUM_TYPES; i++) {
+			struct sim_queue *q = &sim_pipes[p].queues[i];
+
+			q->pipe = p;
+			q->buf_type = sim_buf_types[i];
+			q->size = sim_buf_size(q->buf_type);
+			q->num_bufs = sim_num_bufs;
+
+			ia_css_queue_map(p, q->buf_type, true);
+			if (!ia_css_query_internal_queue_id(q->buf_type, p,
+							    &q->queue_id))
+				return -1;
+
+			q->ref = malloc(q->size);
+			q->ref_isp = mmgr_malloc(q->size);
+			if (!q->ref || q->ref_isp == mmgr_NULL)
+				return -1;
+			for (j = 0; j < q->size; j++)
+				q->ref[j] = rand();
+			mmgr_store(q->ref_isp, q->ref, q->size);
+
+			for (b = 0; b < q->num_bufs; b++) {
+				q->bufs[b].q = q;
+				q->bufs[b].data = mmgr_malloc(q->size);
+				if (q->bufs[b].data == mmgr_NULL)
+					return -1;
+			}
+
+			sim_sp_map_queue(p, q->queue_id, q->buf_type,
+					 IA_CSS_PIPE_ID_PREVIEW, q->ref_isp,
+					 q->size);
+		}
+		if (sim_fps)
+			sim_sp_set_frame_period(p, 1000000000ULL / sim_fps);
+	}
+
+	sim_scratch = malloc(sim_buf_size(IA_CSS_BUFFER_TYPE_OUTPUT_FRAME));
+	return sim_scratch ? 0 : -1;
+}
+
+/* What ia_css_pipe_enqueue_buffer() does once the queue is known */
+static bool sim_enqueue(struct sim_buf *buf)
+{
+	struct sim_queue *q = buf->q;
+	struct sh_css_hmm_buffer ddr_buffer;
+	struct ia_css_rmgr_vbuf_handle p_vbuf;
+	struct ia_css_rmgr_vbuf_handle *h_vbuf;
+	enum ia_css_err err;
+
+	memset(&ddr_buffer, 0, sizeof(ddr_buffer));
+	ddr_buffer.kernel_ptr = HOST_ADDRESS(buf);
+	ddr_buffer.cookie_ptr = HOST_ADDRESS(q);
+	switch (q->buf_type) {
+	case IA_CSS_BUFFER_TYPE_3A_STATISTICS:
+		ddr_buffer.payload.s3a.data_ptr = buf->data;
+		ddr_buffer.payload.s3a.size = q->size;
+		break;
+	case IA_CSS_BUFFER_TYPE_METADATA:
+		ddr_buffer.payload.metadata.address = buf->data;
+		ddr_buffer.payload.metadata.info.size = q->size;
+		break;
+	default:
+		ddr_buffer.payload.frame.frame_data = buf->data;
+		break;
+	}
+
+	p_vbuf.vptr = 0;
+	p_vbuf.count = 0;
+	p_vbuf.size = sizeof(struct sh_css_hmm_buffer);
+	h_vbuf = &p_vbuf;
+	ia_css_rmgr_acq_vbuf(hmm_buffer_pool, &h_vbuf);
+	if (!h_vbuf || !h_vbuf->vptr) {
+		sim_error("no hmm buffer");
+		return false;
+	}
+	mmgr_store(h_vbuf->vptr, &ddr_buffer, sizeof(ddr_buffer));
+
+	err = ia_css_bufq_enqueue_buffer(q->pipe, q->queue_id, h_vbuf->vptr);
+	if (err != IA_CSS_SUCCESS) {
+		ia_css_rmgr_rel_vbuf(hmm_buffer_pool, &h_vbuf);
+		if (err == IA_CSS_ERR_QUEUE_IS_FULL)
+			sim_host_full++;
+		else
+			sim_error("enqueue pipe %u queue %d: %d", q->pipe,
+				  q->queue_id, err);
+		return false;
+	}
+
+	buf->h_vbuf = h_vbuf;
+	buf->queued = true;
+	buf->enq_ns = sim_now_ns();
+	q->queued++;
+
+	err = ia_css_bufq_enqueue_psys_event(
+			IA_CSS_PSYS_SW_EVENT_BUFFER_ENQUEUED,
+			(uint8_t)q->pipe, q->queue_id, 0);
+	if (err != IA_CSS_SUCCESS)
+		sim_error("enqueue event: %d", err);
+	return true;
+}
+
+static void sim_enqueue_idle(void)
+{
+	unsigned int p, i, b;
+
+	for (p = 0; p < sim_num_pipes; p++)
+		for (i = 0; i < SIM_NUM_TYPES; i++) {
+			struct sim_queue *q = &sim_pipes[p].queues[i];
+
+			for (b = 0; b < q->num_bufs; b++) {
+				/* user space does not return all at once */
+				if (q->bufs[b].queued || !(rand() % 4))
+					continue;
+				if (!sim_enqueue(&q->bufs[b]))
+					break;
+			}
+		}
+}
+
+static void sim_check(struct sim_queue *q, struct sim_buf *buf,
+		      uint32_t exp_id)
+{
+	uint32_t stamp;
+
+	if (exp_id < IA_CSS_ISYS_MIN_EXPOSURE_ID ||
+	    exp_id > IA_CSS_ISYS_MAX_EXPOSURE_ID)
+		sim_error("pipe %u %s: bad exp_id %u", q->pipe,
+			  sim_type_names[q - sim_pipes[q->pipe].queues], exp_id);
+
+	/* every frame has an output buffer, so those never skip one */
+	if (q->buf_type == IA_CSS_BUFFER_TYPE_OUTPUT_FRAME && q->last_exp_id &&
+	    exp_id != (q->last_exp_id >= IA_CSS_ISYS_MAX_EXPOSURE_ID ?
+		       IA_CSS_ISYS_MIN_EXPOSURE_ID : q->last_exp_id + 1))
+		sim_error("pipe %u out: exp_id %u after %u", q->pipe, exp_id,
+			  q->last_exp_id);
+	q->last_exp_id = exp_id;
+
+	mmgr_load(buf->data, sim_scratch, q->size);
+	memcpy(&stamp, sim_scratch, sizeof(stamp));
+	if (stamp != exp_id ||
+	    memcmp(sim_scratch + sizeof(stamp), q->ref + sizeof(stamp),
+		   q->size - sizeof(stamp)))
+		sim_error("pipe %u %s: data mismatch, exp_id %u stamp %u",
+			  q->pipe,
+			  sim_type_names[q - sim_pipes[q->pipe].queues],
+			  exp_id, stamp);
+}
+
+static struct sim_buf *sim_find_buf(enum sh_css_queue_id queue_id,
+				    hrt_vaddress vptr)
+{
+	unsigned int p, i, b;
+
+	for (p = 0; p < sim_num_pipes; p++)
+		for (i = 0; i < SIM_NUM_TYPES; i++) {
+			struct sim_queue *q = &sim_pipes[p].queues[i];
+
+			if (q->queue_id != queue_id)
+				continue;
+			for (b = 0; b < q->num_bufs; b++)
+				if (q->bufs[b].queued &&
+				    q->bufs[b].h_vbuf->vptr == vptr)
+					return &q->bufs[b];
+		}
+	return NULL;
+}
+
+/*
+ * What the driver does on an SP interrupt: ia_css_dequeue_psys_event()
+ * followed by ia_css_pipe_dequeue_buffer() for a buffer done event.
+ */
+static bool sim_dequeue(void)
+{
+	static const enum ia_css_buffer_type event_buf_type[] = {
+		[SH_CSS_SP_EVENT_OUTPUT_FRAME_DONE] =
+			IA_CSS_BUFFER_TYPE_OUTPUT_FRAME,
+		[SH_CSS_SP_EVENT_VF_OUTPUT_FRAME_DONE] =
+			IA_CSS_BUFFER_TYPE_VF_OUTPUT_FRAME,
+		[SH_CSS_SP_EVENT_3A_STATISTICS_DONE] =
+			IA_CSS_BUFFER_TYPE_3A_STATISTICS,
+		[SH_CSS_SP_EVENT_METADATA_DONE] = IA_CSS_BUFFER_TYPE_METADATA,
+	};
+	uint8_t payload[4] = {0, 0, 0, 0};
+	struct sh_css_hmm_buffer ddr_buffer;
+	struct sim_queue *q = NULL;
+	struct sim_buf *buf = NULL;
+	uint32_t vptr;
+
+	if (ia_css_bufq_dequeue_psys_event(payload) != IA_CSS_SUCCESS)
+		return false;
+	ia_css_bufq_enqueue_psys_event(IA_CSS_PSYS_SW_EVENT_EVENT_DEQUEUED,
+				       0, 0, 0);
+
+	if (payload[0] < ARRAY_SIZE(event_buf_type) &&
+	    event_buf_type[payload[0]] != IA_CSS_BUFFER_TYPE_INVALID)
+		q = sim_find_queue(payload[1], event_buf_type[payload[0]]);
+	if (!q || payload[2] != IA_CSS_PIPE_ID_PREVIEW) {
+		sim_error("unexpected event %u %u %u", payload[0], payload[1],
+			  payload[2]);
+		return true;
+	}
+
+	if (ia_css_bufq_dequeue_buffer(q->queue_id, &vptr) != IA_CSS_SUCCESS) {
+		sim_error("pipe %u queue %d: event without buffer", q->pipe,
+			  q->queue_id);
+		return true;
+	}
+
+	/*
+	 * The sp2host queues are shared by all SP threads, so the buffer
+	 * may belong to another pipe than the event; like the driver, go
+	 * by the buffer itself.
+	 */
+	buf = sim_find_buf(q->queue_id, vptr);
+	if (!buf) {
+		sim_error("pipe %u queue %d: unknown buffer 0x%x", q->pipe,
+			  q->queue_id, vptr);
+		return true;
+	}
+	q = buf->q;
+
+	mmgr_load(vptr, &ddr_buffer, sizeof(ddr_buffer));
+	ia_css_rmgr_rel_vbuf(hmm_buffer_pool, &buf->h_vbuf);
+	buf->queued = false;
+	q->queued--;
+	q->done++;
+
+	if (ddr_buffer.kernel_ptr != HOST_ADDRESS(buf) ||
+	    ddr_buffer.cookie_ptr != HOST_ADDRESS(q))
+		sim_error("pipe %u queue %d: kernel_ptr/cookie mismatch",
+			  q->pipe, q->queue_id);
+
+	switch (q->buf_type) {
+	case IA_CSS_BUFFER_TYPE_3A_STATISTICS:
+		sim_check(q, buf, ddr_buffer.payload.s3a.exp_id);
+		break;
+	case IA_CSS_BUFFER_TYPE_METADATA:
+		sim_check(q, buf, ddr_buffer.payload.metadata.exp_id);
+		break;
+	default:
+		sim_check(q, buf, ddr_buffer.payload.frame.exp_id);
+		break;
+	}
+
+	if (q->buf_type == IA_CSS_BUFFER_TYPE_OUTPUT_FRAME) {
+		struct sim_pipe *pipe = &sim_pipes[q->pipe];
+		uint64_t lat = sim_now_ns() - buf->enq_ns;
+
+		pipe->latency_ns += lat;
+		if (lat > pipe->max_latency_ns)
+			pipe->max_latency_ns = lat;
+	}
+
+	ia_css_bufq_enqueue_psys_event(IA_CSS_PSYS_SW_EVENT_BUFFER_DEQUEUED,
+				       0, q->queue_id, 0);
+	return true;
+}
+
+static void sim_teardown(void)
+{
+	unsigned int p, i, b;
+
+	for (p = 0; p < sim_num_pipes; p++)
+		for (i = 0; i < SIM_NUM_TYPES; i++) {
+			struct sim_queue *q = &sim_pipes[p].queues[i];
+
+			for (b = 0; b < q->num_bufs; b++)
+				mmgr_free(q->bufs[b].data);
+			mmgr_free(q->ref_isp);
+			free(q->ref);
+		}
+	free(sim_scratch);
+}
+
+static bool sim_done(void)
+{
+	unsigned int p;
+
+	for (p = 0; p < sim_num_pipes; p++)
+		if (sim_pipes[p].queues[0].done < sim_frames)
+			return false;
+	return true;
+}
+
+/* Every buffer still queued must be in its host2sp queue */
+static void sim_check_leftovers(void)
+{
+	unsigned int p, i, b;
+	uint32_t used;
+
+	while (sim_dequeue())
+		;
+
+	for (p = 0; p < sim_num_pipes; p++)
+		for (i = 0; i < SIM_NUM_TYPES; i++) {
+			struct sim_queue *q = &sim_pipes[p].queues[i];
+
+			if (sim_sp_queued(p, q->queue_id, &used) ||
+			    used != q->queued)
+				sim_error("pipe %u %s: %u buffers queued, %u in the queue",
+					  p, sim_type_names[i], q->queued,
+					  used);
+			for (b = 0; b < q->num_bufs; b++)
+				if (q->bufs[b].queued)
+					ia_css_rmgr_rel_vbuf(hmm_buffer_pool,
+							&q->bufs[b].h_vbuf);
+		}
+}
+
+static void sim_print_access(const char *who, const char *what,
+			     const struct sim_access_stats *s,
+			     uint64_t frames)
+{
+	printf("  %-4s %-8s %10llu loads %12llu bytes %10llu stores %12llu bytes",
+	       who, what, (unsigned long long)s->loads,
+	       (unsigned long long)s->load_bytes,
+	       (unsigned long long)s->stores,
+	       (unsigned long long)s->store_bytes);
+	if (frames)
+		printf("  %6llu/frame",
+		       (unsigned long long)((s->loads + s->stores) / frames));
+	printf("\n");
+}
+
+static void sim_report(uint64_t ns)
+{
+	struct sim_sp_stats sp;
+	struct sim_stats env;
+	uint64_t frames = 0;
+	unsigned int p, i;
+
+	sim_sp_get_stats(&sp);
+	sim_env_get_stats(&env);
+
+	printf("css_sim: %u pipes, %u buffers per queue, %ux%u, %s\n",
+	       sim_num_pipes, sim_num_bufs, sim_width, sim_height,
+	       sim_fps ? "paced" : "free running");
+	for (p = 0; p < sim_num_pipes; p++) {
+		struct sim_pipe *pipe = &sim_pipes[p];
+		uint64_t out = pipe->queues[0].done;
+
+		frames += sp.thread[p].frames;
+		printf("  pipe %u: %llu frames, %llu dropped,",
+		       p, (unsigned long long)sp.thread[p].frames,
+		       (unsigned long long)sp.thread[p].dropped);
+		for (i = 0; i < SIM_NUM_TYPES; i++)
+			printf(" %s %llu", sim_type_names[i],
+			       (unsigned long long)pipe->queues[i].done);
+		printf(", latency avg %llu us max %llu us\n",
+		       out ? (unsigned long long)(pipe->latency_ns / out / 1000)
+			   : 0ULL,
+		       (unsigned long long)(pipe->max_latency_ns / 1000));
+	}
+	printf("  %llu frames in %llu ms, %llu frames/s\n",
+	       (unsigned long long)frames, (unsigned long long)(ns / 1000000),
+	       ns ? (unsigned long long)(frames * 1000000000ULL / ns) : 0ULL);
+	printf("  host events: %llu enqueued, %llu buffer dequeued, %llu event dequeued\n",
+	       (unsigned long long)sp.host_events[IA_CSS_PSYS_SW_EVENT_BUFFER_ENQUEUED],
+	       (unsigned long long)sp.host_events[IA_CSS_PSYS_SW_EVENT_BUFFER_DEQUEUED],
+	       (unsigned long long)sp.host_events[IA_CSS_PSYS_SW_EVENT_EVENT_DEQUEUED]);
+	printf("  host2sp queue full %llu, sp stalls %llu\n",
+	       (unsigned long long)sim_host_full,
+	       (unsigned long long)sp.stalls);
+	sim_print_access("host", "sp dmem", &env.host.sp_dmem, frames);
+	sim_print_access("host", "regs", &env.host.reg, frames);
+	sim_print_access("host", "ddr", &env.host.ddr, frames);
+	sim_print_access("sp", "sp dmem", &env.sp.sp_dmem, frames);
+	sim_print_access("sp", "ddr", &env.sp.ddr, frames);
+	printf("  ddr: %llu allocs, %llu frees, peak %llu KB\n",
+	       (unsigned long long)env.ddr_allocs,
+	       (unsigned long long)env.ddr_frees,
+	       (unsigned long long)(env.ddr_peak_bytes / 1024));
+	if (env.ddr_allocs != env.ddr_frees)
+		sim_error("%llu ddr allocations leaked",
+			  (unsigned long long)(env.ddr_allocs - env.ddr_frees));
+	printf("  %llu protocol errors, %llu check errors\n",
+	       (unsigned long long)sp.protocol_errors,
+	       (unsigned long long)sim_errors);
+	sim_errors += sp.protocol_errors;
+}
+
+static void sim_usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-p pipes] [-b buffers] [-n frames] [-W width] [-H height]\n"
+		"          [-r fps] [-s seed] [-v]\n", prog);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	struct ia_css_env env;
+	uint64_t start, last_progress;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "p:b:n:W:H:r:s:v")) != -1) {
+		switch (opt) {
+		case 'p':
+			sim_num_pipes = strtoul(optarg, NULL, 0);
+			break;
+		case 'b':
+			sim_num_bufs = strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			sim_frames = strtoul(optarg, NULL, 0);
+			break;
+		case 'W':
+			sim_width = strtoul(optarg, NULL, 0);
+			break;
+		case 'H':
+			sim_height = strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			sim_fps = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			sim_seed = strtoul(optarg, NULL, 0);
+			break;
+		case 'v':
+			sim_verbose = 1;
+			break;
+		default:
+			sim_usage(argv[0]);
+		}
+	}
+	if (!sim_num_pipes || sim_num_pipes > SH_CSS_MAX_SP_THREADS ||
+	    !sim_num_bufs || sim_num_bufs > SIM_MAX_BUFS || !sim_frames ||
+	    sim_width < 16 || sim_height < 16)
+		sim_usage(argv[0]);
+	/* released handles go back to a pool of fixed size */
+	if (sim_num_pipes * SIM_NUM_TYPES * sim_num_bufs >
+	    hmm_buffer_pool->size) {
+		fprintf(stderr,
+			"css_sim: at most %u buffers can be queued at once\n",
+			hmm_buffer_pool->size);
+		return 1;
+	}
+	srand(sim_seed);
+
+	if (sim_env_init(&env, sim_verbose)) {
+		fprintf(stderr, "css_sim: out of memory\n");
+		return 1;
+	}
+	sh_css_printf = env.print_env.debug_print;
+	if (sim_verbose)
+		ia_css_debug_trace_level = IA_CSS_DEBUG_TRACE;
+
+	/* what ia_css_init() and the SP start do for the queues */
+	sim_sp_init();
+	ia_css_queue_map_init();
+	ia_css_bufq_init();
+	if (ia_css_rmgr_init() != IA_CSS_SUCCESS || sim_setup()) {
+		fprintf(stderr, "css_sim: setup failed\n");
+		return 1;
+	}
+	if (sim_sp_start()) {
+		fprintf(stderr, "css_sim: cannot start the SP thread\n");
+		return 1;
+	}
+
+	start = last_progress = sim_now_ns();
+	while (!sim_done()) {
+		bool progress = false;
+
+		sim_enqueue_idle();
+		while (sim_dequeue())
+			progress = true;
+		if (progress) {
+			last_progress = sim_now_ns();
+		} else if (sim_now_ns() - last_progress > SIM_TIMEOUT_NS) {
+			sim_error("no progress for %llu s, giving up",
+				  SIM_TIMEOUT_NS / 1000000000ULL);
+			break;
+		} else {
+			hrt_sleep();
+		}
+	}
+	sim_sp_stop();
+
+	sim_check_leftovers();
+	sim_teardown();
+	ia_css_rmgr_uninit();
+	sim_report(sim_now_ns() - start);
+	sim_env_uninit();
+
+	if (sim_errors) {
+		printf("FAILED\n");
+		return 1;
+	}
+	printf("PASSED\n");
+	return 0;
+}
@@ -0,0 +1,368 @@
+/*
+ * Host simulation environment for the CSS.
+ *
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ia_css_device_access.h"
+#include "ia_css_memory_access.h"
+#include "system_local.h"
+#include "sp_global.h"
+#include "sim_env.h"
+
+/*
+ * The host thread and the simulated SP share the SP DMEM and the DDR,
+ * like the IA and the SP do on the real system where both are
+ * uncached. Every access is therefore atomic (for the scalar accessors)
+ * and fenced, so a queue element is always visible before the queue
+ * descriptor update that publishes it.
+ */
+#define SIM_DDR_BASE		0x10000000U
+#define SIM_DDR_PAGE_SIZE	4096U
+#define SIM_DDR_PAGES		(SIM_DDR_SIZE / SIM_DDR_PAGE_SIZE)
+
+static uint8_t sim_sp_dmem[SP_DMEM_SIZE];
+
+static uint8_t *sim_ddr;
+static uint32_t sim_ddr_npages[SIM_DDR_PAGES];	/* run length, at its start */
+static uint8_t sim_ddr_used[SIM_DDR_PAGES];
+static uint32_t sim_ddr_next;
+static uint64_t sim_ddr_bytes;
+static pthread_mutex_t sim_ddr_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct sim_stats sim_stats;
+static int sim_verbose;
+static __thread int sim_sp_thread;
+
+#define SIM_SIDE()	(sim_sp_thread ? &sim_stats.sp : &sim_stats.host)
+
+static void sim_account(struct sim_access_stats *s, int store, size_t bytes)
+{
+	if (store) {
+		__atomic_fetch_add(&s->stores, 1, __ATOMIC_RELAXED);
+		__atomic_fetch_add(&s->store_bytes, bytes, __ATOMIC_RELAXED);
+	} else {
+		__atomic_fetch_add(&s->loads, 1, __ATOMIC_RELAXED);
+		__atomic_fetch_add(&s->load_bytes, bytes, __ATOMIC_RELAXED);
+	}
+}
+
+static void sim_fatal(const char *what, unsigned long long addr, size_t bytes)
+{
+	fprintf(stderr, "css_sim: %s out of range: 0x%llx, %zu bytes\n",
+		what, addr, bytes);
+	abort();
+}
+
+/*
+ * HW access env
+ */
+
+/* Host pointer into the SP DMEM for addr, or NULL for a register */
+static void *sim_hw_ptr(hrt_address addr, size_t bytes)
+{
+	hrt_address base = SP_DMEM_BASE[SP0_ID];
+
+	if (addr < base || addr >= base + SP_DMEM_SIZE)
+		return NULL;
+	if (addr + bytes > base + SP_DMEM_SIZE)
+		sim_fatal("SP DMEM access", addr, bytes);
+	return &sim_sp_dmem[addr - base];
+}
+
+#define SIM_HW_STORE(type, bits)					\
+static void sim_hw_store_##bits(hrt_address addr, type data)		\
+{									\
+	type *p = sim_hw_ptr(addr, sizeof(type));			\
+									\
+	if (p) {							\
+		sim_account(&SIM_SIDE()->sp_dmem, 1, sizeof(type));	\
+		__atomic_store_n(p, data, __ATOMIC_SEQ_CST);		\
+	} else {							\
+		sim_account(&SIM_SIDE()->reg, 1, sizeof(type));		\
+	}								\
+}
+
+#define SIM_HW_LOAD(type, bits)						\
+static type sim_hw_load_##bits(hrt_address addr)			\
+{									\
+	type *p = sim_hw_ptr(addr, sizeof(type));			\
+									\
+	if (p) {							\
+		sim_account(&SIM_SIDE()->sp_dmem, 0, sizeof(type));	\
+		return __atomic_load_n(p, __ATOMIC_SEQ_CST);		\
+	}								\
+	sim_account(&SIM_SIDE()->reg, 0, sizeof(type));			\
+	return 0;							\
+}
+
+SIM_HW_STORE(uint8_t, 8)
+SIM_HW_STORE(uint16_t, 16)
+SIM_HW_STORE(uint32_t, 32)
+SIM_HW_LOAD(uint8_t, 8)
+SIM_HW_LOAD(uint16_t, 16)
+SIM_HW_LOAD(uint32_t, 32)
+
+static void sim_hw_store(hrt_address addr, const void *data, uint32_t bytes)
+{
+	void *p = sim_hw_ptr(addr, bytes);
+
+	if (p) {
+		sim_account(&SIM_SIDE()->sp_dmem, 1, bytes);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		memcpy(p, data, bytes);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	} else {
+		sim_account(&SIM_SIDE()->reg, 1, bytes);
+	}
+}
+
+static void sim_hw_load(hrt_address addr, void *data, uint32_t bytes)
+{
+	void *p = sim_hw_ptr(addr, bytes);
+
+	if (p) {
+		sim_account(&SIM_SIDE()->sp_dmem, 0, bytes);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		memcpy(data, p, bytes);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	} else {
+		sim_account(&SIM_SIDE()->reg, 0, bytes);
+		memset(data, 0, bytes);
+	}
+}
+
+/*
+ * CSS memory env: a page granular first fit allocator over SIM_DDR_SIZE
+ * bytes of host memory. Addresses start at SIM_DDR_BASE so that no
+ * allocation is mmgr_NULL.
+ */
+
+static uint8_t *sim_ddr_ptr(ia_css_ptr ptr, size_t bytes)
+{
+	if (ptr < SIM_DDR_BASE || ptr - SIM_DDR_BASE > SIM_DDR_SIZE ||
+	    bytes > SIM_DDR_SIZE - (ptr - SIM_DDR_BASE))
+		sim_fatal("DDR access", ptr, bytes);
+	return sim_ddr + (ptr - SIM_DDR_BASE);
+}
+
+static ia_css_ptr sim_ddr_alloc(size_t bytes, uint32_t attributes)
+{
+	uint32_t n = (bytes + SIM_DDR_PAGE_SIZE - 1) / SIM_DDR_PAGE_SIZE;
+	uint32_t tries, start, i;
+	ia_css_ptr ptr = 0;
+
+	if (!n)
+		n = 1;
+	pthread_mutex_lock(&sim_ddr_lock);
+	start = sim_ddr_next;
+	for (tries = 0; tries < SIM_DDR_PAGES; tries++) {
+		if (start + n > SIM_DDR_PAGES)
+			start = 0;
+		for (i = 0; i < n && !sim_ddr_used[start + i]; i++)
+			;
+		if (i == n)
+			break;
+		start += i + 1;
+	}
+	if (tries < SIM_DDR_PAGES) {
+		memset(&sim_ddr_used[start], 1, n);
+		sim_ddr_npages[start] = n;
+		sim_ddr_next = start + n;
+		sim_ddr_bytes += (uint64_t)n * SIM_DDR_PAGE_SIZE;
+		if (sim_ddr_bytes > sim_stats.ddr_peak_bytes)
+			sim_stats.ddr_peak_bytes = sim_ddr_bytes;
+		sim_stats.ddr_allocs++;
+		ptr = SIM_DDR_BASE + start * SIM_DDR_PAGE_SIZE;
+	}
+	pthread_mutex_unlock(&sim_ddr_lock);
+
+	if (ptr && (attributes & IA_CSS_MEM_ATTR_ZEROED))
+		memset(sim_ddr_ptr(ptr, bytes), 0, bytes);
+	return ptr;
+}
+
+static void sim_ddr_free(ia_css_ptr ptr)
+{
+	uint32_t page;
+
+	if (!ptr)
+		return;
+	page = (ptr - SIM_DDR_BASE) / SIM_DDR_PAGE_SIZE;
+	if (ptr < SIM_DDR_BASE || page >= SIM_DDR_PAGES ||
+	    (ptr - SIM_DDR_BASE) % SIM_DDR_PAGE_SIZE ||
+	    !sim_ddr_npages[page])
+		sim_fatal("DDR free", ptr, 0);
+
+	pthread_mutex_lock(&sim_ddr_lock);
+	memset(&sim_ddr_used[page], 0, sim_ddr_npages[page]);
+	sim_ddr_bytes -= (uint64_t)sim_ddr_npages[page] * SIM_DDR_PAGE_SIZE;
+	sim_ddr_npages[page] = 0;
+	sim_stats.ddr_frees++;
+	pthread_mutex_unlock(&sim_ddr_lock);
+}
+
+static int sim_ddr_load(ia_css_ptr ptr, void *data, size_t bytes)
+{
+	uint8_t *p = sim_ddr_ptr(ptr, bytes);
+
+	sim_account(&SIM_SIDE()->ddr, 0, bytes);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	memcpy(data, p, bytes);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	return 0;
+}
+
+static int sim_ddr_store(ia_css_ptr ptr, const void *data, size_t bytes)
+{
+	uint8_t *p = sim_ddr_ptr(ptr, bytes);
+
+	sim_account(&SIM_SIDE()->ddr, 1, bytes);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	memcpy(p, data, bytes);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	return 0;
+}
+
+static int sim_ddr_set(ia_css_ptr ptr, int c, size_t bytes)
+{
+	uint8_t *p = sim_ddr_ptr(ptr, bytes);
+
+	sim_account(&SIM_SIDE()->ddr, 1, bytes);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	memset(p, c, bytes);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	return 0;
+}
+
+/* There are no user pages to map on the host */
+static ia_css_ptr sim_ddr_mmap(const void *ptr, const size_t size,
+			       uint16_t attribute, void *context)
+{
+	(void)ptr;
+	(void)size;
+	(void)attribute;
+	(void)context;
+	return 0;
+}
+
+/*
+ * CPU memory and print env
+ */
+
+static void *sim_cpu_alloc(size_t bytes, bool zero_mem)
+{
+	return zero_mem ? calloc(1, bytes) : malloc(bytes);
+}
+
+static void sim_cpu_free(void *ptr)
+{
+	free(ptr);
+}
+
+static void sim_cpu_flush(struct ia_css_acc_fw *fw)
+{
+	(void)fw;
+}
+
+static int sim_debug_print(const char *fmt, va_list args)
+{
+	if (!sim_verbose)
+		return 0;
+	return vfprintf(stderr, fmt, args);
+}
+
+static int sim_error_print(const char *fmt, va_list args)
+{
+	return vfprintf(stderr, fmt, args);
+}
+
+int sim_env_init(struct ia_css_env *env, int verbose)
+{
+	sim_ddr = malloc(SIM_DDR_SIZE);
+	if (!sim_ddr)
+		return -1;
+	memset(sim_sp_dmem, 0, sizeof(sim_sp_dmem));
+	memset(sim_ddr_used, 0, sizeof(sim_ddr_used));
+	memset(sim_ddr_npages, 0, sizeof(sim_ddr_npages));
+	sim_ddr_next = 0;
+	sim_ddr_bytes = 0;
+	sim_verbose = verbose;
+	sim_env_reset_stats();
+
+	memset(env, 0, sizeof(*env));
+	env->cpu_mem_env.alloc = sim_cpu_alloc;
+	env->cpu_mem_env.free = sim_cpu_free;
+	env->cpu_mem_env.flush = sim_cpu_flush;
+
+	env->css_mem_env.alloc = sim_ddr_alloc;
+	env->css_mem_env.free = sim_ddr_free;
+	env->css_mem_env.load = sim_ddr_load;
+	env->css_mem_env.store = sim_ddr_store;
+	env->css_mem_env.set = sim_ddr_set;
+	env->css_mem_env.mmap = sim_ddr_mmap;
+
+	env->hw_access_env.store_8 = sim_hw_store_8;
+	env->hw_access_env.store_16 = sim_hw_store_16;
+	env->hw_access_env.store_32 = sim_hw_store_32;
+	env->hw_access_env.load_8 = sim_hw_load_8;
+	env->hw_access_env.load_16 = sim_hw_load_16;
+	env->hw_access_env.load_32 = sim_hw_load_32;
+	env->hw_access_env.store = sim_hw_store;
+	env->hw_access_env.load = sim_hw_load;
+
+	env->print_env.debug_print = sim_debug_print;
+	env->print_env.error_print = sim_error_print;
+
+	ia_css_device_access_init(&env->hw_access_env);
+	ia_css_memory_access_init(&env->css_mem_env);
+	return 0;
+}
+
+void sim_env_uninit(void)
+{
+	free(sim_ddr);
+	sim_ddr = NULL;
+}
+
+void sim_env_set_sp_thread(void)
+{
+	sim_sp_thread = 1;
+}
+
+void sim_env_get_stats(struct sim_stats *stats)
+{
+	pthread_mutex_lock(&sim_ddr_lock);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	*stats = sim_stats;
+	pthread_mutex_unlock(&sim_ddr_lock);
+}
+
+void sim_env_reset_stats(void)
+{
+	pthread_mutex_lock(&sim_ddr_lock);
+	memset(&sim_stats, 0, sizeof(sim_stats));
+	sim_stats.ddr_peak_bytes = sim_ddr_bytes;
+	pthread_mutex_unlock(&sim_ddr_lock);
+}
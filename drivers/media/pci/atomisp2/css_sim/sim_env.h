@@ -0,0 +1,71 @@
+/*
+ * Host simulation environment for the CSS.
+ *
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+#ifndef __CSS_SIM_ENV_H_INCLUDED__
+#define __CSS_SIM_ENV_H_INCLUDED__
+
+#include <stdint.h>
+#include "ia_css_env.h"
+
+/*
+ * The simulated system: the SP DMEM and the ISP DDR live in host memory
+ * and are reached through the regular ia_css_env callbacks, so the CSS
+ * host code runs unmodified on top of them. Accesses to any other HW
+ * address go to a register sink: stores are dropped, loads return 0.
+ *
+ * Every access is counted here, in the simulator, never in the CSS
+ * accessors themselves. Accesses made by the simulated SP thread are
+ * counted apart from those of the host.
+ */
+#define SIM_DDR_SIZE		(64 * 1024 * 1024)
+
+struct sim_access_stats {
+	uint64_t loads;
+	uint64_t stores;
+	uint64_t load_bytes;
+	uint64_t store_bytes;
+};
+
+struct sim_side_stats {
+	struct sim_access_stats sp_dmem;	/* SP DMEM */
+	struct sim_access_stats reg;		/* other HW addresses */
+	struct sim_access_stats ddr;		/* ISP virtual memory */
+};
+
+struct sim_stats {
+	struct sim_side_stats host;
+	struct sim_side_stats sp;
+	uint64_t ddr_allocs;
+	uint64_t ddr_frees;
+	uint64_t ddr_peak_bytes;
+};
+
+/* Fill in env and initialize the device and memory access layers. */
+int sim_env_init(struct ia_css_env *env, int verbose);
+void sim_env_uninit(void);
+
+/* Count the accesses of the calling thread as made by the SP. */
+void sim_env_set_sp_thread(void);
+
+void sim_env_get_stats(struct sim_stats *stats);
+void sim_env_reset_stats(void);
+
+#endif /* __CSS_SIM_ENV_H_INCLUDED__ */
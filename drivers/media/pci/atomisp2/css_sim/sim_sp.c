@@ -0,0 +1,408 @@
+/*
+ * Simulated SP for the CSS host simulation.
+ *
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ia_css_types.h"
+#include "ia_css_queue.h"
+#include "sw_event_global.h"
+#include "memory_access.h"
+#include "sh_css_firmware.h"
+#include "sim_env.h"
+#include "sim_sp.h"
+
+#ifndef ARRAY_SIZE
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+#endif
+
+struct sim_sp_queue {
+	bool mapped;
+	enum ia_css_buffer_type buf_type;
+	hrt_vaddress ref;
+	uint32_t ref_size;
+	/* buffers the host announced with a BUFFER_ENQUEUED event */
+	unsigned int pending;
+	ia_css_queue_t host2sp;
+};
+
+struct sim_sp_pipe {
+	uint8_t pipe_id;
+	uint32_t exp_id;
+	uint64_t period_ns;
+	uint64_t next_sof_ns;
+	struct sim_sp_queue queues[SH_CSS_MAX_NUM_QUEUES];
+};
+
+static struct sim_sp_pipe sim_pipes[SH_CSS_MAX_SP_THREADS];
+static ia_css_queue_t sim_sp2host[SH_CSS_MAX_NUM_QUEUES];
+static ia_css_queue_t sim_host2sp_event;
+static ia_css_queue_t sim_sp2host_event;
+static struct sim_sp_stats sim_stats;
+static pthread_mutex_t sim_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t sim_thread;
+static int sim_stop;
+static uint8_t *sim_scratch;
+static uint32_t sim_scratch_size;
+
+static const enum sh_css_sp_event_type sim_done_event[] = {
+	[IA_CSS_BUFFER_TYPE_3A_STATISTICS] = SH_CSS_SP_EVENT_3A_STATISTICS_DONE,
+	[IA_CSS_BUFFER_TYPE_DIS_STATISTICS] = SH_CSS_SP_EVENT_DIS_STATISTICS_DONE,
+	[IA_CSS_BUFFER_TYPE_INPUT_FRAME] = SH_CSS_SP_EVENT_INPUT_FRAME_DONE,
+	[IA_CSS_BUFFER_TYPE_OUTPUT_FRAME] = SH_CSS_SP_EVENT_OUTPUT_FRAME_DONE,
+	[IA_CSS_BUFFER_TYPE_SEC_OUTPUT_FRAME] =
+		SH_CSS_SP_EVENT_SECOND_OUTPUT_FRAME_DONE,
+	[IA_CSS_BUFFER_TYPE_VF_OUTPUT_FRAME] = SH_CSS_SP_EVENT_VF_OUTPUT_FRAME_DONE,
+	[IA_CSS_BUFFER_TYPE_SEC_VF_OUTPUT_FRAME] =
+		SH_CSS_SP_EVENT_SECOND_VF_OUTPUT_FRAME_DONE,
+	[IA_CSS_BUFFER_TYPE_METADATA] = SH_CSS_SP_EVENT_METADATA_DONE,
+};
+
+static uint64_t sim_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* The same layout ia_css_bufq_init() expects, seen from the SP side */
+static void sim_sp_queue_init(ia_css_queue_t *q, unsigned int desc_offset,
+			      unsigned int elems_offset, unsigned int num_elems)
+{
+	ia_css_queue_remote_t remoteq;
+	ia_css_circbuf_desc_t desc;
+
+	remoteq.location = IA_CSS_QUEUE_LOC_SP;
+	remoteq.proc_id = SP0_ID;
+	remoteq.cb_desc_addr = sh_css_sp_fw.info.sp.host_sp_queue + desc_offset;
+	remoteq.cb_elems_addr =
+		sh_css_sp_fw.info.sp.host_sp_queue + elems_offset;
+	ia_css_queue_remote_init(q, &remoteq);
+
+	desc.size = num_elems;
+	desc.step = sizeof(ia_css_circbuf_elem_t);
+	desc.start = 0;
+	desc.end = 0;
+	ia_css_queue_store(q, &desc, 0);
+}
+
+#define SIM_SP_QUEUE_INIT(q, field, index, num_elems)			\
+	sim_sp_queue_init(q,						\
+		offsetof(struct host_sp_queues, field##_desc index),	\
+		offsetof(struct host_sp_queues, field##_elems index),	\
+		num_elems)
+
+void sim_sp_init(void)
+{
+	unsigned int t, q;
+	ia_css_queue_t unused;
+
+	memset(sim_pipes, 0, sizeof(sim_pipes));
+	memset(&sim_stats, 0, sizeof(sim_stats));
+
+	for (t = 0; t < SH_CSS_MAX_SP_THREADS; t++)
+		for (q = 0; q < SH_CSS_MAX_NUM_QUEUES; q++)
+			SIM_SP_QUEUE_INIT(&sim_pipes[t].queues[q].host2sp,
+					  host2sp_buffer_queues, [t][q],
+					  IA_CSS_NUM_ELEMS_HOST2SP_BUFFER_QUEUE);
+	for (q = 0; q < SH_CSS_MAX_NUM_QUEUES; q++)
+		SIM_SP_QUEUE_INIT(&sim_sp2host[q], sp2host_buffer_queues, [q],
+				  IA_CSS_NUM_ELEMS_SP2HOST_BUFFER_QUEUE);
+	SIM_SP_QUEUE_INIT(&sim_host2sp_event, host2sp_psys_event_queue, ,
+			  IA_CSS_NUM_ELEMS_HOST2SP_PSYS_EVENT_QUEUE);
+	SIM_SP_QUEUE_INIT(&sim_sp2host_event, sp2host_psys_event_queue, ,
+			  IA_CSS_NUM_ELEMS_SP2HOST_PSYS_EVENT_QUEUE);
+#if !defined(HAS_NO_INPUT_SYSTEM)
+	SIM_SP_QUEUE_INIT(&unused, host2sp_isys_event_queue, ,
+			  IA_CSS_NUM_ELEMS_HOST2SP_ISYS_EVENT_QUEUE);
+	SIM_SP_QUEUE_INIT(&unused, sp2host_isys_event_queue, ,
+			  IA_CSS_NUM_ELEMS_SP2HOST_ISYS_EVENT_QUEUE);
+#endif
+	SIM_SP_QUEUE_INIT(&unused, host2sp_tag_cmd_queue, ,
+			  IA_CSS_NUM_ELEMS_HOST2SP_TAG_CMD_QUEUE);
+}
+
+void sim_sp_map_queue(unsigned int thread, unsigned int queue_id,
+		      enum ia_css_buffer_type buf_type, uint8_t pipe_id,
+		      hrt_vaddress ref, uint32_t ref_size)
+{
+	struct sim_sp_queue *q = &sim_pipes[thread].queues[queue_id];
+
+	sim_pipes[thread].pipe_id = pipe_id;
+	q->mapped = true;
+	q->buf_type = buf_type;
+	q->ref = ref;
+	q->ref_size = ref_size;
+	if (ref_size > sim_scratch_size) {
+		free(sim_scratch);
+		sim_scratch = malloc(ref_size);
+		sim_scratch_size = ref_size;
+	}
+}
+
+void sim_sp_set_frame_period(unsigned int thread, uint64_t period_ns)
+{
+	sim_pipes[thread].period_ns = period_ns;
+}
+
+static void sim_sp_protocol_error(void)
+{
+	pthread_mutex_lock(&sim_stats_lock);
+	sim_stats.protocol_errors++;
+	pthread_mutex_unlock(&sim_stats_lock);
+}
+
+/*
+ * ia_css_event_encode() packs host events with the event id in the top
+ * byte, while ia_css_event_decode() expects SP events with the id in the
+ * bottom byte; the SP side therefore does its own packing, as the
+ * firmware does.
+ */
+static void sim_sp_event_send(uint8_t evt_id, uint8_t p0, uint8_t p1,
+			      uint8_t p2)
+{
+	uint32_t sw_event = evt_id | (p0 << 8) | (p1 << 16) |
+			    ((uint32_t)p2 << 24);
+
+	/* room was checked before the frame was started */
+	if (ia_css_queue_enqueue(&sim_sp2host_event, sw_event))
+		sim_sp_protocol_error();
+}
+
+/* Follow the host2sp psys events, like the SP event handler does */
+static bool sim_sp_handle_host_events(void)
+{
+	uint32_t sw_event;
+	bool progress = false;
+
+	while (!ia_css_queue_dequeue(&sim_host2sp_event, &sw_event)) {
+		uint8_t evt_id = sw_event >> 24;
+		uint8_t thread = (sw_event >> 16) & 0xff;
+		uint8_t queue_id = (sw_event >> 8) & 0xff;
+
+		progress = true;
+		if (evt_id < ARRAY_SIZE(sim_stats.host_events)) {
+			pthread_mutex_lock(&sim_stats_lock);
+			sim_stats.host_events[evt_id]++;
+			pthread_mutex_unlock(&sim_stats_lock);
+		}
+		if (evt_id != IA_CSS_PSYS_SW_EVENT_BUFFER_ENQUEUED)
+			continue;
+		if (thread >= SH_CSS_MAX_SP_THREADS ||
+		    queue_id >= SH_CSS_MAX_NUM_QUEUES ||
+		    !sim_pipes[thread].queues[queue_id].mapped) {
+			sim_sp_protocol_error();
+			continue;
+		}
+		sim_pipes[thread].queues[queue_id].pending++;
+	}
+	return progress;
+}
+
+/* Fill one buffer with the reference data and its exposure id */
+static void sim_sp_complete(struct sim_sp_queue *q, hrt_vaddress vptr,
+			    uint32_t exp_id, uint32_t config_id)
+{
+	struct sh_css_hmm_buffer buf;
+	hrt_vaddress dst = mmgr_NULL;
+	uint32_t size = q->ref_size;
+
+	mmgr_load(vptr, &buf, sizeof(buf));
+	switch (q->buf_type) {
+	case IA_CSS_BUFFER_TYPE_3A_STATISTICS:
+		dst = buf.payload.s3a.data_ptr;
+		if (buf.payload.s3a.size < size)
+			size = buf.payload.s3a.size;
+		buf.payload.s3a.exp_id = exp_id;
+		buf.payload.s3a.isp_config_id = config_id;
+		break;
+	case IA_CSS_BUFFER_TYPE_METADATA:
+		dst = buf.payload.metadata.address;
+		if (buf.payload.metadata.info.size < size)
+			size = buf.payload.metadata.info.size;
+		buf.payload.metadata.exp_id = exp_id;
+		break;
+	case IA_CSS_BUFFER_TYPE_INPUT_FRAME:
+	case IA_CSS_BUFFER_TYPE_OUTPUT_FRAME:
+	case IA_CSS_BUFFER_TYPE_SEC_OUTPUT_FRAME:
+	case IA_CSS_BUFFER_TYPE_VF_OUTPUT_FRAME:
+	case IA_CSS_BUFFER_TYPE_SEC_VF_OUTPUT_FRAME:
+		dst = buf.payload.frame.frame_data;
+		buf.payload.frame.exp_id = exp_id;
+		buf.payload.frame.isp_parameters_id = config_id;
+		buf.payload.frame.flashed = 0;
+		break;
+	default:
+		sim_sp_protocol_error();
+		break;
+	}
+
+	if (dst != mmgr_NULL && size >= sizeof(exp_id)) {
+		mmgr_load(q->ref, sim_scratch, size);
+		memcpy(sim_scratch, &exp_id, sizeof(exp_id));
+		mmgr_store(dst, sim_scratch, size);
+	} else {
+		sim_sp_protocol_error();
+	}
+	mmgr_store(vptr, &buf, sizeof(buf));
+}
+
+static bool sim_sp_run_frame(unsigned int thread, uint64_t now)
+{
+	struct sim_sp_pipe *pipe = &sim_pipes[thread];
+	struct sim_sp_queue *out = NULL;
+	unsigned int take[SH_CSS_MAX_NUM_QUEUES];
+	unsigned int n = 0, i, q;
+	uint32_t room;
+
+	if (pipe->period_ns && now < pipe->next_sof_ns)
+		return false;
+
+	for (q = 0; q < SH_CSS_MAX_NUM_QUEUES; q++) {
+		struct sim_sp_queue *sq = &pipe->queues[q];
+
+		if (!sq->mapped)
+			continue;
+		if (sq->buf_type == IA_CSS_BUFFER_TYPE_OUTPUT_FRAME)
+			out = sq;
+		if (sq->pending)
+			take[n++] = q;
+	}
+	if (!out)
+		return false;
+
+	if (!out->pending) {
+		/* a paced sensor does not wait for the host */
+		if (pipe->period_ns) {
+			pipe->next_sof_ns += pipe->period_ns;
+			pthread_mutex_lock(&sim_stats_lock);
+			sim_stats.thread[thread].dropped++;
+			pthread_mutex_unlock(&sim_stats_lock);
+		}
+		return false;
+	}
+
+	/*
+	 * The whole frame must fit, the SP does not block on the host. The
+	 * free space counts the slot a circbuf always keeps empty.
+	 */
+	if (ia_css_queue_get_free_space(&sim_sp2host_event, &room) ||
+	    room <= n)
+		goto stall;
+	for (i = 0; i < n; i++)
+		if (ia_css_queue_get_free_space(&sim_sp2host[take[i]], &room) ||
+		    room <= 1)
+			goto stall;
+
+	pipe->exp_id = pipe->exp_id >= IA_CSS_ISYS_MAX_EXPOSURE_ID ?
+		       IA_CSS_ISYS_MIN_EXPOSURE_ID : pipe->exp_id + 1;
+
+	for (i = 0; i < n; i++) {
+		struct sim_sp_queue *sq = &pipe->queues[take[i]];
+		uint32_t vptr;
+
+		if (ia_css_queue_dequeue(&sq->host2sp, &vptr)) {
+			/* announced by an event but not in the queue */
+			sim_sp_protocol_error();
+			sq->pending = 0;
+			continue;
+		}
+		sq->pending--;
+		sim_sp_complete(sq, vptr, pipe->exp_id,
+				(uint32_t)sim_stats.thread[thread].frames);
+		ia_css_queue_enqueue(&sim_sp2host[take[i]], vptr);
+		sim_sp_event_send(sim_done_event[sq->buf_type], thread,
+				  pipe->pipe_id, 0);
+		pthread_mutex_lock(&sim_stats_lock);
+		sim_stats.thread[thread].buffers[sq->buf_type]++;
+		pthread_mutex_unlock(&sim_stats_lock);
+	}
+
+	pthread_mutex_lock(&sim_stats_lock);
+	sim_stats.thread[thread].frames++;
+	pthread_mutex_unlock(&sim_stats_lock);
+	if (pipe->period_ns)
+		pipe->next_sof_ns += pipe->period_ns;
+	return true;
+
+stall:
+	pthread_mutex_lock(&sim_stats_lock);
+	sim_stats.stalls++;
+	pthread_mutex_unlock(&sim_stats_lock);
+	return false;
+}
+
+static void *sim_sp_main(void *arg)
+{
+	unsigned int t;
+
+	(void)arg;
+	sim_env_set_sp_thread();
+
+	while (!__atomic_load_n(&sim_stop, __ATOMIC_ACQUIRE)) {
+		uint64_t now = sim_now_ns();
+		bool progress = sim_sp_handle_host_events();
+
+		for (t = 0; t < SH_CSS_MAX_SP_THREADS; t++)
+			progress |= sim_sp_run_frame(t, now);
+		if (!progress)
+			hrt_sleep();
+	}
+	return NULL;
+}
+
+int sim_sp_start(void)
+{
+	uint64_t now = sim_now_ns();
+	unsigned int t;
+
+	for (t = 0; t < SH_CSS_MAX_SP_THREADS; t++)
+		sim_pipes[t].next_sof_ns = now;
+	sim_stop = 0;
+	return pthread_create(&sim_thread, NULL, sim_sp_main, NULL);
+}
+
+void sim_sp_stop(void)
+{
+	__atomic_store_n(&sim_stop, 1, __ATOMIC_RELEASE);
+	pthread_join(sim_thread, NULL);
+	free(sim_scratch);
+	sim_scratch = NULL;
+	sim_scratch_size = 0;
+}
+
+int sim_sp_queued(unsigned int thread, unsigned int queue_id,
+		  uint32_t *used)
+{
+	return ia_css_queue_get_used_space(
+			&sim_pipes[thread].queues[queue_id].host2sp, used);
+}
+
+void sim_sp_get_stats(struct sim_sp_stats *stats)
+{
+	pthread_mutex_lock(&sim_stats_lock);
+	*stats = sim_stats;
+	pthread_mutex_unlock(&sim_stats_lock);
+}
@@ -0,0 +1,79 @@
+/*
+ * Simulated SP for the CSS host simulation.
+ *
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+#ifndef __CSS_SIM_SP_H_INCLUDED__
+#define __CSS_SIM_SP_H_INCLUDED__
+
+#include <stdint.h>
+#include "ia_css_buffer.h"
+#include "sh_css_internal.h"
+
+/*
+ * The simulated SP owns the host_sp_queues block in the simulated SP
+ * DMEM and serves it from its own thread the way the SP firmware does:
+ * it follows the host2sp psys events, takes one buffer per mapped queue
+ * of a pipeline thread per frame, completes it with a copy of the
+ * reference data and hands it back through the sp2host buffer queue
+ * with a done event. A frame needs an output frame buffer; the other
+ * buffers are filled when the host provided one. The SP never blocks:
+ * a frame waits until the sp2host queues have room for all of it.
+ *
+ * The first 4 bytes of every completed buffer hold its exposure id.
+ */
+
+struct sim_sp_thread_stats {
+	uint64_t frames;
+	uint64_t dropped;	/* paced frames without an output buffer */
+	uint64_t buffers[IA_CSS_NUM_DYNAMIC_BUFFER_TYPE];
+};
+
+struct sim_sp_stats {
+	struct sim_sp_thread_stats thread[SH_CSS_MAX_SP_THREADS];
+	uint64_t stalls;		/* frame waited for sp2host room */
+	uint64_t host_events[8];	/* by enum ia_css_psys_sw_event */
+	uint64_t protocol_errors;
+};
+
+/* Set up the queues in SP DMEM; before ia_css_bufq_init(). */
+void sim_sp_init(void);
+
+/*
+ * Tell the SP that queue_id of thread carries buf_type buffers, as the
+ * stage configuration does on the real system. ref is the ISP address
+ * of the reference data copied into every completed buffer.
+ */
+void sim_sp_map_queue(unsigned int thread, unsigned int queue_id,
+		      enum ia_css_buffer_type buf_type, uint8_t pipe_id,
+		      hrt_vaddress ref, uint32_t ref_size);
+
+/* 0 runs frames as fast as buffers allow, else one frame per period */
+void sim_sp_set_frame_period(unsigned int thread, uint64_t period_ns);
+
+int sim_sp_start(void);
+void sim_sp_stop(void);
+
+/* Number of buffers in the host2sp queue queue_id of thread */
+int sim_sp_queued(unsigned int thread, unsigned int queue_id,
+		  uint32_t *used);
+
+void sim_sp_get_stats(struct sim_sp_stats *stats);
+
+#endif /* __CSS_SIM_SP_H_INCLUDED__ */
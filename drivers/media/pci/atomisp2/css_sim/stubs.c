@@ -0,0 +1,81 @@
+/*
+ * Host stand-ins for the CSS runtime used by the simulation.
+ *
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+/*
+ * The parts of the CSS runtime that the queue code needs and that are
+ * not worth linking: the trace globals, the host allocators and the SP
+ * firmware descriptor, whose host_sp_queue tells where the queues live
+ * in SP DMEM. util.c comes along for ia_css_convert_errno(); its frame
+ * checks are never called here.
+ */
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include "ia_css_debug.h"
+#include "ia_css_frame.h"
+#include "ia_css_binary.h"
+#include "sh_css_firmware.h"
+#include "sh_css_internal.h"
+
+/* where the SP firmware of this CSS keeps its host_sp_queues */
+#define SIM_HOST_SP_QUEUE	0x1000
+
+unsigned int ia_css_debug_trace_level = IA_CSS_DEBUG_ERROR;
+bool ia_css_debug_trace_ring_enabled;
+int (*sh_css_printf)(const char *fmt, va_list args);
+
+struct ia_css_fw_info sh_css_sp_fw = {
+	.info.sp.host_sp_queue = SIM_HOST_SP_QUEUE,
+};
+
+void ia_css_debug_trace_ring_record(unsigned int level, const char *fmt,
+				    va_list args)
+{
+	(void)level;
+	(void)fmt;
+	(void)args;
+}
+
+void *sh_css_malloc(size_t size)
+{
+	return size ? malloc(size) : NULL;
+}
+
+void *sh_css_calloc(size_t N, size_t size)
+{
+	return (N && size) ? calloc(N, size) : NULL;
+}
+
+void sh_css_free(void *ptr)
+{
+	free(ptr);
+}
+
+enum ia_css_err ia_css_frame_check_info(const struct ia_css_frame_info *info)
+{
+	(void)info;
+	abort();
+}
+
+unsigned ia_css_binary_max_vf_width(void)
+{
+	abort();
+}
@@ -0,0 +1,312 @@
+/*
+ * Host replay of the atomisp DFS utilization governor.
+ *
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+/*
+ * Runs the governor of atomisp_dfs_gov.c over samples the way
+ * atomisp_dfs_gov_frame_done() does, without the ISP: each sample goes
+ * into the running average of its stream, and every
+ * ATOMISP_DFS_GOV_EVAL_FRAMES samples the summed load is evaluated
+ * against the DFS table of the platform.
+ *
+ * With a log, the samples are its "DFS sample: stream fps busy_us freq"
+ * lines, as the driver logs them at debug level; other lines are
+ * skipped. The ISP busy time goes with the inverse of its clock, so each
+ * sample is scaled from the frequency it was measured at to the one the
+ * replay has picked. The replay starts at the frequency of the first
+ * sample.
+ *
+ * Without a log, a few fixed loads are generated, as if logged at a
+ * fixed clock, and the governor must settle on the frequency each of
+ * them needs on the merr table, with the default settings and in a
+ * single step.
+ *
+ * Usage: dfs_replay [-p platform] [-t target_pct] [-d down_evals] [log|-]
+ */
+
+#include <getopt.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <linux/atomisp.h>
+#include <linux/kernel.h>
+
+#include "atomisp-regs.h"
+#include "atomisp_dfs_gov.h"
+#include "atomisp_dfs_tables.h"
+
+#define DR_MAX_STREAMS		2	/* MAX_STREAM_NUM of the driver */
+#define DR_SAMPLE_TAG		"DFS sample:"
+#define DR_LOAD_FRAMES		400
+
+struct dr_platform {
+	const char *name;
+	const struct atomisp_dfs_config *dfs;
+};
+
+static const struct dr_platform dr_platforms[] = {
+	{ "merr", &dfs_config_merr },
+	{ "merr_1179", &dfs_config_merr_1179 },
+	{ "merr_117a", &dfs_config_merr_117a },
+	{ "byt", &dfs_config_byt },
+	{ "byt_cr", &dfs_config_byt_cr },
+	{ "cht", &dfs_config_cht },
+};
+
+struct dr_replay {
+	struct atomisp_dfs_gov gov;
+	const struct atomisp_dfs_config *dfs;
+	unsigned int freq;		/* picked, MHz */
+	unsigned short fps[DR_MAX_STREAMS];
+	unsigned int busy_us[DR_MAX_STREAMS];
+	unsigned int frames;
+	unsigned int evals;
+	unsigned int overloads;		/* evaluations over 100% load */
+	unsigned int step_eval;		/* evaluation of the last step */
+	unsigned long long freq_frames;	/* sum of freq over the frames */
+};
+
+/*
+ * A load to settle on: streams at fps, each taking cycles ISP cycles per
+ * frame (MHz times us), logged at log_freq. freq, ups and downs are what
+ * the governor must end up with on dfs_config_merr, and step_eval the
+ * evaluation that takes the step: the first one going up, the
+ * down_evals'th going down.
+ */
+struct dr_load {
+	const char *name;
+	unsigned int streams;
+	unsigned short fps;
+	unsigned int cycles;
+	unsigned int log_freq;
+	unsigned int freq;
+	unsigned int ups;
+	unsigned int downs;
+	unsigned int step_eval;
+};
+
+static const struct dr_load dr_loads[] = {
+	{ "idle", 1, 30, 1500000, ISP_FREQ_400MHZ, ISP_FREQ_200MHZ, 0, 1,
+	  ATOMISP_DFS_GOV_DOWN_EVALS },
+	{ "heavy", 1, 30, 6000000, ISP_FREQ_200MHZ, ISP_FREQ_400MHZ, 1, 0, 1 },
+	{ "overload", 1, 30, 14000000, ISP_FREQ_200MHZ, ISP_FREQ_457MHZ, 1, 0, 1 },
+	{ "dual", 2, 30, 3000000, ISP_FREQ_457MHZ, ISP_FREQ_400MHZ, 0, 1,
+	  ATOMISP_DFS_GOV_DOWN_EVALS },
+};
+
+static unsigned int dr_errors;
+
+static void dr_init(struct dr_replay *rp, const struct atomisp_dfs_config *dfs,
+		    unsigned int target_pct, unsigned int down_evals)
+{
+	memset(rp, 0, sizeof(*rp));
+	rp->dfs = dfs;
+	rp->gov.target_pct = target_pct;
+	rp->gov.down_evals = down_evals;
+}
+
+/* One sample: busy_us on stream at fps, measured at freq */
+static int dr_sample(struct dr_replay *rp, unsigned int stream,
+		     unsigned int fps, unsigned int busy_us, unsigned int freq)
+{
+	unsigned int util_pct = 0, freq_was;
+	int i;
+
+	if (stream >= DR_MAX_STREAMS || !fps || fps > USHRT_MAX || !freq ||
+	    !busy_us)
+		return -1;
+
+	if (!rp->freq)
+		rp->freq = freq;
+
+	busy_us = ((unsigned long long)busy_us * freq + rp->freq - 1) /
+		  rp->freq;
+
+	rp->fps[stream] = fps;
+	rp->busy_us[stream] = atomisp_dfs_gov_avg(rp->busy_us[stream],
+						  busy_us);
+	rp->frames++;
+	rp->freq_frames += rp->freq;
+
+	if (++rp->gov.frames < ATOMISP_DFS_GOV_EVAL_FRAMES)
+		return 0;
+	rp->gov.frames = 0;
+
+	for (i = 0; i < DR_MAX_STREAMS; i++)
+		if (rp->fps[i])
+			util_pct += atomisp_dfs_gov_util(rp->busy_us[i],
+							 rp->fps[i]);
+
+	rp->evals++;
+	if (util_pct > 100)
+		rp->overloads++;
+	freq_was = rp->freq;
+	rp->freq = atomisp_dfs_gov_eval(&rp->gov, rp->dfs, rp->freq,
+					util_pct);
+	if (rp->freq != freq_was)
+		rp->step_eval = rp->evals;
+
+	return 0;
+}
+
+static int dr_replay_log(struct dr_replay *rp, FILE *f)
+{
+	unsigned int stream, fps, busy_us, freq, n = 0;
+	char line[512];
+
+	while (fgets(line, sizeof(line), f)) {
+		const char *s = strstr(line, DR_SAMPLE_TAG);
+
+		n++;
+		if (!s)
+			continue;
+		if (sscanf(s + strlen(DR_SAMPLE_TAG), "%u %u %u %u", &stream,
+			   &fps, &busy_us, &freq) != 4 ||
+		    dr_sample(rp, stream, fps, busy_us, freq)) {
+			fprintf(stderr, "line %u: bad sample: %s", n, s);
+			dr_errors++;
+		}
+	}
+	if (ferror(f)) {
+		perror("read");
+		return -1;
+	}
+	if (!rp->frames) {
+		fprintf(stderr, "no \"" DR_SAMPLE_TAG "\" lines; these are logged at debug level\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+static void dr_run_load(struct dr_replay *rp, const struct dr_load *load)
+{
+	unsigned int busy_us = load->cycles / load->log_freq;
+	unsigned int i;
+
+	for (i = 0; i < DR_LOAD_FRAMES; i++)
+		dr_sample(rp, i % load->streams, load->fps, busy_us,
+			  load->log_freq);
+
+	if (rp->freq != load->freq || rp->gov.ups != load->ups ||
+	    rp->gov.downs != load->downs) {
+		fprintf(stderr, "%s: ended at %u MHz after %u up %u down, expected %u MHz after %u up %u down\n",
+			load->name, rp->freq, rp->gov.ups, rp->gov.downs,
+			load->freq, load->ups, load->downs);
+		dr_errors++;
+	} else if (rp->step_eval != load->step_eval) {
+		fprintf(stderr, "%s: stepped at evaluation %u, expected %u\n",
+			load->name, rp->step_eval, load->step_eval);
+		dr_errors++;
+	}
+}
+
+static void dr_report_header(void)
+{
+	printf("  %-10s %8s %6s %9s %4s %4s %6s %8s\n", "", "frames",
+	       "evals", "overloads", "up", "down", "freq", "avg freq");
+}
+
+static void dr_report(const char *name, const struct dr_replay *rp)
+{
+	printf("  %-10s %8u %6u %9u %4u %4u %6u %8llu\n", name, rp->frames,
+	       rp->evals, rp->overloads, rp->gov.ups, rp->gov.downs,
+	       rp->freq, rp->freq_frames / rp->frames);
+}
+
+int main(int argc, char **argv)
+{
+	const struct dr_platform *platform = &dr_platforms[0];
+	unsigned int target_pct = ATOMISP_DFS_GOV_TARGET_PCT;
+	unsigned int down_evals = ATOMISP_DFS_GOV_DOWN_EVALS;
+	struct dr_replay rp;
+	unsigned int i;
+	int opt, bad = 0;
+
+	while ((opt = getopt(argc, argv, "p:t:d:")) != -1) {
+		switch (opt) {
+		case 'p':
+			platform = NULL;
+			for (i = 0; i < ARRAY_SIZE(dr_platforms); i++)
+				if (!strcmp(optarg, dr_platforms[i].name))
+					platform = &dr_platforms[i];
+			bad |= !platform;
+			break;
+		case 't':
+			target_pct = strtoul(optarg, NULL, 0);
+			bad |= !target_pct;
+			break;
+		case 'd':
+			down_evals = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			bad = 1;
+			break;
+		}
+	}
+	if (bad || argc - optind > 1) {
+		fprintf(stderr, "usage: %s [-p platform] [-t target_pct] [-d down_evals] [log|-]\nplatforms:",
+			argv[0]);
+		for (i = 0; i < ARRAY_SIZE(dr_platforms); i++)
+			fprintf(stderr, " %s", dr_platforms[i].name);
+		fprintf(stderr, "\n");
+		return 1;
+	}
+
+	if (optind < argc) {
+		FILE *f = stdin;
+		int ret;
+
+		if (strcmp(argv[optind], "-")) {
+			f = fopen(argv[optind], "r");
+			if (!f) {
+				perror(argv[optind]);
+				return 1;
+			}
+		}
+		dr_init(&rp, platform->dfs, target_pct, down_evals);
+		ret = dr_replay_log(&rp, f);
+		if (f != stdin)
+			fclose(f);
+		if (ret)
+			return 1;
+
+		printf("platform %s, target %u%%, down after %u evaluations\n",
+		       platform->name, target_pct, down_evals);
+		dr_report_header();
+		dr_report("log", &rp);
+	} else {
+		printf("platform merr, target %u%%, down after %u evaluations\n",
+		       ATOMISP_DFS_GOV_TARGET_PCT, ATOMISP_DFS_GOV_DOWN_EVALS);
+		dr_report_header();
+		for (i = 0; i < ARRAY_SIZE(dr_loads); i++) {
+			dr_init(&rp, &dfs_config_merr,
+				ATOMISP_DFS_GOV_TARGET_PCT,
+				ATOMISP_DFS_GOV_DOWN_EVALS);
+			dr_run_load(&rp, &dr_loads[i]);
+			dr_report(dr_loads[i].name, &rp);
+		}
+	}
+
+	printf("%u errors\n%s\n", dr_errors, dr_errors ? "FAILED" : "PASSED");
+	return dr_errors ? 1 : 0;
+}
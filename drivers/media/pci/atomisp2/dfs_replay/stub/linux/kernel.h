@@ -0,0 +1,35 @@
+/*
+ * Support for Intel Camera Imaging ISP subsystem.
+ *
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+#ifndef __DFS_REPLAY_LINUX_KERNEL_H_INCLUDED__
+#define __DFS_REPLAY_LINUX_KERNEL_H_INCLUDED__
+
+/*
+ * What atomisp_dfs_gov.c and atomisp_dfs_tables.h take from the kernel
+ * headers, with the same definitions.
+ */
+#include <stdbool.h>
+
+#define ARRAY_SIZE(arr)		(sizeof(arr) / sizeof((arr)[0]))
+#define DIV_ROUND_UP(n, d)	(((n) + (d) - 1) / (d))
+#define USEC_PER_SEC		1000000L
+
+#endif /* __DFS_REPLAY_LINUX_KERNEL_H_INCLUDED__ */
@@ -0,0 +1,359 @@
+/*
+ * Host benchmark for the CSS firmware index.
+ *
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+/*
+ * Loads a firmware package the way ia_css_load_firmware() does after a
+ * deferred power down, both ways:
+ *
+ *   cold     sh_css_load_firmware(): parse and check every binary
+ *            header, copy names, memory offsets and the SP code
+ *   indexed  sh_css_firmware_index_match() and _rebase(): recognise the
+ *            package the index was built from and point the kept
+ *            descriptors at the new copy
+ *
+ * Every load gets a fresh copy of the image at a new address, as
+ * request_firmware() gives the driver. The copy of the binaries to ISP
+ * memory and ia_css_binary_init_infos() follow either way and are not
+ * timed. After each indexed load the descriptors must be those of a
+ * cold parse of the same copy, and a package with a changed binary
+ * header or size must not hit the index.
+ *
+ * The image is a shisp_*.bin of the CSS this is built for, from a
+ * 64-bit build like the host. Without one, a package of FB_SYN_BINARIES
+ * binaries in the same layout is generated.
+ *
+ * Usage: fw_bench [-n loads] [firmware]
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sh_css_firmware.h"
+#include "sh_css_internal.h"
+#include "ia_css_isp_params.h"
+#include "ia_css_isp_configs.h"
+#include "ia_css_isp_states.h"
+#include "isp.h"
+
+#define FB_DEFAULT_LOADS	100
+
+/* release_version of sh_css_firmware.c */
+#define FB_SYN_VERSION		"irci_master_20141125_0453"
+#define FB_SYN_BINARIES		64
+#define FB_SYN_BLOB_SIZE	(32 * 1024)
+#define FB_BLOB_ALIGN		(1U << (ISP_PMEM_WIDTH_LOG2 - 3))
+
+#define FB_ALIGN(x, a)		(((x) + (a) - 1) / (a) * (a))
+
+struct fb_stat {
+	unsigned long long ns;
+	unsigned long long min_ns;
+	unsigned long long max_ns;
+	unsigned int loads;
+};
+
+static unsigned int fb_errors;
+
+static unsigned long long fb_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void fb_record(struct fb_stat *s, unsigned long long ns)
+{
+	if (!s->loads || ns < s->min_ns)
+		s->min_ns = ns;
+	if (ns > s->max_ns)
+		s->max_ns = ns;
+	s->ns += ns;
+	s->loads++;
+}
+
+static char *fb_read(const char *path, unsigned int *size)
+{
+	FILE *f = fopen(path, "rb");
+	char *data;
+	long len;
+
+	if (!f) {
+		perror(path);
+		return NULL;
+	}
+	if (fseek(f, 0, SEEK_END) || (len = ftell(f)) <= 0 ||
+	    fseek(f, 0, SEEK_SET)) {
+		fprintf(stderr, "%s: cannot size\n", path);
+		fclose(f);
+		return NULL;
+	}
+	data = malloc(len);
+	if (data && fread(data, 1, len, f) != (size_t)len) {
+		fprintf(stderr, "%s: short read\n", path);
+		free(data);
+		data = NULL;
+	}
+	fclose(f);
+	*size = len;
+	return data;
+}
+
+/*
+ * A package as the firmware generator lays it out: the file header, all
+ * binary headers, then per binary its name, memory offsets and blob.
+ */
+static char *fb_synthesize(unsigned int *size)
+{
+	const size_t offsets_size = sizeof(struct ia_css_memory_offsets) +
+				    sizeof(struct ia_css_config_memory_offsets) +
+				    sizeof(struct ia_css_state_memory_offsets);
+	struct sh_css_fw_bi_file_h *file_header;
+	struct ia_css_fw_info *bi;
+	size_t pos, total;
+	unsigned int i;
+	char *data;
+
+	pos = sizeof(*file_header) + FB_SYN_BINARIES * sizeof(*bi);
+	total = pos;
+	for (i = 0; i < FB_SYN_BINARIES; i++)
+		total = FB_ALIGN(total + 32 + offsets_size, FB_BLOB_ALIGN) +
+			FB_SYN_BLOB_SIZE;
+
+	data = calloc(1, total);
+	if (!data)
+		return NULL;
+
+	file_header = (struct sh_css_fw_bi_file_h *)data;
+	strncpy(file_header->version, FB_SYN_VERSION,
+		sizeof(file_header->version) - 1);
+	file_header->binary_nr = FB_SYN_BINARIES;
+	file_header->h_size = sizeof(*file_header);
+
+	bi = (struct ia_css_fw_info *)(file_header + 1);
+	for (i = 0; i < FB_SYN_BINARIES; i++, bi++) {
+		enum ia_css_param_class c;
+		size_t offset;
+
+		bi->header_size = sizeof(*bi);
+		bi->type = i < NUM_OF_SPS ? ia_css_sp_firmware :
+					    ia_css_isp_firmware;
+		if (bi->type == ia_css_isp_firmware)
+			bi->info.isp.sp.id = i;
+
+		bi->blob.prog_name_offset = pos;
+		snprintf(data + pos, 32, "isp_binary_%u", i);
+		pos += 32;
+
+		offset = pos;
+		for (c = IA_CSS_PARAM_CLASS_PARAM; c <= IA_CSS_PARAM_CLASS_STATE;
+		     c++)
+			bi->blob.memory_offsets.offsets[c] = offset;
+		memset(data + pos, i, offsets_size);
+		pos += offsets_size;
+
+		pos = FB_ALIGN(pos, FB_BLOB_ALIGN);
+		bi->blob.offset = pos;
+		bi->blob.size = FB_SYN_BLOB_SIZE;
+		bi->blob.text_size = FB_SYN_BLOB_SIZE / 2;
+		bi->blob.icache_size = FB_SYN_BLOB_SIZE / 4;
+		bi->blob.data_size = FB_SYN_BLOB_SIZE / 4;
+		bi->blob.data_source = bi->blob.text_size +
+				       bi->blob.icache_size;
+		memset(data + pos, 0xa5 ^ i, FB_SYN_BLOB_SIZE);
+		pos += FB_SYN_BLOB_SIZE;
+	}
+
+	*size = total;
+	return data;
+}
+
+/* Blob offsets of the ISP binaries after a cold parse of a copy */
+static unsigned int *fb_offsets;
+
+static void fb_check_rebase(const char *copy, const struct ia_css_blob_descr *ref)
+{
+	unsigned int i;
+
+	for (i = 0; i < sh_css_num_binaries - NUM_OF_SPS; i++) {
+		const struct ia_css_blob_descr *bd = &sh_css_blob_info[i];
+
+		if (bd->blob != (const unsigned char *)copy + fb_offsets[i] ||
+		    memcmp(&bd->header, &ref[i].header, sizeof(bd->header)) ||
+		    strcmp(bd->name, ref[i].name)) {
+			fprintf(stderr, "binary %u: indexed descriptor differs\n",
+				NUM_OF_SPS + i);
+			fb_errors++;
+			return;
+		}
+	}
+}
+
+/* A package that is not the indexed one must be parsed again */
+static void fb_check_miss(const char *image, unsigned int size)
+{
+	struct ia_css_fw_info *bi;
+	char *copy = malloc(size);
+
+	if (!copy)
+		return;
+	memcpy(copy, image, size);
+
+	if (sh_css_firmware_index_match(copy, size - 1)) {
+		fprintf(stderr, "a package of another size hits the index\n");
+		fb_errors++;
+	}
+
+	bi = (struct ia_css_fw_info *)(copy +
+				       sizeof(struct sh_css_fw_bi_file_h));
+	bi[sh_css_num_binaries - 1].blob.text_size ^= 1;
+	if (sh_css_firmware_index_match(copy, size)) {
+		fprintf(stderr, "a changed binary header hits the index\n");
+		fb_errors++;
+	}
+
+	free(copy);
+}
+
+static void fb_report(const char *name, const struct fb_stat *s)
+{
+	printf("  %-10s %8u %12llu %12llu %12llu\n", name, s->loads,
+	       s->ns / s->loads, s->min_ns, s->max_ns);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int loads = FB_DEFAULT_LOADS, size, i, n;
+	struct fb_stat cold = { 0 }, indexed = { 0 };
+	struct ia_css_blob_descr *ref;
+	char *image, *copy;
+	enum ia_css_err err;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:")) != -1) {
+		switch (opt) {
+		case 'n':
+			loads = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			loads = 0;
+			break;
+		}
+	}
+	if (!loads || argc - optind > 1) {
+		fprintf(stderr, "usage: %s [-n loads] [firmware]\n", argv[0]);
+		return 1;
+	}
+
+	if (optind < argc)
+		image = fb_read(argv[optind], &size);
+	else
+		image = fb_synthesize(&size);
+	if (!image)
+		return 1;
+
+	copy = malloc(size);
+	if (!copy)
+		return 1;
+	memcpy(copy, image, size);
+	err = sh_css_load_firmware(copy, size);
+	if (err != IA_CSS_SUCCESS) {
+		fprintf(stderr, "firmware %s does not load: error %d\n",
+			sh_css_get_fw_version(), err);
+		return 1;
+	}
+	n = sh_css_num_binaries;
+	printf("firmware %s: %u bytes, %u binaries\n",
+	       sh_css_get_fw_version(), size, n);
+	if (n <= NUM_OF_SPS) {
+		fprintf(stderr, "no ISP binaries\n");
+		return 1;
+	}
+
+	/* the cold parse is the reference for the indexed loads */
+	ref = malloc((n - NUM_OF_SPS) * sizeof(*ref));
+	fb_offsets = malloc((n - NUM_OF_SPS) * sizeof(*fb_offsets));
+	if (!ref || !fb_offsets)
+		return 1;
+	for (i = 0; i < n - NUM_OF_SPS; i++) {
+		ref[i] = sh_css_blob_info[i];
+		ref[i].name = strdup(sh_css_blob_info[i].name);
+		fb_offsets[i] = sh_css_blob_info[i].blob -
+				(const unsigned char *)copy;
+	}
+	fb_check_miss(image, size);
+
+	for (i = 0; i < loads; i++) {
+		unsigned long long start;
+		char *next;
+
+		/* what ia_css_unload_firmware() does before a full load */
+		sh_css_unload_firmware();
+		free(copy);
+		copy = malloc(size);
+		if (!copy)
+			return 1;
+		memcpy(copy, image, size);
+
+		start = fb_now_ns();
+		err = sh_css_load_firmware(copy, size);
+		fb_record(&cold, fb_now_ns() - start);
+		if (err != IA_CSS_SUCCESS) {
+			fprintf(stderr, "load %u: error %d\n", i, err);
+			return 1;
+		}
+
+		/* the next power up, the same package at a new address */
+		next = malloc(size);
+		if (!next)
+			return 1;
+		memcpy(next, image, size);
+
+		start = fb_now_ns();
+		if (sh_css_firmware_index_match(next, size))
+			sh_css_firmware_index_rebase(next);
+		fb_record(&indexed, fb_now_ns() - start);
+		if (next[0] != image[0] ||
+		    !sh_css_firmware_index_match(next, size)) {
+			fprintf(stderr, "load %u: index missed\n", i);
+			fb_errors++;
+		}
+
+		fb_check_rebase(next, ref);
+		free(copy);
+		copy = next;
+	}
+
+	printf("  %-10s %8s %12s %12s %12s\n",
+	       "", "loads", "ns/load", "min ns", "max ns");
+	fb_report("cold", &cold);
+	fb_report("indexed", &indexed);
+
+	sh_css_unload_firmware();
+	free(copy);
+	free(image);
+
+	printf("%u errors\n%s\n", fb_errors, fb_errors ? "FAILED" : "PASSED");
+	return fb_errors ? 1 : 0;
+}
@@ -0,0 +1,68 @@
+/*
+ * Host stand-ins for the CSS runtime used by the firmware parser.
+ *
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+/*
+ * The parser only needs the trace globals and the host allocators.
+ * sh_css_load_blob(), which copies a binary to ISP memory, comes along
+ * in the same object but is never called here.
+ */
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include "ia_css_debug.h"
+#include "memory_access.h"
+#include "sh_css_internal.h"
+
+unsigned int ia_css_debug_trace_level = IA_CSS_DEBUG_ERROR;
+bool ia_css_debug_trace_ring_enabled;
+int (*sh_css_printf)(const char *fmt, va_list args);
+
+void ia_css_debug_trace_ring_record(unsigned int level, const char *fmt,
+				    va_list args)
+{
+	(void)level;
+	(void)fmt;
+	(void)args;
+}
+
+void *sh_css_malloc(size_t size)
+{
+	return size ? malloc(size) : NULL;
+}
+
+void sh_css_free(void *ptr)
+{
+	free(ptr);
+}
+
+hrt_vaddress mmgr_malloc(const size_t size)
+{
+	(void)size;
+	abort();
+}
+
+void mmgr_store(const hrt_vaddress vaddr, const void *data, const size_t size)
+{
+	(void)vaddr;
+	(void)data;
+	(void)size;
+	abort();
+}
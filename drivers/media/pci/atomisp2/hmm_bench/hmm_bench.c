@@ -0,0 +1,194 @@
+/*
+ * Host benchmark of the atomisp hmm_store() path.
+ *
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+/*
+ * Times small hmm_store()s into a parameter-sized buffer of HB_PGNR
+ * pages, the way the CSS host library writes its parameters, with a
+ * hmm_flush_dirty() every HB_HANDOFF stores for the ISP handoff in
+ * between:
+ *
+ *   access      vmap budget 0: a vmap, clflush and vunmap per store
+ *   persistent  the default budget: the buffer stays vmapped and the
+ *               stored range is flushed at the handoff
+ *
+ * The vmaps are mappings of host memory, see hmm_bench_bo.c. After each
+ * run the buffer must hold what was stored. The persistent run must have
+ * mapped the buffer once and deferred every store, flushing no more than
+ * the buffer per handoff; the access run must not defer any.
+ *
+ * Usage: hmm_bench [-n stores] [bytes...]
+ */
+
+#include <getopt.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "hmm/hmm.h"
+
+#define HB_PGNR			4
+#define HB_DEFAULT_STORES	8192
+/* parameter stores the CSS does between two ISP handoffs */
+#define HB_HANDOFF		32
+#define HB_SIZE			(HB_PGNR * PAGE_SIZE)
+
+static const unsigned int hb_default_bytes[] = { 16, 64, 256, 1024, 4096 };
+
+static unsigned int hb_stores = HB_DEFAULT_STORES;
+static unsigned int hb_errors;
+static unsigned char hb_expect[HB_SIZE];
+static unsigned char hb_readback[HB_SIZE];
+
+static unsigned long long hb_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static unsigned long long hb_run(const char *name, ia_css_ptr ptr,
+				 unsigned int bytes, unsigned char pattern)
+{
+	unsigned int span = HB_SIZE - bytes + 1;
+	struct _hmm_vmap_stat before = hmm_vmap_stat;
+	unsigned char data[PAGE_SIZE];
+	unsigned long long start, ns;
+	unsigned int i;
+
+	memset(data, pattern, bytes);
+	memset(hb_expect, 0, sizeof(hb_expect));
+	hmm_set(ptr, 0, HB_SIZE);
+	hmm_flush_dirty();
+
+	start = hb_now_ns();
+	for (i = 0; i < hb_stores; i++) {
+		hmm_store(ptr + (i * bytes) % span, data, bytes);
+		if (i % HB_HANDOFF == HB_HANDOFF - 1)
+			hmm_flush_dirty();
+	}
+	hmm_flush_dirty();
+	ns = hb_now_ns() - start;
+
+	for (i = 0; i < hb_stores; i++)
+		memset(hb_expect + (i * bytes) % span, pattern, bytes);
+	if (hmm_load(ptr, hb_readback, HB_SIZE) ||
+	    memcmp(hb_readback, hb_expect, HB_SIZE)) {
+		fprintf(stderr, "%u bytes %s: buffer differs from the stores\n",
+			bytes, name);
+		hb_errors++;
+	}
+	/* hmm_set() above is deferred as well */
+	if (hmm_vmap_stat.deferred - before.deferred !=
+	    (hmm_vmap_stat.max_pages ? hb_stores + 1 : 0)) {
+		fprintf(stderr, "%u bytes %s: %llu stores deferred\n", bytes,
+			name, hmm_vmap_stat.deferred - before.deferred);
+		hb_errors++;
+	}
+	/* one dirty range per buffer and handoff */
+	if (hmm_vmap_stat.flushed - before.flushed >
+	    (hmm_vmap_stat.handoffs - before.handoffs) * HB_SIZE) {
+		fprintf(stderr, "%u bytes %s: %llu bytes flushed in %llu handoffs\n",
+			bytes, name, hmm_vmap_stat.flushed - before.flushed,
+			hmm_vmap_stat.handoffs - before.handoffs);
+		hb_errors++;
+	}
+	if (hmm_vmap_stat.max_pages &&
+	    hmm_vmap_stat.maps - before.maps != 1) {
+		fprintf(stderr, "%u bytes %s: %u vmaps, expected 1\n", bytes,
+			name, hmm_vmap_stat.maps - before.maps);
+		hb_errors++;
+	}
+
+	return ns;
+}
+
+static void hb_report(unsigned int bytes, unsigned long long access_ns,
+		      unsigned long long persistent_ns)
+{
+	double total = (double)bytes * hb_stores * 1e3;
+
+	printf("  %6u %12llu %10.0f %12llu %10.0f %8.1f\n", bytes,
+	       access_ns / hb_stores, total / access_ns,
+	       persistent_ns / hb_stores, total / persistent_ns,
+	       (double)access_ns / persistent_ns);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int budget = hmm_vmap_stat.max_pages;
+	unsigned int bytes, i, n;
+	ia_css_ptr ptr;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:")) != -1) {
+		switch (opt) {
+		case 'n':
+			hb_stores = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			hb_stores = 0;
+			break;
+		}
+	}
+	for (i = optind; i < argc; i++) {
+		bytes = strtoul(argv[i], NULL, 0);
+		if (!bytes || bytes > PAGE_SIZE)
+			hb_stores = 0;
+	}
+	if (!hb_stores) {
+		fprintf(stderr, "usage: %s [-n stores] [bytes (1-%lu)...]\n",
+			argv[0], PAGE_SIZE);
+		return 1;
+	}
+
+	if (hmm_init())
+		return 1;
+	ptr = hmm_alloc(HB_SIZE, HMM_BO_PRIVATE, 0, NULL, HMM_CACHED);
+	if (!ptr)
+		return 1;
+
+	printf("%u stores per size into a %u page buffer, flush every %u stores\n",
+	       hb_stores, HB_PGNR, HB_HANDOFF);
+	printf("  %6s %12s %10s %12s %10s %8s\n", "bytes", "access ns",
+	       "MB/s", "persist ns", "MB/s", "speedup");
+
+	n = optind < argc ? argc - optind :
+			    sizeof(hb_default_bytes) / sizeof(hb_default_bytes[0]);
+	for (i = 0; i < n; i++) {
+		unsigned long long access_ns, persistent_ns;
+
+		bytes = optind < argc ? strtoul(argv[optind + i], NULL, 0) :
+					hb_default_bytes[i];
+
+		hmm_vmap_cache_set_budget(0);
+		access_ns = hb_run("access", ptr, bytes, 0x5a);
+		hmm_vmap_cache_set_budget(budget);
+		persistent_ns = hb_run("persistent", ptr, bytes, 0xa5);
+
+		hb_report(bytes, access_ns, persistent_ns);
+	}
+
+	hmm_free(ptr);
+	hmm_cleanup();
+
+	printf("%u errors\n%s\n", hb_errors, hb_errors ? "FAILED" : "PASSED");
+	return hb_errors ? 1 : 0;
+}
@@ -0,0 +1,333 @@
+/*
+ * Buffer objects and pages under hmm.c for the hmm host benchmark.
+ *
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+/*
+ * Physical memory is a memfd of HB_PHYS_PAGES pages, mapped once as the
+ * direct map that kmap() returns addresses in. The pages of a buffer
+ * object are contiguous in it and never reused. hmm_bo_vmap() maps them
+ * a second time with mmap(MAP_POPULATE) and hmm_bo_vunmap() unmaps them:
+ * like vmap() and vunmap() that sets up and tears down page table
+ * entries and flushes the TLB, which is what a vmap per access costs.
+ *
+ * The ISP side (MMU, page pools) is not there; buffer objects are bound
+ * by setting the flag.
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "hmm/hmm.h"
+#include "hmm/hmm_bo_dev.h"
+#include "mmu/sh_mmu_mrfld.h"
+#include "asm/cacheflush.h"
+#include "atomisp_internal.h"
+
+#define HB_PHYS_PAGES		4096
+#define HB_CACHE_LINE		64
+
+struct page {
+	unsigned int pfn;
+};
+
+static struct page hb_pages[HB_PHYS_PAGES];
+static unsigned int hb_next_pfn;
+static unsigned int hb_next_vaddr;
+static char *hb_direct;
+static int hb_memfd = -1;
+
+struct device *atomisp_dev;
+struct isp_mmu_client sh_mmu_mrfld;
+struct hmm_pool_ops reserved_pops;
+struct hmm_pool_ops dynamic_pops;
+
+void *kmap(struct page *page)
+{
+	return hb_direct + ((size_t)page->pfn << PAGE_SHIFT);
+}
+
+void kunmap(struct page *page)
+{
+}
+
+void *kmap_atomic(struct page *page)
+{
+	return kmap(page);
+}
+
+void kunmap_atomic(void *addr)
+{
+}
+
+phys_addr_t page_to_phys(struct page *page)
+{
+	return (phys_addr_t)page->pfn << PAGE_SHIFT;
+}
+
+void clflush_cache_range(void *vaddr, unsigned int size)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	char *p = (char *)((uintptr_t)vaddr & ~(uintptr_t)(HB_CACHE_LINE - 1));
+	char *end = (char *)vaddr + size;
+
+	__builtin_ia32_mfence();
+	for (; p < end; p += HB_CACHE_LINE)
+		__builtin_ia32_clflush(p);
+	__builtin_ia32_mfence();
+#endif
+}
+
+int hmm_bo_device_init(struct hmm_bo_device *bdev,
+		       struct isp_mmu_client *mmu_driver,
+		       unsigned int vaddr_start, unsigned int size)
+{
+	size_t bytes = (size_t)HB_PHYS_PAGES << PAGE_SHIFT;
+	unsigned int i;
+
+	hb_memfd = memfd_create("hmm_bench", 0);
+	if (hb_memfd < 0 || ftruncate(hb_memfd, bytes)) {
+		perror("memfd");
+		return -ENOMEM;
+	}
+	hb_direct = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+			 MAP_SHARED | MAP_POPULATE, hb_memfd, 0);
+	if (hb_direct == MAP_FAILED) {
+		perror("mmap");
+		return -ENOMEM;
+	}
+	for (i = 0; i < HB_PHYS_PAGES; i++)
+		hb_pages[i].pfn = i;
+
+	INIT_LIST_HEAD(&bdev->free_bo_list);
+	INIT_LIST_HEAD(&bdev->active_bo_list);
+	bdev->vaddr_space.start = vaddr_start;
+	bdev->vaddr_space.size = size;
+	bdev->flag = HMM_BO_DEVICE_INITED;
+	hb_next_vaddr = vaddr_start;
+
+	return 0;
+}
+
+void hmm_bo_device_exit(struct hmm_bo_device *bdev)
+{
+	munmap(hb_direct, (size_t)HB_PHYS_PAGES << PAGE_SHIFT);
+	close(hb_memfd);
+	bdev->flag = 0;
+}
+
+void hmm_bo_device_cleanup_mmu_l2(struct hmm_bo_device *bdev)
+{
+}
+
+struct hmm_buffer_object *hmm_bo_create(struct hmm_bo_device *bdev,
+					int pgnr)
+{
+	struct hmm_buffer_object *bo = calloc(1, sizeof(*bo));
+
+	if (!bo)
+		return NULL;
+	bo->bdev = bdev;
+	bo->pgnr = pgnr;
+	bo->kref.refcount = 1;
+	INIT_LIST_HEAD(&bo->vmap_list);
+	INIT_LIST_HEAD(&bo->dirty_list);
+	list_add_tail(&bo->list, &bdev->active_bo_list);
+
+	return bo;
+}
+
+void hmm_bo_ref(struct hmm_buffer_object *bo)
+{
+	bo->kref.refcount++;
+}
+
+void hmm_bo_unref(struct hmm_buffer_object *bo)
+{
+	if (--bo->kref.refcount)
+		return;
+	/* what hmm_bo_release() does with a mapping still around */
+	hmm_bo_vunmap(bo);
+	list_del(&bo->list);
+	free(bo);
+}
+
+int hmm_bo_alloc_vm(struct hmm_buffer_object *bo)
+{
+	bo->vm_node = calloc(1, sizeof(*bo->vm_node));
+	if (!bo->vm_node)
+		return -ENOMEM;
+	bo->vm_node->start = hb_next_vaddr;
+	bo->vm_node->pgnr = bo->pgnr;
+	bo->vm_node->size = bo->pgnr << PAGE_SHIFT;
+	hb_next_vaddr += bo->vm_node->size;
+	bo->status |= HMM_BO_VM_ALLOCED;
+
+	return 0;
+}
+
+void hmm_bo_free_vm(struct hmm_buffer_object *bo)
+{
+	free(bo->vm_node);
+	bo->vm_node = NULL;
+	bo->status &= ~HMM_BO_VM_ALLOCED;
+}
+
+int hmm_bo_vm_allocated(struct hmm_buffer_object *bo)
+{
+	return bo->status & HMM_BO_VM_ALLOCED;
+}
+
+int hmm_bo_alloc_pages(struct hmm_buffer_object *bo,
+		       enum hmm_bo_type type, int from_highmem,
+		       void *userptr, bool cached)
+{
+	unsigned int i;
+
+	if (hb_next_pfn + bo->pgnr > HB_PHYS_PAGES)
+		return -ENOMEM;
+	bo->page_obj = calloc(bo->pgnr, sizeof(*bo->page_obj));
+	if (!bo->page_obj)
+		return -ENOMEM;
+	for (i = 0; i < bo->pgnr; i++)
+		bo->page_obj[i].page = &hb_pages[hb_next_pfn + i];
+	hb_next_pfn += bo->pgnr;
+	bo->type = type;
+	bo->cached = cached;
+	bo->status |= HMM_BO_PAGE_ALLOCED;
+
+	return 0;
+}
+
+void hmm_bo_free_pages(struct hmm_buffer_object *bo)
+{
+	free(bo->page_obj);
+	bo->page_obj = NULL;
+	bo->status &= ~HMM_BO_PAGE_ALLOCED;
+}
+
+int hmm_bo_page_allocated(struct hmm_buffer_object *bo)
+{
+	return bo->status & HMM_BO_PAGE_ALLOCED;
+}
+
+int hmm_bo_bind(struct hmm_buffer_object *bo)
+{
+	bo->status |= HMM_BO_BINDED;
+	return 0;
+}
+
+void hmm_bo_unbind(struct hmm_buffer_object *bo)
+{
+	bo->status &= ~HMM_BO_BINDED;
+}
+
+/* the status handling of hmm_bo_vmap() in hmm_bo.c */
+void *hmm_bo_vmap(struct hmm_buffer_object *bo, bool cached)
+{
+	void *addr;
+
+	if (((bo->status & HMM_BO_VMAPED) && !cached) ||
+	    ((bo->status & HMM_BO_VMAPED_CACHED) && cached))
+		return bo->vmap_addr;
+
+	hmm_bo_vunmap(bo);
+
+	addr = mmap(NULL, (size_t)bo->pgnr << PAGE_SHIFT,
+		    PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		    hb_memfd,
+		    (off_t)bo->page_obj[0].page->pfn << PAGE_SHIFT);
+	if (addr == MAP_FAILED) {
+		dev_err(atomisp_dev, "vmap failed...\n");
+		return NULL;
+	}
+	bo->vmap_addr = addr;
+	bo->status |= (cached ? HMM_BO_VMAPED_CACHED : HMM_BO_VMAPED);
+
+	return bo->vmap_addr;
+}
+
+void hmm_bo_vunmap(struct hmm_buffer_object *bo)
+{
+	if (!(bo->status & (HMM_BO_VMAPED | HMM_BO_VMAPED_CACHED)))
+		return;
+
+	munmap(bo->vmap_addr, (size_t)bo->pgnr << PAGE_SHIFT);
+	bo->vmap_addr = NULL;
+	bo->status &= ~(HMM_BO_VMAPED | HMM_BO_VMAPED_CACHED);
+}
+
+void hmm_bo_flush_vmap(struct hmm_buffer_object *bo)
+{
+	if (bo->status & HMM_BO_VMAPED_CACHED)
+		clflush_cache_range(bo->vmap_addr, bo->pgnr << PAGE_SHIFT);
+}
+
+void hmm_bo_flush_cache(struct hmm_buffer_object *bo)
+{
+	unsigned int i;
+
+	for (i = 0; i < bo->pgnr; i++)
+		clflush_cache_range(kmap(bo->page_obj[i].page), PAGE_SIZE);
+}
+
+int hmm_bo_mmap(struct vm_area_struct *vma, struct hmm_buffer_object *bo)
+{
+	return -EINVAL;
+}
+
+/* the lookups walk the active list, as in hmm_bo_dev.c */
+struct hmm_buffer_object *hmm_bo_device_search_start(
+		struct hmm_bo_device *bdev, ia_css_ptr vaddr)
+{
+	struct hmm_buffer_object *bo, *tmp;
+
+	list_for_each_entry_safe(bo, tmp, &bdev->active_bo_list, list)
+		if (bo->vm_node && bo->vm_node->start == vaddr)
+			return bo;
+
+	return NULL;
+}
+
+struct hmm_buffer_object *hmm_bo_device_search_in_range(
+		struct hmm_bo_device *bdev, ia_css_ptr vaddr)
+{
+	struct hmm_buffer_object *bo, *tmp;
+
+	list_for_each_entry_safe(bo, tmp, &bdev->active_bo_list, list)
+		if (bo->vm_node && bo->vm_node->start <= vaddr &&
+		    vaddr < bo->vm_node->start + bo->vm_node->size)
+			return bo;
+
+	return NULL;
+}
+
+struct hmm_buffer_object *hmm_bo_device_search_vmap_start(
+		struct hmm_bo_device *bdev, const void *vaddr)
+{
+	struct hmm_buffer_object *bo, *tmp;
+
+	list_for_each_entry_safe(bo, tmp, &bdev->active_bo_list, list)
+		if (bo->vmap_addr == vaddr)
+			return bo;
+
+	return NULL;
+}
@@ -0,0 +1,30 @@
+/*
+ * Support for Intel Camera Imaging ISP subsystem.
+ *
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+#ifndef __HMM_BENCH_IA_CSS_TYPES_H_INCLUDED__
+#define __HMM_BENCH_IA_CSS_TYPES_H_INCLUDED__
+
+/* The one CSS type the hmm headers use, as in ia_css_types.h */
+#include <stdint.h>
+
+typedef uint32_t ia_css_ptr;
+
+#endif /* __HMM_BENCH_IA_CSS_TYPES_H_INCLUDED__ */
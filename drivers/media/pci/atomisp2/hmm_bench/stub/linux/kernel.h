@@ -0,0 +1,145 @@
+/*
+ * Support for Intel Camera Imaging ISP subsystem.
+ *
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+#ifndef __HMM_BENCH_LINUX_KERNEL_H_INCLUDED__
+#define __HMM_BENCH_LINUX_KERNEL_H_INCLUDED__
+
+/*
+ * The kernel API hmm/hmm.c and the hmm headers use, for a single
+ * threaded host program: locks are no-ops and nothing runs in atomic
+ * context. The linux/ headers they include all come here.
+ */
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int64_t s64;
+typedef uint64_t phys_addr_t;
+
+#define PAGE_SHIFT		12
+#define PAGE_SIZE		(1UL << PAGE_SHIFT)
+
+#define unlikely(x)		__builtin_expect(!!(x), 0)
+#define min(x, y)		((x) < (y) ? (x) : (y))
+#define max(x, y)		((x) > (y) ? (x) : (y))
+#define container_of(ptr, type, member) \
+	((type *)((char *)(ptr) - offsetof(type, member)))
+
+struct device;
+struct kmem_cache;
+struct page;
+struct vm_area_struct;
+
+#define dev_err(dev, fmt, ...) \
+	((void)(dev), fprintf(stderr, fmt, ##__VA_ARGS__))
+#define dev_warn		dev_err
+#define trace_printk(fmt, ...)	printf(fmt, ##__VA_ARGS__)
+
+#define in_atomic()		0
+
+typedef struct spinlock {
+	int unused;
+} spinlock_t;
+
+#define DEFINE_SPINLOCK(x)	spinlock_t x
+#define spin_lock_irqsave(lock, flags)	((void)(lock), (flags) = 0)
+#define spin_unlock_irqrestore(lock, flags) ((void)(lock), (void)(flags))
+
+struct mutex {
+	int unused;
+};
+
+#define mutex_lock(m)		((void)(m))
+#define mutex_unlock(m)		((void)(m))
+
+struct kref {
+	int refcount;
+};
+
+struct list_head {
+	struct list_head *next, *prev;
+};
+
+#define LIST_HEAD(name)		struct list_head name = { &(name), &(name) }
+
+static inline void INIT_LIST_HEAD(struct list_head *list)
+{
+	list->next = list;
+	list->prev = list;
+}
+
+static inline void list_add_tail(struct list_head *new,
+				 struct list_head *head)
+{
+	new->prev = head->prev;
+	new->next = head;
+	head->prev->next = new;
+	head->prev = new;
+}
+
+static inline void list_del(struct list_head *entry)
+{
+	entry->prev->next = entry->next;
+	entry->next->prev = entry->prev;
+}
+
+static inline void list_del_init(struct list_head *entry)
+{
+	list_del(entry);
+	INIT_LIST_HEAD(entry);
+}
+
+static inline void list_move_tail(struct list_head *list,
+				  struct list_head *head)
+{
+	list_del(list);
+	list_add_tail(list, head);
+}
+
+static inline int list_empty(const struct list_head *head)
+{
+	return head->next == head;
+}
+
+#define list_entry(ptr, type, member)	container_of(ptr, type, member)
+#define list_first_entry(ptr, type, member) \
+	list_entry((ptr)->next, type, member)
+#define list_for_each_entry_safe(pos, n, head, member) \
+	for (pos = list_entry((head)->next, typeof(*pos), member), \
+	     n = list_entry(pos->member.next, typeof(*pos), member); \
+	     &pos->member != (head); \
+	     pos = n, n = list_entry(n->member.next, typeof(*n), member))
+
+/* pages live in the memory of hmm_bench_bo.c */
+void *kmap(struct page *page);
+void kunmap(struct page *page);
+void *kmap_atomic(struct page *page);
+void kunmap_atomic(void *addr);
+phys_addr_t page_to_phys(struct page *page);
+
+#endif /* __HMM_BENCH_LINUX_KERNEL_H_INCLUDED__ */
@@ -0,0 +1,227 @@
+/*
+ * Host check of the SP descriptor stores in sh_css_params.c/sh_css_sp.c.
+ *
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+/*
+ * Runs the store chain of every frame, sh_css_sp_start_binary_copy():
+ * isp stage and sp stage to DDR, sp group to DDR and sp_per_frame_data
+ * to SP dmem, against the mmgr_store() and sp_dmem_store() stubs, for a
+ * few change sequences:
+ *
+ *   static   the same output frame every frame
+ *   rotate   the output frame rotates over DB_BUFFERS buffers
+ *   stage    rotate, and a stage field changes every DB_STAGE_PERIOD
+ *            frames
+ *   restart  rotate, and the SP is restarted every DB_RESTART_PERIOD
+ *            frames, which reloads its dmem
+ *
+ * After every frame the DDR and dmem images must match the host
+ * descriptors, and sh_css_get_sp_desc_store_stats() must account for
+ * exactly the bytes that reached mmgr_store(). The report compares the
+ * bytes written per frame with a full store of every descriptor.
+ *
+ * Usage: desc_bench [frames]
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sh_css_internal.h"
+#include "sh_css_params.h"
+#include "sh_css_sp.h"
+#include "ia_css_frame.h"
+
+#include "stubs.h"
+
+#define DB_DEFAULT_FRAMES	1000
+#define DB_PIPE_NUM		0
+#define DB_BUFFERS		3
+#define DB_STAGE_PERIOD		30
+#define DB_RESTART_PERIOD	100
+
+enum db_seq {
+	DB_SEQ_STATIC,
+	DB_SEQ_ROTATE,
+	DB_SEQ_STAGE,
+	DB_SEQ_RESTART,
+	DB_NUM_SEQS
+};
+
+static const char * const db_seq_names[DB_NUM_SEQS] = {
+	[DB_SEQ_STATIC]  = "static",
+	[DB_SEQ_ROTATE]  = "rotate",
+	[DB_SEQ_STAGE]   = "stage",
+	[DB_SEQ_RESTART] = "restart",
+};
+
+static struct ia_css_frame db_frame;
+static unsigned int db_restarts;
+static unsigned int db_errors;
+
+static void db_frame_init(void)
+{
+	db_frame.info.format = IA_CSS_FRAME_FORMAT_NV12;
+	db_frame.info.res.width = 1920;
+	db_frame.info.res.height = 1080;
+	db_frame.dynamic_queue_id = SH_CSS_INVALID_QUEUE_ID;
+	db_frame.buf_type = IA_CSS_BUFFER_TYPE_OUTPUT_FRAME;
+	db_frame.data_bytes = 1920 * 1080 * 3 / 2;
+	db_frame.planes.nv.y.offset = 0;
+	db_frame.planes.nv.uv.offset = 1920 * 1080;
+}
+
+static void db_check_ddr(const char *what, hrt_vaddress ddr,
+			 const void *desc, size_t size)
+{
+	if (memcmp(bench_ddr_ptr(ddr), desc, size) != 0) {
+		fprintf(stderr, "%s in DDR differs from the host copy\n", what);
+		db_errors++;
+	}
+}
+
+/* One frame; returns the bytes mmgr_store() was asked to write */
+static unsigned long db_frame_run(enum db_seq seq, unsigned int frame)
+{
+	struct sh_css_sp_desc_store_stats stats;
+	struct sh_css_sp_per_frame_data pfd;
+	const struct sh_css_sp_pipeline *pipe;
+	unsigned long start = bench_ddr_store_bytes, ddr_bytes;
+
+	if (seq != DB_SEQ_STATIC)
+		db_frame.data = (hrt_vaddress)
+			((frame % DB_BUFFERS + 1) * db_frame.data_bytes);
+	if (seq == DB_SEQ_STAGE && frame % DB_STAGE_PERIOD == 0)
+		sh_css_isp_stage.binary_info.iterator.num_stripes =
+			1 + frame / DB_STAGE_PERIOD % 2;
+	if (seq == DB_SEQ_RESTART && frame % DB_RESTART_PERIOD == 0) {
+		/*
+		 * What ia_css_stop_sp() and ia_css_start_sp() do; loading
+		 * the SP firmware again wipes sp_per_frame_data.
+		 */
+		sh_css_sp_set_sp_running(false);
+		memset(bench_dmem_ptr(sh_css_sp_fw.info.sp.per_frame_data), 0,
+		       sizeof(struct sh_css_sp_per_frame_data));
+		sh_css_sp_start_isp();
+		db_restarts++;
+	}
+
+	ddr_bytes = bench_ddr_store_bytes;
+	sh_css_sp_start_binary_copy(DB_PIPE_NUM, &db_frame, 0);
+	ddr_bytes = bench_ddr_store_bytes - ddr_bytes;
+
+	sh_css_get_sp_desc_store_stats(&stats);
+	if (stats.last_frame_bytes != ddr_bytes) {
+		fprintf(stderr, "frame %u: stats report %u bytes, %lu stored\n",
+			frame, stats.last_frame_bytes, ddr_bytes);
+		db_errors++;
+	}
+
+	/* sp_per_frame_data as the SP sees it */
+	memcpy(&pfd, bench_dmem_ptr(sh_css_sp_fw.info.sp.per_frame_data),
+	       sizeof(pfd));
+	if (pfd.sp_group_addr == mmgr_NULL) {
+		fprintf(stderr, "frame %u: no sp group in SP dmem\n", frame);
+		db_errors++;
+		return bench_ddr_store_bytes - start;
+	}
+	db_check_ddr("sp group", pfd.sp_group_addr,
+		     &sh_css_sp_group, sizeof(sh_css_sp_group));
+
+	pipe = &sh_css_sp_group.pipe[DB_PIPE_NUM];
+	db_check_ddr("sp stage", pipe->sp_stage_addr[0],
+		     &sh_css_sp_stage, sizeof(sh_css_sp_stage));
+	db_check_ddr("isp stage", sh_css_sp_stage.isp_stage_addr,
+		     &sh_css_isp_stage, sizeof(sh_css_isp_stage));
+
+	return bench_ddr_store_bytes - start;
+}
+
+static void db_run(enum db_seq seq, unsigned int frames)
+{
+	const unsigned long full = sizeof(struct sh_css_sp_group) +
+				   sizeof(struct sh_css_sp_stage) +
+				   sizeof(struct sh_css_isp_stage);
+	unsigned long ddr_bytes = 0, ddr_stores, dmem_bytes, dmem_stores;
+	struct sh_css_sp_desc_store_stats before, after;
+	unsigned int i, restarts = db_restarts;
+
+	sh_css_get_sp_desc_store_stats(&before);
+	ddr_stores = bench_ddr_stores;
+	dmem_bytes = bench_dmem_store_bytes;
+	dmem_stores = bench_dmem_stores;
+
+	for (i = 0; i < frames; i++)
+		ddr_bytes += db_frame_run(seq, i);
+
+	sh_css_get_sp_desc_store_stats(&after);
+	restarts = db_restarts - restarts;
+	ddr_stores = bench_ddr_stores - ddr_stores;
+	dmem_bytes = bench_dmem_store_bytes - dmem_bytes;
+	dmem_stores = bench_dmem_stores - dmem_stores;
+
+	/* a restart stores the sp group once more */
+	if (after.total_bytes - before.total_bytes != ddr_bytes ||
+	    after.total_bytes + after.skipped_bytes -
+	    before.total_bytes - before.skipped_bytes !=
+	    full * frames + sizeof(struct sh_css_sp_group) * restarts) {
+		fprintf(stderr, "%s: total/skipped bytes do not add up\n",
+			db_seq_names[seq]);
+		db_errors++;
+	}
+
+	printf("%s: %u frames\n", db_seq_names[seq], frames);
+	printf("  %-10s %12s %12s %12s\n",
+	       "", "bytes/frame", "full/frame", "stores/frame");
+	printf("  %-10s %12lu %12lu %12.2f\n", "ddr",
+	       ddr_bytes / frames, full, (double)ddr_stores / frames);
+	printf("  %-10s %12lu %12zu %12.2f\n\n", "sp dmem",
+	       dmem_bytes / frames, sizeof(struct sh_css_sp_per_frame_data),
+	       (double)dmem_stores / frames);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int frames = DB_DEFAULT_FRAMES;
+	enum db_seq seq;
+
+	if (argc > 1)
+		frames = strtoul(argv[1], NULL, 0);
+	if (!frames) {
+		fprintf(stderr, "usage: %s [frames]\n", argv[0]);
+		return 1;
+	}
+
+	if (sh_css_params_init() != IA_CSS_SUCCESS) {
+		fprintf(stderr, "sh_css_params_init failed\n");
+		return 1;
+	}
+	db_frame_init();
+	sh_css_sp_start_isp();
+
+	for (seq = 0; seq < DB_NUM_SEQS; seq++)
+		db_run(seq, frames);
+
+	sh_css_params_uninit();
+
+	printf("%u errors\n%s\n", db_errors, db_errors ? "FAILED" : "PASSED");
+	return db_errors ? 1 : 0;
+}
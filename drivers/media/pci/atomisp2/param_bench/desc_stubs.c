@@ -0,0 +1,439 @@
+/*
+ * Host stand-ins for what the SP descriptor stores reference.
+ *
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+/*
+ * sh_css_params.o and sh_css_sp.o are linked whole, so everything they
+ * reference needs a definition. desc_bench only runs the stores of
+ * sh_css_sp_start_binary_copy() and sh_css_sp_start_isp(); SP dmem is
+ * a host array, buffers are not refcounted and there is one pipe on SP
+ * thread 0. The rest is never reached and aborts if it is.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sh_css_internal.h"
+#include "sh_css_firmware.h"
+#include "sh_css_param_dvs.h"
+#include "ia_css_binary.h"
+#include "ia_css_bufq.h"
+#include "ia_css_control.h"
+#include "ia_css_debug.h"
+#include "ia_css_debug_pipe.h"
+#include "ia_css_isp_param.h"
+#include "ia_css_isys.h"
+#include "ia_css_mmu.h"
+#include "ia_css_pipeline.h"
+#include "ia_css_refcount.h"
+#include "ia_css_spctrl.h"
+#include "ia_css_stream.h"
+#include "gdc_device.h"
+#include "mmu_device.h"
+#include "sp.h"
+
+#include "stubs.h"
+
+#define BENCH_DMEM_BYTES	0x10000
+/* where the SP firmware would have sp_per_frame_data */
+#define BENCH_PER_FRAME_DATA	0x100
+
+static unsigned char bench_dmem[BENCH_DMEM_BYTES];
+
+unsigned long bench_dmem_stores;
+unsigned long bench_dmem_store_bytes;
+
+struct ia_css_fw_info sh_css_sp_fw = {
+	.type = ia_css_sp_firmware,
+	.info.sp.per_frame_data = BENCH_PER_FRAME_DATA,
+};
+
+bool ia_css_debug_param_prof_enabled;
+
+#define BENCH_UNREACHED() \
+	do { \
+		fprintf(stderr, "%s: not stubbed\n", __func__); \
+		abort(); \
+	} while (0)
+
+void *bench_dmem_ptr(unsigned int addr)
+{
+	assert(addr < BENCH_DMEM_BYTES);
+	return &bench_dmem[addr];
+}
+
+void sp_dmem_store(const sp_ID_t ID, hrt_address addr,
+		   const void *data, const size_t size)
+{
+	(void)ID;
+	assert(addr + size <= BENCH_DMEM_BYTES);
+	bench_dmem_stores++;
+	bench_dmem_store_bytes += size;
+	memcpy(&bench_dmem[addr], data, size);
+}
+
+void sp_dmem_load(const sp_ID_t ID, const hrt_address addr,
+		  void *data, const size_t size)
+{
+	(void)ID;
+	assert(addr + size <= BENCH_DMEM_BYTES);
+	memcpy(data, &bench_dmem[addr], size);
+}
+
+void sp_dmem_store_uint32(const sp_ID_t ID, hrt_address addr,
+			  const uint32_t data)
+{
+	sp_dmem_store(ID, addr, &data, sizeof(data));
+}
+
+uint32_t sp_dmem_load_uint32(const sp_ID_t ID, const hrt_address addr)
+{
+	uint32_t data;
+
+	sp_dmem_load(ID, addr, &data, sizeof(data));
+	return data;
+}
+
+hrt_vaddress ia_css_refcount_increment(int32_t id, hrt_vaddress ptr)
+{
+	(void)id;
+	return ptr;
+}
+
+bool ia_css_refcount_decrement(int32_t id, hrt_vaddress ptr)
+{
+	(void)id;
+	mmgr_free(ptr);
+	return true;
+}
+
+bool ia_css_refcount_is_single(hrt_vaddress ptr)
+{
+	(void)ptr;
+	return true;
+}
+
+void ia_css_refcount_clear(int32_t id, clear_func clear_func_ptr)
+{
+	(void)id;
+	(void)clear_func_ptr;
+}
+
+bool ia_css_pipeline_get_sp_thread_id(unsigned int key, unsigned int *val)
+{
+	*val = key;
+	return true;
+}
+
+enum ia_css_err ia_css_spctrl_start(sp_ID_t sp_id)
+{
+	(void)sp_id;
+	return IA_CSS_SUCCESS;
+}
+
+void ia_css_mmu_invalidate_cache(void)
+{
+}
+
+void mmu_invalidate_cache_all(void)
+{
+}
+
+void gdc_lut_store(const gdc_ID_t ID, const int data[4][HRT_GDC_N])
+{
+	(void)ID;
+	(void)data;
+}
+
+uint64_t ia_css_debug_param_prof_clock(void)
+{
+	return 0;
+}
+
+void ia_css_debug_param_prof_record(unsigned int param_id, uint64_t ns)
+{
+	(void)param_id;
+	(void)ns;
+}
+
+void ia_css_debug_param_prof_frame(void)
+{
+}
+
+void ia_css_debug_pipe_graph_dump_stage(struct ia_css_pipeline_stage *stage,
+					enum ia_css_pipe_id id)
+{
+	(void)stage;
+	(void)id;
+}
+
+void ia_css_debug_pipe_graph_dump_sp_raw_copy(struct ia_css_frame *out_frame)
+{
+	(void)out_frame;
+}
+
+/* Not reached by desc_bench */
+
+hrt_vaddress mmgr_alloc_attr(const size_t size, const uint16_t attribute)
+{
+	(void)size;
+	(void)attribute;
+	BENCH_UNREACHED();
+}
+
+void ia_css_uninit(void)
+{
+	BENCH_UNREACHED();
+}
+
+struct ia_css_pipe *find_pipe_by_num(uint32_t pipe_num)
+{
+	(void)pipe_num;
+	BENCH_UNREACHED();
+}
+
+bool sh_css_continuous_is_enabled(uint8_t pipe_num)
+{
+	(void)pipe_num;
+	BENCH_UNREACHED();
+}
+
+struct ia_css_pipeline *ia_css_pipe_get_pipeline(const struct ia_css_pipe *pipe)
+{
+	(void)pipe;
+	BENCH_UNREACHED();
+}
+
+unsigned int ia_css_pipe_get_pipe_num(const struct ia_css_pipe *pipe)
+{
+	(void)pipe;
+	BENCH_UNREACHED();
+}
+
+unsigned int ia_css_pipe_get_isp_pipe_version(const struct ia_css_pipe *pipe)
+{
+	(void)pipe;
+	BENCH_UNREACHED();
+}
+
+void ia_css_get_crop_offsets(struct ia_css_pipe *pipe,
+			     struct ia_css_frame_info *in_frame)
+{
+	(void)pipe;
+	(void)in_frame;
+	BENCH_UNREACHED();
+}
+
+enum ia_css_err ia_css_pipeline_get_stage(struct ia_css_pipeline *pipeline,
+					  int mode,
+					  struct ia_css_pipeline_stage **stage)
+{
+	(void)pipeline;
+	(void)mode;
+	(void)stage;
+	BENCH_UNREACHED();
+}
+
+bool ia_css_pipeline_uses_params(struct ia_css_pipeline *pipeline)
+{
+	(void)pipeline;
+	BENCH_UNREACHED();
+}
+
+struct ia_css_binary *
+ia_css_stream_get_shading_correction_binary(const struct ia_css_stream *stream)
+{
+	(void)stream;
+	BENCH_UNREACHED();
+}
+
+unsigned int
+ia_css_stream_input_format_bits_per_pixel(struct ia_css_stream *stream)
+{
+	(void)stream;
+	BENCH_UNREACHED();
+}
+
+void sh_css_invalidate_shading_tables(struct ia_css_stream *stream)
+{
+	(void)stream;
+	BENCH_UNREACHED();
+}
+
+enum ia_css_err
+ia_css_binary_fill_info(const struct ia_css_binary_xinfo *xinfo,
+			bool online, bool two_ppc,
+			enum ia_css_stream_format stream_format,
+			const struct ia_css_frame_info *in_info,
+			const struct ia_css_frame_info *bds_out_info,
+			const struct ia_css_frame_info *out_info[],
+			const struct ia_css_frame_info *vf_info,
+			struct ia_css_binary *binary,
+			struct ia_css_resolution *dvs_env,
+			int stream_config_left_padding,
+			bool accelerator)
+{
+	(void)xinfo;
+	(void)online;
+	(void)two_ppc;
+	(void)stream_format;
+	(void)in_info;
+	(void)bds_out_info;
+	(void)out_info;
+	(void)vf_info;
+	(void)binary;
+	(void)dvs_env;
+	(void)stream_config_left_padding;
+	(void)accelerator;
+	BENCH_UNREACHED();
+}
+
+bool ia_css_query_internal_queue_id(enum ia_css_buffer_type buf_type,
+				    unsigned int thread_id,
+				    enum sh_css_queue_id *val)
+{
+	(void)buf_type;
+	(void)thread_id;
+	(void)val;
+	BENCH_UNREACHED();
+}
+
+enum ia_css_err ia_css_bufq_enqueue_buffer(int thread_index, int queue_id,
+					   uint32_t item)
+{
+	(void)thread_index;
+	(void)queue_id;
+	(void)item;
+	BENCH_UNREACHED();
+}
+
+enum ia_css_err ia_css_bufq_dequeue_buffer(int queue_id, uint32_t *item)
+{
+	(void)queue_id;
+	(void)item;
+	BENCH_UNREACHED();
+}
+
+enum ia_css_err ia_css_bufq_enqueue_psys_event(uint8_t evt_id,
+					       uint8_t evt_payload_0,
+					       uint8_t evt_payload_1,
+					       uint8_t evt_payload_2)
+{
+	(void)evt_id;
+	(void)evt_payload_0;
+	(void)evt_payload_1;
+	(void)evt_payload_2;
+	BENCH_UNREACHED();
+}
+
+enum ia_css_err
+ia_css_isys_convert_stream_format_to_mipi_format(
+		enum ia_css_stream_format input_format,
+		mipi_predictor_t compression,
+		unsigned int *fmt_type)
+{
+	(void)input_format;
+	(void)compression;
+	(void)fmt_type;
+	BENCH_UNREACHED();
+}
+
+const struct ia_css_host_data *
+ia_css_isp_param_get_mem_init(const struct ia_css_isp_param_host_segments *mem_init,
+			      enum ia_css_param_class pclass,
+			      enum ia_css_isp_memories mem)
+{
+	(void)mem_init;
+	(void)pclass;
+	(void)mem;
+	BENCH_UNREACHED();
+}
+
+const struct ia_css_isp_data *
+ia_css_isp_param_get_isp_mem_init(const struct ia_css_isp_param_isp_segments *mem_init,
+				  enum ia_css_param_class pclass,
+				  enum ia_css_isp_memories mem)
+{
+	(void)mem_init;
+	(void)pclass;
+	(void)mem;
+	BENCH_UNREACHED();
+}
+
+void
+ia_css_init_memory_interface(struct ia_css_isp_param_css_segments *isp_mem_if,
+			     const struct ia_css_isp_param_host_segments *mem_params,
+			     const struct ia_css_isp_param_css_segments *css_params)
+{
+	(void)isp_mem_if;
+	(void)mem_params;
+	(void)css_params;
+	BENCH_UNREACHED();
+}
+
+enum ia_css_err
+ia_css_isp_param_copy_isp_mem_if_to_ddr(struct ia_css_isp_param_css_segments *ddr,
+					const struct ia_css_isp_param_host_segments *host,
+					enum ia_css_param_class pclass)
+{
+	(void)ddr;
+	(void)host;
+	(void)pclass;
+	BENCH_UNREACHED();
+}
+
+void
+ia_css_isp_param_enable_pipeline(const struct ia_css_isp_param_host_segments *mem_params)
+{
+	(void)mem_params;
+	BENCH_UNREACHED();
+}
+
+struct ia_css_dvs_6axis_config *
+generate_dvs_6axis_table(const struct ia_css_resolution *frame_res,
+			 const struct ia_css_resolution *dvs_offset)
+{
+	(void)frame_res;
+	(void)dvs_offset;
+	BENCH_UNREACHED();
+}
+
+struct ia_css_dvs_6axis_config *
+generate_dvs_6axis_table_from_config(struct ia_css_dvs_6axis_config *dvs_config_src)
+{
+	(void)dvs_config_src;
+	BENCH_UNREACHED();
+}
+
+void free_dvs_6axis_table(struct ia_css_dvs_6axis_config **dvs_6axis_config)
+{
+	(void)dvs_6axis_config;
+	BENCH_UNREACHED();
+}
+
+void copy_dvs_6axis_table(struct ia_css_dvs_6axis_config *dvs_config_dst,
+			  const struct ia_css_dvs_6axis_config *dvs_config_src)
+{
+	(void)dvs_config_dst;
+	(void)dvs_config_src;
+	BENCH_UNREACHED();
+}
@@ -0,0 +1,593 @@
+/*
+ * Host benchmark for the CSS ISP parameter encoders.
+ *
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+/*
+ * Runs the per-kernel encoders of ia_css_kernel_process_param[] the
+ * way process_kernel_parameters() in sh_css_params.c does, on one
+ * binary whose parameter memories live in host memory, and reports the
+ * cost per frame of every encoder for a few parameter change sequences:
+ *
+ *   3a       white balance, color matrix, 3A grid and black level each
+ *            frame, tone curves every 4 frames, tuning every 16 frames
+ *   zoom     digital zoom ramp: uds and crop of every frame
+ *   shading  a new shading table every frame: the table conversion
+ *            (prepare_shading_table) followed by the sc encoder
+ *   prepared the same, with the table converted ahead of time by
+ *            ia_css_shading_prepare() and _convert(), as the driver does
+ *            outside isp->mutex; only the lookup and the sc encoder are
+ *            left for the parameter update
+ *
+ * A prepared table must be the one prepare_shading_table() makes, and
+ * must not be found for another table.
+ *
+ * Usage: param_bench [frames]
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define IA_CSS_INCLUDE_PARAMETERS
+#include "sh_css_params.h"
+#include "sh_css_param_shading.h"
+#include "ia_css_shading.h"
+#include "ia_css_binary.h"
+#include "ia_css_pipeline.h"
+#include "ia_css_stream.h"
+#include "ia_css_isp_params.h"
+
+#include "isp/kernels/aa/aa_2/ia_css_aa2.host.h"
+#include "isp/kernels/anr/anr_1.0/ia_css_anr.host.h"
+#include "isp/kernels/bnr/bnr_1.0/ia_css_bnr.host.h"
+#include "isp/kernels/cnr/cnr_2/ia_css_cnr2.host.h"
+#include "isp/kernels/crop/crop_1.0/ia_css_crop_param.h"
+#include "isp/kernels/csc/csc_1.0/ia_css_csc.host.h"
+#include "isp/kernels/ctc/ctc_1.0/ia_css_ctc.host.h"
+#include "isp/kernels/ctc/ctc_1.0/ia_css_ctc_table.host.h"
+#include "isp/kernels/ctc/ctc_1.0/ia_css_ctc_param.h"
+#include "isp/kernels/ctc/ctc1_5/ia_css_ctc1_5_param.h"
+#include "isp/kernels/de/de_1.0/ia_css_de.host.h"
+#include "isp/kernels/de/de_2/ia_css_de2.host.h"
+#include "isp/kernels/dp/dp_1.0/ia_css_dp.host.h"
+#include "isp/kernels/fc/fc_1.0/ia_css_formats.host.h"
+#include "isp/kernels/gc/gc_1.0/ia_css_gc.host.h"
+#include "isp/kernels/gc/gc_1.0/ia_css_gc_table.host.h"
+#include "isp/kernels/gc/gc_2/ia_css_gc2.host.h"
+#include "isp/kernels/gc/gc_2/ia_css_gc2_table.host.h"
+#include "isp/kernels/macc/macc_1.0/ia_css_macc.host.h"
+#include "isp/kernels/ob/ob_1.0/ia_css_ob.host.h"
+#include "isp/kernels/s3a/s3a_1.0/ia_css_s3a.host.h"
+#include "isp/kernels/sc/sc_1.0/ia_css_sc_param.h"
+#include "isp/kernels/wb/wb_1.0/ia_css_wb.host.h"
+#include "isp/kernels/xnr/xnr_1.0/ia_css_xnr.host.h"
+#include "isp/kernels/xnr/xnr_1.0/ia_css_xnr_table.host.h"
+#include "isp/kernels/xnr/xnr_3.0/ia_css_xnr3.host.h"
+#include "isp/kernels/ynr/ynr_1.0/ia_css_ynr.host.h"
+#include "isp/kernels/ynr/ynr_2/ia_css_ynr2.host.h"
+
+#include "stubs.h"
+
+#ifndef ARRAY_SIZE
+#define ARRAY_SIZE(a)		(sizeof(a) / sizeof((a)[0]))
+#endif
+
+#define PB_DEFAULT_FRAMES	1000
+#define PB_RAW_BIT_DEPTH	10
+#define PB_ISP_PIPE_VERSION	2
+
+/* the shading table the sensor tuning provides, and what the ISP uses */
+#define PB_SENSOR_WIDTH		4208
+#define PB_SENSOR_HEIGHT	3120
+#define PB_SC_IN_WIDTH		66
+#define PB_SC_IN_HEIGHT		50
+#define PB_INPUT_WIDTH		4160
+#define PB_INPUT_HEIGHT		3104
+#define PB_SCTBL_WIDTH		68
+#define PB_SCTBL_HEIGHT		51
+
+/* pseudo parameter ids for the shading table conversion */
+#define PB_SC_PREPARE_ID	IA_CSS_NUM_PARAMETER_IDS
+#define PB_SC_CONVERT_ID	(IA_CSS_NUM_PARAMETER_IDS + 1)
+#define PB_SC_LOOKUP_ID		(IA_CSS_NUM_PARAMETER_IDS + 2)
+#define PB_NUM_IDS		(IA_CSS_NUM_PARAMETER_IDS + 3)
+
+struct pb_stat {
+	unsigned long long calls;
+	unsigned long long ns;
+	unsigned long long max_ns;
+};
+
+static const char *pb_names[PB_NUM_IDS] = {
+	[IA_CSS_AA_ID] = "aa",
+	[IA_CSS_ANR_ID] = "anr",
+	[IA_CSS_CNR_ID] = "cnr",
+	[IA_CSS_CROP_ID] = "crop",
+	[IA_CSS_CSC_ID] = "csc",
+	[IA_CSS_DP_ID] = "dp",
+	[IA_CSS_BNR_ID] = "bnr",
+	[IA_CSS_DE_ID] = "de",
+	[IA_CSS_ECD_ID] = "ecd",
+	[IA_CSS_GC_ID] = "gc",
+	[IA_CSS_CE_ID] = "ce",
+	[IA_CSS_YUV2RGB_ID] = "yuv2rgb",
+	[IA_CSS_RGB2YUV_ID] = "rgb2yuv",
+	[IA_CSS_R_GAMMA_ID] = "r_gamma",
+	[IA_CSS_G_GAMMA_ID] = "g_gamma",
+	[IA_CSS_B_GAMMA_ID] = "b_gamma",
+	[IA_CSS_UDS_ID] = "uds",
+	[IA_CSS_S3A_ID] = "s3a",
+	[IA_CSS_OB_ID] = "ob",
+	[IA_CSS_SC_ID] = "sc",
+	[IA_CSS_MACC_ID] = "macc",
+	[IA_CSS_WB_ID] = "wb",
+	[IA_CSS_NR_ID] = "nr",
+	[IA_CSS_YNR_ID] = "ynr",
+	[IA_CSS_FC_ID] = "fc",
+	[IA_CSS_CTC_ID] = "ctc",
+	[IA_CSS_XNR_TABLE_ID] = "xnr_table",
+	[IA_CSS_XNR_ID] = "xnr",
+	[IA_CSS_XNR3_ID] = "xnr3",
+	[PB_SC_PREPARE_ID] = "sc_prepare",
+	[PB_SC_CONVERT_ID] = "sc_convert",
+	[PB_SC_LOOKUP_ID] = "sc_lookup",
+};
+
+static struct ia_css_memory_offsets pb_offsets;
+static struct ia_css_binary_xinfo pb_xinfo;
+static struct ia_css_binary pb_binary;
+static struct ia_css_pipeline_stage pb_stage;
+static struct ia_css_pipeline pb_pipeline;
+static struct ia_css_pipe *pb_pipes[1];
+static struct ia_css_stream pb_stream;
+static struct ia_css_isp_parameters pb_params;
+static struct pb_stat pb_stats[PB_NUM_IDS];
+static unsigned int pb_mem_used[IA_CSS_NUM_MEMORIES];
+static unsigned int pb_errors;
+
+/*
+ * What the encoders store their tables with; in the device this is in
+ * sh_css_params.c, which desc_bench links but param_bench does not.
+ */
+void ia_css_params_store_ia_css_host_data(hrt_vaddress ddr_addr,
+					  struct ia_css_host_data *data)
+{
+	memcpy(bench_ddr_ptr(ddr_addr), data->address, data->size);
+}
+
+/* The one pipe of pb_stream runs pb_stage */
+struct ia_css_pipeline *ia_css_pipe_get_pipeline(const struct ia_css_pipe *pipe)
+{
+	(void)pipe;
+	return &pb_pipeline;
+}
+
+static unsigned long long pb_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Give a parameter its own slot in the host copy of an ISP memory */
+static void pb_layout(struct ia_css_isp_parameter *param,
+		      enum ia_css_isp_memories mem, unsigned int size)
+{
+	param->offset = pb_mem_used[mem];
+	param->size = size;
+	pb_mem_used[mem] += (size + 63) & ~63U;
+}
+
+#define PB_LAYOUT(mem, mem_id, name, type) \
+	pb_layout(&pb_offsets.mem.name, mem_id, sizeof(type))
+
+static void pb_binary_init(void)
+{
+	unsigned int mem;
+
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, aa, struct sh_css_isp_aa_params);
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, anr, struct sh_css_isp_anr_params);
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, bh, struct sh_css_isp_bh_params);
+	PB_LAYOUT(hmem0, IA_CSS_ISP_HMEM0, bh, struct sh_css_isp_bh_hmem_params);
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, cnr, struct sh_css_isp_cnr_params);
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, crop, struct sh_css_isp_crop_isp_params);
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, csc, struct sh_css_isp_csc_params);
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, dp, struct sh_css_isp_dp_params);
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, bnr, struct sh_css_isp_bnr_params);
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, de, struct sh_css_isp_de_params);
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, ecd, struct sh_css_isp_ecd_params);
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, gc, struct sh_css_isp_gc_params);
+	PB_LAYOUT(vamem1, IA_CSS_ISP_VAMEM1, gc,
+		  struct sh_css_isp_gc_vamem_params);
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, ce, struct sh_css_isp_ce_params);
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, yuv2rgb, struct sh_css_isp_csc_params);
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, rgb2yuv, struct sh_css_isp_csc_params);
+	PB_LAYOUT(vamem0, IA_CSS_ISP_VAMEM0, r_gamma,
+		  struct sh_css_isp_rgb_gamma_vamem_params);
+	PB_LAYOUT(vamem1, IA_CSS_ISP_VAMEM1, g_gamma,
+		  struct sh_css_isp_rgb_gamma_vamem_params);
+	PB_LAYOUT(vamem2, IA_CSS_ISP_VAMEM2, b_gamma,
+		  struct sh_css_isp_rgb_gamma_vamem_params);
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, uds, struct sh_css_sp_uds_params);
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, s3a, struct sh_css_isp_s3a_params);
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, ob, struct sh_css_isp_ob_params);
+	PB_LAYOUT(vmem, IA_CSS_ISP_VMEM, ob, struct sh_css_isp_ob_vmem_params);
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, sc, struct sh_css_isp_sc_params);
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, macc, struct sh_css_isp_macc_params);
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, wb, struct sh_css_isp_wb_params);
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, nr, struct sh_css_isp_ynr_params);
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, ynr, struct sh_css_isp_yee2_params);
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, fc, struct sh_css_isp_fc_params);
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, ctc, struct sh_css_isp_ctc_params);
+	PB_LAYOUT(vamem0, IA_CSS_ISP_VAMEM0, ctc,
+		  struct sh_css_isp_ctc_vamem_params);
+	PB_LAYOUT(vamem1, IA_CSS_ISP_VAMEM1, xnr_table,
+		  struct sh_css_isp_xnr_vamem_params);
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, xnr, struct sh_css_isp_xnr_params);
+	PB_LAYOUT(dmem, IA_CSS_ISP_DMEM, xnr3, struct sh_css_isp_xnr3_params);
+
+	for (mem = 0; mem < IA_CSS_NUM_MEMORIES; mem++) {
+		struct ia_css_host_data *d =
+			&pb_binary.mem_params.params[IA_CSS_PARAM_CLASS_PARAM][mem];
+
+		d->size = pb_mem_used[mem] ? pb_mem_used[mem] : 64;
+		d->address = calloc(1, d->size);
+		if (!d->address) {
+			fprintf(stderr, "out of memory\n");
+			exit(1);
+		}
+	}
+
+	pb_xinfo.mem_offsets.offsets.param = &pb_offsets;
+	pb_binary.info = &pb_xinfo;
+	pb_binary.in_frame_info.res.width = PB_INPUT_WIDTH;
+	pb_binary.in_frame_info.res.height = PB_INPUT_HEIGHT;
+	pb_binary.in_frame_info.padded_width = PB_INPUT_WIDTH + 64;
+	pb_binary.left_padding = 32;
+	pb_binary.sctbl_width_per_color = PB_SCTBL_WIDTH;
+	pb_binary.sctbl_height = PB_SCTBL_HEIGHT;
+	pb_xinfo.sp.enable.sc = 1;
+	pb_stage.binary = &pb_binary;
+	pb_stage.stage_num = 0;
+	pb_pipeline.stages = &pb_stage;
+	pb_stream.num_pipes = 1;
+	pb_stream.pipes = pb_pipes;
+	pb_stream.isp_params_configs = &pb_params;
+}
+
+static void pb_params_init(void)
+{
+	ia_css_config_gamma_table();
+	ia_css_config_ctc_table();
+	ia_css_config_rgb_gamma_tables();
+	ia_css_config_xnr_table();
+
+	pb_params.aa_config = default_aa_config;
+	pb_params.anr_config = default_anr_config;
+	pb_params.cnr_config = default_cnr_config;
+	pb_params.cc_config = default_cc_config;
+	pb_params.dp_config = default_dp_config;
+	pb_params.nr_config = default_nr_config;
+	pb_params.de_config = default_de_config;
+	pb_params.ecd_config = default_ecd_config;
+	pb_params.gc_config = default_gc_config;
+	pb_params.gc_table = default_gamma_table;
+	pb_params.ce_config = default_ce_config;
+	pb_params.yuv2rgb_cc_config = default_yuv2rgb_cc_config;
+	pb_params.rgb2yuv_cc_config = default_rgb2yuv_cc_config;
+	pb_params.r_gamma_table = default_r_gamma_table;
+	pb_params.g_gamma_table = default_g_gamma_table;
+	pb_params.b_gamma_table = default_b_gamma_table;
+	pb_params.s3a_config = default_3a_config;
+	pb_params.ob_config = default_ob_config;
+	pb_params.macc_config = default_macc_config;
+	pb_params.wb_config = default_wb_config;
+	pb_params.ynr_config = default_ynr_config;
+	pb_params.fc_config = default_fc_config;
+	pb_params.ctc_config = default_ctc_config;
+	pb_params.ctc_table = default_ctc_table;
+	pb_params.xnr_table = default_xnr_table;
+	pb_params.xnr_config = default_xnr_config;
+	pb_params.xnr3_config = default_xnr3_config;
+
+	pb_params.shading_settings.enable_shading_table_conversion = 1;
+
+	ia_css_ob_configure(&pb_params.stream_configs.ob,
+			    PB_ISP_PIPE_VERSION, PB_RAW_BIT_DEPTH);
+	ia_css_s3a_configure(PB_RAW_BIT_DEPTH);
+}
+
+static void pb_record(unsigned int id, unsigned long long ns)
+{
+	pb_stats[id].calls++;
+	pb_stats[id].ns += ns;
+	if (ns > pb_stats[id].max_ns)
+		pb_stats[id].max_ns = ns;
+}
+
+/* What process_kernel_parameters() does for one committed frame */
+static void pb_process_frame(void)
+{
+	unsigned long long start;
+	unsigned int id;
+
+	pb_params.crop_config.crop_pos = pb_params.uds[0].crop_pos;
+	pb_params.uds_config.crop_pos = pb_params.uds[0].crop_pos;
+	pb_params.uds_config.uds = pb_params.uds[0].uds;
+
+	for (id = 0; id < IA_CSS_NUM_PARAMETER_IDS; id++) {
+		if (id == IA_CSS_SC_ID || !pb_params.config_changed[id])
+			continue;
+		start = pb_now_ns();
+		ia_css_kernel_process_param[id](IA_CSS_PIPE_ID_PREVIEW,
+						&pb_stage, &pb_params);
+		pb_record(id, pb_now_ns() - start);
+	}
+	memset(pb_params.config_changed, 0, sizeof(pb_params.config_changed));
+}
+
+static void pb_seq_3a(unsigned int frame)
+{
+	static const unsigned int per_frame[] = {
+		IA_CSS_WB_ID, IA_CSS_CSC_ID, IA_CSS_S3A_ID, IA_CSS_OB_ID,
+	};
+	static const unsigned int tone[] = {
+		IA_CSS_GC_ID, IA_CSS_CTC_ID, IA_CSS_R_GAMMA_ID,
+		IA_CSS_G_GAMMA_ID, IA_CSS_B_GAMMA_ID,
+	};
+	static const unsigned int tuning[] = {
+		IA_CSS_AA_ID, IA_CSS_ANR_ID, IA_CSS_CNR_ID, IA_CSS_DP_ID,
+		IA_CSS_BNR_ID, IA_CSS_DE_ID, IA_CSS_ECD_ID, IA_CSS_CE_ID,
+		IA_CSS_YUV2RGB_ID, IA_CSS_RGB2YUV_ID, IA_CSS_MACC_ID,
+		IA_CSS_NR_ID, IA_CSS_YNR_ID, IA_CSS_FC_ID,
+		IA_CSS_XNR_TABLE_ID, IA_CSS_XNR_ID, IA_CSS_XNR3_ID,
+	};
+	unsigned int i;
+
+	/* AWB and AE move a little every frame */
+	pb_params.wb_config.r = 32768 + (frame * 37) % 8192;
+	pb_params.wb_config.b = 32768 + (frame * 53) % 8192;
+	pb_params.cc_config.matrix[0] = 8192 + (frame % 64);
+	pb_params.s3a_config.ae_y_coef_g = 32768 + (frame % 16);
+	pb_params.ob_config.level_gr = 64 + (frame % 4);
+	for (i = 0; i < ARRAY_SIZE(per_frame); i++)
+		pb_params.config_changed[per_frame[i]] = true;
+
+	if (frame % 4 == 0) {
+		pb_params.gc_config.gain_k1 = frame % 256;
+		pb_params.gc_table.data.vamem_2[frame % 256] ^= 1;
+		for (i = 0; i < ARRAY_SIZE(tone); i++)
+			pb_params.config_changed[tone[i]] = true;
+	}
+
+	if (frame % 16 == 0) {
+		pb_params.de_config.pixelnoise = frame % 65536;
+		pb_params.macc_config.exp = frame % 4;
+		for (i = 0; i < ARRAY_SIZE(tuning); i++)
+			pb_params.config_changed[tuning[i]] = true;
+	}
+
+	pb_process_frame();
+}
+
+static void pb_seq_zoom(unsigned int frame)
+{
+	/* zoom from 1x to 4x and back, one step per frame */
+	unsigned int step = frame % 512;
+	unsigned int zoom = step < 256 ? step : 511 - step;
+
+	pb_params.uds[0].crop_pos.x = zoom * 6;
+	pb_params.uds[0].crop_pos.y = zoom * 4;
+	pb_params.uds[0].uds.curr_dx = 64 - zoom / 6;
+	pb_params.uds[0].uds.curr_dy = 64 - zoom / 6;
+	pb_params.uds[0].uds.xc = PB_INPUT_WIDTH / 2;
+	pb_params.uds[0].uds.yc = PB_INPUT_HEIGHT / 2;
+	pb_params.config_changed[IA_CSS_UDS_ID] = true;
+	pb_params.config_changed[IA_CSS_CROP_ID] = true;
+
+	pb_process_frame();
+}
+
+static struct ia_css_shading_table *pb_sc_tables[2];
+/* prepare_shading_table() of pb_sc_tables, for the prepared ones */
+static struct ia_css_shading_table *pb_sc_refs[2];
+
+static struct ia_css_shading_table *pb_sc_table_alloc(unsigned int seed)
+{
+	struct ia_css_shading_table *t;
+	unsigned int c, i;
+
+	t = ia_css_shading_table_alloc(PB_SC_IN_WIDTH, PB_SC_IN_HEIGHT);
+	if (!t) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	t->sensor_width = PB_SENSOR_WIDTH;
+	t->sensor_height = PB_SENSOR_HEIGHT;
+	t->fraction_bits = 10;
+	t->enable = 1;
+	for (c = 0; c < IA_CSS_SC_NUM_COLORS; c++)
+		for (i = 0; i < PB_SC_IN_WIDTH * PB_SC_IN_HEIGHT; i++)
+			t->data[c][i] = 1024 + (i * (seed + c + 1)) % 2048;
+	return t;
+}
+
+static void pb_seq_shading(unsigned int frame)
+{
+	unsigned long long start;
+
+	/* what sh_css_param_update_isp_params() does on a table swap */
+	if (pb_params.sc_config) {
+		ia_css_shading_table_free(pb_params.sc_config);
+		pb_params.sc_config = NULL;
+	}
+	start = pb_now_ns();
+	prepare_shading_table(pb_sc_tables[frame % 2], 0,
+			      &pb_params.sc_config, &pb_binary);
+	pb_record(PB_SC_PREPARE_ID, pb_now_ns() - start);
+	if (!pb_params.sc_config) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+
+	start = pb_now_ns();
+	ia_css_kernel_process_param[IA_CSS_SC_ID](IA_CSS_PIPE_ID_PREVIEW,
+						  &pb_stage, &pb_params);
+	pb_record(IA_CSS_SC_ID, pb_now_ns() - start);
+}
+
+static int pb_sc_table_cmp(const struct ia_css_shading_table *a,
+			   const struct ia_css_shading_table *b)
+{
+	unsigned int c;
+
+	if (a->width != b->width || a->height != b->height ||
+	    a->sensor_width != b->sensor_width ||
+	    a->sensor_height != b->sensor_height ||
+	    a->fraction_bits != b->fraction_bits)
+		return 1;
+	for (c = 0; c < IA_CSS_SC_NUM_COLORS; c++)
+		if (memcmp(a->data[c], b->data[c],
+			   a->width * a->height * sizeof(*a->data[c])))
+			return 1;
+	return 0;
+}
+
+static void pb_seq_prepared(unsigned int frame)
+{
+	const struct ia_css_shading_table *table = pb_sc_tables[frame % 2];
+	const struct ia_css_shading_table *converted;
+	struct ia_css_shading_prepared *prepared;
+	unsigned long long start;
+
+	/* the ioctl: geometry under the lock, the conversion outside it */
+	prepared = ia_css_shading_prepare(&pb_stream, table);
+	if (!prepared) {
+		fprintf(stderr, "frame %u: nothing to prepare\n", frame);
+		exit(1);
+	}
+	start = pb_now_ns();
+	if (ia_css_shading_prepared_convert(prepared) != IA_CSS_SUCCESS) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	pb_record(PB_SC_CONVERT_ID, pb_now_ns() - start);
+
+	/* the parameter update, back under the lock */
+	pb_params.sc_table = table;
+	pb_params.sc_prepared = prepared;
+	start = pb_now_ns();
+	converted = sh_css_shading_prepared_lookup(pb_params.sc_prepared,
+						   pb_params.sc_table,
+						   pb_params.sensor_binning,
+						   &pb_binary);
+	pb_record(PB_SC_LOOKUP_ID, pb_now_ns() - start);
+	if (!converted || pb_sc_table_cmp(converted, pb_sc_refs[frame % 2])) {
+		fprintf(stderr, "frame %u: prepared table differs\n", frame);
+		pb_errors++;
+		converted = pb_sc_refs[frame % 2];
+	}
+	if (sh_css_shading_prepared_lookup(prepared, pb_sc_tables[!(frame % 2)],
+					   pb_params.sensor_binning,
+					   &pb_binary)) {
+		fprintf(stderr, "frame %u: found for another table\n", frame);
+		pb_errors++;
+	}
+
+	pb_params.sc_config = (struct ia_css_shading_table *)converted;
+	start = pb_now_ns();
+	ia_css_kernel_process_param[IA_CSS_SC_ID](IA_CSS_PIPE_ID_PREVIEW,
+						  &pb_stage, &pb_params);
+	pb_record(IA_CSS_SC_ID, pb_now_ns() - start);
+	pb_params.sc_config = NULL;
+	pb_params.sc_prepared = NULL;
+
+	ia_css_shading_prepared_free(prepared);
+}
+
+static void pb_report(const char *seq, unsigned int frames)
+{
+	unsigned long long total = 0;
+	unsigned int id;
+
+	printf("%s: %u frames\n", seq, frames);
+	printf("  %-12s %10s %12s %12s %10s\n",
+	       "kernel", "calls", "ns/frame", "ns/call", "max ns");
+	for (id = 0; id < PB_NUM_IDS; id++) {
+		struct pb_stat *s = &pb_stats[id];
+
+		if (!s->calls)
+			continue;
+		total += s->ns;
+		printf("  %-12s %10llu %12llu %12llu %10llu\n",
+		       pb_names[id] ? pb_names[id] : "?", s->calls,
+		       s->ns / frames, s->ns / s->calls, s->max_ns);
+	}
+	printf("  %-12s %10s %12llu\n\n", "total", "", total / frames);
+	memset(pb_stats, 0, sizeof(pb_stats));
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int frames = PB_DEFAULT_FRAMES;
+	unsigned int i;
+
+	if (argc > 1)
+		frames = strtoul(argv[1], NULL, 0);
+	if (!frames) {
+		fprintf(stderr, "usage: %s [frames]\n", argv[0]);
+		return 1;
+	}
+
+	pb_binary_init();
+	pb_params_init();
+	pb_sc_tables[0] = pb_sc_table_alloc(0);
+	pb_sc_tables[1] = pb_sc_table_alloc(1);
+
+	for (i = 0; i < frames; i++)
+		pb_seq_3a(i);
+	pb_report("3a", frames);
+
+	for (i = 0; i < frames; i++)
+		pb_seq_zoom(i);
+	pb_report("zoom", frames);
+
+	for (i = 0; i < frames; i++)
+		pb_seq_shading(i);
+	pb_report("shading", frames);
+
+	for (i = 0; i < 2; i++) {
+		prepare_shading_table(pb_sc_tables[i], 0, &pb_sc_refs[i],
+				      &pb_binary);
+		if (!pb_sc_refs[i]) {
+			fprintf(stderr, "out of memory\n");
+			return 1;
+		}
+	}
+	for (i = 0; i < frames; i++)
+		pb_seq_prepared(i);
+	pb_report("prepared", frames);
+
+	printf("%u errors\n%s\n", pb_errors, pb_errors ? "FAILED" : "PASSED");
+	return pb_errors ? 1 : 0;
+}
@@ -0,0 +1,188 @@
+/*
+ * Host stand-ins for the CSS runtime used by the parameter encoders.
+ *
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+/*
+ * The parameter encoders only run on the host copy of the ISP memories.
+ * Tracing is off, host allocations come from libc and the handful of
+ * frame and stream helpers the encoder objects reference are only
+ * reached from the binary configuration paths, which the benchmark
+ * does not run.
+ */
+
+#include <assert.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ia_css_debug.h"
+#include "ia_css_frame.h"
+#include "ia_css_frame_comm.h"
+#include "ia_css_stream.h"
+#include "ia_css_binary.h"
+#include "ia_css_host_data.h"
+#include "memory_access.h"
+#include "sh_css_internal.h"
+#include "stubs.h"
+
+unsigned int ia_css_debug_trace_level = IA_CSS_DEBUG_ERROR;
+bool ia_css_debug_trace_ring_enabled;
+int (*sh_css_printf)(const char *fmt, va_list args);
+
+void ia_css_debug_trace_ring_record(unsigned int level, const char *fmt,
+				    va_list args)
+{
+	(void)level;
+	(void)fmt;
+	(void)args;
+}
+
+void *sh_css_malloc(size_t size)
+{
+	return size ? malloc(size) : NULL;
+}
+
+void *sh_css_calloc(size_t N, size_t size)
+{
+	return (N && size) ? calloc(N, size) : NULL;
+}
+
+void sh_css_free(void *ptr)
+{
+	free(ptr);
+}
+
+/*
+ * ISP virtual memory. hrt_vaddress is 32 bit, so a host pointer cannot
+ * stand in for it on a 64 bit host; each allocation gets a window of
+ * BENCH_DDR_WINDOW bytes instead, and the address is the window plus
+ * the offset into it.
+ */
+#define BENCH_DDR_SLOTS		255
+#define BENCH_DDR_SHIFT		24
+#define BENCH_DDR_WINDOW	(1UL << BENCH_DDR_SHIFT)
+
+static void *bench_ddr[BENCH_DDR_SLOTS];
+
+const hrt_vaddress mmgr_NULL = (hrt_vaddress)0;
+const hrt_vaddress mmgr_EXCEPTION = (hrt_vaddress)-1;
+
+unsigned long bench_ddr_stores;
+unsigned long bench_ddr_store_bytes;
+
+void *bench_ddr_ptr(hrt_vaddress vaddr)
+{
+	unsigned int slot = (vaddr >> BENCH_DDR_SHIFT) - 1;
+
+	assert(vaddr != mmgr_NULL && slot < BENCH_DDR_SLOTS && bench_ddr[slot]);
+	return (char *)bench_ddr[slot] + (vaddr & (BENCH_DDR_WINDOW - 1));
+}
+
+hrt_vaddress mmgr_malloc(const size_t size)
+{
+	unsigned int slot;
+
+	if (!size || size > BENCH_DDR_WINDOW)
+		return mmgr_NULL;
+	for (slot = 0; slot < BENCH_DDR_SLOTS; slot++)
+		if (!bench_ddr[slot])
+			break;
+	if (slot == BENCH_DDR_SLOTS)
+		return mmgr_NULL;
+	bench_ddr[slot] = malloc(size);
+	if (!bench_ddr[slot])
+		return mmgr_NULL;
+	return (hrt_vaddress)((slot + 1) << BENCH_DDR_SHIFT);
+}
+
+hrt_vaddress mmgr_calloc(const size_t N, const size_t size)
+{
+	hrt_vaddress vaddr = mmgr_malloc(N * size);
+
+	if (vaddr != mmgr_NULL)
+		memset(bench_ddr_ptr(vaddr), 0, N * size);
+	return vaddr;
+}
+
+void mmgr_free(hrt_vaddress vaddr)
+{
+	unsigned int slot;
+
+	if (vaddr == mmgr_NULL)
+		return;
+	slot = (vaddr >> BENCH_DDR_SHIFT) - 1;
+	assert(slot < BENCH_DDR_SLOTS);
+	free(bench_ddr[slot]);
+	bench_ddr[slot] = NULL;
+}
+
+void mmgr_load(const hrt_vaddress vaddr, void *data, const size_t size)
+{
+	memcpy(data, bench_ddr_ptr(vaddr), size);
+}
+
+void mmgr_store(const hrt_vaddress vaddr, const void *data, const size_t size)
+{
+	bench_ddr_stores++;
+	bench_ddr_store_bytes += size;
+	memcpy(bench_ddr_ptr(vaddr), data, size);
+}
+
+void sh_css_parallel_for(unsigned int n,
+			 void (*fn)(void *ctx, unsigned int i), void *ctx)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+		fn(ctx, i);
+}
+
+void ia_css_dma_configure_from_info(struct dma_port_config *config,
+				    const struct ia_css_frame_info *info)
+{
+	memset(config, 0, sizeof(*config));
+	(void)info;
+}
+
+void ia_css_frame_info_to_frame_sp_info(struct ia_css_frame_sp_info *sp_info,
+					const struct ia_css_frame_info *info)
+{
+	memset(sp_info, 0, sizeof(*sp_info));
+	(void)info;
+}
+
+void ia_css_resolution_to_sp_resolution(struct ia_css_sp_resolution *to,
+					const struct ia_css_resolution *from)
+{
+	to->width  = (uint16_t)from->width;
+	to->height = (uint16_t)from->height;
+}
+
+/* no viewfinder post-processing binary is loaded */
+unsigned ia_css_binary_max_vf_width(void)
+{
+	return 0;
+}
+
+struct ia_css_binary *
+ia_css_stream_get_dvs_binary(const struct ia_css_stream *stream)
+{
+	(void)stream;
+	return NULL;
+}
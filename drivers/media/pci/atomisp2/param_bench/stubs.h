@@ -0,0 +1,41 @@
+/*
+ * Host stand-ins for the CSS runtime, as seen by the benchmarks.
+ *
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version
+ * 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ */
+
+#ifndef __BENCH_STUBS_H__
+#define __BENCH_STUBS_H__
+
+#include "memory_access.h"
+
+/* Host address of ISP virtual address vaddr (stubs.c) */
+void *bench_ddr_ptr(hrt_vaddress vaddr);
+
+/* mmgr_store() traffic since start (stubs.c) */
+extern unsigned long bench_ddr_stores;
+extern unsigned long bench_ddr_store_bytes;
+
+/* Host address of SP dmem address addr (desc_stubs.c) */
+void *bench_dmem_ptr(unsigned int addr);
+
+/* sp_dmem_store() traffic since start (desc_stubs.c) */
+extern unsigned long bench_dmem_stores;
+extern unsigned long bench_dmem_store_bytes;
+
+#endif /* __BENCH_STUBS_H__ */